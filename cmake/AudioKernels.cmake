@@ -0,0 +1,60 @@
+# AudioKernels.cmake - FIR and FFT kernels, built once per build tree
+#
+# Each instruction set has its own source, compiled with that set's flags
+# and selected at runtime. Targets that need the kernels link the
+# audio_kernels library instead of listing the sources, so every build
+# compiles them a single time however many targets use them.
+
+include_guard(GLOBAL)
+
+set(AUDIO_KERNEL_DIR ${CMAKE_CURRENT_LIST_DIR}/../src/audio)
+
+#----------------------------------------------------------
+# Build one kernel source with the flags of its instruction set
+#----------------------------------------------------------
+function(set_kernel_instruction_set SOURCE ISA)
+    if(NOT CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64|i386|i686")
+        return()
+    endif()
+
+    # SSE2 is the MSVC baseline; NEON needs no flag where it exists
+    if(MSVC)
+        set(FLAGS_AVX2 "/arch:AVX2")
+        set(FLAGS_AVX512 "/arch:AVX512")
+    else()
+        set(FLAGS_SSE2 "-msse2")
+        set(FLAGS_AVX2 "-mavx2;-mfma")
+        set(FLAGS_AVX512 "-mavx512f;-mavx2;-mfma")
+    endif()
+
+    if(FLAGS_${ISA})
+        set_source_files_properties(${AUDIO_KERNEL_DIR}/${SOURCE} PROPERTIES COMPILE_OPTIONS "${FLAGS_${ISA}}")
+    endif()
+endfunction()
+
+add_library(audio_kernels STATIC
+    ${AUDIO_KERNEL_DIR}/fir_kernels.cpp
+    ${AUDIO_KERNEL_DIR}/fir_kernels_sse2.cpp
+    ${AUDIO_KERNEL_DIR}/fir_kernels_avx2.cpp
+    ${AUDIO_KERNEL_DIR}/fir_kernels_avx512.cpp
+    ${AUDIO_KERNEL_DIR}/fir_kernels_neon.cpp
+    ${AUDIO_KERNEL_DIR}/fft.cpp
+    ${AUDIO_KERNEL_DIR}/fft_sse2.cpp
+    ${AUDIO_KERNEL_DIR}/fft_avx2.cpp
+    ${AUDIO_KERNEL_DIR}/fft_neon.cpp
+)
+
+set_kernel_instruction_set(fir_kernels_sse2.cpp SSE2)
+set_kernel_instruction_set(fir_kernels_avx2.cpp AVX2)
+set_kernel_instruction_set(fir_kernels_avx512.cpp AVX512)
+set_kernel_instruction_set(fft_sse2.cpp SSE2)
+set_kernel_instruction_set(fft_avx2.cpp AVX2)
+
+target_include_directories(audio_kernels PUBLIC
+    ${AUDIO_KERNEL_DIR}
+)
+
+# Also linked into the DSP plugins, which are shared libraries
+set_target_properties(audio_kernels PROPERTIES
+    POSITION_INDEPENDENT_CODE ON
+)
@@ -61,6 +61,7 @@ Result CoreEngine::initialize() {
     
     // Create playback engine
     playback_engine_ = std::make_unique<PlaybackEngine>();
+    playback_engine_->set_event_bus(event_bus_.get());
 
     // Create plugin host
     plugin_host_ = std::make_unique<PluginHost>(service_registry_.get());
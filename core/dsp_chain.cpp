@@ -0,0 +1,530 @@
+#include "dsp_chain.h"
+#include "mp_dsp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace mp {
+namespace core {
+
+namespace {
+
+// Waiting on a queue: yield first, then sleep briefly so an idle worker
+// does not hold a core
+void back_off(uint32_t& attempts) {
+    if (attempts++ < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+} // namespace
+
+DSPChain::DSPChain()
+    : order_count_(0)
+    , sample_rate_(0)
+    , channels_(0)
+    , max_frames_(0)
+    , latency_frames_(0)
+    , threads_requested_(1)
+    , threads_(1)
+    , workers_running_(false)
+    , submitted_(0)
+    , finished_(0)
+    , output_(nullptr)
+    , output_frames_(0)
+    , output_returned_(0)
+    , blocks_since_rebalance_(0)
+    , rebalances_(0) {
+    for (uint32_t slot = 0; slot < MAX_STAGES; ++slot) {
+        stages_[slot] = Stage{ nullptr, nullptr, false, false, false };
+        average_us_[slot].store(0.0f, std::memory_order_relaxed);
+        peak_us_[slot].store(0.0f, std::memory_order_relaxed);
+    }
+    for (Block& block : blocks_) {
+        block = Block{ { nullptr, nullptr }, 0, 0 };
+    }
+    for (SpscRingBuffer<uint32_t>& queue : queues_) {
+        queue.initialize(MAX_THREADS);
+    }
+    group_begin_[0] = 0;
+    group_begin_[1] = 0;
+}
+
+DSPChain::~DSPChain() {
+    stop_workers();
+    clear();
+}
+
+int DSPChain::find(const IDSPProcessor* processor) const {
+    for (uint32_t slot = 0; slot < MAX_STAGES; ++slot) {
+        if (processor && stages_[slot].processor == processor) {
+            return static_cast<int>(slot);
+        }
+    }
+    return -1;
+}
+
+void DSPChain::destroy_processor(IDSPProcessor* processor, DestroyDSPProcessorFunc destroy) {
+    if (destroy) {
+        destroy(processor);
+    } else {
+        delete processor;
+    }
+}
+
+void DSPChain::destroy_stage(Stage& stage) {
+    stage.processor->shutdown();
+    destroy_processor(stage.processor, stage.destroy);
+    stage = Stage{ nullptr, nullptr, false, false, false };
+}
+
+Result DSPChain::initialize_stage(Stage& stage) {
+    DSPConfig config;
+    config.sample_rate = sample_rate_;
+    config.channels = channels_;
+    config.format = SampleFormat::Float32;
+    config.max_buffer_frames = max_frames_;
+    return stage.processor->initialize(&config);
+}
+
+Result DSPChain::add_stage(IDSPProcessor* processor, DestroyDSPProcessorFunc destroy) {
+    if (!processor || find(processor) >= 0) {
+        return Result::InvalidParameter;
+    }
+
+    int free_slot = -1;
+    for (uint32_t slot = 0; slot < MAX_STAGES && free_slot < 0; ++slot) {
+        if (!stages_[slot].processor) {
+            free_slot = static_cast<int>(slot);
+        }
+    }
+    if (free_slot < 0) {
+        return Result::OutOfMemory;
+    }
+
+    quiesce();
+
+    Stage stage;
+    stage.processor = processor;
+    stage.destroy = destroy;
+    stage.in_place = (processor->get_dsp_capabilities() & static_cast<uint32_t>(DSPCapability::InPlace)) != 0;
+    stage.bypassed = false;
+    stage.ready = false;
+
+    if (max_frames_ > 0) {
+        Result result = initialize_stage(stage);
+        if (result != Result::Success) {
+            return result;
+        }
+        stage.ready = true;
+    }
+
+    stages_[free_slot] = stage;
+    average_us_[free_slot].store(0.0f, std::memory_order_relaxed);
+    peak_us_[free_slot].store(0.0f, std::memory_order_relaxed);
+    order_[order_count_++] = static_cast<uint32_t>(free_slot);
+    rebalance(true);
+    update_latency();
+    return Result::Success;
+}
+
+Result DSPChain::remove_stage(IDSPProcessor* processor) {
+    int slot = find(processor);
+    if (slot < 0) {
+        return Result::InvalidParameter;
+    }
+
+    quiesce();
+    uint32_t* end = std::remove(order_, order_ + order_count_, static_cast<uint32_t>(slot));
+    order_count_ = static_cast<uint32_t>(end - order_);
+    destroy_stage(stages_[slot]);
+    rebalance(true);
+    update_latency();
+    return Result::Success;
+}
+
+void DSPChain::clear() {
+    quiesce();
+    for (uint32_t i = 0; i < order_count_; ++i) {
+        destroy_stage(stages_[order_[i]]);
+    }
+    order_count_ = 0;
+    rebalance(true);
+    update_latency();
+}
+
+Result DSPChain::set_order(const IDSPProcessor* const* order, uint32_t count) {
+    if ((count > 0 && !order) || count != order_count_) {
+        return Result::InvalidParameter;
+    }
+
+    uint32_t slots[MAX_STAGES];
+    bool listed[MAX_STAGES] = {};
+    for (uint32_t i = 0; i < count; ++i) {
+        int slot = find(order[i]);
+        if (slot < 0 || listed[slot]) {
+            return Result::InvalidParameter;
+        }
+        listed[slot] = true;
+        slots[i] = static_cast<uint32_t>(slot);
+    }
+
+    quiesce();
+    std::copy(slots, slots + count, order_);
+    rebalance(true);
+    return Result::Success;
+}
+
+Result DSPChain::set_stage_bypassed(IDSPProcessor* processor, bool bypassed) {
+    int slot = find(processor);
+    if (slot < 0) {
+        return Result::InvalidParameter;
+    }
+
+    quiesce();
+    stages_[slot].bypassed = bypassed;
+    rebalance(true);
+    update_latency();
+    return Result::Success;
+}
+
+void DSPChain::set_threads(uint32_t threads) {
+    threads_requested_ = std::max(1u, std::min(threads, MAX_THREADS));
+}
+
+Result DSPChain::configure(uint32_t sample_rate, uint16_t channels, uint32_t max_frames) {
+    if (sample_rate == 0 || channels == 0 || max_frames == 0) {
+        return Result::InvalidParameter;
+    }
+
+    if (sample_rate == sample_rate_ && channels == channels_ && max_frames == max_frames_ &&
+        threads_requested_ == threads_) {
+        reset();
+        return Result::Success;
+    }
+
+    stop_workers();
+    threads_ = threads_requested_;
+
+    // Each buffer starts on an alignment boundary, so padding the size to
+    // a multiple of the alignment keeps the next one aligned too. Blocks
+    // held by different threads therefore never share a cache line.
+    const size_t align_floats = BUFFER_ALIGNMENT / sizeof(float);
+    size_t buffer_floats = static_cast<size_t>(max_frames) * channels;
+    buffer_floats = (buffer_floats + align_floats - 1) / align_floats * align_floats;
+    const size_t output_floats = threads_ > 1 ? static_cast<size_t>(threads_) * max_frames * channels : 0;
+    storage_.assign(buffer_floats * 2 * threads_ + output_floats + align_floats, 0.0f);
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(storage_.data());
+    size_t skip = ((BUFFER_ALIGNMENT - base % BUFFER_ALIGNMENT) % BUFFER_ALIGNMENT) / sizeof(float);
+    float* next = storage_.data() + skip;
+    for (uint32_t i = 0; i < MAX_THREADS; ++i) {
+        blocks_[i] = Block{ { nullptr, nullptr }, 0, 0 };
+        if (i < threads_) {
+            blocks_[i].buffers[0] = next;
+            blocks_[i].buffers[1] = next + buffer_floats;
+            next += buffer_floats * 2;
+        }
+    }
+    output_ = threads_ > 1 ? next : nullptr;
+
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    max_frames_ = max_frames;
+
+    // A stage that cannot take this format sits out until one it can
+    Result result = Result::Success;
+    for (uint32_t i = 0; i < order_count_; ++i) {
+        const uint32_t slot = order_[i];
+        Stage& stage = stages_[slot];
+        stage.ready = initialize_stage(stage) == Result::Success;
+        if (!stage.ready) {
+            result = Result::NotSupported;
+        }
+        average_us_[slot].store(0.0f, std::memory_order_relaxed);
+        peak_us_[slot].store(0.0f, std::memory_order_relaxed);
+    }
+
+    reset_output();
+    rebalance(true);
+    rebalances_ = 0;
+    start_workers();
+    update_latency();
+    return result;
+}
+
+const float* DSPChain::process(uint32_t frames) {
+    frames = std::min(frames, max_frames_);
+
+    if (threads_ == 1) {
+        Block& block = blocks_[0];
+        block.current = 0;
+        block.frames = frames;
+        run_group(block, 0);
+        // Variable-latency stages may have changed theirs
+        update_latency();
+        return block.buffers[block.current];
+    }
+
+    // Drop what the previous call handed out
+    if (output_returned_ > 0) {
+        output_frames_ -= output_returned_;
+        std::memmove(output_, output_ + static_cast<size_t>(output_returned_) * channels_,
+                     static_cast<size_t>(output_frames_) * channels_ * sizeof(float));
+        output_returned_ = 0;
+    }
+
+    if (++blocks_since_rebalance_ >= REBALANCE_BLOCKS) {
+        rebalance(false);
+    }
+
+    // Frames held for output plus frames in flight always add up to the
+    // pipeline latency, so the oldest blocks are only waited for once the
+    // held frames run short. Short blocks could put more blocks in flight
+    // than there are buffers; those wait too, so the block input() hands
+    // out next is always free.
+    const uint32_t index = static_cast<uint32_t>(submitted_ % threads_);
+    blocks_[index].current = 0;
+    blocks_[index].frames = frames;
+    queues_[0].write(&index, 1);
+    submitted_++;
+
+    while (output_frames_ < frames || submitted_ - finished_ > threads_ - 1) {
+        finish_block();
+    }
+    output_returned_ = frames;
+
+    update_latency();
+    return output_;
+}
+
+void DSPChain::reset() {
+    quiesce();
+    for (uint32_t i = 0; i < order_count_; ++i) {
+        stages_[order_[i]].processor->reset();
+    }
+    reset_output();
+}
+
+void DSPChain::update_latency() {
+    uint32_t latency = 0;
+    for (uint32_t i = 0; i < order_count_; ++i) {
+        const Stage& stage = stages_[order_[i]];
+        if (!stage.bypassed && stage.ready) {
+            latency += stage.processor->get_latency_samples();
+        }
+    }
+    latency_frames_ = latency + pipeline_latency_frames();
+}
+
+void DSPChain::run_group(Block& block, uint32_t group) {
+    using clock = std::chrono::steady_clock;
+    float* current = block.buffers[block.current];
+    float* spare = block.buffers[block.current ^ 1];
+
+    for (uint32_t i = group_begin_[group]; i < group_begin_[group + 1]; ++i) {
+        const uint32_t slot = order_[i];
+        Stage& stage = stages_[slot];
+        if (stage.bypassed || !stage.ready) {
+            continue;
+        }
+
+        AudioBuffer input;
+        input.data = current;
+        input.sample_rate = sample_rate_;
+        input.channels = channels_;
+        input.format = SampleFormat::Float32;
+        input.frames = block.frames;
+        input.capacity = max_frames_;
+
+        auto start = clock::now();
+        if (stage.in_place) {
+            stage.processor->process(&input, nullptr);
+        } else {
+            AudioBuffer output = input;
+            output.data = spare;
+            if (stage.processor->process(&input, &output) == Result::Success) {
+                std::swap(current, spare);
+            }
+        }
+        float elapsed_us = std::chrono::duration<float, std::micro>(clock::now() - start).count();
+
+        // Only the thread running the stage writes its counters
+        float average = average_us_[slot].load(std::memory_order_relaxed);
+        average += (elapsed_us - average) * (1.0f / 16.0f);
+        average_us_[slot].store(average, std::memory_order_relaxed);
+        if (elapsed_us > peak_us_[slot].load(std::memory_order_relaxed)) {
+            peak_us_[slot].store(elapsed_us, std::memory_order_relaxed);
+        }
+    }
+
+    block.current = current == block.buffers[0] ? 0 : 1;
+}
+
+void DSPChain::worker_main(uint32_t group) {
+    // The queues carry the happens-before edges: a block and the stage
+    // list it is filtered with are published by the write that hands the
+    // block on
+    while (true) {
+        uint32_t index = 0;
+        uint32_t attempts = 0;
+        while (queues_[group].read(&index, 1) == 0) {
+            if (!workers_running_.load(std::memory_order_acquire)) {
+                return;
+            }
+            back_off(attempts);
+        }
+        run_group(blocks_[index], group);
+        queues_[group + 1].write(&index, 1);
+    }
+}
+
+void DSPChain::start_workers() {
+    if (threads_ < 2) {
+        return;
+    }
+    workers_running_.store(true, std::memory_order_release);
+    for (uint32_t group = 0; group + 1 < threads_; ++group) {
+        workers_.emplace_back(&DSPChain::worker_main, this, group);
+    }
+}
+
+void DSPChain::stop_workers() {
+    quiesce();
+    workers_running_.store(false, std::memory_order_release);
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void DSPChain::finish_block() {
+    uint32_t index = 0;
+    uint32_t attempts = 0;
+    while (queues_[threads_ - 1].read(&index, 1) == 0) {
+        back_off(attempts);
+    }
+
+    Block& block = blocks_[index];
+    run_group(block, threads_ - 1);
+    std::memcpy(output_ + static_cast<size_t>(output_frames_) * channels_,
+                block.buffers[block.current],
+                static_cast<size_t>(block.frames) * channels_ * sizeof(float));
+    output_frames_ += block.frames;
+    finished_++;
+}
+
+void DSPChain::quiesce() {
+    while (finished_ < submitted_) {
+        finish_block();
+    }
+}
+
+void DSPChain::reset_output() {
+    // The pipeline starts out holding its latency in silence
+    submitted_ = 0;
+    finished_ = 0;
+    output_returned_ = 0;
+    output_frames_ = pipeline_latency_frames();
+    if (output_) {
+        std::memset(output_, 0, static_cast<size_t>(output_frames_) * channels_ * sizeof(float));
+    }
+}
+
+void DSPChain::rebalance(bool force) {
+    blocks_since_rebalance_ = 0;
+    const uint32_t groups = threads_;
+    const uint32_t count = order_count_;
+
+    // Unmeasured stages weigh a little, so they start spread evenly
+    float prefix[MAX_STAGES + 1];
+    prefix[0] = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+        const Stage& stage = stages_[order_[i]];
+        float cost = 0.0f;
+        if (!stage.bypassed && stage.ready) {
+            cost = average_us_[order_[i]].load(std::memory_order_relaxed) + 0.001f;
+        }
+        prefix[i + 1] = prefix[i] + cost;
+    }
+
+    // Contiguous split minimizing the slowest group: best[g][i] is the
+    // slowest group when the first i stages form g groups
+    float best[MAX_THREADS + 1][MAX_STAGES + 1];
+    uint32_t cut[MAX_THREADS + 1][MAX_STAGES + 1];
+    for (uint32_t i = 0; i <= count; ++i) {
+        best[1][i] = prefix[i];
+        cut[1][i] = 0;
+    }
+    for (uint32_t g = 2; g <= groups; ++g) {
+        for (uint32_t i = 0; i <= count; ++i) {
+            best[g][i] = best[g - 1][i];
+            cut[g][i] = i;
+            for (uint32_t j = 0; j < i; ++j) {
+                float slowest = std::max(best[g - 1][j], prefix[i] - prefix[j]);
+                if (slowest < best[g][i]) {
+                    best[g][i] = slowest;
+                    cut[g][i] = j;
+                }
+            }
+        }
+    }
+
+    uint32_t begin[MAX_THREADS + 1];
+    begin[groups] = count;
+    for (uint32_t g = groups; g > 0; --g) {
+        begin[g - 1] = cut[g][begin[g]];
+    }
+
+    if (!force) {
+        float current = 0.0f;
+        for (uint32_t g = 0; g < groups; ++g) {
+            uint32_t from = std::min(group_begin_[g], count);
+            uint32_t to = std::min(group_begin_[g + 1], count);
+            current = std::max(current, prefix[to] - prefix[from]);
+        }
+        if (best[groups][count] > current * 0.9f) {
+            return;
+        }
+    }
+
+    if (!std::equal(begin, begin + groups + 1, group_begin_)) {
+        quiesce();
+        std::copy(begin, begin + groups + 1, group_begin_);
+        if (groups > 1) {
+            rebalances_++;
+        }
+    }
+}
+
+void DSPChain::get_stats(DSPChainStats* stats) const {
+    std::memset(stats, 0, sizeof(*stats));
+    stats->stage_count = order_count_;
+    stats->thread_count = threads_;
+    stats->pipeline_latency_frames = pipeline_latency_frames();
+    stats->rebalances = rebalances_;
+    if (threads_ > 1) {
+        for (uint32_t g = 0; g < threads_; ++g) {
+            stats->queue_depth[g] = static_cast<uint32_t>(queues_[g].available_read());
+        }
+    }
+
+    uint32_t group = 0;
+    for (uint32_t i = 0; i < order_count_; ++i) {
+        while (group + 1 < threads_ && i >= group_begin_[group + 1]) {
+            group++;
+        }
+        const uint32_t slot = order_[i];
+        DSPStageStats& stage = stats->stages[i];
+        stage.processor = stages_[slot].processor;
+        stage.thread = group;
+        stage.bypassed = stages_[slot].bypassed;
+        stage.ready = stages_[slot].ready;
+        stage.average_us = average_us_[slot].load(std::memory_order_relaxed);
+        stage.peak_us = peak_us_[slot].load(std::memory_order_relaxed);
+    }
+}
+
+}} // namespace mp::core
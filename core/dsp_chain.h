@@ -0,0 +1,192 @@
+#pragma once
+
+#include "mp_types.h"
+#include "spsc_ring_buffer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace mp {
+
+// From mp_dsp.h, which only dsp_chain.cpp needs in full
+class IDSPProcessor;
+using DestroyDSPProcessorFunc = void (*)(IDSPProcessor*);
+
+namespace core {
+
+struct DSPChainStats;
+
+// Ordered DSP processors between the resampler and the output ring.
+//
+// Blocks ping-pong between two aligned buffers allocated in configure():
+// a stage with DSPCapability::InPlace filters the current buffer, any
+// other stage writes into the spare one and the two swap. Stages live in a
+// fixed set of slots and run in the order of an index list, so reordering
+// and bypassing only rewrite that list and never allocate.
+//
+// With set_threads(n > 1) the ordered stages are cut into n contiguous
+// groups. Groups 0..n-2 run on worker threads and the last one on the
+// thread calling process(); blocks travel between them through lock-free
+// queues, so up to n blocks are filtered at once. The output is delayed
+// by a fixed n - 1 blocks, counted in get_latency_frames(). The cuts
+// follow the measured time of each stage and are moved when another split
+// would shorten the slowest group by a tenth or more.
+//
+// Not thread-safe: the playback engine thread owns it. Every call other
+// than input() and process() first waits for the blocks in flight, so the
+// workers never see a stage change under them.
+class DSPChain {
+public:
+    static constexpr uint32_t MAX_STAGES = 16;
+    static constexpr uint32_t MAX_THREADS = 4;
+    static constexpr size_t BUFFER_ALIGNMENT = 64;   // Bytes; a cache line, wide enough for AVX-512
+    static constexpr uint32_t REBALANCE_BLOCKS = 64; // Blocks between checks of the group cuts
+
+    DSPChain();
+    ~DSPChain();
+
+    DSPChain(const DSPChain&) = delete;
+    DSPChain& operator=(const DSPChain&) = delete;
+
+    // Append a processor and take ownership of it. It is freed with destroy,
+    // or deleted when destroy is null. If the chain is configured the
+    // processor is initialized for that format first; on failure it is
+    // left with the caller.
+    Result add_stage(IDSPProcessor* processor, DestroyDSPProcessorFunc destroy);
+
+    // Remove and free a processor
+    Result remove_stage(IDSPProcessor* processor);
+
+    // Free every processor
+    void clear();
+
+    // Free a processor that never became a stage: with destroy, or
+    // deleted when destroy is null
+    static void destroy_processor(IDSPProcessor* processor, DestroyDSPProcessorFunc destroy);
+
+    // Run the stages in this order; must list every stage exactly once
+    Result set_order(const IDSPProcessor* const* order, uint32_t count);
+
+    // Skip a stage without removing it; its latency no longer counts
+    Result set_stage_bypassed(IDSPProcessor* processor, bool bypassed);
+
+    // Threads to spread the stages over, the caller's included (1 to
+    // MAX_THREADS). Applied by the next configure().
+    void set_threads(uint32_t threads);
+    uint32_t get_threads() const { return threads_; }
+
+    // Size the buffers and initialize every stage for a format. Stages are
+    // only reset when the format and thread count are unchanged.
+    Result configure(uint32_t sample_rate, uint16_t channels, uint32_t max_frames);
+
+    // Buffer for the next block: max_frames interleaved frames
+    float* input() { return blocks_[submitted_ % threads_].buffers[0]; }
+
+    // Filter the frames in input() through the active stages
+    // @return The buffer holding the result, valid until the next call
+    const float* process(uint32_t frames);
+
+    // Clear the state of every stage and drop the blocks in flight, e.g.
+    // after a seek
+    void reset();
+
+    // Latency of the active stages plus the pipeline, in frames
+    uint32_t get_latency_frames() const { return latency_frames_; }
+
+    uint32_t get_stage_count() const { return order_count_; }
+    uint32_t get_max_frames() const { return max_frames_; }
+
+    // Per-stage time, group placement and queue depths
+    void get_stats(DSPChainStats* stats) const;
+
+private:
+    struct Stage {
+        IDSPProcessor* processor;      // Null for a free slot
+        DestroyDSPProcessorFunc destroy;
+        bool in_place;
+        bool bypassed;
+        bool ready;                    // Initialized for the current format
+    };
+
+    // One block travelling through the groups
+    struct Block {
+        float* buffers[2];
+        uint32_t current;              // Which buffer holds the signal
+        uint32_t frames;
+    };
+
+    int find(const IDSPProcessor* processor) const;
+    void destroy_stage(Stage& stage);
+    Result initialize_stage(Stage& stage);
+    void update_latency();
+    uint32_t pipeline_latency_frames() const { return (threads_ - 1) * max_frames_; }
+
+    void run_group(Block& block, uint32_t group);
+    void worker_main(uint32_t group);
+    void start_workers();
+    void stop_workers();
+
+    // Caller side of the pipeline: wait for the oldest block, run the last
+    // group on it and queue the result for output
+    void finish_block();
+    void quiesce();
+    void reset_output();
+
+    // Move the group cuts to balance the measured stage times; force
+    // applies the best split even when it is no real improvement
+    void rebalance(bool force);
+
+    Stage stages_[MAX_STAGES];
+    uint32_t order_[MAX_STAGES];       // Slot indices in processing order
+    uint32_t order_count_;
+
+    // Measured per slot by whichever thread runs the stage
+    std::atomic<float> average_us_[MAX_STAGES];
+    std::atomic<float> peak_us_[MAX_STAGES];
+
+    std::vector<float> storage_;       // All buffers, with room to align them
+    Block blocks_[MAX_THREADS];
+    uint32_t sample_rate_;
+    uint16_t channels_;
+    uint32_t max_frames_;
+    uint32_t latency_frames_;
+
+    // Pipeline; group g covers order_[group_begin_[g]..group_begin_[g + 1])
+    uint32_t threads_requested_;
+    uint32_t threads_;
+    uint32_t group_begin_[MAX_THREADS + 1];
+    SpscRingBuffer<uint32_t> queues_[MAX_THREADS];   // Block indices waiting for group g
+    std::vector<std::thread> workers_;
+    std::atomic<bool> workers_running_;
+    uint64_t submitted_;               // Blocks handed to the first group
+    uint64_t finished_;                // Blocks through the last group
+    float* output_;                    // Filtered frames not yet returned
+    uint32_t output_frames_;
+    uint32_t output_returned_;         // Frames at the front handed out by the last process()
+    uint32_t blocks_since_rebalance_;
+    uint64_t rebalances_;
+};
+
+// Timing of one stage
+struct DSPStageStats {
+    const IDSPProcessor* processor;
+    uint32_t thread;                   // Group running it; the last is the caller's
+    bool bypassed;
+    bool ready;
+    float average_us;                  // Smoothed time per block
+    float peak_us;                     // Longest block since configure()
+};
+
+// Snapshot of a DSP chain, trivially copyable for SeqLock publishing
+struct DSPChainStats {
+    uint32_t stage_count;
+    uint32_t thread_count;
+    uint32_t pipeline_latency_frames;  // Part of the chain latency added by threading
+    uint32_t queue_depth[DSPChain::MAX_THREADS];   // Blocks waiting for each group
+    uint64_t rebalances;               // Times the group cuts moved
+    DSPStageStats stages[DSPChain::MAX_STAGES];    // In processing order
+};
+
+}} // namespace mp::core
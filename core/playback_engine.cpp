@@ -1,8 +1,10 @@
 #include "playback_engine.h"
+#include "universal_sample_rate_converter.h"
 #include <iostream>
 #include <algorithm>
 #include <cstring>
 #include <cmath>
+#include <chrono>
 
 namespace mp {
 namespace core {
@@ -14,7 +16,39 @@ PlaybackEngine::PlaybackEngine()
     , state_(PlaybackState::Stopped)
     , volume_(1.0f)
     , gapless_enabled_(true)
+    , has_track_(false)
+    , next_track_ready_(false)
+    , event_bus_(nullptr)
+    , next_track_requested_(false)
+    , output_open_(false)
+    , commands_(COMMAND_QUEUE_CAPACITY)
+    , start_generation_(0)
+    , started_generation_(0)
+    , next_serial_(1)
+    , decode_running_(false)
+    , decode_finished_(false)
+    , decoding_enabled_(false)
+    , dsp_latency_frames_(0)
+    , dsp_threads_(1)
+    , dsp_tail_frames_(0)
+    , dsp_tail_action_(DSPTailAction::None)
+    , resampler_quality_(audio::ResampleQuality::Good)
+    , configured_quality_(audio::ResampleQuality::Good)
+    , resampler_ready_(false)
+    , ring_capacity_(0)
+    , buffer_depth_ms_(DEFAULT_BUFFER_DEPTH_MS)
+    , output_rate_mode_(OutputRateMode::Fixed)
+    , track_output_rate_(DEFAULT_OUTPUT_SAMPLE_RATE)
+    , output_reopen_pending_(false)
+    , output_sample_rate_(DEFAULT_OUTPUT_SAMPLE_RATE)
+    , output_channels_(2)
+    , underrun_count_(0)
+    , underrun_frames_(0)
+    , last_refill_latency_us_(0)
+    , max_refill_latency_us_(0)
+    , resampler_cpu_cost_(0.0f)
     , initialized_(false) {
+    std::memset(&playhead_state_, 0, sizeof(playhead_state_));
 }
 
 PlaybackEngine::~PlaybackEngine() {
@@ -22,7 +56,7 @@ PlaybackEngine::~PlaybackEngine() {
 }
 
 Result PlaybackEngine::initialize(IAudioOutput* audio_output) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(control_mutex_);
     
     if (initialized_) {
         return Result::AlreadyInitialized;
@@ -35,44 +69,68 @@ Result PlaybackEngine::initialize(IAudioOutput* audio_output) {
     audio_output_ = audio_output;
     current_decoder_ = 0;
     next_decoder_ = -1;
+    has_track_ = false;
+    next_track_ready_ = false;
+    
+    std::memset(&playhead_state_, 0, sizeof(playhead_state_));
+    playhead_.store(playhead_state_);
+    resampler_.set_source(resampler_source, this);
+    resampler_ready_ = false;
+    
     initialized_ = true;
+    start_decode_thread();
     
     return Result::Success;
 }
 
 void PlaybackEngine::shutdown() {
-    stop();
+    if (stop() == Result::NotInitialized) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    
+    // Engine thread owns the decoders while it runs
+    stop_decode_thread();
     
-    std::lock_guard<std::mutex> lock(mutex_);
+    // Streams and processors handed over in commands that were never applied
+    PlaybackCommand command;
+    while (commands_.try_pop(command)) {
+        DecoderInstance& inst = command.instance;
+        if (inst.handle.internal && inst.decoder) {
+            inst.decoder->close_stream(inst.handle);
+        }
+        if (command.type == PlaybackCommandType::AddDSP) {
+            DSPChain::destroy_processor(command.dsp_processor, command.dsp_destroy);
+        }
+    }
+    dsp_chain_.clear();
+    publish_dsp_state();
     
     close_decoder(0);
     close_decoder(1);
+    next_decoder_ = -1;
+    has_track_ = false;
+    next_track_ready_ = false;
     
     audio_output_ = nullptr;
     initialized_ = false;
 }
 
-Result PlaybackEngine::load_track(const std::string& file_path, IDecoder* decoder) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (!initialized_) {
-        return Result::NotInitialized;
+Result PlaybackEngine::open_track(const std::string& file_path, IDecoder* decoder, DecoderInstance& inst) {
+    if (!decoder) {
+        return Result::InvalidParameter;
     }
-    
-    // Close current decoder
-    close_decoder(current_decoder_);
-    
-    // Open new track
-    DecoderInstance& inst = decoders_[current_decoder_];
+
     inst.decoder = decoder;
     inst.track_info.file_path = file_path;
-    
+
     Result result = decoder->open_stream(file_path.c_str(), &inst.handle);
     if (result != Result::Success) {
-        std::cerr << "Failed to open track: " << file_path << std::endl;
+        inst.handle.internal = nullptr;
         return result;
     }
-    
+
     // Get stream info
     result = decoder->get_stream_info(inst.handle, &inst.stream_info);
     if (result != Result::Success) {
@@ -80,63 +138,82 @@ Result PlaybackEngine::load_track(const std::string& file_path, IDecoder* decode
         inst.handle.internal = nullptr;
         return result;
     }
-    
+
     inst.track_info.total_samples = inst.stream_info.total_samples;
     inst.current_position = 0;
-    inst.active = false;
+    inst.active = true;
     inst.eos = false;
-    
+
     // TODO: Parse encoder delay/padding from metadata
     // For now, set to 0
     inst.track_info.encoder_delay = 0;
     inst.track_info.encoder_padding = 0;
+
+    inst.serial = next_serial_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(track_info_mutex_);
+        track_infos_[inst.serial % TRACK_INFO_SLOTS] = inst.track_info;
+    }
+
+    return Result::Success;
+}
+
+Result PlaybackEngine::load_track(const std::string& file_path, IDecoder* decoder) {
+    if (!initialized_) {
+        return Result::NotInitialized;
+    }
+    
+    // Open on the calling thread; the engine thread only swaps it in
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::LoadTrack;
+    Result result = open_track(file_path, decoder, command.instance);
+    if (result != Result::Success) {
+        std::cerr << "Failed to open track: " << file_path << std::endl;
+        return result;
+    }
+    
+    const AudioStreamInfo info = command.instance.stream_info;
+    const uint32_t output_rate = select_output_rate(info.sample_rate, 0);
+    command.instance.output_rate = output_rate;
+    result = push_command(std::move(command));
+    if (result != Result::Success) {
+        return result;
+    }
+    has_track_ = true;
+    track_output_rate_ = output_rate;
     
     std::cout << "Loaded track: " << file_path << std::endl;
-    std::cout << "  Sample rate: " << inst.stream_info.sample_rate << " Hz" << std::endl;
-    std::cout << "  Channels: " << inst.stream_info.channels << std::endl;
-    std::cout << "  Duration: " << (inst.stream_info.duration_ms / 1000) << " seconds" << std::endl;
+    std::cout << "  Sample rate: " << info.sample_rate << " Hz" << std::endl;
+    std::cout << "  Channels: " << info.channels << std::endl;
+    std::cout << "  Duration: " << (info.duration_ms / 1000) << " seconds" << std::endl;
     
     return Result::Success;
 }
 
 Result PlaybackEngine::prepare_next_track(const std::string& file_path, IDecoder* decoder) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     if (!initialized_) {
         return Result::NotInitialized;
     }
     
-    // Determine next decoder index (alternate between 0 and 1)
-    int next_idx = (current_decoder_ == 0) ? 1 : 0;
-    
-    // Close previous next decoder if any
-    close_decoder(next_idx);
-    
-    // Open next track
-    DecoderInstance& inst = decoders_[next_idx];
-    inst.decoder = decoder;
-    inst.track_info.file_path = file_path;
-    
-    Result result = decoder->open_stream(file_path.c_str(), &inst.handle);
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::PrepareNextTrack;
+    Result result = open_track(file_path, decoder, command.instance);
     if (result != Result::Success) {
         std::cerr << "Failed to prepare next track: " << file_path << std::endl;
         return result;
     }
+    command.instance.active = false;
     
-    // Get stream info
-    result = decoder->get_stream_info(inst.handle, &inst.stream_info);
+    // Stay on the current device rate when the track can follow without
+    // reopening the device, so the transition remains gapless
+    command.instance.output_rate = select_output_rate(command.instance.stream_info.sample_rate,
+                                                      gapless_enabled_ ? track_output_rate_.load() : 0);
+    
+    result = push_command(std::move(command));
     if (result != Result::Success) {
-        decoder->close_stream(inst.handle);
-        inst.handle.internal = nullptr;
         return result;
     }
-    
-    inst.track_info.total_samples = inst.stream_info.total_samples;
-    inst.current_position = 0;
-    inst.active = false;
-    inst.eos = false;
-    
-    next_decoder_ = next_idx;
+    next_track_ready_ = true;
     
     std::cout << "Prepared next track: " << file_path << std::endl;
     
@@ -144,7 +221,7 @@ Result PlaybackEngine::prepare_next_track(const std::string& file_path, IDecoder
 }
 
 Result PlaybackEngine::play() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(control_mutex_);
 
     if (!initialized_) {
         return Result::NotInitialized;
@@ -155,41 +232,43 @@ Result PlaybackEngine::play() {
     }
 
     // Check if we have a loaded track
-    if (!decoders_[current_decoder_].handle.internal) {
+    if (!has_track_) {
         return Result::InvalidState;
     }
 
-    // Ensure decoder is marked as active
-    decoders_[current_decoder_].active = true;
-    decoders_[current_decoder_].eos = false;
-
     // Configure and start audio output with system-preferred format for compatibility
     if (state_ == PlaybackState::Stopped) {
-        AudioOutputConfig config;
-        config.device_id = nullptr;  // Use default device
-        config.sample_rate = 48000;  // Use system preferred rate per analyst report
-        config.channels = 2;         // Force stereo for compatibility
-        config.format = SampleFormat::Float32;  // Use float for processing
-        config.buffer_frames = 1024;  // Smaller buffer for lower latency
-        config.callback = audio_callback;
-        config.user_data = this;
-
-        std::cout << "Configuring audio output: " << config.sample_rate
-                  << " Hz, " << config.channels << " channels" << std::endl;
-
-        Result result = audio_output_->open(config);
+        // Track ended on its own: output is still open and the track is at its end
+        if (output_open_) {
+            stop_locked();
+        }
+
+        Result result = open_output(track_output_rate_);
+        if (result != Result::Success) {
+            return result;
+        }
+
+        // Engine resets the ring and starts decoding; the output is not
+        // pulling yet, so it is the only thread touching the ring
+        PlaybackCommand command;
+        command.type = PlaybackCommandType::Start;
+        command.generation = start_generation_.fetch_add(1) + 1;
+        const uint32_t generation = command.generation;
+        result = push_command(std::move(command));
         if (result != Result::Success) {
-            std::cerr << "Failed to open audio output: " << static_cast<int>(result) << std::endl;
+            audio_output_->close();
+            output_open_ = false;
             return result;
         }
+
+        wait_for_prefill(generation);
     }
 
     state_ = PlaybackState::Playing;
 
     Result result = audio_output_->start();
     if (result != Result::Success) {
-        state_ = PlaybackState::Stopped;
-        decoders_[current_decoder_].active = false;
+        stop_locked();
         std::cerr << "Failed to start audio output: " << static_cast<int>(result) << std::endl;
         return result;
     }
@@ -198,8 +277,31 @@ Result PlaybackEngine::play() {
     return Result::Success;
 }
 
+Result PlaybackEngine::open_output(uint32_t sample_rate) {
+    AudioOutputConfig config;
+    config.device_id = nullptr;  // Use default device
+    config.sample_rate = sample_rate;
+    config.channels = output_channels_;        // Force stereo for compatibility
+    config.format = SampleFormat::Float32;  // Use float for processing
+    config.buffer_frames = 1024;  // Smaller buffer for lower latency
+    config.callback = audio_callback;
+    config.user_data = this;
+
+    std::cout << "Configuring audio output: " << config.sample_rate
+              << " Hz, " << config.channels << " channels" << std::endl;
+
+    Result result = audio_output_->open(config);
+    if (result != Result::Success) {
+        std::cerr << "Failed to open audio output: " << static_cast<int>(result) << std::endl;
+        return result;
+    }
+    output_open_ = true;
+    output_sample_rate_ = sample_rate;
+    return Result::Success;
+}
+
 Result PlaybackEngine::pause() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(control_mutex_);
     
     if (!initialized_) {
         return Result::NotInitialized;
@@ -217,88 +319,123 @@ Result PlaybackEngine::pause() {
 }
 
 Result PlaybackEngine::stop() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(control_mutex_);
     
     if (!initialized_) {
         return Result::NotInitialized;
     }
     
-    if (state_ == PlaybackState::Stopped) {
+    // Output stops itself at end of stream, so it may still be open
+    // even though the state is already Stopped
+    if (state_ == PlaybackState::Stopped && !output_open_) {
         return Result::Success;
     }
     
-    audio_output_->stop();
-    audio_output_->close();
-    
-    decoders_[current_decoder_].active = false;
-    decoders_[current_decoder_].current_position = 0;
-    
-    state_ = PlaybackState::Stopped;
+    Result result = stop_locked();
     
     std::cout << "Playback stopped" << std::endl;
-    return Result::Success;
+    return result;
+}
+
+Result PlaybackEngine::stop_locked() {
+    if (output_open_) {
+        audio_output_->stop();
+        audio_output_->close();
+        output_open_ = false;
+    }
+    state_ = PlaybackState::Stopped;
+
+    // Engine rewinds the track and drops what is buffered
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::Stop;
+    return push_command(std::move(command));
 }
 
 Result PlaybackEngine::seek(uint64_t position_ms) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     if (!initialized_) {
         return Result::NotInitialized;
     }
     
-    DecoderInstance& inst = decoders_[current_decoder_];
-    if (!inst.handle.internal) {
+    if (!has_track_) {
         return Result::InvalidState;
     }
     
-    uint64_t actual_position = 0;
-    Result result = inst.decoder->seek(inst.handle, position_ms, &actual_position);
-    if (result != Result::Success) {
-        return result;
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::Seek;
+    command.position_ms = position_ms;
+    return push_command(std::move(command));
+}
+
+const PlayheadSegment* PlaybackEngine::find_segment(const PlayheadSnapshot& snapshot, uint64_t read_position) {
+    if (snapshot.count == 0) {
+        return nullptr;
     }
-    
-    // Update position
-    inst.current_position = (actual_position * inst.stream_info.sample_rate) / 1000;
-    inst.eos = false;
-    
-    return Result::Success;
+
+    // Newest segment that the device has already reached
+    for (uint32_t i = 0; i < snapshot.count; ++i) {
+        if (snapshot.segments[i].ring_origin <= read_position) {
+            return &snapshot.segments[i];
+        }
+    }
+    return &snapshot.segments[snapshot.count - 1];
 }
 
 uint64_t PlaybackEngine::get_position() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // Read the device position first: a segment published after this
+    // point starts at or beyond it and is skipped by find_segment()
+    const uint64_t read_position = ring_.read_position();
+    const PlayheadSnapshot snapshot = playhead_.load();
     
-    const DecoderInstance& inst = decoders_[current_decoder_];
-    if (inst.stream_info.sample_rate == 0) {
+    const PlayheadSegment* segment = find_segment(snapshot, read_position);
+    if (!segment || segment->sample_rate == 0 || segment->ring_rate == 0) {
         return 0;
     }
     
-    return (inst.current_position * 1000) / inst.stream_info.sample_rate;
+    // Ring frames run at the device rate, the origin at the track rate.
+    // The DSP chain delays the audio behind the ring positions.
+    uint64_t position_ms = (segment->origin_frames * 1000) / segment->sample_rate;
+    const uint64_t dsp_latency = dsp_latency_frames_.load(std::memory_order_relaxed);
+    if (read_position > segment->ring_origin) {
+        uint64_t ring_frames = (read_position - segment->ring_origin) / output_channels_;
+        if (ring_frames > dsp_latency) {
+            position_ms += ((ring_frames - dsp_latency) * 1000) / segment->ring_rate;
+        }
+    }
+    
+    return position_ms;
 }
 
 uint64_t PlaybackEngine::get_duration() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return decoders_[current_decoder_].stream_info.duration_ms;
+    const PlayheadSnapshot snapshot = playhead_.load();
+    const PlayheadSegment* segment = find_segment(snapshot, ring_.read_position());
+    return segment ? segment->duration_ms : 0;
+}
+
+TrackInfo PlaybackEngine::get_current_track() const {
+    const PlayheadSnapshot snapshot = playhead_.load();
+    const PlayheadSegment* segment = find_segment(snapshot, ring_.read_position());
+    if (!segment || segment->serial == 0) {
+        return TrackInfo();
+    }
+
+    std::lock_guard<std::mutex> lock(track_info_mutex_);
+    return track_infos_[segment->serial % TRACK_INFO_SLOTS];
 }
 
 Result PlaybackEngine::transition_to_next() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_) {
+        return Result::NotInitialized;
+    }
     
-    if (next_decoder_ < 0) {
+    if (!next_track_ready_.exchange(false)) {
         return Result::InvalidState;  // No next track prepared
     }
     
     std::cout << "Transitioning to next track (gapless)" << std::endl;
     
-    // Close current decoder
-    close_decoder(current_decoder_);
-    
-    // Switch to next decoder
-    current_decoder_ = next_decoder_;
-    next_decoder_ = -1;
-    
-    decoders_[current_decoder_].active = true;
-    
-    return Result::Success;
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::TransitionToNext;
+    return push_command(std::move(command));
 }
 
 void PlaybackEngine::set_volume(float volume) {
@@ -314,47 +451,27 @@ void PlaybackEngine::audio_callback(void* buffer, size_t frames, void* user_data
 }
 
 void PlaybackEngine::fill_buffer(float* buffer, size_t frames) {
-    // This is called from audio thread - must be real-time safe
-
-    // Initialize buffer to silence first - always stereo for safety
-    std::memset(buffer, 0, frames * 2 * sizeof(float));
+    // This is called from audio thread - must be real-time safe.
+    // Decoding happens on the engine thread; here we only copy out of the ring.
+    // Flushed audio (seek / track load) is skipped inside ring_.read().
+    const size_t samples = frames * output_channels_;
 
     if (state_ != PlaybackState::Playing) {
+        std::memset(buffer, 0, samples * sizeof(float));
         return;  // Just return silence
     }
 
-    // Safety check: ensure decoder is valid
-    if (current_decoder_ < 0 || current_decoder_ >= 2) {
-        state_ = PlaybackState::Stopped;
-        return;
-    }
+    size_t copied = ring_.read(buffer, samples);
 
-    const DecoderInstance& decoder = decoders_[current_decoder_];
+    if (copied < samples) {
+        std::memset(buffer + copied, 0, (samples - copied) * sizeof(float));
 
-    // Safety check: ensure decoder is properly initialized
-    if (!decoder.handle.internal || !decoder.decoder) {
-        state_ = PlaybackState::Stopped;
-        return;
-    }
-
-    // Safety check: ensure stream info is valid
-    if (decoder.stream_info.channels == 0 || decoder.stream_info.sample_rate == 0) {
-        state_ = PlaybackState::Stopped;
-        return;
-    }
-
-    // Simple decode without gapless for now (avoid complexity that could cause crashes)
-    size_t decoded = decode_samples(current_decoder_, buffer, frames);
-
-    if (decoded < frames) {
-        // End of track - fill remaining with silence
-        size_t silence_samples = (frames - decoded) * decoder.stream_info.channels;
-        float* silence_start = buffer + (decoded * decoder.stream_info.channels);
-        std::memset(silence_start, 0, silence_samples * sizeof(float));
-
-        // Stop playback gracefully if we got no samples
-        if (decoded == 0) {
+        if (decode_finished_.load(std::memory_order_acquire) && ring_.available_read() == 0) {
+            // End of track and buffer drained - stop gracefully
             state_ = PlaybackState::Stopped;
+        } else if (!output_reopen_pending_.load(std::memory_order_acquire)) {
+            underrun_count_.fetch_add(1, std::memory_order_relaxed);
+            underrun_frames_.fetch_add((samples - copied) / output_channels_, std::memory_order_relaxed);
         }
     }
 }
@@ -366,42 +483,670 @@ size_t PlaybackEngine::decode_samples(int decoder_idx, float* buffer, size_t fra
         return 0;
     }
 
-    // Use a temporary buffer for decoder output
-    std::vector<int32_t> temp_buffer(frames * inst.stream_info.channels);
-    size_t temp_buffer_size = temp_buffer.size() * sizeof(int32_t);
+    const uint32_t src_channels = inst.stream_info.channels;
+    if (src_channels == 0 || decode_scratch_.size() < frames * src_channels) {
+        inst.eos = true;
+        return 0;
+    }
+
+    size_t buffer_size = frames * src_channels * sizeof(int32_t);
     size_t samples_decoded = 0;
 
-    // Decode to temporary buffer first
-    Result result = inst.decoder->decode_block(inst.handle, temp_buffer.data(), temp_buffer_size, &samples_decoded);
+    // Decode into the preallocated scratch buffer
+    Result result = inst.decoder->decode_block(inst.handle, decode_scratch_.data(), buffer_size, &samples_decoded);
 
     if (result != Result::Success || samples_decoded == 0) {
         inst.eos = true;
         return 0;
     }
+    samples_decoded = std::min(samples_decoded, frames);
 
-    // Convert int32 to float (normalized to [-1.0, 1.0])
-    for (size_t i = 0; i < samples_decoded * inst.stream_info.channels; ++i) {
-        buffer[i] = static_cast<float>(temp_buffer[i]) / 2147483648.0f;  // 2^31
+    // Drop encoder padding so the next track follows the last real sample
+    uint64_t effective_end = inst.track_info.total_samples - inst.track_info.encoder_padding;
+    if (inst.track_info.total_samples > 0) {
+        uint64_t remaining = effective_end > inst.current_position ? effective_end - inst.current_position : 0;
+        samples_decoded = static_cast<size_t>(std::min<uint64_t>(samples_decoded, remaining));
+    }
+
+    // Convert int32 to float (normalized to [-1.0, 1.0]) in output channel layout
+    const float scale = 1.0f / 2147483648.0f;  // 2^31
+    for (size_t i = 0; i < samples_decoded; ++i) {
+        const int32_t* src = &decode_scratch_[i * src_channels];
+        float* dst = &buffer[i * output_channels_];
+        for (uint32_t ch = 0; ch < output_channels_; ++ch) {
+            if (src_channels == 1) {
+                dst[ch] = static_cast<float>(src[0]) * scale;  // Mono to all outputs
+            } else if (ch < src_channels) {
+                dst[ch] = static_cast<float>(src[ch]) * scale;
+            } else {
+                dst[ch] = 0.0f;
+            }
+        }
     }
 
     // Update position
     inst.current_position += samples_decoded;
 
-    // Check if we've reached the end
-    uint64_t effective_end = inst.track_info.total_samples - inst.track_info.encoder_padding;
-    if (inst.current_position >= effective_end) {
+    // Check if we've reached the end (length unknown: wait for the decoder)
+    if (inst.track_info.total_samples > 0 && inst.current_position >= effective_end) {
         inst.eos = true;
     }
 
     return samples_decoded;
 }
 
-void PlaybackEngine::switch_decoder() {
-    // Must be called with mutex locked
+void PlaybackEngine::decode_thread_main() {
+    const size_t block_samples = DECODE_BLOCK_FRAMES * output_channels_;
+
+    while (decode_running_.load(std::memory_order_acquire)) {
+        // Control changes land between blocks, never mid-decode
+        apply_commands();
+
+        if (output_reopen_pending_.load(std::memory_order_relaxed)) {
+            reopen_output();
+        }
+
+        // A finished stream's DSP tail goes out before anything else
+        if (dsp_tail_frames_ > 0) {
+            drain_dsp();
+            if (dsp_tail_frames_ > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+            continue;
+        }
+
+        // Idle while stopped, the ring is full, the stream ended or the
+        // device still plays the previous track at its rate
+        if (!decoding_enabled_ ||
+            decode_finished_.load(std::memory_order_relaxed) ||
+            output_reopen_pending_.load(std::memory_order_relaxed) ||
+            ring_.available_write() < block_samples) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+
+        refill();
+    }
+}
+
+void PlaybackEngine::refill() {
+    using clock = std::chrono::steady_clock;
+    auto refill_start = clock::now();
+
+    // Pulls decoded audio through decode_gapless() at the track rate
+    size_t frames = resampler_.produce(dsp_chain_.input(), static_cast<int>(DECODE_BLOCK_FRAMES));
+    if (frames > 0) {
+        const float* filtered = dsp_chain_.process(static_cast<uint32_t>(frames));
+        ring_.write(filtered, frames * output_channels_);
+    }
+    publish_dsp_state();
+    if (frames < DECODE_BLOCK_FRAMES) {
+        // Source exhausted and converter tail flushed
+        if (gapless_enabled_ && next_decoder_ >= 0 && decoders_[current_decoder_].eos) {
+            // Next track runs at another rate: it starts right after the tail,
+            // or on a reopened device once the tail has played
+            switch_decoder(0);
+            if (decoders_[current_decoder_].output_rate != output_sample_rate_) {
+                start_dsp_tail(DSPTailAction::Reopen);
+            } else {
+                configure_resampler();
+            }
+        } else {
+            start_dsp_tail(DSPTailAction::Finish);
+        }
+    } else {
+        request_next_track();
+    }
+    resampler_cpu_cost_.store(static_cast<float>(resampler_.get_cpu_cost()), std::memory_order_relaxed);
+
+    uint32_t latency_us = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - refill_start).count());
+    last_refill_latency_us_.store(latency_us, std::memory_order_relaxed);
+    if (latency_us > max_refill_latency_us_.load(std::memory_order_relaxed)) {
+        max_refill_latency_us_.store(latency_us, std::memory_order_relaxed);
+    }
+}
+
+void PlaybackEngine::publish_dsp_state() {
+    dsp_latency_frames_.store(dsp_chain_.get_latency_frames(), std::memory_order_relaxed);
+    DSPChainStats stats;
+    dsp_chain_.get_stats(&stats);
+    dsp_stats_.store(stats);
+}
+
+void PlaybackEngine::start_dsp_tail(DSPTailAction action) {
+    dsp_tail_frames_ = dsp_chain_.get_latency_frames();
+    dsp_tail_action_ = action;
+    drain_dsp();
+}
+
+void PlaybackEngine::drain_dsp() {
+    size_t room = ring_.available_write() / output_channels_;
+    while (dsp_tail_frames_ > 0 && room > 0) {
+        uint32_t frames = static_cast<uint32_t>(
+            std::min(std::min<size_t>(dsp_tail_frames_, room), DECODE_BLOCK_FRAMES));
+        std::memset(dsp_chain_.input(), 0, frames * output_channels_ * sizeof(float));
+        ring_.write(dsp_chain_.process(frames), frames * output_channels_);
+        dsp_tail_frames_ -= frames;
+        room -= frames;
+    }
+    if (dsp_tail_frames_ > 0) {
+        return;
+    }
+
+    if (dsp_tail_action_ == DSPTailAction::Finish) {
+        decode_finished_.store(true, std::memory_order_release);
+    } else if (dsp_tail_action_ == DSPTailAction::Reopen) {
+        output_reopen_pending_.store(true, std::memory_order_release);
+    }
+    dsp_tail_action_ = DSPTailAction::None;
+}
+
+size_t PlaybackEngine::decode_gapless(float* buffer, size_t frames) {
+    size_t produced = 0;
+
+    while (produced < frames) {
+        // decode_scratch_ holds one block; the resampler may ask for more
+        size_t request = std::min(frames - produced, DECODE_BLOCK_FRAMES);
+        size_t decoded = decode_samples(current_decoder_, buffer + produced * output_channels_, request);
+        produced += decoded;
+
+        if (!decoders_[current_decoder_].eos) {
+            if (decoded == 0) {
+                break;  // No track loaded
+            }
+            continue;
+        }
+
+        // Current track ended: the rest of this block comes from the next one,
+        // with no silence or overlap at the boundary. A rate change instead
+        // ends the block so the resampler can flush and retune.
+        if (!gapless_enabled_ || next_decoder_ < 0 ||
+            decoders_[next_decoder_].stream_info.sample_rate != decoders_[current_decoder_].stream_info.sample_rate ||
+            decoders_[next_decoder_].output_rate != decoders_[current_decoder_].output_rate) {
+            break;
+        }
+        size_t pending_frames = static_cast<size_t>(resampler_.pending_output_frames() +
+                                                    resampler_.output_frames_for_input(produced));
+        switch_decoder(pending_frames * output_channels_);
+    }
+
+    return produced;
+}
+
+int PlaybackEngine::resampler_source(float* buffer, int max_frames, void* user_data) {
+    PlaybackEngine* engine = static_cast<PlaybackEngine*>(user_data);
+    return static_cast<int>(engine->decode_gapless(buffer, static_cast<size_t>(max_frames)));
+}
+
+void PlaybackEngine::configure_resampler() {
+    const DecoderInstance& inst = decoders_[current_decoder_];
+    if (inst.stream_info.sample_rate == 0) {
+        return;
+    }
+
+    const int input_rate = static_cast<int>(inst.stream_info.sample_rate);
+    const audio::ResampleQuality quality = resampler_quality_.load();
+
+    if (!resampler_ready_ || quality != configured_quality_ ||
+        resampler_.get_output_rate() != static_cast<int>(output_sample_rate_)) {
+        resampler_ready_ = resampler_.initialize(input_rate, static_cast<int>(output_sample_rate_),
+                                                 static_cast<int>(output_channels_), quality,
+                                                 static_cast<int>(DECODE_BLOCK_FRAMES));
+        configured_quality_ = quality;
+    } else if (resampler_.get_input_rate() != input_rate) {
+        resampler_ready_ = resampler_.set_input_rate(input_rate);
+    }
+
+    if (!resampler_ready_) {
+        std::cerr << "Failed to configure resampler: " << input_rate << " -> "
+                  << output_sample_rate_ << " Hz" << std::endl;
+    }
+}
+
+uint32_t PlaybackEngine::select_output_rate(uint32_t track_rate, uint32_t continue_rate) const {
+    if (output_rate_mode_ == OutputRateMode::Fixed || track_rate == 0) {
+        return DEFAULT_OUTPUT_SAMPLE_RATE;
+    }
+
+    // An integer ratio away from the running device rate is cheap to convert
+    // and avoids the gap of a device reopen
+    if (continue_rate != 0 &&
+        audio::AudioSampleRate::is_integer_ratio(static_cast<int>(track_rate), static_cast<int>(continue_rate))) {
+        return continue_rate;
+    }
+
+    std::vector<int> supported;
+    {
+        std::lock_guard<std::mutex> lock(output_rates_mutex_);
+        supported = supported_output_rates_;
+    }
+    return static_cast<uint32_t>(audio::AudioSampleRate::select_device_rate(
+        static_cast<int>(track_rate), supported, static_cast<int>(DEFAULT_OUTPUT_SAMPLE_RATE)));
+}
+
+void PlaybackEngine::reopen_output() {
+    // Let the device play out what was queued at the old rate
+    if (ring_.available_read() > 0) {
+        return;
+    }
+
+    // Never block on a control thread, which may itself be waiting for us
+    std::unique_lock<std::mutex> lock(control_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
+    if (!output_open_) {
+        // play() opens the device at the current track's rate
+        output_reopen_pending_.store(false, std::memory_order_release);
+        return;
+    }
+    if (state_ != PlaybackState::Playing) {
+        return;  // Paused: reopen once resumed
+    }
+
+    const uint32_t sample_rate = decoders_[current_decoder_].output_rate;
+    audio_output_->stop();
+    audio_output_->close();
+    output_open_ = false;
+
+    if (open_output(sample_rate) != Result::Success) {
+        state_ = PlaybackState::Stopped;
+        decoding_enabled_ = false;
+        output_reopen_pending_.store(false, std::memory_order_release);
+        return;
+    }
+
+    // Device is closed to the callback, so the ring can be rebuilt for the new rate
+    reset_ring();
+    resampler_.reset();
+    configure_resampler();
+    output_reopen_pending_.store(false, std::memory_order_release);
+
+    const size_t target = ring_.capacity() / 2;
+    while (ring_.available_read() < target && dsp_tail_frames_ == 0 &&
+           !decode_finished_.load(std::memory_order_relaxed) &&
+           !output_reopen_pending_.load(std::memory_order_relaxed)) {
+        refill();
+    }
+
+    if (audio_output_->start() != Result::Success) {
+        std::cerr << "Failed to restart audio output at " << sample_rate << " Hz" << std::endl;
+        stop_locked();
+    }
+}
+
+void PlaybackEngine::reset_ring() {
+    size_t ring_frames = (static_cast<size_t>(buffer_depth_ms_.load()) * output_sample_rate_) / 1000;
+    ring_frames = std::max(ring_frames, DECODE_BLOCK_FRAMES * 2);
+    if (ring_.capacity() < ring_frames * output_channels_ ||
+        ring_.capacity() >= ring_frames * output_channels_ * 2) {
+        ring_.initialize(ring_frames * output_channels_);
+        ring_capacity_.store(ring_.capacity(), std::memory_order_release);
+    } else {
+        ring_.clear();
+    }
+
+    // Stages are initialized for a new device rate or thread count,
+    // otherwise just cleared
+    dsp_tail_frames_ = 0;
+    dsp_tail_action_ = DSPTailAction::None;
+    dsp_chain_.set_threads(dsp_threads_.load());
+    dsp_chain_.configure(output_sample_rate_, static_cast<uint16_t>(output_channels_),
+                         static_cast<uint32_t>(DECODE_BLOCK_FRAMES));
+    publish_dsp_state();
+
+    // Ring indices restarted at zero; so does the playhead timeline
+    playhead_state_.count = 0;
+    begin_segment(false);
+}
+
+void PlaybackEngine::request_next_track() {
+    if (next_track_requested_ || next_decoder_ >= 0 || !gapless_enabled_ || !is_approaching_end()) {
+        return;
+    }
+    next_track_requested_ = true;
+
+    IEventBus* event_bus = event_bus_.load();
+    if (event_bus) {
+        event_bus->publish(Event(EVENT_NEXT_TRACK_REQUESTED));
+    }
+}
+
+void PlaybackEngine::start_decode_thread() {
+    if (decode_running_.exchange(true)) {
+        return;  // Already running
+    }
+    decode_thread_ = std::thread(&PlaybackEngine::decode_thread_main, this);
+}
+
+void PlaybackEngine::stop_decode_thread() {
+    decode_running_ = false;
+    if (decode_thread_.joinable()) {
+        decode_thread_.join();
+    }
+}
+
+Result PlaybackEngine::push_command(PlaybackCommand&& command) {
+    if (!commands_.try_push(std::move(command))) {
+        std::cerr << "Playback command queue full" << std::endl;
+        DecoderInstance& inst = command.instance;
+        if (inst.handle.internal && inst.decoder) {
+            inst.decoder->close_stream(inst.handle);
+            inst.handle.internal = nullptr;
+        }
+        return Result::Error;
+    }
+    return Result::Success;
+}
+
+void PlaybackEngine::apply_commands() {
+    PlaybackCommand command;
+    while (commands_.try_pop(command)) {
+        apply_command(command);
+    }
+}
+
+void PlaybackEngine::apply_command(PlaybackCommand& command) {
+    // Engine thread only
+    switch (command.type) {
+    case PlaybackCommandType::LoadTrack: {
+        close_decoder(current_decoder_);
+        decoders_[current_decoder_] = std::move(command.instance);
+        command.instance.handle.internal = nullptr;
+
+        // Make room for this track's channel count in the decoder scratch buffer
+        size_t scratch_samples = DECODE_BLOCK_FRAMES * decoders_[current_decoder_].stream_info.channels;
+        if (decode_scratch_.size() < scratch_samples) {
+            decode_scratch_.resize(scratch_samples);
+        }
+
+        // Anything still buffered belongs to the previous track
+        next_track_requested_ = false;
+        decode_finished_.store(false, std::memory_order_relaxed);
+        resampler_.reset();
+        configure_resampler();
+        begin_segment(true);
+
+        // Device may be open at the previous track's rate
+        output_reopen_pending_.store(decoders_[current_decoder_].output_rate != output_sample_rate_,
+                                     std::memory_order_release);
+        break;
+    }
+
+    case PlaybackCommandType::PrepareNextTrack: {
+        // Alternate between decoder slots 0 and 1
+        int next_idx = (current_decoder_ == 0) ? 1 : 0;
+        close_decoder(next_idx);
+        decoders_[next_idx] = std::move(command.instance);
+        command.instance.handle.internal = nullptr;
+
+        size_t scratch_samples = DECODE_BLOCK_FRAMES * decoders_[next_idx].stream_info.channels;
+        if (decode_scratch_.size() < scratch_samples) {
+            decode_scratch_.resize(scratch_samples);
+        }
+
+        next_decoder_ = next_idx;
+        break;
+    }
+
+    case PlaybackCommandType::Seek: {
+        DecoderInstance& inst = decoders_[current_decoder_];
+        if (!inst.handle.internal) {
+            break;
+        }
+
+        uint64_t actual_position = 0;
+        if (inst.decoder->seek(inst.handle, command.position_ms, &actual_position) != Result::Success) {
+            std::cerr << "Seek failed: " << command.position_ms << " ms" << std::endl;
+            break;
+        }
+
+        inst.current_position = (actual_position * inst.stream_info.sample_rate) / 1000;
+        inst.eos = false;
+
+        // Buffered audio is from before the seek point
+        decode_finished_.store(false, std::memory_order_relaxed);
+        resampler_.reset();
+        begin_segment(true);
+        break;
+    }
+
+    case PlaybackCommandType::TransitionToNext: {
+        if (next_decoder_ < 0) {
+            break;
+        }
+
+        // Buffered audio of the previous track still plays out, including
+        // what the resampler has converted but not yet handed over
+        switch_decoder(static_cast<size_t>(resampler_.pending_output_frames()) * output_channels_);
+        configure_resampler();
+        decode_finished_.store(false, std::memory_order_relaxed);
+        dsp_tail_action_ = DSPTailAction::None;
+        if (decoders_[current_decoder_].output_rate != output_sample_rate_) {
+            output_reopen_pending_.store(true, std::memory_order_release);
+        }
+        break;
+    }
+
+    case PlaybackCommandType::Start: {
+        // Output is open but not pulling, so the ring can be reset here
+        reset_ring();
+        output_reopen_pending_.store(false, std::memory_order_release);
+
+        // Quality changes take effect here
+        resampler_.reset();
+        configure_resampler();
+
+        decoders_[current_decoder_].active = true;
+        decoding_enabled_ = true;
+        decode_finished_.store(false, std::memory_order_relaxed);
+        underrun_count_ = 0;
+        underrun_frames_ = 0;
+        last_refill_latency_us_ = 0;
+        max_refill_latency_us_ = 0;
+        resampler_cpu_cost_ = 0.0f;
+
+        started_generation_.store(command.generation, std::memory_order_release);
+        break;
+    }
+
+    case PlaybackCommandType::Stop: {
+        decoding_enabled_ = false;
+        output_reopen_pending_.store(false, std::memory_order_release);
+
+        // Rewind so the next play starts from the beginning
+        DecoderInstance& inst = decoders_[current_decoder_];
+        if (inst.handle.internal) {
+            uint64_t actual_position = 0;
+            inst.decoder->seek(inst.handle, 0, &actual_position);
+            inst.current_position = 0;
+            inst.eos = false;
+        }
+
+        decode_finished_.store(false, std::memory_order_relaxed);
+        resampler_.reset();
+        begin_segment(true);
+        break;
+    }
+
+    case PlaybackCommandType::AddDSP: {
+        if (dsp_chain_.add_stage(command.dsp_processor, command.dsp_destroy) != Result::Success) {
+            std::cerr << "Failed to add DSP processor" << std::endl;
+            DSPChain::destroy_processor(command.dsp_processor, command.dsp_destroy);
+        }
+        break;
+    }
+
+    case PlaybackCommandType::RemoveDSP:
+        dsp_chain_.remove_stage(command.dsp_processor);
+        break;
+
+    case PlaybackCommandType::ReorderDSP:
+        if (dsp_chain_.set_order(command.dsp_order, command.dsp_order_count) != Result::Success) {
+            std::cerr << "Invalid DSP order" << std::endl;
+        }
+        break;
+
+    case PlaybackCommandType::BypassDSP:
+        dsp_chain_.set_stage_bypassed(command.dsp_processor, command.dsp_bypassed);
+        break;
+
+    case PlaybackCommandType::None:
+        break;
+    }
+
+    if (command.type == PlaybackCommandType::AddDSP || command.type == PlaybackCommandType::RemoveDSP ||
+        command.type == PlaybackCommandType::ReorderDSP || command.type == PlaybackCommandType::BypassDSP) {
+        publish_dsp_state();
+    }
+}
+
+void PlaybackEngine::begin_segment(bool flush, size_t pending_samples) {
+    // Engine thread only
+    if (flush) {
+        ring_.mark_flush();
+        dsp_chain_.reset();
+        dsp_tail_frames_ = 0;
+        dsp_tail_action_ = DSPTailAction::None;
+    }
+
+    const DecoderInstance& inst = decoders_[current_decoder_];
+
+    PlayheadSegment segment;
+    segment.ring_origin = ring_.write_position() + pending_samples;
+    segment.origin_frames = inst.current_position;
+    segment.sample_rate = inst.stream_info.sample_rate;
+    segment.ring_rate = output_sample_rate_;
+    segment.duration_ms = inst.stream_info.duration_ms;
+    segment.serial = inst.serial;
+
+    // Newest first; the oldest segment falls off the end
+    uint32_t count = std::min(playhead_state_.count + 1, PlayheadSnapshot::MAX_SEGMENTS);
+    for (uint32_t i = count - 1; i > 0; --i) {
+        playhead_state_.segments[i] = playhead_state_.segments[i - 1];
+    }
+    playhead_state_.segments[0] = segment;
+    playhead_state_.count = count;
+
+    playhead_.store(playhead_state_);
+}
+
+void PlaybackEngine::wait_for_prefill(uint32_t generation) {
+    // Must be called with control_mutex_ locked
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::milliseconds(PREFILL_TIMEOUT_MS);
+
+    // Half the ring is enough that the first callbacks do not underrun
+    while (clock::now() < deadline) {
+        if (started_generation_.load(std::memory_order_acquire) == generation) {
+            const size_t target = ring_capacity_.load(std::memory_order_acquire) / 2;
+            if (decode_finished_.load(std::memory_order_acquire) || ring_.available_read() >= target) {
+                return;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+Result PlaybackEngine::add_dsp_processor(IDSPProcessor* processor, DestroyDSPProcessorFunc destroy) {
+    if (!initialized_) {
+        return Result::NotInitialized;
+    }
+    if (!processor) {
+        return Result::InvalidParameter;
+    }
+
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::AddDSP;
+    command.dsp_processor = processor;
+    command.dsp_destroy = destroy;
+    return push_command(std::move(command));
+}
+
+Result PlaybackEngine::remove_dsp_processor(IDSPProcessor* processor) {
+    if (!initialized_) {
+        return Result::NotInitialized;
+    }
+
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::RemoveDSP;
+    command.dsp_processor = processor;
+    return push_command(std::move(command));
+}
+
+Result PlaybackEngine::set_dsp_order(const std::vector<IDSPProcessor*>& order) {
+    if (!initialized_) {
+        return Result::NotInitialized;
+    }
+    if (order.size() > DSPChain::MAX_STAGES) {
+        return Result::InvalidParameter;
+    }
+
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::ReorderDSP;
+    std::copy(order.begin(), order.end(), command.dsp_order);
+    command.dsp_order_count = static_cast<uint32_t>(order.size());
+    return push_command(std::move(command));
+}
+
+Result PlaybackEngine::set_dsp_bypass(IDSPProcessor* processor, bool bypassed) {
+    if (!initialized_) {
+        return Result::NotInitialized;
+    }
+
+    PlaybackCommand command;
+    command.type = PlaybackCommandType::BypassDSP;
+    command.dsp_processor = processor;
+    command.dsp_bypassed = bypassed;
+    return push_command(std::move(command));
+}
+
+void PlaybackEngine::set_resampler_quality(const std::string& quality) {
+    resampler_quality_ = audio::StreamingResampler::parse_quality(quality);
+}
+
+void PlaybackEngine::set_supported_output_rates(const std::vector<int>& rates) {
+    std::lock_guard<std::mutex> lock(output_rates_mutex_);
+    supported_output_rates_ = rates;
+}
+
+void PlaybackEngine::set_buffer_depth_ms(uint32_t depth_ms) {
+    buffer_depth_ms_ = std::max<uint32_t>(20, std::min<uint32_t>(depth_ms, 10000));
+}
+
+void PlaybackEngine::set_dsp_threads(uint32_t threads) {
+    dsp_threads_ = std::max<uint32_t>(1, std::min<uint32_t>(threads, DSPChain::MAX_THREADS));
+}
+
+PlaybackBufferStats PlaybackEngine::get_buffer_stats() const {
+    PlaybackBufferStats stats;
+    stats.capacity_frames = static_cast<uint32_t>(ring_capacity_.load(std::memory_order_acquire) / output_channels_);
+    stats.fill_frames = static_cast<uint32_t>(ring_.available_read() / output_channels_);
+    stats.fill_ms = output_sample_rate_ ?
+        static_cast<uint32_t>((static_cast<uint64_t>(stats.fill_frames) * 1000) / output_sample_rate_) : 0;
+    stats.underruns = underrun_count_.load(std::memory_order_relaxed);
+    stats.underrun_frames = underrun_frames_.load(std::memory_order_relaxed);
+    stats.last_refill_latency_us = last_refill_latency_us_.load(std::memory_order_relaxed);
+    stats.max_refill_latency_us = max_refill_latency_us_.load(std::memory_order_relaxed);
+    stats.resampler_cpu_cost = resampler_cpu_cost_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void PlaybackEngine::switch_decoder(size_t pending_samples) {
     close_decoder(current_decoder_);
     current_decoder_ = next_decoder_;
     next_decoder_ = -1;
     
+    decoders_[current_decoder_].active = true;
+    next_track_ready_ = false;
+    next_track_requested_ = false;
+    track_output_rate_ = decoders_[current_decoder_].output_rate;
+    
+    // Next track becomes audible right after the samples still pending
+    begin_segment(false, pending_samples);
+    
     std::cout << "Switched to next track" << std::endl;
 }
 
@@ -412,6 +1157,10 @@ bool PlaybackEngine::is_approaching_end() const {
         return false;
     }
     
+    if (inst.current_position >= inst.track_info.total_samples) {
+        return true;
+    }
+    
     uint64_t remaining_samples = inst.track_info.total_samples - inst.current_position;
     uint64_t remaining_ms = (remaining_samples * 1000) / inst.stream_info.sample_rate;
     
@@ -3,12 +3,19 @@
 #include "mp_types.h"
 #include "mp_decoder.h"
 #include "mp_audio_output.h"
+#include "mp_event.h"
+#include "spsc_ring_buffer.h"
+#include "bounded_mpsc_queue.h"
+#include "seqlock.h"
+#include "streaming_resampler.h"
+#include "dsp_chain.h"
 #include <memory>
 #include <atomic>
 #include <mutex>
 #include <thread>
 #include <queue>
 #include <string>
+#include <vector>
 
 namespace mp {
 namespace core {
@@ -21,6 +28,12 @@ enum class PlaybackState {
     Transitioning  // During gapless track change
 };
 
+// How the audio device sample rate is chosen
+enum class OutputRateMode {
+    Fixed,   // Always open the device at the default rate and resample
+    Native   // Open the device at each track's rate where possible
+};
+
 // Track information for playback
 struct TrackInfo {
     std::string file_path;
@@ -38,12 +51,16 @@ struct DecoderInstance {
     AudioStreamInfo stream_info;
     TrackInfo track_info;
     uint64_t current_position;  // In samples
+    uint32_t serial;            // Identifies the track in playhead snapshots
+    uint32_t output_rate;       // Device rate chosen for this track
     bool active;
     bool eos;  // End of stream reached
     
     DecoderInstance() 
         : decoder(nullptr)
         , current_position(0)
+        , serial(0)
+        , output_rate(0)
         , active(false)
         , eos(false) {
         handle.internal = nullptr;
@@ -51,6 +68,76 @@ struct DecoderInstance {
     }
 };
 
+// Control operation queued for the engine thread
+enum class PlaybackCommandType {
+    None,
+    LoadTrack,          // Replace current track (stream opened by caller)
+    PrepareNextTrack,   // Install gapless successor (stream opened by caller)
+    Seek,
+    TransitionToNext,
+    Start,              // Activate decoding and reset the ring
+    Stop,               // Deactivate decoding and rewind
+    AddDSP,             // Append a processor to the DSP chain
+    RemoveDSP,
+    ReorderDSP,
+    BypassDSP
+};
+
+struct PlaybackCommand {
+    PlaybackCommandType type;
+    DecoderInstance instance;   // LoadTrack / PrepareNextTrack
+    uint64_t position_ms;       // Seek
+    uint32_t generation;        // Start: handshake with play()
+    IDSPProcessor* dsp_processor;            // AddDSP / RemoveDSP / BypassDSP
+    DestroyDSPProcessorFunc dsp_destroy;     // AddDSP
+    bool dsp_bypassed;                       // BypassDSP
+    const IDSPProcessor* dsp_order[DSPChain::MAX_STAGES];   // ReorderDSP
+    uint32_t dsp_order_count;
+    
+    PlaybackCommand()
+        : type(PlaybackCommandType::None), position_ms(0), generation(0)
+        , dsp_processor(nullptr), dsp_destroy(nullptr), dsp_bypassed(false)
+        , dsp_order(), dsp_order_count(0) {}
+};
+
+// Stretch of the ring timeline that belongs to one track position.
+// A new segment starts on every load, seek and track change.
+struct PlayheadSegment {
+    uint64_t ring_origin;       // Ring sample index where the segment starts
+    uint64_t origin_frames;     // Track position (source frames) at ring_origin
+    uint32_t sample_rate;       // Track sample rate
+    uint32_t ring_rate;         // Rate of the frames stored in the ring
+    uint64_t duration_ms;
+    uint32_t serial;
+};
+
+// Published by the engine thread, read lock-free by get_position()/get_duration().
+// Keeps a few recent segments because the ring may still hold audio that
+// was queued before the latest one started.
+struct PlayheadSnapshot {
+    static constexpr uint32_t MAX_SEGMENTS = 4;
+    PlayheadSegment segments[MAX_SEGMENTS];  // Newest first
+    uint32_t count;
+};
+
+// Decode-ahead buffer statistics
+struct PlaybackBufferStats {
+    uint32_t capacity_frames;       // Ring capacity in output frames
+    uint32_t fill_frames;           // Frames currently buffered
+    uint32_t fill_ms;               // Buffered audio in milliseconds
+    uint64_t underruns;             // Callbacks that could not be fully served
+    uint64_t underrun_frames;       // Frames replaced with silence
+    uint32_t last_refill_latency_us; // Time to decode and queue the last block
+    uint32_t max_refill_latency_us;  // Worst refill time since playback start
+    float resampler_cpu_cost;        // Resampler CPU seconds per second of audio
+    
+    PlaybackBufferStats()
+        : capacity_frames(0), fill_frames(0), fill_ms(0)
+        , underruns(0), underrun_frames(0)
+        , last_refill_latency_us(0), max_refill_latency_us(0)
+        , resampler_cpu_cost(0.0f) {}
+};
+
 // Playback engine with gapless support
 class PlaybackEngine {
 public:
@@ -90,11 +177,11 @@ public:
     // Get playback state
     PlaybackState get_state() const { return state_; }
     
-    // Get current track info
-    const TrackInfo& get_current_track() const { return decoders_[current_decoder_].track_info; }
+    // Get info of the track currently audible
+    TrackInfo get_current_track() const;
     
     // Check if next track is ready for gapless
-    bool is_next_track_ready() const { return next_decoder_ >= 0; }
+    bool is_next_track_ready() const { return next_track_ready_; }
     
     // Trigger gapless transition to next track
     Result transition_to_next();
@@ -109,6 +196,58 @@ public:
     void set_gapless_enabled(bool enabled) { gapless_enabled_ = enabled; }
     bool is_gapless_enabled() const { return gapless_enabled_; }
     
+    // Event bus for EVENT_NEXT_TRACK_REQUESTED, published once per track when
+    // it nears its end with no successor prepared (may be null)
+    void set_event_bus(IEventBus* event_bus) { event_bus_ = event_bus; }
+    
+    // Decode-ahead buffer depth (in milliseconds), applied on next play from stop
+    void set_buffer_depth_ms(uint32_t depth_ms);
+    uint32_t get_buffer_depth_ms() const { return buffer_depth_ms_.load(); }
+    
+    // Decode-ahead buffer fill level, refill latency and underrun counters
+    PlaybackBufferStats get_buffer_stats() const;
+    
+    // Resampler quality by ResamplerConfig name ("fast", "good", "high", "best"),
+    // applied from the next track load or play from stop
+    void set_resampler_quality(const std::string& quality);
+    audio::ResampleQuality get_resampler_quality() const { return resampler_quality_; }
+    
+    // Device rate selection, decided per track when it is loaded or prepared
+    void set_output_rate_mode(OutputRateMode mode) { output_rate_mode_ = mode; }
+    OutputRateMode get_output_rate_mode() const { return output_rate_mode_; }
+    
+    // Rates the device accepts for native mode (empty: common studio rates)
+    void set_supported_output_rates(const std::vector<int>& rates);
+    
+    // Rate the device is currently opened at
+    uint32_t get_output_sample_rate() const { return output_sample_rate_; }
+    
+    // DSP chain between the resampler and the output. Changes are queued
+    // and applied by the engine thread between blocks. add_dsp_processor()
+    // hands the processor over, to be freed with destroy (null: delete);
+    // if queuing fails it stays with the caller.
+    Result add_dsp_processor(IDSPProcessor* processor, DestroyDSPProcessorFunc destroy = nullptr);
+    Result remove_dsp_processor(IDSPProcessor* processor);
+    
+    // New processing order; must list every added processor exactly once
+    Result set_dsp_order(const std::vector<IDSPProcessor*>& order);
+    
+    // Skip a processor in the chain without removing it
+    Result set_dsp_bypass(IDSPProcessor* processor, bool bypassed);
+    
+    // Summed latency of the active DSP stages and the DSP pipeline, already
+    // subtracted from get_position()
+    uint32_t get_dsp_latency_frames() const { return dsp_latency_frames_.load(std::memory_order_relaxed); }
+    
+    // Threads running the DSP chain, the engine thread included (1 to
+    // DSPChain::MAX_THREADS); each extra one adds a block of latency.
+    // Applied on next play from stop
+    void set_dsp_threads(uint32_t threads);
+    uint32_t get_dsp_threads() const { return dsp_threads_.load(); }
+    
+    // Per-stage DSP time, thread placement and queue depths
+    DSPChainStats get_dsp_stats() const { return dsp_stats_.load(); }
+    
 private:
     // Audio callback function
     static void audio_callback(void* buffer, size_t frames, void* user_data);
@@ -116,11 +255,97 @@ private:
     // Fill audio buffer (called from audio callback)
     void fill_buffer(float* buffer, size_t frames);
     
-    // Decode samples from active decoder
+    // Decode samples from active decoder into output-channel layout
+    // Engine thread only
     size_t decode_samples(int decoder_idx, float* buffer, size_t frames);
     
+    // Decode a block, continuing into the prepared next track when the
+    // current one ends so the ring holds both back to back
+    // Engine thread only
+    size_t decode_gapless(float* buffer, size_t frames);
+    
+    // Resampler input: decoded frames in output channel layout
+    static int resampler_source(float* buffer, int max_frames, void* user_data);
+    
+    // Match the resampler to the current track's rate
+    // Engine thread only
+    void configure_resampler();
+    
+    // Decode, resample, filter and queue one block
+    // Engine thread only
+    void refill();
+    
+    // Publish the DSP chain latency and statistics
+    // Engine thread only
+    void publish_dsp_state();
+    
+    // What follows once the DSP tail is out
+    enum class DSPTailAction {
+        None,
+        Finish,     // Stream ended: mark decoding finished
+        Reopen      // Next track needs another device rate
+    };
+    
+    // Feed silence through the DSP chain to push out the audio its stages
+    // still hold, before the stream ends or the device rate changes. What
+    // does not fit in the ring yet goes out on later engine loop passes.
+    // Engine thread only
+    void start_dsp_tail(DSPTailAction action);
+    void drain_dsp();
+    
+    // Device rate for a track; continue_rate is the rate a gapless
+    // predecessor plays at (0 when there is none)
+    uint32_t select_output_rate(uint32_t track_rate, uint32_t continue_rate) const;
+    
+    // Open the audio output at a sample rate
+    // Must be called with control_mutex_ locked
+    Result open_output(uint32_t sample_rate);
+    
+    // Reopen the device at the current track's rate once the ring has
+    // drained; retried until it succeeds. Engine thread only
+    void reopen_output();
+    
+    // Size the ring for the device rate and restart the playhead timeline
+    // Engine thread only, with the output not pulling
+    void reset_ring();
+    
+    // Ask for a successor once the current track nears its end
+    // Engine thread only
+    void request_next_track();
+    
+    // Engine thread: applies queued commands between blocks and keeps
+    // the ring buffer topped up. Sole owner of decoders_ while running.
+    void decode_thread_main();
+    void start_decode_thread();
+    void stop_decode_thread();
+    
+    // Queue a command for the engine thread (lock-free, any thread)
+    Result push_command(PlaybackCommand&& command);
+    
+    // Engine thread: apply all queued commands
+    void apply_commands();
+    void apply_command(PlaybackCommand& command);
+    
+    // Engine thread: invalidate buffered audio and start a new playhead segment
+    // pending_samples: samples decoded but not yet written before the segment starts
+    void begin_segment(bool flush, size_t pending_samples = 0);
+    
+    // Open a track on the calling thread so file I/O stays off the engine thread
+    Result open_track(const std::string& file_path, IDecoder* decoder, DecoderInstance& inst);
+    
+    // Stop and close the audio output, rewind the track
+    // Must be called with control_mutex_ locked
+    Result stop_locked();
+    
+    // Wait (bounded) until the engine has buffered enough to start output
+    void wait_for_prefill(uint32_t generation);
+    
+    // Segment covering a ring read position
+    static const PlayheadSegment* find_segment(const PlayheadSnapshot& snapshot, uint64_t read_position);
+    
     // Switch to next decoder (gapless transition)
-    void switch_decoder();
+    // Engine thread only
+    void switch_decoder(size_t pending_samples);
     
     // Check if approaching end of track
     bool is_approaching_end() const;
@@ -129,15 +354,91 @@ private:
     void close_decoder(int decoder_idx);
     
     IAudioOutput* audio_output_;
-    DecoderInstance decoders_[2];  // Dual decoder setup (A/B)
+    DecoderInstance decoders_[2];  // Dual decoder setup (A/B), engine thread only
     int current_decoder_;          // Index of current active decoder (0 or 1)
     int next_decoder_;             // Index of next decoder (-1 if none)
     
     std::atomic<PlaybackState> state_;
     std::atomic<float> volume_;
     std::atomic<bool> gapless_enabled_;
+    std::atomic<bool> has_track_;
+    std::atomic<bool> next_track_ready_;
+    std::atomic<IEventBus*> event_bus_;
+    bool next_track_requested_;    // Engine thread: request sent for current track
+    
+    // Serializes play/pause/stop (audio device lifecycle) between control
+    // threads. The engine thread only try-locks it to reopen the device
+    // between tracks; the audio thread never takes it.
+    mutable std::mutex control_mutex_;
+    bool output_open_;
+    
+    // Control path: commands in, playhead snapshots out
+    BoundedMpscQueue<PlaybackCommand> commands_;
+    SeqLock<PlayheadSnapshot> playhead_;
+    PlayheadSnapshot playhead_state_;     // Engine thread's copy of the snapshot
+    std::atomic<uint32_t> start_generation_;
+    std::atomic<uint32_t> started_generation_;
+    std::atomic<uint32_t> next_serial_;
+    
+    // Track infos by serial, for get_current_track()
+    static constexpr uint32_t TRACK_INFO_SLOTS = 8;
+    TrackInfo track_infos_[TRACK_INFO_SLOTS];
+    mutable std::mutex track_info_mutex_;
+    
+    // Decode-ahead ring (interleaved float, output channel layout)
+    SpscRingBuffer<float> ring_;
+    std::thread decode_thread_;
+    std::atomic<bool> decode_running_;
+    std::atomic<bool> decode_finished_;   // Decoder hit end of stream
+    bool decoding_enabled_;               // Engine thread: between Start and Stop
+    std::vector<int32_t> decode_scratch_; // Preallocated decoder output
+    
+    // Resampled blocks are filtered in the chain's own buffers, engine thread only
+    DSPChain dsp_chain_;
+    std::atomic<uint32_t> dsp_latency_frames_;
+    std::atomic<uint32_t> dsp_threads_;
+    SeqLock<DSPChainStats> dsp_stats_;
+    uint32_t dsp_tail_frames_;            // Silence still to push through, engine thread only
+    DSPTailAction dsp_tail_action_;
+    
+    // Source rate to device rate, engine thread only
+    audio::StreamingResampler resampler_;
+    std::atomic<audio::ResampleQuality> resampler_quality_;
+    audio::ResampleQuality configured_quality_;
+    bool resampler_ready_;
+    std::atomic<size_t> ring_capacity_;   // Published after the engine sizes the ring
+    std::atomic<uint32_t> buffer_depth_ms_;
+    
+    // Device rate selection
+    std::atomic<OutputRateMode> output_rate_mode_;
+    std::vector<int> supported_output_rates_;
+    mutable std::mutex output_rates_mutex_;
+    std::atomic<uint32_t> track_output_rate_;     // Device rate of the current track, used by play()
+    std::atomic<bool> output_reopen_pending_;     // Current track needs another device rate
+    std::atomic<uint32_t> output_sample_rate_;
+    uint32_t output_channels_;
+    
+    // Buffer statistics (written by audio/decoder threads)
+    std::atomic<uint64_t> underrun_count_;
+    std::atomic<uint64_t> underrun_frames_;
+    std::atomic<uint32_t> last_refill_latency_us_;
+    std::atomic<uint32_t> max_refill_latency_us_;
+    std::atomic<float> resampler_cpu_cost_;
+    
+    // Device rate in fixed mode, and fallback in native mode
+    static constexpr uint32_t DEFAULT_OUTPUT_SAMPLE_RATE = 48000;
+    
+    // Default decode-ahead depth (in milliseconds)
+    static constexpr uint32_t DEFAULT_BUFFER_DEPTH_MS = 500;
+    
+    // Frames decoded per refill step
+    static constexpr size_t DECODE_BLOCK_FRAMES = 1024;
+    
+    // Pending control commands before push_command reports failure
+    static constexpr size_t COMMAND_QUEUE_CAPACITY = 64;
     
-    mutable std::mutex mutex_;
+    // Longest play() waits for the initial decode-ahead fill
+    static constexpr uint32_t PREFILL_TIMEOUT_MS = 1000;
     
     // Pre-buffering threshold (in milliseconds)
     static constexpr uint64_t PREBUFFER_THRESHOLD_MS = 5000;  // 5 seconds
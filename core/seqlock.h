@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace mp {
+namespace core {
+
+// Single-writer sequence lock for small trivially copyable snapshots.
+// The writer never waits; readers retry while a store is in progress,
+// so polling from a UI thread can never stall the publishing thread.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock() : sequence_(0) {
+        std::memset(&data_, 0, sizeof(T));
+    }
+
+    // Writer thread only
+    void store(const T& value) {
+        uint32_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data_, &value, sizeof(T));
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Any thread
+    T load() const {
+        T value;
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            std::memcpy(&value, &data_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return value;
+    }
+
+private:
+    std::atomic<uint32_t> sequence_;
+    T data_;
+};
+
+// Sequence lock over a trivially copyable header plus an array of fixed
+// capacity, for snapshots whose length varies (one value per pixel or per
+// bar). Storage is allocated once in initialize(), so readers copy straight
+// out of it without locks and the single writer never waits for them.
+template <typename Header, typename T>
+class SeqLockBuffer {
+    static_assert(std::is_trivially_copyable<Header>::value &&
+                  std::is_trivially_copyable<T>::value,
+                  "SeqLockBuffer payload must be trivially copyable");
+
+public:
+    SeqLockBuffer() : sequence_(0) {
+        std::memset(&header_, 0, sizeof(Header));
+    }
+
+    SeqLockBuffer(const SeqLockBuffer&) = delete;
+    SeqLockBuffer& operator=(const SeqLockBuffer&) = delete;
+
+    // Not thread-safe: call before the writer and readers start
+    void initialize(size_t capacity) {
+        values_.assign(capacity, T());
+    }
+
+    size_t capacity() const { return values_.size(); }
+
+    // Writer thread only: fill header() and values() between the two calls
+    void begin_write() {
+        uint32_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    Header& header() { return header_; }
+    T* values() { return values_.data(); }
+
+    // Any thread: copy(header, values) runs until it sees a snapshot no
+    // write overlapped. A retried pass can see a torn header, so copy must
+    // clamp any count it reads from it to capacity().
+    template <typename Copy>
+    void read(Copy copy) const {
+        for (;;) {
+            uint32_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            Header header;
+            std::memcpy(&header, &header_, sizeof(Header));
+            copy(header, values_.data());
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint32_t> sequence_;
+    Header header_;
+    std::vector<T> values_;
+};
+
+}} // namespace mp::core
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+namespace mp {
+namespace core {
+
+// Lock-free single-producer/single-consumer ring buffer for trivially
+// copyable samples. Storage is allocated once in initialize(); read() and
+// write() never allocate, lock or block, so the consumer side is safe to
+// call from a real-time audio callback.
+//
+// Indices are free-running counters; capacity is rounded up to a power of
+// two so wrap-around is a mask instead of a modulo.
+//
+// The producer can invalidate everything written so far with mark_flush();
+// the consumer skips the stale region on its next read, so a flush never
+// needs a handshake between the two threads. The producer reuses the
+// flushed slots straight away: a consumer that was copying from them when
+// the flush landed notices and reads again from the mark, as a seqlock
+// reader would.
+template <typename T>
+class SpscRingBuffer {
+public:
+    SpscRingBuffer() : mask_(0), write_index_(0), read_index_(0), flush_mark_(0) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    // Allocate storage for at least min_capacity elements.
+    // Not thread-safe: call before producer and consumer start.
+    void initialize(size_t min_capacity) {
+        size_t capacity = 1;
+        while (capacity < min_capacity) {
+            capacity <<= 1;
+        }
+        buffer_.assign(capacity, T());
+        mask_ = capacity - 1;
+        clear();
+    }
+
+    // Drop all contents. Not thread-safe: both sides must be idle.
+    void clear() {
+        write_index_.store(0, std::memory_order_relaxed);
+        read_index_.store(0, std::memory_order_relaxed);
+        flush_mark_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return buffer_.size(); }
+
+    // Elements ready to be read (consumer view, excluding flushed data)
+    size_t available_read() const {
+        return write_index_.load(std::memory_order_acquire) - read_position();
+    }
+
+    // Total elements consumed so far, counting flushed data as consumed
+    size_t read_position() const {
+        return std::max(read_index_.load(std::memory_order_acquire),
+                        flush_mark_.load(std::memory_order_acquire));
+    }
+
+    // Total elements written so far
+    size_t write_position() const {
+        return write_index_.load(std::memory_order_acquire);
+    }
+
+    // Producer: everything written up to now is stale, and its slots are
+    // free for writing again
+    void mark_flush() {
+        flush_mark_.store(write_index_.load(std::memory_order_relaxed), std::memory_order_release);
+        // Writes into the freed slots stay behind the mark
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // Consumer: skip past a pending flush without reading
+    void apply_flush() {
+        read_index_.store(read_position(), std::memory_order_release);
+    }
+
+    // Free slots (producer view, counting flushed data as free)
+    size_t available_write() const {
+        return buffer_.size() - (write_index_.load(std::memory_order_relaxed) - reclaimed_position());
+    }
+
+    // Producer: copy up to count elements in, returns number written
+    size_t write(const T* data, size_t count) {
+        const size_t w = write_index_.load(std::memory_order_relaxed);
+        const size_t r = reclaimed_position();
+        const size_t free_slots = buffer_.size() - (w - r);
+        const size_t n = std::min(count, free_slots);
+        if (n == 0) {
+            return 0;
+        }
+
+        const size_t start = w & mask_;
+        const size_t first = std::min(n, buffer_.size() - start);
+        std::memcpy(&buffer_[start], data, first * sizeof(T));
+        if (n > first) {
+            std::memcpy(&buffer_[0], data + first, (n - first) * sizeof(T));
+        }
+
+        write_index_.store(w + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: copy up to count elements out, returns number read
+    size_t read(T* data, size_t count) {
+        for (;;) {
+            const size_t r = read_position();
+            const size_t w = write_index_.load(std::memory_order_acquire);
+            const size_t n = std::min(count, w - r);
+            if (n == 0) {
+                read_index_.store(r, std::memory_order_release);  // Release flushed slots
+                return 0;
+            }
+
+            const size_t start = r & mask_;
+            const size_t first = std::min(n, buffer_.size() - start);
+            std::memcpy(data, &buffer_[start], first * sizeof(T));
+            if (n > first) {
+                std::memcpy(data + first, &buffer_[0], (n - first) * sizeof(T));
+            }
+
+            // A flush during the copy may have handed these slots back to
+            // the producer: what was copied is stale or torn
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (flush_mark_.load(std::memory_order_relaxed) > r) {
+                continue;
+            }
+
+            read_index_.store(r + n, std::memory_order_release);
+            return n;
+        }
+    }
+
+    // Consumer: discard everything currently readable
+    size_t discard_all() {
+        const size_t r = read_position();
+        const size_t w = write_index_.load(std::memory_order_acquire);
+        read_index_.store(w, std::memory_order_release);
+        return w - r;
+    }
+
+private:
+    // Producer: oldest slot still in use, skipping flushed data the
+    // consumer has not caught up with
+    size_t reclaimed_position() const {
+        return std::max(read_index_.load(std::memory_order_acquire),
+                        flush_mark_.load(std::memory_order_relaxed));
+    }
+
+    std::vector<T> buffer_;
+    size_t mask_;
+
+    // Keep the two indices on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> write_index_;
+    alignas(64) std::atomic<size_t> read_index_;
+    std::atomic<size_t> flush_mark_;
+};
+
+}} // namespace mp::core
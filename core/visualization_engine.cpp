@@ -1,6 +1,7 @@
 #include "visualization_engine.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 #include <limits>
 
 namespace mp {
@@ -13,8 +14,23 @@ namespace {
 
 VisualizationEngine::VisualizationEngine()
     : initialized_(false)
+    , input_format_(0)
+    , producer_format_(0)
+    , analysis_running_(false)
+    , layout_changed_(false)
     , waveform_write_pos_(0)
+    , waveform_width_(1)
+    , spectrum_history_pos_(0)
+    , spectrogram_columns_(0)
+    , spectrogram_fft_size_(0)
+    , spectrogram_bins_(0)
+    , spectrogram_hop_(0)
+    , spectrogram_history_pos_(0)
+    , spectrogram_since_column_(0)
+    , spectrogram_written_(0)
     , rms_buffer_pos_(0)
+    , block_peak_left_(0.0f)
+    , block_peak_right_(0.0f)
     , peak_hold_time_left_(0.0f)
     , peak_hold_time_right_(0.0f)
     , current_sample_rate_(0)
@@ -29,6 +45,11 @@ VisualizationEngine::VisualizationEngine()
     vu_data_.peak_db_right = MIN_DB;
     vu_data_.rms_db_left = MIN_DB;
     vu_data_.rms_db_right = MIN_DB;
+    
+    // Fixed capacity, so a reader never sees the storage move
+    waveform_snapshot_.initialize(2 * static_cast<size_t>(MAX_WAVEFORM_WIDTH));
+    spectrum_snapshot_.initialize(2 * static_cast<size_t>(MAX_SPECTRUM_BARS));
+    vu_snapshot_.store(vu_data_);
 }
 
 VisualizationEngine::~VisualizationEngine() {
@@ -43,19 +64,73 @@ Result VisualizationEngine::initialize(const VisualizationConfig& config) {
     config_ = config;
     
     // Ensure FFT size is power of 2
-    config_.fft_size = next_power_of_two(config_.fft_size);
+    config_.fft_size = valid_fft_size(config_.fft_size);
+    if (config_.update_rate_hz == 0) {
+        config_.update_rate_hz = 60;
+    }
+    
+    // Input ring: four analysis periods of the widest supported format
+    size_t ring_frames = std::max<size_t>(
+        static_cast<size_t>(MAX_SAMPLE_RATE) * 4 / config_.update_rate_hz,
+        ANALYSIS_CHUNK_FRAMES);
+    input_ring_.initialize(ring_frames * MAX_CHANNELS);
+    input_format_.store(0, std::memory_order_relaxed);
+    producer_format_ = 0;
+    analysis_chunk_.assign(static_cast<size_t>(ANALYSIS_CHUNK_FRAMES) * MAX_CHANNELS, 0.0f);
+    analysis_mono_.assign(ANALYSIS_CHUNK_FRAMES, 0.0f);
+    
+    config_.waveform_width = std::max(1u, std::min(config_.waveform_width, MAX_WAVEFORM_WIDTH));
+    config_.spectrum_bars = std::max(2u, std::min(config_.spectrum_bars, MAX_SPECTRUM_BARS));
     
     // Initialize waveform buffer (ring buffer)
     size_t waveform_samples = static_cast<size_t>(
         config_.waveform_time_span * 48000.0f * 2); // Assume max 48kHz stereo
     waveform_buffer_.resize(waveform_samples, 0.0f);
     waveform_write_pos_ = 0;
+    waveform_width_ = config_.waveform_width;
+    waveform_columns_.assign(2 * static_cast<size_t>(MAX_WAVEFORM_WIDTH), 0.0f);
     
     // Initialize spectrum buffers
+    spectrum_history_.assign(config_.fft_size, 0.0f);
+    spectrum_history_pos_ = 0;
     spectrum_input_buffer_.resize(config_.fft_size, 0.0f);
-    spectrum_fft_output_.resize(config_.fft_size);
+    spectrum_fft_.initialize(config_.fft_size);
+    spectrum_fft_real_.resize(spectrum_fft_.bins());
+    spectrum_fft_imag_.resize(spectrum_fft_.bins());
     spectrum_bar_values_.resize(config_.spectrum_bars, MIN_DB);
     spectrum_smoothed_bars_.resize(config_.spectrum_bars, MIN_DB);
+    update_spectrum_frequencies();
+    
+    // Spectrogram ring. assign() keeps the storage when re-initialized with
+    // the same size, so a view still holding the engine reads valid memory.
+    config_.spectrogram_columns = std::min(config_.spectrogram_columns, MAX_SPECTROGRAM_COLUMNS);
+    config_.spectrogram_overlap = std::max(0.0f, std::min(0.9375f, config_.spectrogram_overlap));
+    spectrogram_columns_ = config_.spectrogram_columns;
+    spectrogram_fft_size_ = std::min(config_.fft_size, MAX_SPECTROGRAM_FFT_SIZE);
+    spectrogram_bins_ = spectrogram_fft_size_ / 2 + 1;
+    spectrogram_hop_ = std::max(1u, static_cast<uint32_t>(
+        std::lround(spectrogram_fft_size_ * (1.0f - config_.spectrogram_overlap))));
+    spectrogram_history_pos_ = 0;
+    spectrogram_since_column_ = 0;
+    spectrogram_written_.store(0, std::memory_order_relaxed);
+    if (spectrogram_columns_ > 0) {
+        // Periodic Hann, scaled so a full-scale sine on a bin reads 0 dB
+        spectrogram_window_.resize(spectrogram_fft_size_);
+        float window_sum = 0.0f;
+        for (uint32_t i = 0; i < spectrogram_fft_size_; ++i) {
+            spectrogram_window_[i] = 0.5f * (1.0f - std::cos(2.0f * PI * i / spectrogram_fft_size_));
+            window_sum += spectrogram_window_[i];
+        }
+        for (float& w : spectrogram_window_) {
+            w *= 2.0f / window_sum;
+        }
+        spectrogram_history_.assign(spectrogram_fft_size_, 0.0f);
+        spectrogram_input_.assign(spectrogram_fft_size_, 0.0f);
+        spectrogram_fft_.initialize(spectrogram_fft_size_);
+        spectrogram_fft_real_.assign(spectrogram_bins_, 0.0f);
+        spectrogram_fft_imag_.assign(spectrogram_bins_, 0.0f);
+        spectrogram_ring_.assign(static_cast<size_t>(spectrogram_columns_) * spectrogram_bins_, MIN_DB);
+    }
     
     // Initialize VU meter buffers
     size_t rms_samples = static_cast<size_t>(
@@ -63,8 +138,18 @@ Result VisualizationEngine::initialize(const VisualizationConfig& config) {
     rms_buffer_left_.resize(rms_samples, 0.0f);
     rms_buffer_right_.resize(rms_samples, 0.0f);
     rms_buffer_pos_ = 0;
+    block_peak_left_ = 0.0f;
+    block_peak_right_ = 0.0f;
+    
+    // Readers see an empty display until the first analysis pass
+    publish_waveform();
+    publish_spectrum();
+    vu_snapshot_.store(vu_data_);
+    layout_changed_ = false;
     
     initialized_ = true;
+    analysis_running_ = true;
+    analysis_thread_ = std::thread(&VisualizationEngine::analysis_thread_main, this);
     return Result::Success;
 }
 
@@ -73,9 +158,20 @@ void VisualizationEngine::shutdown() {
         return;
     }
     
+    {
+        std::lock_guard<std::mutex> lock(analysis_mutex_);
+        analysis_running_ = false;
+    }
+    analysis_cv_.notify_one();
+    if (analysis_thread_.joinable()) {
+        analysis_thread_.join();
+    }
+    
     waveform_buffer_.clear();
+    spectrum_history_.clear();
     spectrum_input_buffer_.clear();
-    spectrum_fft_output_.clear();
+    spectrum_fft_real_.clear();
+    spectrum_fft_imag_.clear();
     spectrum_bar_values_.clear();
     spectrum_smoothed_bars_.clear();
     rms_buffer_left_.clear();
@@ -86,124 +182,256 @@ void VisualizationEngine::shutdown() {
 
 void VisualizationEngine::process_audio(const float* samples, size_t frame_count,
                                        uint16_t channels, uint32_t sample_rate) {
-    if (!initialized_ || !samples || frame_count == 0) {
+    if (!initialized_ || !samples || frame_count == 0 || channels == 0) {
         return;
     }
     
-    current_sample_rate_ = sample_rate;
-    current_channels_ = channels;
-    
-    // Process waveform data
-    {
-        std::lock_guard<std::mutex> lock(waveform_mutex_);
-        for (size_t i = 0; i < frame_count; ++i) {
-            // Mix to mono for waveform
-            float mono_sample = 0.0f;
-            for (uint16_t ch = 0; ch < channels; ++ch) {
-                mono_sample += samples[i * channels + ch];
-            }
-            mono_sample /= static_cast<float>(channels);
-            
-            waveform_buffer_[waveform_write_pos_] = mono_sample;
-            waveform_write_pos_ = (waveform_write_pos_ + 1) % waveform_buffer_.size();
-        }
+    // Frames of the old format still in the ring are stale once the format
+    // changes; flush them before the analysis thread can see the new one.
+    // Their slots count as free for the new format right away.
+    uint64_t format = (static_cast<uint64_t>(sample_rate) << 16) | channels;
+    if (format != producer_format_) {
+        producer_format_ = format;
+        input_ring_.mark_flush();
+        input_format_.store(format, std::memory_order_release);
     }
     
-    // Process spectrum data (use first block of audio)
-    {
-        std::lock_guard<std::mutex> lock(spectrum_mutex_);
-        size_t samples_to_copy = std::min(frame_count, spectrum_input_buffer_.size());
+    // Whole frames only, so the reader stays frame-aligned
+    size_t frames = std::min(frame_count, input_ring_.available_write() / channels);
+    input_ring_.write(samples, frames * channels);
+}
+
+void VisualizationEngine::analysis_thread_main() {
+    const auto period = std::chrono::microseconds(1000000 / config_.update_rate_hz);
+    uint64_t analysis_format = 0;
+    
+    std::unique_lock<std::mutex> lock(analysis_mutex_);
+    while (analysis_running_) {
+        analysis_cv_.wait_for(lock, period, [this] { return !analysis_running_; });
+        if (!analysis_running_) {
+            break;
+        }
+        lock.unlock();
         
-        for (size_t i = 0; i < samples_to_copy; ++i) {
-            // Mix to mono for spectrum
-            float mono_sample = 0.0f;
-            for (uint16_t ch = 0; ch < channels; ++ch) {
-                mono_sample += samples[i * channels + ch];
+        size_t analyzed = 0;
+        for (;;) {
+            uint64_t format = input_format_.load(std::memory_order_acquire);
+            uint16_t channels = static_cast<uint16_t>(format & 0xFFFF);
+            if (channels == 0) {
+                break;
+            }
+            if (format != analysis_format) {
+                analysis_format = format;
+                current_sample_rate_ = static_cast<uint32_t>(format >> 16);
+                current_channels_ = channels;
+            }
+            
+            size_t frames = std::min<size_t>(input_ring_.available_read() / channels,
+                                             ANALYSIS_CHUNK_FRAMES);
+            if (frames == 0) {
+                break;
+            }
+            input_ring_.read(analysis_chunk_.data(), frames * channels);
+            
+            // The format changed while reading: the frames may be of either
+            if (input_format_.load(std::memory_order_acquire) != format) {
+                continue;
             }
-            mono_sample /= static_cast<float>(channels);
-            spectrum_input_buffer_[i] = mono_sample;
+            analyze_frames(analysis_chunk_.data(), frames, channels);
+            analyzed += frames;
         }
         
-        // Apply Hann window
-        apply_hann_window(spectrum_input_buffer_);
-        
-        // Compute FFT
-        compute_fft(spectrum_input_buffer_, spectrum_fft_output_);
-        
-        // Map FFT to frequency bars
-        map_fft_to_bars(spectrum_fft_output_, spectrum_bar_values_);
+        bool layout_changed = layout_changed_.exchange(false, std::memory_order_acquire);
+        if (analyzed > 0) {
+            update_spectrum();
+            update_vu_meter();
+        }
+        if (analyzed > 0 || layout_changed) {
+            publish_waveform();
+            publish_spectrum();
+        }
         
-        // Apply smoothing
-        for (size_t i = 0; i < spectrum_bar_values_.size(); ++i) {
-            spectrum_smoothed_bars_[i] = 
-                config_.spectrum_smoothing * spectrum_smoothed_bars_[i] +
-                (1.0f - config_.spectrum_smoothing) * spectrum_bar_values_[i];
+        lock.lock();
+    }
+}
+
+void VisualizationEngine::analyze_frames(const float* samples, size_t frame_count,
+                                        uint16_t channels) {
+    // Mix to mono for waveform and spectrum
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (size_t i = 0; i < frame_count; ++i) {
+        float mono_sample = 0.0f;
+        for (uint16_t ch = 0; ch < channels; ++ch) {
+            mono_sample += samples[i * channels + ch];
         }
+        analysis_mono_[i] = mono_sample * scale;
+    }
+    
+    for (size_t i = 0; i < frame_count; ++i) {
+        waveform_buffer_[waveform_write_pos_] = analysis_mono_[i];
+        waveform_write_pos_ = (waveform_write_pos_ + 1) % waveform_buffer_.size();
     }
     
-    // Process VU meter data
     {
-        std::lock_guard<std::mutex> lock(vu_mutex_);
-        
-        float peak_left = 0.0f;
-        float peak_right = 0.0f;
-        float sum_sq_left = 0.0f;
-        float sum_sq_right = 0.0f;
-        
+        std::lock_guard<std::mutex> lock(spectrum_mutex_);
         for (size_t i = 0; i < frame_count; ++i) {
-            float left = samples[i * channels];
-            float right = (channels > 1) ? samples[i * channels + 1] : left;
-            
-            // Peak detection
-            peak_left = std::max(peak_left, std::abs(left));
-            peak_right = std::max(peak_right, std::abs(right));
-            
-            // RMS calculation (store in ring buffer)
-            rms_buffer_left_[rms_buffer_pos_] = left * left;
-            rms_buffer_right_[rms_buffer_pos_] = right * right;
-            rms_buffer_pos_ = (rms_buffer_pos_ + 1) % rms_buffer_left_.size();
+            spectrum_history_[spectrum_history_pos_] = analysis_mono_[i];
+            spectrum_history_pos_ = (spectrum_history_pos_ + 1) % spectrum_history_.size();
         }
+    }
+    
+    if (spectrogram_columns_ > 0) {
+        advance_spectrogram(analysis_mono_.data(), frame_count);
+    }
+    
+    for (size_t i = 0; i < frame_count; ++i) {
+        float left = samples[i * channels];
+        float right = (channels > 1) ? samples[i * channels + 1] : left;
         
-        // Calculate RMS
-        for (float val : rms_buffer_left_) sum_sq_left += val;
-        for (float val : rms_buffer_right_) sum_sq_right += val;
-        
-        float rms_left = std::sqrt(sum_sq_left / rms_buffer_left_.size());
-        float rms_right = std::sqrt(sum_sq_right / rms_buffer_right_.size());
-        
-        // Update peak with hold
-        vu_data_.peak_left = std::max(vu_data_.peak_left, peak_left);
-        vu_data_.peak_right = std::max(vu_data_.peak_right, peak_right);
-        
-        // Update RMS
-        vu_data_.rms_left = rms_left;
-        vu_data_.rms_right = rms_right;
+        // Peak detection
+        block_peak_left_ = std::max(block_peak_left_, std::abs(left));
+        block_peak_right_ = std::max(block_peak_right_, std::abs(right));
         
-        // Convert to dB
-        vu_data_.peak_db_left = linear_to_db(vu_data_.peak_left);
-        vu_data_.peak_db_right = linear_to_db(vu_data_.peak_right);
-        vu_data_.rms_db_left = linear_to_db(vu_data_.rms_left);
-        vu_data_.rms_db_right = linear_to_db(vu_data_.rms_right);
+        // RMS calculation (store in ring buffer)
+        rms_buffer_left_[rms_buffer_pos_] = left * left;
+        rms_buffer_right_[rms_buffer_pos_] = right * right;
+        rms_buffer_pos_ = (rms_buffer_pos_ + 1) % rms_buffer_left_.size();
     }
 }
 
-WaveformData VisualizationEngine::get_waveform_data() {
-    WaveformData data;
+void VisualizationEngine::update_spectrum() {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
     
-    std::lock_guard<std::mutex> lock(waveform_mutex_);
+    // Latest fft_size samples, oldest first
+    size_t n = spectrum_history_.size();
+    size_t first = n - spectrum_history_pos_;
+    std::copy(spectrum_history_.begin() + spectrum_history_pos_, spectrum_history_.end(),
+              spectrum_input_buffer_.begin());
+    std::copy(spectrum_history_.begin(), spectrum_history_.begin() + spectrum_history_pos_,
+              spectrum_input_buffer_.begin() + first);
     
-    data.sample_rate = current_sample_rate_;
-    data.channels = current_channels_;
-    data.time_span_seconds = config_.waveform_time_span;
+    // Apply Hann window
+    apply_hann_window(spectrum_input_buffer_);
     
-    // Downsample waveform to pixel width
-    size_t samples_per_pixel = waveform_buffer_.size() / config_.waveform_width;
-    if (samples_per_pixel == 0) samples_per_pixel = 1;
+    // Compute FFT
+    spectrum_fft_.forward(spectrum_input_buffer_.data(), spectrum_fft_real_.data(),
+                          spectrum_fft_imag_.data());
+    
+    // Map FFT to frequency bars
+    map_fft_to_bars(spectrum_fft_real_, spectrum_fft_imag_, spectrum_bar_values_);
+    
+    // Apply smoothing
+    for (size_t i = 0; i < spectrum_bar_values_.size(); ++i) {
+        spectrum_smoothed_bars_[i] = 
+            config_.spectrum_smoothing * spectrum_smoothed_bars_[i] +
+            (1.0f - config_.spectrum_smoothing) * spectrum_bar_values_[i];
+    }
+}
+
+void VisualizationEngine::advance_spectrogram(const float* mono, size_t count) {
+    // Runs of samples up to the next hop boundary, so columns land exactly
+    // every spectrogram_hop_ samples whatever the chunk sizes
+    size_t i = 0;
+    while (i < count) {
+        size_t run = std::min(count - i, spectrogram_hop_ - spectrogram_since_column_);
+        for (size_t k = 0; k < run; ++k) {
+            spectrogram_history_[spectrogram_history_pos_] = mono[i + k];
+            if (++spectrogram_history_pos_ == spectrogram_history_.size()) {
+                spectrogram_history_pos_ = 0;
+            }
+        }
+        i += run;
+        spectrogram_since_column_ += run;
+        if (spectrogram_since_column_ == spectrogram_hop_) {
+            spectrogram_since_column_ = 0;
+            compute_spectrogram_column();
+        }
+    }
+}
+
+void VisualizationEngine::compute_spectrogram_column() {
+    // Latest fft_size samples, oldest first, windowed
+    const size_t n = spectrogram_history_.size();
+    const size_t first = n - spectrogram_history_pos_;
+    for (size_t i = 0; i < first; ++i) {
+        spectrogram_input_[i] = spectrogram_history_[spectrogram_history_pos_ + i] * spectrogram_window_[i];
+    }
+    for (size_t i = 0; i < spectrogram_history_pos_; ++i) {
+        spectrogram_input_[first + i] = spectrogram_history_[i] * spectrogram_window_[first + i];
+    }
+    spectrogram_fft_.forward(spectrogram_input_.data(), spectrogram_fft_real_.data(),
+                             spectrogram_fft_imag_.data());
+    
+    const uint64_t column = spectrogram_written_.load(std::memory_order_relaxed);
+    float* out = &spectrogram_ring_[(column % spectrogram_columns_) * spectrogram_bins_];
+    
+    // Readers check the count after copying: keep its last store ahead of
+    // the writes that overwrite this slot
+    std::atomic_thread_fence(std::memory_order_release);
+    const float min_power = db_to_linear(2.0f * MIN_DB);
+    for (uint32_t bin = 0; bin < spectrogram_bins_; ++bin) {
+        float power = spectrogram_fft_real_[bin] * spectrogram_fft_real_[bin] +
+                      spectrogram_fft_imag_[bin] * spectrogram_fft_imag_[bin];
+        out[bin] = power > min_power ? 10.0f * std::log10(power) : MIN_DB;
+    }
+    spectrogram_written_.store(column + 1, std::memory_order_release);
+}
+
+void VisualizationEngine::update_vu_meter() {
+    float sum_sq_left = 0.0f;
+    float sum_sq_right = 0.0f;
     
-    data.min_values.resize(config_.waveform_width);
-    data.max_values.resize(config_.waveform_width);
+    // Calculate RMS
+    for (float val : rms_buffer_left_) sum_sq_left += val;
+    for (float val : rms_buffer_right_) sum_sq_right += val;
     
-    for (uint32_t pixel = 0; pixel < config_.waveform_width; ++pixel) {
+    float rms_left = std::sqrt(sum_sq_left / rms_buffer_left_.size());
+    float rms_right = std::sqrt(sum_sq_right / rms_buffer_right_.size());
+    
+    // Update peak with hold
+    vu_data_.peak_left = std::max(vu_data_.peak_left, block_peak_left_);
+    vu_data_.peak_right = std::max(vu_data_.peak_right, block_peak_right_);
+    block_peak_left_ = 0.0f;
+    block_peak_right_ = 0.0f;
+    
+    // Update RMS
+    vu_data_.rms_left = rms_left;
+    vu_data_.rms_right = rms_right;
+    
+    // Convert to dB
+    vu_data_.peak_db_left = linear_to_db(vu_data_.peak_left);
+    vu_data_.peak_db_right = linear_to_db(vu_data_.peak_right);
+    vu_data_.rms_db_left = linear_to_db(vu_data_.rms_left);
+    vu_data_.rms_db_right = linear_to_db(vu_data_.rms_right);
+    
+    vu_snapshot_.store(vu_data_);
+}
+
+void VisualizationEngine::update_spectrum_frequencies() {
+    // Center frequencies for each bar (logarithmic spacing)
+    size_t bars = spectrum_smoothed_bars_.size();
+    spectrum_frequencies_.resize(bars);
+    float log_min = std::log10(config_.spectrum_min_freq);
+    float log_max = std::log10(config_.spectrum_max_freq);
+    float log_range = log_max - log_min;
+    
+    for (size_t i = 0; i < bars; ++i) {
+        float t = static_cast<float>(i) / (bars - 1);
+        float log_freq = log_min + t * log_range;
+        spectrum_frequencies_[i] = std::pow(10.0f, log_freq);
+    }
+}
+
+void VisualizationEngine::publish_waveform() {
+    // Downsample waveform to pixel width, outside the write section so
+    // readers only ever wait for the copy
+    uint32_t width = waveform_width_.load(std::memory_order_relaxed);
+    size_t samples_per_pixel = waveform_buffer_.size() / width;
+    if (samples_per_pixel == 0) samples_per_pixel = 1;
+    
+    float* min_values = waveform_columns_.data();
+    float* max_values = min_values + width;
+    for (uint32_t pixel = 0; pixel < width; ++pixel) {
         float min_val = std::numeric_limits<float>::max();
         float max_val = std::numeric_limits<float>::lowest();
         
@@ -217,114 +445,155 @@ WaveformData VisualizationEngine::get_waveform_data() {
             max_val = std::max(max_val, sample);
         }
         
-        data.min_values[pixel] = min_val;
-        data.max_values[pixel] = max_val;
+        min_values[pixel] = min_val;
+        max_values[pixel] = max_val;
     }
     
-    return data;
+    waveform_snapshot_.begin_write();
+    WaveformHeader& header = waveform_snapshot_.header();
+    header.width = width;
+    header.sample_rate = current_sample_rate_;
+    header.channels = current_channels_;
+    header.time_span_seconds = config_.waveform_time_span;
+    std::copy(min_values, min_values + 2 * static_cast<size_t>(width), waveform_snapshot_.values());
+    waveform_snapshot_.end_write();
 }
 
-SpectrumData VisualizationEngine::get_spectrum_data() {
-    SpectrumData data;
-    
+void VisualizationEngine::publish_spectrum() {
     std::lock_guard<std::mutex> lock(spectrum_mutex_);
     
-    data.fft_size = config_.fft_size;
-    data.sample_rate = current_sample_rate_;
-    data.min_frequency = config_.spectrum_min_freq;
-    data.max_frequency = config_.spectrum_max_freq;
-    
-    data.magnitudes = spectrum_smoothed_bars_;
-    
-    // Calculate center frequencies for each bar (logarithmic spacing)
-    data.frequencies.resize(config_.spectrum_bars);
-    float log_min = std::log10(config_.spectrum_min_freq);
-    float log_max = std::log10(config_.spectrum_max_freq);
-    float log_range = log_max - log_min;
-    
-    for (uint32_t i = 0; i < config_.spectrum_bars; ++i) {
-        float t = static_cast<float>(i) / (config_.spectrum_bars - 1);
-        float log_freq = log_min + t * log_range;
-        data.frequencies[i] = std::pow(10.0f, log_freq);
-    }
-    
-    return data;
+    uint32_t bars = static_cast<uint32_t>(spectrum_smoothed_bars_.size());
+    spectrum_snapshot_.begin_write();
+    SpectrumHeader& header = spectrum_snapshot_.header();
+    header.bars = bars;
+    header.fft_size = config_.fft_size;
+    header.sample_rate = current_sample_rate_;
+    header.min_frequency = config_.spectrum_min_freq;
+    header.max_frequency = config_.spectrum_max_freq;
+    float* values = spectrum_snapshot_.values();
+    std::copy(spectrum_smoothed_bars_.begin(), spectrum_smoothed_bars_.end(), values);
+    std::copy(spectrum_frequencies_.begin(), spectrum_frequencies_.end(), values + bars);
+    spectrum_snapshot_.end_write();
 }
 
-VUMeterData VisualizationEngine::get_vu_meter_data() {
-    std::lock_guard<std::mutex> lock(vu_mutex_);
-    return vu_data_;
+void VisualizationEngine::read_waveform_data(WaveformData& data) const {
+    waveform_snapshot_.read([&](const WaveformHeader& header, const float* values) {
+        size_t width = std::min<size_t>(header.width, waveform_snapshot_.capacity() / 2);
+        data.sample_rate = header.sample_rate;
+        data.channels = header.channels;
+        data.time_span_seconds = header.time_span_seconds;
+        data.min_values.assign(values, values + width);
+        data.max_values.assign(values + width, values + 2 * width);
+    });
 }
 
-void VisualizationEngine::set_waveform_width(uint32_t width) {
-    config_.waveform_width = width;
+void VisualizationEngine::read_spectrum_data(SpectrumData& data) const {
+    spectrum_snapshot_.read([&](const SpectrumHeader& header, const float* values) {
+        size_t bars = std::min<size_t>(header.bars, spectrum_snapshot_.capacity() / 2);
+        data.fft_size = header.fft_size;
+        data.sample_rate = header.sample_rate;
+        data.min_frequency = header.min_frequency;
+        data.max_frequency = header.max_frequency;
+        data.magnitudes.assign(values, values + bars);
+        data.frequencies.assign(values + bars, values + 2 * bars);
+    });
 }
 
-void VisualizationEngine::set_fft_size(uint32_t size) {
-    std::lock_guard<std::mutex> lock(spectrum_mutex_);
-    config_.fft_size = next_power_of_two(size);
-    spectrum_input_buffer_.resize(config_.fft_size, 0.0f);
-    spectrum_fft_output_.resize(config_.fft_size);
+WaveformData VisualizationEngine::get_waveform_data() const {
+    WaveformData data;
+    read_waveform_data(data);
+    return data;
 }
 
-void VisualizationEngine::set_spectrum_bars(uint32_t bars) {
-    std::lock_guard<std::mutex> lock(spectrum_mutex_);
-    config_.spectrum_bars = bars;
-    spectrum_bar_values_.resize(bars, MIN_DB);
-    spectrum_smoothed_bars_.resize(bars, MIN_DB);
+SpectrumData VisualizationEngine::get_spectrum_data() const {
+    SpectrumData data;
+    read_spectrum_data(data);
+    return data;
 }
 
-void VisualizationEngine::set_spectrum_smoothing(float smoothing) {
-    config_.spectrum_smoothing = std::max(0.0f, std::min(1.0f, smoothing));
+VUMeterData VisualizationEngine::get_vu_meter_data() const {
+    return vu_snapshot_.load();
 }
 
-// FFT implementation (Cooley-Tukey radix-2 DIT)
-void VisualizationEngine::compute_fft(const std::vector<float>& input,
-                                      std::vector<std::complex<float>>& output) {
-    size_t N = input.size();
-    output.resize(N);
-    
-    // Convert input to complex
-    for (size_t i = 0; i < N; ++i) {
-        output[i] = std::complex<float>(input[i], 0.0f);
+SpectrogramInfo VisualizationEngine::get_spectrogram_info() const {
+    SpectrogramInfo info;
+    info.bins = spectrogram_bins_;
+    info.columns = spectrogram_columns_;
+    info.fft_size = spectrogram_fft_size_;
+    info.hop_size = spectrogram_hop_;
+    info.sample_rate = current_sample_rate_;
+    info.min_db = MIN_DB;
+    return info;
+}
+
+uint64_t VisualizationEngine::get_spectrogram_column_count() const {
+    return spectrogram_written_.load(std::memory_order_acquire);
+}
+
+size_t VisualizationEngine::read_spectrogram_columns(uint64_t& next_column, float* out,
+                                                      size_t max_columns) const {
+    const uint64_t columns = spectrogram_columns_;
+    const size_t bins = spectrogram_bins_;
+    if (columns == 0 || !out) {
+        return 0;
     }
     
-    // Bit-reversal permutation
-    for (size_t i = 0; i < N; ++i) {
-        size_t j = 0;
-        size_t k = i;
-        size_t m = N / 2;
-        
-        while (m >= 1) {
-            j = (j << 1) | (k & 1);
-            k >>= 1;
-            m >>= 1;
+    for (;;) {
+        // The slot of column written - columns is the one being overwritten
+        uint64_t written = spectrogram_written_.load(std::memory_order_acquire);
+        uint64_t oldest = written >= columns ? written - columns + 1 : 0;
+        uint64_t first = std::max(next_column, oldest);
+        if (first >= written) {
+            return 0;
         }
         
-        if (j > i) {
-            std::swap(output[i], output[j]);
+        size_t count = static_cast<size_t>(std::min<uint64_t>(written - first, max_columns));
+        for (size_t i = 0; i < count; ++i) {
+            const float* column = &spectrogram_ring_[((first + i) % columns) * bins];
+            std::copy(column, column + bins, out + i * bins);
         }
-    }
-    
-    // FFT computation
-    for (size_t s = 1; s <= std::log2(N); ++s) {
-        size_t m = static_cast<size_t>(1) << s;
-        size_t m2 = m >> 1;
-        std::complex<float> w(1.0f, 0.0f);
-        std::complex<float> wm = std::exp(std::complex<float>(0.0f, -2.0f * PI / m));
         
-        for (size_t j = 0; j < m2; ++j) {
-            for (size_t k = j; k < N; k += m) {
-                std::complex<float> t = w * output[k + m2];
-                std::complex<float> u = output[k];
-                output[k] = u + t;
-                output[k + m2] = u - t;
-            }
-            w *= wm;
+        // Lapped while copying: start again from the columns still there
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now = spectrogram_written_.load(std::memory_order_relaxed);
+        next_column = first;
+        if ((now >= columns ? now - columns + 1 : 0) <= first) {
+            next_column = first + count;
+            return count;
         }
     }
 }
 
+void VisualizationEngine::set_waveform_width(uint32_t width) {
+    waveform_width_ = std::max(1u, std::min(width, MAX_WAVEFORM_WIDTH));
+    layout_changed_ = true;
+}
+
+void VisualizationEngine::set_fft_size(uint32_t size) {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
+    config_.fft_size = valid_fft_size(size);
+    spectrum_history_.assign(config_.fft_size, 0.0f);
+    spectrum_history_pos_ = 0;
+    spectrum_input_buffer_.resize(config_.fft_size, 0.0f);
+    spectrum_fft_.initialize(config_.fft_size);
+    spectrum_fft_real_.resize(spectrum_fft_.bins());
+    spectrum_fft_imag_.resize(spectrum_fft_.bins());
+    layout_changed_ = true;
+}
+
+void VisualizationEngine::set_spectrum_bars(uint32_t bars) {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
+    config_.spectrum_bars = std::max(2u, std::min(bars, MAX_SPECTRUM_BARS));
+    spectrum_bar_values_.resize(config_.spectrum_bars, MIN_DB);
+    spectrum_smoothed_bars_.resize(config_.spectrum_bars, MIN_DB);
+    update_spectrum_frequencies();
+    layout_changed_ = true;
+}
+
+void VisualizationEngine::set_spectrum_smoothing(float smoothing) {
+    config_.spectrum_smoothing = std::max(0.0f, std::min(1.0f, smoothing));
+}
+
 void VisualizationEngine::apply_hann_window(std::vector<float>& samples) {
     size_t N = samples.size();
     for (size_t i = 0; i < N; ++i) {
@@ -333,14 +602,15 @@ void VisualizationEngine::apply_hann_window(std::vector<float>& samples) {
     }
 }
 
-void VisualizationEngine::map_fft_to_bars(const std::vector<std::complex<float>>& fft_output,
+void VisualizationEngine::map_fft_to_bars(const std::vector<float>& fft_real,
+                                          const std::vector<float>& fft_imag,
                                           std::vector<float>& bar_magnitudes) {
     if (current_sample_rate_ == 0) {
         return;
     }
     
-    size_t fft_bins = fft_output.size() / 2; // Only use positive frequencies
-    float bin_frequency = static_cast<float>(current_sample_rate_) / fft_output.size();
+    size_t fft_bins = fft_real.size() - 1; // Positive frequencies below Nyquist
+    float bin_frequency = static_cast<float>(current_sample_rate_) / config_.fft_size;
     
     // Logarithmic frequency mapping
     float log_min = std::log10(config_.spectrum_min_freq);
@@ -357,7 +627,7 @@ void VisualizationEngine::map_fft_to_bars(const std::vector<std::complex<float>>
         if (bin >= fft_bins) bin = fft_bins - 1;
         
         // Calculate magnitude
-        float magnitude = std::abs(fft_output[bin]);
+        float magnitude = std::sqrt(fft_real[bin] * fft_real[bin] + fft_imag[bin] * fft_imag[bin]);
         bar_magnitudes[bar] = linear_to_db(magnitude);
     }
 }
@@ -373,6 +643,12 @@ float VisualizationEngine::db_to_linear(float db) {
     return std::pow(10.0f, db / 20.0f);
 }
 
+uint32_t VisualizationEngine::valid_fft_size(uint32_t n) {
+    n = next_power_of_two(n);
+    return static_cast<uint32_t>(std::max<size_t>(audio::FFTTables::MIN_SIZE,
+                                                  std::min<size_t>(n, audio::FFTTables::MAX_SIZE)));
+}
+
 uint32_t VisualizationEngine::next_power_of_two(uint32_t n) {
     n--;
     n |= n >> 1;
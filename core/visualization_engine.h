@@ -2,9 +2,14 @@
 #define VISUALIZATION_ENGINE_H
 
 #include "mp_types.h"
+#include "spsc_ring_buffer.h"
+#include "seqlock.h"
+#include "fft.h"
 #include <vector>
-#include <complex>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
 #include <cstdint>
 
 namespace mp {
@@ -28,6 +33,17 @@ struct SpectrumData {
     float max_frequency;
 };
 
+// Layout of the spectrogram ring. Each column holds bins log-magnitude
+// values in dB, DC first; a full-scale sine on a bin reads 0 dB.
+struct SpectrogramInfo {
+    uint32_t bins;                  // fft_size / 2 + 1
+    uint32_t columns;               // Ring length; 0 when disabled
+    uint32_t fft_size;
+    uint32_t hop_size;              // Samples between consecutive columns
+    uint32_t sample_rate;           // Of the audio being analyzed
+    float min_db;                   // Floor of the values
+};
+
 struct VUMeterData {
     float peak_left;                // Peak level (0.0 - 1.0)
     float peak_right;
@@ -52,6 +68,11 @@ struct VisualizationConfig {
     float spectrum_max_freq;        // Maximum frequency (Hz)
     float spectrum_smoothing;       // Smoothing factor (0.0 - 1.0)
     
+    // Spectrogram settings; the spectrogram keeps the fft_size it was
+    // initialized with
+    uint32_t spectrogram_columns;   // Columns kept; 0 disables the spectrogram
+    float spectrogram_overlap;      // Fraction of fft_size shared by consecutive columns (0.0 - 0.9375)
+    
     // VU meter settings
     float vu_peak_decay_rate;       // Peak decay in dB/second
     float vu_rms_window_ms;         // RMS averaging window in ms
@@ -60,8 +81,31 @@ struct VisualizationConfig {
     uint32_t update_rate_hz;        // Update rate (Hz)
 };
 
+// Audio is handed over through a lock-free ring: process_audio() only
+// copies the interleaved frames, and an analysis thread drains the ring
+// update_rate_hz times per second to build the waveform, spectrum and VU
+// data. The audio thread never takes a lock or waits for a reader.
+//
+// Results are published as sequence-locked snapshots of fixed capacity,
+// so readers neither lock nor allocate once their storage is sized, and
+// any number of views can read while the analysis thread publishes.
+//
+// The spectrogram is an STFT with a fixed hop: every hop_size mono samples
+// the latest fft_size are windowed and transformed into one column, so no
+// audio is skipped however the callbacks are sized. Columns go into a
+// contiguous ring and are numbered in the order they were produced;
+// column n lives in slot n % columns. A view remembers the next column it
+// wants and copies only the new ones.
 class VisualizationEngine {
 public:
+    static constexpr uint32_t MAX_SAMPLE_RATE = 192000; // Sizing of the input ring
+    static constexpr uint16_t MAX_CHANNELS = 8;
+    static constexpr uint32_t ANALYSIS_CHUNK_FRAMES = 4096; // Frames drained per pass
+    static constexpr uint32_t MAX_WAVEFORM_WIDTH = 16384;   // Pixels
+    static constexpr uint32_t MAX_SPECTRUM_BARS = 4096;
+    static constexpr uint32_t MAX_SPECTROGRAM_COLUMNS = 4096;
+    static constexpr uint32_t MAX_SPECTROGRAM_FFT_SIZE = 8192;
+
     VisualizationEngine();
     ~VisualizationEngine();
     
@@ -69,66 +113,153 @@ public:
     Result initialize(const VisualizationConfig& config);
     void shutdown();
     
-    // Audio data input (called from audio thread)
+    // Audio data input (called from audio thread). Wait-free: frames that
+    // do not fit in the ring are dropped rather than waited for.
     void process_audio(const float* samples, size_t frame_count, 
                       uint16_t channels, uint32_t sample_rate);
     
-    // Data retrieval (called from UI thread)
-    WaveformData get_waveform_data();
-    SpectrumData get_spectrum_data();
-    VUMeterData get_vu_meter_data();
+    // Data retrieval (any thread). Copies the latest snapshot into
+    // caller-owned storage; the vectors only reallocate when they have to
+    // grow, so a view that keeps its data object reads without allocating.
+    void read_waveform_data(WaveformData& data) const;
+    void read_spectrum_data(SpectrumData& data) const;
+    
+    // Same as above into a fresh object; allocates
+    WaveformData get_waveform_data() const;
+    SpectrumData get_spectrum_data() const;
+    VUMeterData get_vu_meter_data() const;
     
-    // Configuration updates
+    // Spectrogram (any thread). read_spectrogram_columns() copies columns
+    // from next_column on, oldest first, at most max_columns of bins
+    // floats each, and advances next_column past them. Columns that were
+    // overwritten before they could be read are skipped. Never allocates.
+    SpectrogramInfo get_spectrogram_info() const;
+    uint64_t get_spectrogram_column_count() const;   // Columns produced so far
+    size_t read_spectrogram_columns(uint64_t& next_column, float* out, size_t max_columns) const;
+    
+    // Configuration updates, picked up by the next analysis pass
     void set_waveform_width(uint32_t width);
     void set_fft_size(uint32_t size);
     void set_spectrum_bars(uint32_t bars);
     void set_spectrum_smoothing(float smoothing);
     
 private:
-    // FFT implementation (Cooley-Tukey algorithm)
-    void compute_fft(const std::vector<float>& input, 
-                     std::vector<std::complex<float>>& output);
+    // Analysis thread: drain the input ring, then refresh spectrum and VU
+    void analysis_thread_main();
+    void analyze_frames(const float* samples, size_t frame_count, uint16_t channels);
+    void update_spectrum();
+    void update_vu_meter();
+    void update_spectrum_frequencies();
+    void advance_spectrogram(const float* mono, size_t count);
+    void compute_spectrogram_column();
     
+    // Analysis thread: write the snapshots readers copy from
+    void publish_waveform();
+    void publish_spectrum();
+
     // Window functions
     void apply_hann_window(std::vector<float>& samples);
     
     // Frequency mapping (linear to logarithmic)
-    void map_fft_to_bars(const std::vector<std::complex<float>>& fft_output,
+    void map_fft_to_bars(const std::vector<float>& fft_real,
+                         const std::vector<float>& fft_imag,
                          std::vector<float>& bar_magnitudes);
     
     // Helper functions
     float linear_to_db(float linear);
     float db_to_linear(float db);
     uint32_t next_power_of_two(uint32_t n);
+    uint32_t valid_fft_size(uint32_t n);
     
     // Configuration
     VisualizationConfig config_;
     bool initialized_;
     
-    // Waveform data
+    // Audio thread to analysis thread. A format change flushes the ring
+    // before the new format is published, so a pass that sees the same
+    // format before and after reading got frames of that format only.
+    core::SpscRingBuffer<float> input_ring_;
+    std::atomic<uint64_t> input_format_;  // sample_rate << 16 | channels
+    uint64_t producer_format_;            // Audio thread's copy
+    std::vector<float> analysis_chunk_;   // ANALYSIS_CHUNK_FRAMES frames
+    std::vector<float> analysis_mono_;    // The chunk mixed to mono
+    
+    std::thread analysis_thread_;
+    std::atomic<bool> analysis_running_;
+    std::mutex analysis_mutex_;           // Only for waking the thread on shutdown
+    std::condition_variable analysis_cv_;
+    
+    // Published snapshots. The waveform holds the minimum per pixel then
+    // the maximum per pixel; the spectrum holds the bar magnitudes then
+    // their center frequencies.
+    struct WaveformHeader {
+        uint32_t width;
+        uint32_t sample_rate;
+        uint16_t channels;
+        float time_span_seconds;
+    };
+    struct SpectrumHeader {
+        uint32_t bars;
+        uint32_t fft_size;
+        uint32_t sample_rate;
+        float min_frequency;
+        float max_frequency;
+    };
+    core::SeqLockBuffer<WaveformHeader, float> waveform_snapshot_;
+    core::SeqLockBuffer<SpectrumHeader, float> spectrum_snapshot_;
+    core::SeqLock<VUMeterData> vu_snapshot_;
+    std::atomic<bool> layout_changed_;    // A setter ran; republish even without audio
+    
+    // Waveform data (analysis thread)
     std::vector<float> waveform_buffer_;  // Ring buffer for waveform
     size_t waveform_write_pos_;
-    std::mutex waveform_mutex_;
+    std::atomic<uint32_t> waveform_width_;
+    std::vector<float> waveform_columns_; // Min then max per pixel, before publishing
     
-    // Spectrum data
+    // Spectrum data; spectrum_history_ holds the latest fft_size mono
+    // samples, oldest first from spectrum_history_pos_
+    std::vector<float> spectrum_history_;
+    size_t spectrum_history_pos_;
     std::vector<float> spectrum_input_buffer_;
-    std::vector<std::complex<float>> spectrum_fft_output_;
+    audio::RealFFT spectrum_fft_;
+    std::vector<float> spectrum_fft_real_;  // fft_size / 2 + 1 bins
+    std::vector<float> spectrum_fft_imag_;
     std::vector<float> spectrum_bar_values_;
     std::vector<float> spectrum_smoothed_bars_;
-    std::mutex spectrum_mutex_;
+    std::vector<float> spectrum_frequencies_; // Center frequency per bar
+    std::mutex spectrum_mutex_;           // Setters against the analysis thread
+    
+    // Spectrogram; spectrogram_history_ holds the latest fft_size mono
+    // samples, oldest first from spectrogram_history_pos_. The ring is
+    // allocated in initialize() and never resized while readers may run.
+    uint32_t spectrogram_columns_;
+    uint32_t spectrogram_fft_size_;
+    uint32_t spectrogram_bins_;
+    uint32_t spectrogram_hop_;
+    std::vector<float> spectrogram_history_;
+    size_t spectrogram_history_pos_;
+    size_t spectrogram_since_column_;     // Samples since the last column
+    std::vector<float> spectrogram_window_;
+    std::vector<float> spectrogram_input_;
+    audio::RealFFT spectrogram_fft_;
+    std::vector<float> spectrogram_fft_real_;
+    std::vector<float> spectrogram_fft_imag_;
+    std::vector<float> spectrogram_ring_; // columns * bins, column by column
+    std::atomic<uint64_t> spectrogram_written_; // Columns complete in the ring
     
-    // VU meter data
+    // VU meter data (analysis thread)
     VUMeterData vu_data_;
     std::vector<float> rms_buffer_left_;
     std::vector<float> rms_buffer_right_;
     size_t rms_buffer_pos_;
+    float block_peak_left_;               // Since the last VU update
+    float block_peak_right_;
     float peak_hold_time_left_;
     float peak_hold_time_right_;
-    std::mutex vu_mutex_;
     
-    // Sample rate tracking
-    uint32_t current_sample_rate_;
-    uint16_t current_channels_;
+    // Format of the audio being analyzed
+    std::atomic<uint32_t> current_sample_rate_;
+    std::atomic<uint16_t> current_channels_;
 };
 
 } // namespace mp
@@ -0,0 +1,529 @@
+#include "waveform_pyramid.h"
+#include "mp_sample_format.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace mp {
+namespace core {
+
+namespace {
+
+const char SIDECAR_MAGIC[4] = { 'M', 'P', 'W', 'F' };
+const uint32_t SIDECAR_VERSION = 1;
+const char* const SIDECAR_EXTENSION = ".mpwf";
+
+// Rounded outwards, so the stored envelope never undershoots the audio
+WaveformBucket make_bucket(float min_value, float max_value, double rms) {
+    min_value = std::min(1.0f, std::max(-1.0f, min_value));
+    max_value = std::min(1.0f, std::max(-1.0f, max_value));
+    rms = std::min(1.0, std::max(0.0, rms));
+    WaveformBucket bucket;
+    bucket.min = static_cast<int16_t>(std::floor(min_value * 32767.0f));
+    bucket.max = static_cast<int16_t>(std::ceil(max_value * 32767.0f));
+    bucket.rms = static_cast<uint16_t>(std::lround(rms * 65535.0));
+    return bucket;
+}
+
+// Frames covered by bucket index of a level; only the last one is short
+uint64_t bucket_weight(uint64_t total_frames, uint64_t bucket_frames, size_t index) {
+    uint64_t start = index * bucket_frames;
+    return std::min(bucket_frames, total_frames - start);
+}
+
+uint64_t buckets_for(uint64_t total_frames, uint64_t bucket_frames) {
+    return (total_frames + bucket_frames - 1) / bucket_frames;
+}
+
+template <typename T>
+void write_value(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+// FNV-1a; only needs to spread paths over file names
+uint64_t hash_path(const std::string& path) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+bool WaveformSourceKey::from_file(const std::string& path, WaveformSourceKey& key) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    uint64_t size = fs::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    fs::file_time_type mtime = fs::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    key.path = path;
+    key.size = size;
+    key.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+WaveformPyramid::WaveformPyramid()
+    : sample_rate_(0)
+    , channels_(0)
+    , total_frames_(0) {
+}
+
+Result WaveformPyramid::build(IDecoder* decoder, const char* file_path, const std::atomic<bool>* cancel) {
+    if (!decoder || !file_path) {
+        return Result::InvalidParameter;
+    }
+
+    DecoderHandle handle = {};
+    Result result = decoder->open_stream(file_path, &handle);
+    if (result != Result::Success) {
+        return result;
+    }
+
+    AudioStreamInfo info = {};
+    result = decoder->get_stream_info(handle, &info);
+    const size_t bytes_per_sample = sample_format_bytes(info.format);
+    if (result == Result::Success &&
+        (bytes_per_sample == 0 || info.channels == 0 || info.channels > 0xFFFF || info.sample_rate == 0)) {
+        result = Result::NotSupported;
+    }
+    if (result != Result::Success) {
+        decoder->close_stream(handle);
+        return result;
+    }
+
+    sample_rate_ = info.sample_rate;
+    channels_ = static_cast<uint16_t>(info.channels);
+    total_frames_ = 0;
+    for (auto& level : levels_) {
+        level.clear();
+    }
+    if (info.total_samples > 0) {
+        levels_[0].reserve(buckets_for(info.total_samples, BASE_BUCKET_FRAMES));
+    }
+
+    const size_t channels = info.channels;
+    std::vector<uint8_t> raw(DECODE_BLOCK_FRAMES * channels * bytes_per_sample);
+    std::vector<float> samples(DECODE_BLOCK_FRAMES * channels);
+
+    // The bucket being filled
+    float bucket_min = std::numeric_limits<float>::max();
+    float bucket_max = std::numeric_limits<float>::lowest();
+    double bucket_sum_sq = 0.0;
+    size_t bucket_fill = 0;
+
+    while (true) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            result = Result::Error;
+            break;
+        }
+        size_t frames = 0;
+        result = decoder->decode_block(handle, raw.data(), raw.size(), &frames);
+        if (result != Result::Success || frames == 0) {
+            break;
+        }
+        frames = std::min(frames, static_cast<size_t>(DECODE_BLOCK_FRAMES));
+        samples_to_float(raw.data(), info.format, frames * channels, samples.data());
+
+        // Whole runs of frames per bucket, so the inner loop is flat
+        size_t frame = 0;
+        while (frame < frames) {
+            size_t run = std::min(frames - frame, BASE_BUCKET_FRAMES - bucket_fill);
+            const float* p = samples.data() + frame * channels;
+            const float* end = p + run * channels;
+            for (; p < end; ++p) {
+                bucket_min = std::min(bucket_min, *p);
+                bucket_max = std::max(bucket_max, *p);
+                bucket_sum_sq += static_cast<double>(*p) * *p;
+            }
+            frame += run;
+            bucket_fill += run;
+            if (bucket_fill == BASE_BUCKET_FRAMES) {
+                levels_[0].push_back(make_bucket(bucket_min, bucket_max,
+                    std::sqrt(bucket_sum_sq / (BASE_BUCKET_FRAMES * channels))));
+                bucket_min = std::numeric_limits<float>::max();
+                bucket_max = std::numeric_limits<float>::lowest();
+                bucket_sum_sq = 0.0;
+                bucket_fill = 0;
+            }
+        }
+        total_frames_ += frames;
+    }
+    decoder->close_stream(handle);
+
+    if (result == Result::Success && bucket_fill > 0) {
+        levels_[0].push_back(make_bucket(bucket_min, bucket_max,
+            std::sqrt(bucket_sum_sq / (bucket_fill * channels))));
+    }
+    if (result == Result::Success && total_frames_ == 0) {
+        result = Result::Error;
+    }
+    if (result != Result::Success) {
+        total_frames_ = 0;
+        levels_[0].clear();
+        return result;
+    }
+
+    build_upper_levels();
+    return Result::Success;
+}
+
+void WaveformPyramid::build_upper_levels() {
+    for (size_t level = 1; level < LEVEL_COUNT; ++level) {
+        const std::vector<WaveformBucket>& below = levels_[level - 1];
+        const uint64_t below_frames = bucket_frames(level - 1);
+        std::vector<WaveformBucket>& buckets = levels_[level];
+        buckets.resize(buckets_for(total_frames_, bucket_frames(level)));
+
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            size_t first = i * LEVEL_FACTOR;
+            size_t last = std::min(first + LEVEL_FACTOR, below.size());
+            int16_t min_value = below[first].min;
+            int16_t max_value = below[first].max;
+            double weighted_sq = 0.0;
+            uint64_t weight = 0;
+            for (size_t j = first; j < last; ++j) {
+                min_value = std::min(min_value, below[j].min);
+                max_value = std::max(max_value, below[j].max);
+                double rms = below[j].rms / 65535.0;
+                uint64_t w = bucket_weight(total_frames_, below_frames, j);
+                weighted_sq += rms * rms * w;
+                weight += w;
+            }
+            buckets[i].min = min_value;
+            buckets[i].max = max_value;
+            buckets[i].rms = static_cast<uint16_t>(std::lround(std::sqrt(weighted_sq / weight) * 65535.0));
+        }
+    }
+}
+
+void WaveformPyramid::render(uint64_t start_frame, uint64_t end_frame, uint32_t pixels,
+                             WaveformOverviewData& data) const {
+    data.sample_rate = sample_rate_;
+    data.channels = channels_;
+    data.total_frames = total_frames_;
+    data.min_values.assign(pixels, 0.0f);
+    data.max_values.assign(pixels, 0.0f);
+    data.rms_values.assign(pixels, 0.0f);
+    if (pixels == 0 || end_frame <= start_frame || total_frames_ == 0) {
+        return;
+    }
+
+    // Coarsest level with buckets no wider than a pixel
+    const double frames_per_pixel = static_cast<double>(end_frame - start_frame) / pixels;
+    size_t level = 0;
+    while (level + 1 < LEVEL_COUNT && bucket_frames(level + 1) <= frames_per_pixel) {
+        ++level;
+    }
+    const std::vector<WaveformBucket>& buckets = levels_[level];
+    const uint64_t frames = bucket_frames(level);
+
+    for (uint32_t pixel = 0; pixel < pixels; ++pixel) {
+        uint64_t from = start_frame + static_cast<uint64_t>(pixel * frames_per_pixel);
+        uint64_t to = start_frame + static_cast<uint64_t>((pixel + 1) * frames_per_pixel);
+        if (from >= total_frames_) {
+            break;
+        }
+        to = std::min(std::max(to, from + 1), total_frames_);
+
+        size_t first = static_cast<size_t>(from / frames);
+        size_t last = static_cast<size_t>((to - 1) / frames);
+        int16_t min_value = buckets[first].min;
+        int16_t max_value = buckets[first].max;
+        double weighted_sq = 0.0;
+        uint64_t weight = 0;
+        for (size_t i = first; i <= last; ++i) {
+            min_value = std::min(min_value, buckets[i].min);
+            max_value = std::max(max_value, buckets[i].max);
+            double rms = buckets[i].rms / 65535.0;
+            uint64_t w = bucket_weight(total_frames_, frames, i);
+            weighted_sq += rms * rms * w;
+            weight += w;
+        }
+        data.min_values[pixel] = min_value / 32767.0f;
+        data.max_values[pixel] = max_value / 32767.0f;
+        data.rms_values[pixel] = static_cast<float>(std::sqrt(weighted_sq / weight));
+    }
+}
+
+// Sidecar layout, native byte order: magic, version, sample rate, channels,
+// total frames, source mtime, source size, path length, path bytes, then
+// the buckets of each level from the finest up. Bucket counts follow from
+// the total frames, so the file length is checked exactly.
+Result WaveformPyramid::save(const std::string& cache_path, const WaveformSourceKey& key) const {
+    if (total_frames_ == 0) {
+        return Result::InvalidState;
+    }
+
+    // Written aside and renamed, so a reader never sees half a file
+    std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return Result::FileError;
+        }
+        file.write(SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+        write_value(file, SIDECAR_VERSION);
+        write_value(file, sample_rate_);
+        write_value(file, static_cast<uint32_t>(channels_));
+        write_value(file, total_frames_);
+        write_value(file, key.mtime);
+        write_value(file, key.size);
+        write_value(file, static_cast<uint32_t>(key.path.size()));
+        file.write(key.path.data(), static_cast<std::streamsize>(key.path.size()));
+        for (const auto& level : levels_) {
+            file.write(reinterpret_cast<const char*>(level.data()),
+                       static_cast<std::streamsize>(level.size() * sizeof(WaveformBucket)));
+        }
+        if (!file) {
+            file.close();
+            std::remove(temp_path.c_str());
+            return Result::FileError;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, cache_path, error);
+    if (error) {
+        std::remove(temp_path.c_str());
+        return Result::FileError;
+    }
+    return Result::Success;
+}
+
+Result WaveformPyramid::load(const std::string& cache_path, const WaveformSourceKey& key) {
+    std::ifstream file(cache_path, std::ios::binary);
+    if (!file.is_open()) {
+        return Result::FileNotFound;
+    }
+
+    char magic[sizeof(SIDECAR_MAGIC)];
+    uint32_t version = 0, sample_rate = 0, channels = 0, path_length = 0;
+    uint64_t total_frames = 0, size = 0;
+    int64_t mtime = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, SIDECAR_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(file, version) || version != SIDECAR_VERSION ||
+        !read_value(file, sample_rate) || !read_value(file, channels) ||
+        !read_value(file, total_frames) || !read_value(file, mtime) ||
+        !read_value(file, size) || !read_value(file, path_length)) {
+        return Result::InvalidFormat;
+    }
+    if (mtime != key.mtime || size != key.size || path_length != key.path.size() ||
+        sample_rate == 0 || channels == 0 || channels > 0xFFFF || total_frames == 0) {
+        return Result::InvalidFormat;
+    }
+    std::string path(path_length, '\0');
+    if (!file.read(&path[0], path_length) || path != key.path) {
+        return Result::InvalidFormat;
+    }
+
+    // Check the length before allocating anything it implies
+    uint64_t bucket_count = 0;
+    for (size_t level = 0; level < LEVEL_COUNT; ++level) {
+        bucket_count += buckets_for(total_frames, bucket_frames(level));
+    }
+    std::streamoff header_end = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff file_end = file.tellg();
+    if (header_end < 0 || file_end < header_end ||
+        static_cast<uint64_t>(file_end - header_end) != bucket_count * sizeof(WaveformBucket)) {
+        return Result::InvalidFormat;
+    }
+    file.seekg(header_end);
+
+    std::vector<WaveformBucket> levels[LEVEL_COUNT];
+    for (size_t level = 0; level < LEVEL_COUNT; ++level) {
+        levels[level].resize(buckets_for(total_frames, bucket_frames(level)));
+        if (!file.read(reinterpret_cast<char*>(levels[level].data()),
+                       static_cast<std::streamsize>(levels[level].size() * sizeof(WaveformBucket)))) {
+            return Result::InvalidFormat;
+        }
+    }
+
+    sample_rate_ = sample_rate;
+    channels_ = static_cast<uint16_t>(channels);
+    total_frames_ = total_frames;
+    for (size_t level = 0; level < LEVEL_COUNT; ++level) {
+        levels_[level].swap(levels[level]);
+    }
+    return Result::Success;
+}
+
+WaveformPyramidCache::WaveformPyramidCache()
+    : initialized_(false)
+    , running_(false)
+    , cancel_(false) {
+}
+
+WaveformPyramidCache::~WaveformPyramidCache() {
+    shutdown();
+}
+
+Result WaveformPyramidCache::initialize(const char* cache_dir) {
+    if (initialized_) {
+        return Result::AlreadyInitialized;
+    }
+    if (!cache_dir) {
+        return Result::InvalidParameter;
+    }
+
+    namespace fs = std::filesystem;
+    try {
+        if (!fs::exists(cache_dir)) {
+            fs::create_directories(cache_dir);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to create waveform cache directory: " << e.what() << std::endl;
+        return Result::Error;
+    }
+
+    cache_dir_ = cache_dir;
+    cancel_ = false;
+    running_ = true;
+    worker_ = std::thread(&WaveformPyramidCache::worker_main, this);
+    initialized_ = true;
+    return Result::Success;
+}
+
+void WaveformPyramidCache::shutdown() {
+    if (!initialized_) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        queue_.clear();
+    }
+    cancel_ = true;
+    work_cv_.notify_one();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    initialized_ = false;
+}
+
+void WaveformPyramidCache::set_ready_callback(ReadyCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_callback_ = std::move(callback);
+}
+
+std::shared_ptr<const WaveformPyramid> WaveformPyramidCache::request(const std::string& file_path,
+                                                                     IDecoder* decoder) {
+    WaveformSourceKey key;
+    if (!WaveformSourceKey::from_file(file_path, key)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = resident_.find(file_path);
+    if (it != resident_.end() && it->second.key == key) {
+        resident_order_.erase(std::find(resident_order_.begin(), resident_order_.end(), file_path));
+        resident_order_.push_back(file_path);
+        return it->second.pyramid;
+    }
+
+    if (!running_ || !decoder || building_ == file_path) {
+        return nullptr;
+    }
+    for (const Job& job : queue_) {
+        if (job.key.path == file_path) {
+            return nullptr;
+        }
+    }
+    queue_.push_back(Job{ key, decoder });
+    work_cv_.notify_one();
+    return nullptr;
+}
+
+std::shared_ptr<const WaveformPyramid> WaveformPyramidCache::get(const std::string& file_path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = resident_.find(file_path);
+    return it != resident_.end() ? it->second.pyramid : nullptr;
+}
+
+std::string WaveformPyramidCache::cache_file_path(const std::string& file_path) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash_path(file_path)));
+    return cache_dir_ + "/" + name + SIDECAR_EXTENSION;
+}
+
+void WaveformPyramidCache::worker_main() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+        if (!running_) {
+            break;
+        }
+        Job job = queue_.front();
+        queue_.pop_front();
+        building_ = job.key.path;
+
+        lock.unlock();
+        std::shared_ptr<const WaveformPyramid> pyramid = produce(job);
+        lock.lock();
+
+        building_.clear();
+        if (!pyramid) {
+            continue;
+        }
+        store(job.key, pyramid);
+        if (ready_callback_) {
+            ReadyCallback callback = ready_callback_;
+            lock.unlock();
+            callback(job.key.path);
+            lock.lock();
+        }
+    }
+}
+
+std::shared_ptr<const WaveformPyramid> WaveformPyramidCache::produce(const Job& job) {
+    const std::string sidecar = cache_file_path(job.key.path);
+    auto pyramid = std::make_shared<WaveformPyramid>();
+    if (pyramid->load(sidecar, job.key) == Result::Success) {
+        return pyramid;
+    }
+
+    if (pyramid->build(job.decoder, job.key.path.c_str(), &cancel_) != Result::Success) {
+        return nullptr;
+    }
+    if (pyramid->save(sidecar, job.key) != Result::Success) {
+        std::cerr << "Failed to write waveform cache: " << sidecar << std::endl;
+    }
+    return pyramid;
+}
+
+// Caller holds mutex_
+void WaveformPyramidCache::store(const WaveformSourceKey& key,
+                                 std::shared_ptr<const WaveformPyramid> pyramid) {
+    auto it = resident_.find(key.path);
+    if (it != resident_.end()) {
+        resident_order_.erase(std::find(resident_order_.begin(), resident_order_.end(), key.path));
+    }
+    resident_[key.path] = Entry{ key, std::move(pyramid) };
+    resident_order_.push_back(key.path);
+
+    while (resident_order_.size() > MAX_RESIDENT) {
+        resident_.erase(resident_order_.front());
+        resident_order_.pop_front();
+    }
+}
+
+} // namespace core
+} // namespace mp
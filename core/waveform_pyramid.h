@@ -0,0 +1,180 @@
+#pragma once
+
+#include "mp_decoder.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mp {
+namespace core {
+
+// Identifies the audio file a pyramid was built from; a cached pyramid is
+// only used while all three still match
+struct WaveformSourceKey {
+    std::string path;
+    int64_t mtime;                  // File modification time, filesystem clock ticks
+    uint64_t size;                  // File size in bytes
+
+    WaveformSourceKey() : mtime(0), size(0) {}
+
+    // Read mtime and size of path; false if the file cannot be stat'ed
+    static bool from_file(const std::string& path, WaveformSourceKey& key);
+
+    bool operator==(const WaveformSourceKey& other) const {
+        return path == other.path && mtime == other.mtime && size == other.size;
+    }
+    bool operator!=(const WaveformSourceKey& other) const { return !(*this == other); }
+};
+
+// Min, max and RMS of every channel over one bucket of frames. Quantized
+// to 16 bits so a track costs 6 bytes per 256 frames at the finest level.
+struct WaveformBucket {
+    int16_t min;                    // Full scale is +-32767
+    int16_t max;
+    uint16_t rms;                   // Full scale is 65535
+};
+
+// Per-pixel columns for a range of the track
+struct WaveformOverviewData {
+    std::vector<float> min_values;  // Minimum amplitude per pixel
+    std::vector<float> max_values;  // Maximum amplitude per pixel
+    std::vector<float> rms_values;  // RMS level per pixel (0.0 - 1.0)
+    uint32_t sample_rate;
+    uint16_t channels;
+    uint64_t total_frames;          // Length of the whole track
+};
+
+// Whole-track min/max/RMS mip-pyramid for seekbar and overview waveforms.
+//
+// Level 0 holds one bucket per BASE_BUCKET_FRAMES frames and each level
+// above merges LEVEL_FACTOR buckets of the one below, up to 65536 frames
+// per bucket. render() picks the coarsest level whose buckets are no wider
+// than a pixel, so a pixel merges at most LEVEL_FACTOR + 1 buckets (more
+// only when zoomed out past the top level) and any zoom costs O(pixels),
+// without touching the audio file.
+//
+// Immutable once built or loaded; any number of threads may render().
+class WaveformPyramid {
+public:
+    static constexpr uint32_t BASE_BUCKET_FRAMES = 256;
+    static constexpr uint32_t LEVEL_FACTOR = 4;
+    static constexpr size_t LEVEL_COUNT = 5;        // 256, 1024, 4096, 16384, 65536 frames
+    static constexpr size_t DECODE_BLOCK_FRAMES = 4096;
+
+    WaveformPyramid();
+
+    // Decode the whole stream through a decoder plugin. Gives up with
+    // Result::Error when cancel becomes true; cancel may be null.
+    Result build(IDecoder* decoder, const char* file_path, const std::atomic<bool>* cancel);
+
+    // Sidecar file I/O. load() fails with InvalidFormat when the file is
+    // damaged, from another version or was built for a different key.
+    Result save(const std::string& cache_path, const WaveformSourceKey& key) const;
+    Result load(const std::string& cache_path, const WaveformSourceKey& key);
+
+    // Fill pixels columns covering frames [start_frame, end_frame). Pixels
+    // past the end of the track are silent. Reuses the vectors' storage.
+    void render(uint64_t start_frame, uint64_t end_frame, uint32_t pixels,
+                WaveformOverviewData& data) const;
+
+    uint32_t sample_rate() const { return sample_rate_; }
+    uint16_t channels() const { return channels_; }
+    uint64_t total_frames() const { return total_frames_; }
+    const std::vector<WaveformBucket>& level(size_t index) const { return levels_[index]; }
+
+    static uint64_t bucket_frames(size_t level) {
+        uint64_t frames = BASE_BUCKET_FRAMES;
+        for (size_t i = 0; i < level; ++i) {
+            frames *= LEVEL_FACTOR;
+        }
+        return frames;
+    }
+
+private:
+    void build_upper_levels();
+
+    uint32_t sample_rate_;
+    uint16_t channels_;
+    uint64_t total_frames_;
+    std::vector<WaveformBucket> levels_[LEVEL_COUNT];
+};
+
+// Builds pyramids on a background thread and keeps them in sidecar files.
+//
+// Sidecars live in the cache directory, named by a hash of the track path;
+// the file records path, mtime and size, so an edited or replaced track is
+// rebuilt rather than drawn from stale data. The most recently requested
+// pyramids also stay in memory.
+class WaveformPyramidCache {
+public:
+    static constexpr size_t MAX_RESIDENT = 8;       // Pyramids kept in memory
+
+    // Called on the worker thread when a requested pyramid becomes ready
+    using ReadyCallback = std::function<void(const std::string& file_path)>;
+
+    WaveformPyramidCache();
+    ~WaveformPyramidCache();
+
+    WaveformPyramidCache(const WaveformPyramidCache&) = delete;
+    WaveformPyramidCache& operator=(const WaveformPyramidCache&) = delete;
+
+    // Create the cache directory and start the worker
+    Result initialize(const char* cache_dir);
+
+    // Cancel the build in progress, drop queued requests, stop the worker
+    void shutdown();
+
+    void set_ready_callback(ReadyCallback callback);
+
+    // Return the pyramid if it is in memory and the file is unchanged;
+    // otherwise queue it to be loaded from its sidecar or built with
+    // decoder, and return nullptr. The decoder must outlive the request.
+    std::shared_ptr<const WaveformPyramid> request(const std::string& file_path, IDecoder* decoder);
+
+    // In-memory lookup only; never queues work
+    std::shared_ptr<const WaveformPyramid> get(const std::string& file_path) const;
+
+    // Sidecar path used for a track
+    std::string cache_file_path(const std::string& file_path) const;
+
+private:
+    struct Job {
+        WaveformSourceKey key;
+        IDecoder* decoder;
+    };
+    struct Entry {
+        WaveformSourceKey key;
+        std::shared_ptr<const WaveformPyramid> pyramid;
+    };
+
+    void worker_main();
+    std::shared_ptr<const WaveformPyramid> produce(const Job& job);
+    void store(const WaveformSourceKey& key, std::shared_ptr<const WaveformPyramid> pyramid);
+
+    std::string cache_dir_;
+    bool initialized_;
+
+    mutable std::mutex mutex_;                   // Guards everything below
+    std::condition_variable work_cv_;
+    std::deque<Job> queue_;
+    std::map<std::string, Entry> resident_;
+    std::deque<std::string> resident_order_;     // Least recently used first
+    std::string building_;                       // Path the worker is on
+    ReadyCallback ready_callback_;
+
+    std::thread worker_;
+    bool running_;
+    std::atomic<bool> cancel_;
+};
+
+} // namespace core
+} // namespace mp
@@ -0,0 +1,684 @@
+#include "mp_dsp.h"
+#include "mp_sample_format.h"
+#include "fft.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mp {
+namespace dsp {
+
+// Impulse response as planar float channels
+struct ImpulseResponse {
+    std::vector<std::vector<float>> channels;
+    uint32_t sample_rate;
+
+    ImpulseResponse() : sample_rate(0) {}
+
+    uint32_t frames() const {
+        return channels.empty() ? 0 : static_cast<uint32_t>(channels[0].size());
+    }
+};
+
+// Non-uniformly partitioned overlap-save convolution.
+//
+// The response is cut into segments of equal partitions. The head segment
+// uses partitions of head_block frames, which sets the latency; each later
+// segment uses partitions four times longer, up to max_block. A segment of
+// block B starts at offset B - head_block in the response, so the output of
+// each of its blocks is due the moment that block of input is complete:
+// every segment adds into the same output frames without extra delay.
+//
+// Each segment keeps a frequency-domain delay line of past input spectra.
+// At a block boundary it transforms the new input, multiplies it with the
+// first partition and adds the products of the older partitions, which
+// were accumulated across the head blocks of the previous period rather
+// than all at once. Only the FFTs remain at the boundary.
+//
+// Input and output go through a FIFO of one head block, so callers may
+// pass any number of frames. Every buffer is allocated in the constructor.
+class ConvolutionEngine {
+public:
+    static constexpr uint32_t GROWTH = 4;   // Partition size ratio between segments
+
+    ConvolutionEngine(const ImpulseResponse& ir, uint16_t channels,
+                      uint32_t head_block, uint32_t max_block)
+        : channels_(channels)
+        , head_(head_block)
+        , fill_(0)
+        , in_fifo_(static_cast<size_t>(channels) * head_block)
+        , out_fifo_(static_cast<size_t>(channels) * head_block)
+        , needs_clear_(false) {
+
+        const uint32_t length = std::max(ir.frames(), 1u);
+        uint32_t offset = 0;
+        uint32_t block = head_block;
+
+        for (;;) {
+            const uint32_t next = std::min(block * GROWTH, max_block);
+            uint32_t partitions = (block < max_block) ? next / block - 1 : 0;
+            const bool last = partitions == 0 || offset + partitions * block >= length;
+            if (last) {
+                partitions = (length - offset + block - 1) / block;
+            }
+
+            segments_.emplace_back(new Segment(ir, channels, block, partitions, offset, head_block));
+            if (last) {
+                break;
+            }
+            offset += partitions * block;
+            block = next;
+        }
+    }
+
+    uint32_t latency() const { return head_; }
+
+    // Convolve interleaved frames in place. While bypassed the dry input
+    // is still delayed by the latency, so toggling does not shift the
+    // signal; the filter history restarts when processing resumes.
+    void process(float* samples, uint32_t frames, bool bypass) {
+        if (!bypass && needs_clear_) {
+            reset();
+        }
+        needs_clear_ = needs_clear_ || bypass;
+
+        uint32_t done = 0;
+        while (done < frames) {
+            const uint32_t count = std::min(frames - done, head_ - fill_);
+            for (uint16_t ch = 0; ch < channels_; ++ch) {
+                float* in = in_fifo_.data() + static_cast<size_t>(ch) * head_ + fill_;
+                const float* out = (bypass ? in_fifo_.data() : out_fifo_.data()) +
+                                   static_cast<size_t>(ch) * head_ + fill_;
+                float* frame = samples + static_cast<size_t>(done) * channels_ + ch;
+                for (uint32_t i = 0; i < count; ++i) {
+                    // Read first: in bypass the sample leaving the FIFO is the delayed one
+                    float y = out[i];
+                    in[i] = frame[i * channels_];
+                    frame[i * channels_] = y;
+                }
+            }
+            fill_ += count;
+            done += count;
+
+            if (fill_ == head_) {
+                if (!bypass) {
+                    run_block();
+                }
+                fill_ = 0;
+            }
+        }
+    }
+
+    void reset() {
+        std::fill(in_fifo_.begin(), in_fifo_.end(), 0.0f);
+        std::fill(out_fifo_.begin(), out_fifo_.end(), 0.0f);
+        fill_ = 0;
+        for (auto& segment : segments_) {
+            segment->reset();
+        }
+        needs_clear_ = false;
+    }
+
+private:
+    // One run of equal partitions: FFTs of twice the partition length
+    struct Segment {
+        uint32_t block;
+        uint32_t partitions;
+        uint32_t steps;          // Head blocks per block
+        uint32_t phase;          // Head blocks collected in the current block
+        uint32_t newest;         // Delay line slot of the latest spectrum
+        uint32_t read;           // Output frames already handed out
+        audio::RealFFT fft;
+        uint32_t bins;
+        std::vector<uint32_t> response_of;   // Response channel per stream channel
+        std::vector<float> h_re, h_im;       // [response channel][partition][bin]
+        std::vector<float> x_re, x_im;       // [channel][partition][bin], ring
+        std::vector<float> acc_re, acc_im;   // [channel][bin], older partitions
+        std::vector<float> previous;         // [channel][block]
+        std::vector<float> current;          // [channel][block]
+        std::vector<float> output;           // [channel][block]
+        std::vector<float> window;           // 2 * block
+        std::vector<float> spectrum_re, spectrum_im;
+
+        Segment(const ImpulseResponse& ir, uint16_t channels, uint32_t block_frames,
+                uint32_t partition_count, uint32_t offset, uint32_t head_block)
+            : block(block_frames)
+            , partitions(partition_count)
+            , steps(block_frames / head_block)
+            , fft(2 * block_frames)
+            , bins(static_cast<uint32_t>(fft.bins()))
+            , response_of(channels)
+            , x_re(static_cast<size_t>(channels) * partitions * bins)
+            , x_im(x_re.size())
+            , acc_re(static_cast<size_t>(channels) * bins)
+            , acc_im(acc_re.size())
+            , previous(static_cast<size_t>(channels) * block)
+            , current(previous.size())
+            , output(previous.size())
+            , window(2 * block)
+            , spectrum_re(bins)
+            , spectrum_im(bins) {
+
+            // No response passes the input through unchanged
+            ImpulseResponse dirac;
+            dirac.channels.assign(1, std::vector<float>(1, 1.0f));
+            const ImpulseResponse& source = ir.channels.empty() ? dirac : ir;
+            const uint32_t responses = static_cast<uint32_t>(source.channels.size());
+
+            for (uint16_t ch = 0; ch < channels; ++ch) {
+                response_of[ch] = ch % responses;
+            }
+
+            // Fold the inverse transform's gain of 2 * block into the spectra
+            const float scale = 1.0f / static_cast<float>(2 * block);
+            h_re.resize(static_cast<size_t>(responses) * partitions * bins);
+            h_im.resize(h_re.size());
+            for (uint32_t r = 0; r < responses; ++r) {
+                const std::vector<float>& taps = source.channels[r];
+                for (uint32_t p = 0; p < partitions; ++p) {
+                    std::fill(window.begin(), window.end(), 0.0f);
+                    const size_t start = static_cast<size_t>(offset) + static_cast<size_t>(p) * block;
+                    for (uint32_t i = 0; i < block && start + i < taps.size(); ++i) {
+                        window[i] = taps[start + i] * scale;
+                    }
+                    const size_t at = (static_cast<size_t>(r) * partitions + p) * bins;
+                    fft.forward(window.data(), h_re.data() + at, h_im.data() + at);
+                }
+            }
+
+            reset();
+        }
+
+        void reset() {
+            phase = 0;
+            newest = 0;
+            read = 0;
+            std::fill(x_re.begin(), x_re.end(), 0.0f);
+            std::fill(x_im.begin(), x_im.end(), 0.0f);
+            std::fill(acc_re.begin(), acc_re.end(), 0.0f);
+            std::fill(acc_im.begin(), acc_im.end(), 0.0f);
+            std::fill(previous.begin(), previous.end(), 0.0f);
+            std::fill(current.begin(), current.end(), 0.0f);
+            std::fill(output.begin(), output.end(), 0.0f);
+        }
+    };
+
+    static void multiply_add(float* __restrict acc_re, float* __restrict acc_im,
+                             const float* __restrict x_re, const float* __restrict x_im,
+                             const float* __restrict h_re, const float* __restrict h_im,
+                             uint32_t bins) {
+        for (uint32_t k = 0; k < bins; ++k) {
+            acc_re[k] += x_re[k] * h_re[k] - x_im[k] * h_im[k];
+            acc_im[k] += x_re[k] * h_im[k] + x_im[k] * h_re[k];
+        }
+    }
+
+    // A full head block of input is in in_fifo_: filter it into out_fifo_
+    void run_block() {
+        std::fill(out_fifo_.begin(), out_fifo_.end(), 0.0f);
+
+        for (auto& segment : segments_) {
+            Segment& s = *segment;
+            const size_t bins = s.bins;
+            const size_t line = static_cast<size_t>(s.partitions) * bins;
+
+            for (uint16_t ch = 0; ch < channels_; ++ch) {
+                std::memcpy(s.current.data() + static_cast<size_t>(ch) * s.block + static_cast<size_t>(s.phase) * head_,
+                            in_fifo_.data() + static_cast<size_t>(ch) * head_, head_ * sizeof(float));
+            }
+
+            if (++s.phase == s.steps) {
+                // Block boundary: transform, finish the sum and return to time
+                s.newest = (s.newest + s.partitions - 1) % s.partitions;
+                for (uint16_t ch = 0; ch < channels_; ++ch) {
+                    const size_t frames = static_cast<size_t>(ch) * s.block;
+                    std::memcpy(s.window.data(), s.previous.data() + frames, s.block * sizeof(float));
+                    std::memcpy(s.window.data() + s.block, s.current.data() + frames, s.block * sizeof(float));
+
+                    float* x_re = s.x_re.data() + ch * line + s.newest * bins;
+                    float* x_im = s.x_im.data() + ch * line + s.newest * bins;
+                    s.fft.forward(s.window.data(), x_re, x_im);
+
+                    float* acc_re = s.acc_re.data() + ch * bins;
+                    float* acc_im = s.acc_im.data() + ch * bins;
+                    const size_t h = s.response_of[ch] * line;
+                    multiply_add(acc_re, acc_im, x_re, x_im, s.h_re.data() + h, s.h_im.data() + h, s.bins);
+
+                    // Overlap-save: the second half is the valid output
+                    s.fft.inverse(acc_re, acc_im, s.window.data());
+                    std::memcpy(s.output.data() + frames, s.window.data() + s.block, s.block * sizeof(float));
+                    std::fill(acc_re, acc_re + bins, 0.0f);
+                    std::fill(acc_im, acc_im + bins, 0.0f);
+                }
+                s.previous.swap(s.current);
+                s.phase = 0;
+                s.read = 0;
+            }
+
+            // This head block's share of the older partitions for the next
+            // boundary, where today's newest spectrum becomes partition 1
+            const uint32_t first = 1 + (s.partitions - 1) * s.phase / s.steps;
+            const uint32_t end = 1 + (s.partitions - 1) * (s.phase + 1) / s.steps;
+            for (uint16_t ch = 0; ch < channels_; ++ch) {
+                float* acc_re = s.acc_re.data() + ch * bins;
+                float* acc_im = s.acc_im.data() + ch * bins;
+                const size_t h = s.response_of[ch] * line;
+                for (uint32_t p = first; p < end; ++p) {
+                    const size_t x = ch * line + ((s.newest + p - 1) % s.partitions) * bins;
+                    multiply_add(acc_re, acc_im, s.x_re.data() + x, s.x_im.data() + x,
+                                 s.h_re.data() + h + p * bins, s.h_im.data() + h + p * bins, s.bins);
+                }
+            }
+
+            for (uint16_t ch = 0; ch < channels_; ++ch) {
+                const float* from = s.output.data() + static_cast<size_t>(ch) * s.block + s.read;
+                float* to = out_fifo_.data() + static_cast<size_t>(ch) * head_;
+                for (uint32_t i = 0; i < head_; ++i) {
+                    to[i] += from[i];
+                }
+            }
+            s.read += head_;
+        }
+    }
+
+    uint16_t channels_;
+    uint32_t head_;
+    uint32_t fill_;                  // Frames in the current head block
+    std::vector<float> in_fifo_;     // [channel][head]
+    std::vector<float> out_fifo_;    // [channel][head]
+    bool needs_clear_;               // Bypassed since the last processed block
+    std::vector<std::unique_ptr<Segment>> segments_;
+};
+
+// Room-correction convolution DSP plugin. Loading a response or changing
+// the partition sizes builds a new engine on the calling thread; the audio
+// thread switches to it at its next block, and engines it has left behind
+// are freed by the next load, so the audio thread never allocates. The
+// reported latency is the one of the engine the audio thread runs.
+class ConvolutionDSP : public IDSPProcessor, public IPlugin, public IImpulseResponseLoader {
+public:
+    static constexpr uint16_t MAX_CHANNELS = 8;
+    static constexpr uint32_t MAX_RESPONSE_FRAMES = 1u << 20;   // About 11 s at 96 kHz
+    static constexpr uint32_t MIN_BLOCK = 32;
+    static constexpr uint32_t MAX_BLOCK = 65536;
+    static constexpr uint32_t DEFAULT_HEAD_BLOCK = 256;
+    static constexpr uint32_t DEFAULT_MAX_BLOCK = 4096;   // Longer tails save little and spike at boundaries
+
+    enum Parameter : uint32_t {
+        HEAD_BLOCK = 0,
+        TAIL_BLOCK = 1,
+        PARAMETER_COUNT = 2
+    };
+
+    ConvolutionDSP()
+        : sample_rate_(0)
+        , channels_(0)
+        , bypassed_(false)
+        , head_block_(DEFAULT_HEAD_BLOCK)
+        , max_block_(DEFAULT_MAX_BLOCK)
+        , latency_(0)
+        , started_(false)
+        , latest_(nullptr)
+        , active_(nullptr)
+        , engine_(nullptr) {
+    }
+
+    ~ConvolutionDSP() override {
+        shutdown();
+    }
+
+    // IDSPProcessor implementation
+    Result initialize(const DSPConfig* config) override {
+        if (!config) {
+            return Result::InvalidParameter;
+        }
+        if (config->channels == 0 || config->channels > MAX_CHANNELS) {
+            return Result::NotSupported;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        sample_rate_ = config->sample_rate;
+        channels_ = config->channels;
+
+        // Nothing is processing yet, so the engine can be installed directly
+        engines_.clear();
+        engines_.emplace_back(build());
+        engine_ = engines_.back().get();
+        latency_.store(engine_->latency(), std::memory_order_relaxed);
+        started_.store(false, std::memory_order_relaxed);
+        latest_.store(engine_, std::memory_order_release);
+        active_.store(engine_, std::memory_order_release);
+
+        return Result::Success;
+    }
+
+    Result process(AudioBuffer* input, AudioBuffer* output) override {
+        if (!input || !input->data) {
+            return Result::InvalidParameter;
+        }
+        if (!engine_) {
+            return Result::NotInitialized;
+        }
+
+        // Switch to an engine published since the last block. Once started_
+        // is seen, the loader leaves the latency to this thread.
+        if (!started_.load(std::memory_order_relaxed)) {
+            started_.store(true, std::memory_order_seq_cst);
+        }
+        ConvolutionEngine* latest = latest_.load(std::memory_order_seq_cst);
+        if (latest != engine_) {
+            engine_ = latest;
+            latency_.store(engine_->latency(), std::memory_order_relaxed);
+            active_.store(latest, std::memory_order_release);
+        }
+
+        engine_->process(static_cast<float*>(input->data), input->frames, bypassed_);
+
+        // If output buffer provided, copy result
+        if (output && output != input) {
+            std::memcpy(output->data, input->data,
+                       input->frames * channels_ * sizeof(float));
+            output->frames = input->frames;
+        }
+
+        return Result::Success;
+    }
+
+    uint32_t get_latency_samples() const override {
+        // One head block, also while bypassed
+        return latency_.load(std::memory_order_relaxed);
+    }
+
+    void reset() override {
+        if (engine_) {
+            engine_->reset();
+        }
+    }
+
+    void set_bypass(bool bypass) override {
+        bypassed_ = bypass;
+    }
+
+    bool is_bypassed() const override {
+        return bypassed_;
+    }
+
+    uint32_t get_dsp_capabilities() const override {
+        return static_cast<uint32_t>(DSPCapability::InPlace) |
+               static_cast<uint32_t>(DSPCapability::VariableLatency) |
+               static_cast<uint32_t>(DSPCapability::Bypass) |
+               static_cast<uint32_t>(DSPCapability::Stereo) |
+               static_cast<uint32_t>(DSPCapability::Multichannel);
+    }
+
+    PluginCapability get_capabilities() const override {
+        return PluginCapability::None;
+    }
+
+    uint32_t get_parameter_count() const override {
+        return PARAMETER_COUNT;
+    }
+
+    Result get_parameter_info(uint32_t index, DSPParameter* param) const override {
+        if (!param || index >= PARAMETER_COUNT) {
+            return Result::InvalidParameter;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index == HEAD_BLOCK) {
+            param->name = "head_block";
+            param->label = "Head Partition";
+            param->min_value = static_cast<float>(MIN_BLOCK);
+            param->max_value = 8192.0f;
+            param->default_value = static_cast<float>(DEFAULT_HEAD_BLOCK);
+            param->current_value = static_cast<float>(head_block_);
+        } else {
+            param->name = "tail_block";
+            param->label = "Longest Partition";
+            param->min_value = static_cast<float>(MIN_BLOCK);
+            param->max_value = static_cast<float>(MAX_BLOCK);
+            param->default_value = static_cast<float>(DEFAULT_MAX_BLOCK);
+            param->current_value = static_cast<float>(max_block_);
+        }
+        param->unit = "samples";
+
+        return Result::Success;
+    }
+
+    Result set_parameter(uint32_t index, float value) override {
+        if (index >= PARAMETER_COUNT) {
+            return Result::InvalidParameter;
+        }
+
+        // Partitions are powers of two; the head sets the latency, longer
+        // tail partitions cost less on average but more at their boundaries
+        uint32_t block = MIN_BLOCK;
+        while (block < MAX_BLOCK && block * 2 <= value) {
+            block *= 2;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index == HEAD_BLOCK) {
+            head_block_ = std::min(block, 8192u);
+        } else {
+            max_block_ = block;
+        }
+        rebuild();
+
+        return Result::Success;
+    }
+
+    float get_parameter(uint32_t index) const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index == HEAD_BLOCK) {
+            return static_cast<float>(head_block_);
+        }
+        if (index == TAIL_BLOCK) {
+            return static_cast<float>(max_block_);
+        }
+        return 0.0f;
+    }
+
+    void shutdown() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        engine_ = nullptr;
+        latency_.store(0, std::memory_order_relaxed);
+        latest_.store(nullptr, std::memory_order_release);
+        active_.store(nullptr, std::memory_order_release);
+        engines_.clear();
+    }
+
+    // IImpulseResponseLoader implementation
+    Result load_impulse_response(IDecoder* decoder, const char* file_path) override {
+        if (!decoder || !file_path) {
+            return Result::InvalidParameter;
+        }
+
+        ImpulseResponse ir;
+        Result result = decode(decoder, file_path, ir);
+        if (result != Result::Success) {
+            return result;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return install(std::move(ir));
+    }
+
+    Result set_impulse_response(const float* const* channels, uint32_t channel_count,
+                                uint32_t frames, uint32_t sample_rate) override {
+        if (!channels || channel_count == 0 || channel_count > MAX_CHANNELS ||
+            frames == 0 || sample_rate == 0) {
+            return Result::InvalidParameter;
+        }
+
+        ImpulseResponse ir;
+        ir.sample_rate = sample_rate;
+        frames = std::min(frames, MAX_RESPONSE_FRAMES);
+        for (uint32_t ch = 0; ch < channel_count; ++ch) {
+            ir.channels.emplace_back(channels[ch], channels[ch] + frames);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return install(std::move(ir));
+    }
+
+    // IPlugin implementation
+    const PluginInfo& get_plugin_info() const override {
+        static PluginInfo info = {
+            "Convolution",
+            "Music Player",
+            "Partitioned FFT convolution with an impulse response",
+            {1, 0, 0},
+            API_VERSION,
+            "mp.dsp.convolution"
+        };
+        return info;
+    }
+
+    Result initialize(IServiceRegistry* services) override {
+        (void)services;
+        return Result::Success;
+    }
+
+    void* get_service(ServiceID id) override {
+        if (id == SERVICE_IMPULSE_RESPONSE) {
+            return static_cast<IImpulseResponseLoader*>(this);
+        }
+        return nullptr;
+    }
+
+    // Plugin type info methods (for macro)
+    const char* get_uuid() const;
+    const char* get_name() const;
+    const char* get_author() const;
+    const char* get_description() const;
+    Version get_version() const;
+    uint32_t get_type() const;
+
+private:
+    // Read a whole response through a decoder plugin into planar floats
+    static Result decode(IDecoder* decoder, const char* file_path, ImpulseResponse& ir) {
+        DecoderHandle handle = {};
+        Result result = decoder->open_stream(file_path, &handle);
+        if (result != Result::Success) {
+            return result;
+        }
+
+        AudioStreamInfo info = {};
+        result = decoder->get_stream_info(handle, &info);
+
+        const size_t bytes_per_sample = sample_format_bytes(info.format);
+        if (result == Result::Success &&
+            (bytes_per_sample == 0 || info.channels == 0 || info.channels > MAX_CHANNELS)) {
+            result = Result::NotSupported;
+        }
+        if (result != Result::Success) {
+            decoder->close_stream(handle);
+            return result;
+        }
+
+        const size_t chunk_frames = 4096;
+        const size_t frame_bytes = bytes_per_sample * info.channels;
+        std::vector<uint8_t> buffer(chunk_frames * frame_bytes);
+        std::vector<float> samples(chunk_frames * info.channels);
+        ir.sample_rate = info.sample_rate;
+        ir.channels.assign(info.channels, std::vector<float>());
+
+        while (ir.frames() < MAX_RESPONSE_FRAMES) {
+            size_t frames = 0;
+            result = decoder->decode_block(handle, buffer.data(), buffer.size(), &frames);
+            if (result != Result::Success || frames == 0) {
+                break;
+            }
+            frames = std::min<size_t>({ frames, chunk_frames, MAX_RESPONSE_FRAMES - ir.frames() });
+            samples_to_float(buffer.data(), info.format, frames * info.channels, samples.data());
+            for (size_t i = 0; i < frames; ++i) {
+                for (uint32_t ch = 0; ch < info.channels; ++ch) {
+                    ir.channels[ch].push_back(samples[i * info.channels + ch]);
+                }
+            }
+        }
+        decoder->close_stream(handle);
+
+        if (result != Result::Success) {
+            return result;
+        }
+        return ir.frames() > 0 ? Result::Success : Result::Error;
+    }
+
+    // Caller holds mutex_
+    Result install(ImpulseResponse&& ir) {
+        // Responses are measured per rate; resampling one would blur it
+        if (sample_rate_ != 0 && ir.sample_rate != sample_rate_) {
+            return Result::NotSupported;
+        }
+        response_ = std::move(ir);
+        rebuild();
+        return Result::Success;
+    }
+
+    // Caller holds mutex_
+    std::unique_ptr<ConvolutionEngine> build() const {
+        const bool usable = response_.sample_rate == sample_rate_;
+        static const ImpulseResponse none;
+        return std::unique_ptr<ConvolutionEngine>(new ConvolutionEngine(
+            usable ? response_ : none, channels_, head_block_, std::max(head_block_, max_block_)));
+    }
+
+    // Publish a fresh engine. Caller holds mutex_.
+    void rebuild() {
+        if (channels_ == 0) {
+            // Built by initialize()
+            return;
+        }
+
+        // Engines before the one the audio thread acknowledged are unreachable
+        ConvolutionEngine* active = active_.load(std::memory_order_acquire);
+        auto in_use = std::find_if(engines_.begin(), engines_.end(),
+            [active](const std::unique_ptr<ConvolutionEngine>& e) { return e.get() == active; });
+        if (in_use != engines_.end()) {
+            engines_.erase(engines_.begin(), in_use);
+        }
+
+        engines_.emplace_back(build());
+        latest_.store(engines_.back().get(), std::memory_order_seq_cst);
+
+        // Before the first block no engine runs yet, so the new one's latency
+        // is already the right answer. Otherwise process() reports it when it
+        // switches; either it sees this engine or we see started_.
+        if (!started_.load(std::memory_order_seq_cst)) {
+            latency_.store(engines_.back()->latency(), std::memory_order_relaxed);
+        }
+    }
+
+    mutable std::mutex mutex_;       // Loader side: response, format, parameters, engines_
+    uint32_t sample_rate_;
+    uint16_t channels_;
+    bool bypassed_;
+    uint32_t head_block_;
+    uint32_t max_block_;
+    ImpulseResponse response_;
+
+    std::atomic<uint32_t> latency_;                            // Of the engine in use
+    std::atomic<bool> started_;                                // Processed since initialize()
+    std::vector<std::unique_ptr<ConvolutionEngine>> engines_;   // In publish order
+    std::atomic<ConvolutionEngine*> latest_;                   // Newest published engine
+    std::atomic<ConvolutionEngine*> active_;                   // Last one the audio thread took
+    ConvolutionEngine* engine_;                                // Audio thread only
+};
+
+}} // namespace mp::dsp
+
+// Register plugin
+MP_DEFINE_DSP_PLUGIN(
+    mp::dsp::ConvolutionDSP,
+    "mp.dsp.convolution",
+    "Convolution",
+    "Music Player",
+    "Partitioned FFT convolution for room correction impulse responses",
+    1, 0, 0
+)
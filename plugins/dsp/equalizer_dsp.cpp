@@ -1,75 +1,18 @@
 #include "mp_dsp.h"
+#include "equalizer_dsp.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <cstdio>
 
 namespace mp {
 namespace dsp {
 
-// Biquad filter implementation for peaking EQ
-struct BiquadFilter {
-    // Filter coefficients
-    float b0, b1, b2;  // Numerator coefficients
-    float a1, a2;      // Denominator coefficients (a0 is normalized to 1)
-    
-    // State variables (for stereo)
-    float x1[2], x2[2];  // Input history
-    float y1[2], y2[2];  // Output history
-    
-    BiquadFilter() {
-        reset();
-    }
-    
-    void reset() {
-        b0 = 1.0f; b1 = 0.0f; b2 = 0.0f;
-        a1 = 0.0f; a2 = 0.0f;
-        std::memset(x1, 0, sizeof(x1));
-        std::memset(x2, 0, sizeof(x2));
-        std::memset(y1, 0, sizeof(y1));
-        std::memset(y2, 0, sizeof(y2));
-    }
-    
-    // Design peaking EQ filter
-    void design_peaking(float sample_rate, float freq, float gain_db, float q) {
-        const float pi = 3.14159265358979323846f;
-        float A = std::pow(10.0f, gain_db / 40.0f);
-        float omega = 2.0f * pi * freq / sample_rate;
-        float sin_omega = std::sin(omega);
-        float cos_omega = std::cos(omega);
-        float alpha = sin_omega / (2.0f * q);
-        
-        // Peaking EQ filter coefficients
-        b0 = 1.0f + alpha * A;
-        b1 = -2.0f * cos_omega;
-        b2 = 1.0f - alpha * A;
-        float a0 = 1.0f + alpha / A;
-        a1 = -2.0f * cos_omega;
-        a2 = 1.0f - alpha / A;
-        
-        // Normalize by a0
-        b0 /= a0;
-        b1 /= a0;
-        b2 /= a0;
-        a1 /= a0;
-        a2 /= a0;
-    }
-    
-    // Process a single sample for one channel
-    inline float process(float input, int channel) {
-        float output = b0 * input + b1 * x1[channel] + b2 * x2[channel]
-                                   - a1 * y1[channel] - a2 * y2[channel];
-        
-        // Update state
-        x2[channel] = x1[channel];
-        x1[channel] = input;
-        y2[channel] = y1[channel];
-        y1[channel] = output;
-        
-        return output;
-    }
-};
-
 // 10-band graphic equalizer DSP plugin
 class EqualizerDSP : public IDSPProcessor, public IPlugin {
 public:
@@ -79,15 +22,19 @@ public:
         1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f
     };
     static constexpr float Q_FACTOR = 1.0f;  // Q factor for peaking filters
+    static constexpr float SMOOTHING_MS = 10.0f;  // Coefficient ramp after a gain change
     
     EqualizerDSP()
         : sample_rate_(0)
         , channels_(0)
-        , bypassed_(false) {
+        , bypassed_(false)
+        , ramp_frames_(0)
+        , design_pending_(false)
+        , designer_stop_(false) {
         
         // Initialize all band gains to 0 dB
         for (int i = 0; i < NUM_BANDS; ++i) {
-            band_gains_db_[i] = 0.0f;
+            band_gains_db_[i].store(0.0f, std::memory_order_relaxed);
         }
     }
     
@@ -101,16 +48,27 @@ public:
             return Result::InvalidParameter;
         }
         
+        stop_designer();
+        
+        if (!cascade_.set_channels(config->channels)) {
+            // Mono up to 7.1
+            return Result::NotSupported;
+        }
+        
         sample_rate_ = config->sample_rate;
         channels_ = config->channels;
+        ramp_frames_ = static_cast<uint32_t>(sample_rate_ * SMOOTHING_MS / 1000.0f);
         
-        if (channels_ > 2) {
-            // Currently only support mono and stereo
-            return Result::NotSupported;
+        // Design all filters now; later changes are designed off the audio thread
+        CoefficientSet set;
+        design(set);
+        for (int band = 0; band < NUM_BANDS; ++band) {
+            cascade_.set_band(band, set.bands[band]);
         }
+        designs_.consume();   // Drop anything designed for the previous format
         
-        // Design all filters
-        update_filters();
+        designer_stop_ = false;
+        designer_ = std::thread(&EqualizerDSP::designer_loop, this);
         
         return Result::Success;
     }
@@ -130,24 +88,14 @@ public:
             return Result::Success;
         }
         
-        // Process audio
-        float* buffer = static_cast<float*>(input->data);
-        
-        // Process each frame
-        for (size_t frame = 0; frame < input->frames; ++frame) {
-            for (int ch = 0; ch < channels_; ++ch) {
-                size_t sample_idx = frame * channels_ + ch;
-                float sample = buffer[sample_idx];
-                
-                // Apply all band filters in series
-                for (int band = 0; band < NUM_BANDS; ++band) {
-                    sample = filters_[band].process(sample, ch);
-                }
-                
-                buffer[sample_idx] = sample;
-            }
+        // Glide to coefficients the designer has published since the last block
+        if (designs_.consume()) {
+            cascade_.ramp_to(designs_.front().bands, ramp_frames_);
         }
         
+        // Apply all band filters in series, every channel at once
+        cascade_.process(static_cast<float*>(input->data), input->frames);
+        
         // If output buffer provided, copy result
         if (output && output != input) {
             std::memcpy(output->data, input->data, 
@@ -164,9 +112,7 @@ public:
     
     void reset() override {
         // Reset all filter states
-        for (int i = 0; i < NUM_BANDS; ++i) {
-            filters_[i].reset();
-        }
+        cascade_.reset();
     }
     
     void set_bypass(bool bypass) override {
@@ -180,7 +126,8 @@ public:
     uint32_t get_dsp_capabilities() const {
         return static_cast<uint32_t>(DSPCapability::InPlace) |
                static_cast<uint32_t>(DSPCapability::Bypass) |
-               static_cast<uint32_t>(DSPCapability::Stereo);
+               static_cast<uint32_t>(DSPCapability::Stereo) |
+               static_cast<uint32_t>(DSPCapability::Multichannel);
     }
     
     PluginCapability get_capabilities() const override {
@@ -224,7 +171,7 @@ public:
         param->min_value = -12.0f;   // -12 dB
         param->max_value = 12.0f;    // +12 dB
         param->default_value = 0.0f;  // 0 dB (flat)
-        param->current_value = band_gains_db_[index];
+        param->current_value = band_gains_db_[index].load(std::memory_order_relaxed);
         param->unit = "dB";
         
         return Result::Success;
@@ -239,10 +186,14 @@ public:
         if (value < -12.0f) value = -12.0f;
         if (value > 12.0f) value = 12.0f;
         
-        band_gains_db_[index] = value;
+        band_gains_db_[index].store(value, std::memory_order_relaxed);
         
-        // Update the filter for this band
-        update_filter(index);
+        // Redesign on the worker; bursts of changes coalesce into one design
+        {
+            std::lock_guard<std::mutex> lock(designer_mutex_);
+            design_pending_ = true;
+        }
+        designer_wake_.notify_one();
         
         return Result::Success;
     }
@@ -251,11 +202,11 @@ public:
         if (index >= NUM_BANDS) {
             return 0.0f;
         }
-        return band_gains_db_[index];
+        return band_gains_db_[index].load(std::memory_order_relaxed);
     }
     
     void shutdown() override {
-        // Nothing to cleanup
+        stop_designer();
     }
     
     // IPlugin implementation
@@ -285,30 +236,63 @@ public:
     uint32_t get_type() const;
     
 private:
-    void update_filters() {
-        for (int i = 0; i < NUM_BANDS; ++i) {
-            update_filter(i);
+    struct CoefficientSet {
+        BiquadCoefficients bands[NUM_BANDS];
+    };
+    
+    void design(CoefficientSet& set) const {
+        for (int band = 0; band < NUM_BANDS; ++band) {
+            set.bands[band] = BiquadCoefficients::peaking(
+                static_cast<float>(sample_rate_),
+                BAND_FREQUENCIES[band],
+                band_gains_db_[band].load(std::memory_order_relaxed),
+                Q_FACTOR
+            );
         }
     }
     
-    void update_filter(int band) {
-        if (band < 0 || band >= NUM_BANDS || sample_rate_ == 0) {
+    // Worker: designs from the latest gains whenever set_parameter asks
+    void designer_loop() {
+        std::unique_lock<std::mutex> lock(designer_mutex_);
+        for (;;) {
+            designer_wake_.wait(lock, [this] { return design_pending_ || designer_stop_; });
+            if (designer_stop_) {
+                return;
+            }
+            design_pending_ = false;
+            
+            lock.unlock();
+            design(designs_.back());
+            designs_.publish();
+            lock.lock();
+        }
+    }
+    
+    void stop_designer() {
+        if (!designer_.joinable()) {
             return;
         }
-        
-        filters_[band].design_peaking(
-            static_cast<float>(sample_rate_),
-            BAND_FREQUENCIES[band],
-            band_gains_db_[band],
-            Q_FACTOR
-        );
+        {
+            std::lock_guard<std::mutex> lock(designer_mutex_);
+            designer_stop_ = true;
+        }
+        designer_wake_.notify_one();
+        designer_.join();
     }
     
     uint32_t sample_rate_;
     uint16_t channels_;
     bool bypassed_;
-    float band_gains_db_[NUM_BANDS];
-    BiquadFilter filters_[NUM_BANDS];
+    uint32_t ramp_frames_;
+    std::atomic<float> band_gains_db_[NUM_BANDS];   // Written by any thread
+    BiquadCascade<NUM_BANDS> cascade_;              // Audio thread only after initialize()
+    
+    TripleBuffer<CoefficientSet> designs_;          // Designer -> audio thread
+    std::thread designer_;
+    std::mutex designer_mutex_;
+    std::condition_variable designer_wake_;
+    bool design_pending_;
+    bool designer_stop_;
 };
 
 }} // namespace mp::dsp
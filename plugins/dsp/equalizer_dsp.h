@@ -0,0 +1,246 @@
+#pragma once
+
+// Building blocks of the equalizer plugin, kept apart from the plugin
+// class so tests can drive them directly
+
+#include "simd_lanes.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace mp {
+namespace dsp {
+
+// Peaking EQ coefficients, normalized so that a0 = 1
+struct BiquadCoefficients {
+    float b0, b1, b2;  // Numerator coefficients
+    float a1, a2;      // Denominator coefficients
+
+    BiquadCoefficients()
+        : b0(1.0f), b1(0.0f), b2(0.0f), a1(0.0f), a2(0.0f) {
+    }
+
+    static BiquadCoefficients peaking(float sample_rate, float freq, float gain_db, float q) {
+        const float pi = 3.14159265358979323846f;
+        float A = std::pow(10.0f, gain_db / 40.0f);
+        float omega = 2.0f * pi * freq / sample_rate;
+        float sin_omega = std::sin(omega);
+        float cos_omega = std::cos(omega);
+        float alpha = sin_omega / (2.0f * q);
+        float a0 = 1.0f + alpha / A;
+
+        BiquadCoefficients c;
+        c.b0 = (1.0f + alpha * A) / a0;
+        c.b1 = (-2.0f * cos_omega) / a0;
+        c.b2 = (1.0f - alpha * A) / a0;
+        c.a1 = (-2.0f * cos_omega) / a0;
+        c.a2 = (1.0f - alpha / A) / a0;
+        return c;
+    }
+};
+
+// Latest-value handoff from one writer thread to one reader thread. The
+// writer fills its own slot and swaps it with the shared middle slot; the
+// reader swaps the middle slot for its own when it holds something newer.
+// Neither side ever waits, and the writer simply overwrites values the
+// reader has not picked up yet.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle_(1), back_(2), front_(0) {}
+
+    // Writer: the slot to fill, then publish() it
+    T& back() { return slots_[back_]; }
+
+    void publish() {
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader: true if front() now holds a value published since the last call
+    bool consume() {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static constexpr int INDEX = 3;
+    static constexpr int FRESH = 4;
+
+    T slots_[3];
+    std::atomic<int> middle_;   // Slot index, plus FRESH until consumed
+    int back_;                  // Writer only
+    int front_;                 // Reader only
+};
+
+// Series of biquads over up to 8 interleaved channels, in structure of
+// arrays form: channels are padded to groups of four lanes, coefficients
+// are stored pre-broadcast, and each band keeps its transposed direct
+// form II state per lane. Blocks are copied into an aligned scratch
+// buffer, filtered frame by frame through every band, and copied back.
+template <int Bands>
+class BiquadCascade {
+public:
+    static constexpr int LANES = 4;
+    static constexpr int MAX_CHANNELS = 8;
+    static constexpr uint32_t BLOCK_FRAMES = 256;
+
+    BiquadCascade()
+        : channels_(0)
+        , groups_(0)
+        , ramp_remaining_(0) {
+        for (int band = 0; band < Bands; ++band) {
+            set_band(band, BiquadCoefficients());
+        }
+        reset();
+    }
+
+    // Returns false for more than MAX_CHANNELS channels
+    bool set_channels(int channels) {
+        if (channels < 1 || channels > MAX_CHANNELS) {
+            return false;
+        }
+        channels_ = channels;
+        groups_ = (channels + LANES - 1) / LANES;
+        reset();
+        return true;
+    }
+
+    // Switch one band immediately; cancels a ramp in progress
+    void set_band(int band, const BiquadCoefficients& c) {
+        ramp_remaining_ = 0;
+        fill(coefficients_[band], c);
+    }
+
+    // Move every band to new coefficients, interpolating linearly once
+    // per frame over the given number of frames. The interpolated filters
+    // stay stable: the stable (a1, a2) region is convex. A new ramp starts
+    // from wherever the current one has got to.
+    void ramp_to(const BiquadCoefficients* targets, uint32_t frames) {
+        if (frames == 0) {
+            for (int band = 0; band < Bands; ++band) {
+                set_band(band, targets[band]);
+            }
+            return;
+        }
+
+        for (int band = 0; band < Bands; ++band) {
+            fill(targets_[band], targets[band]);
+            for (int k = 0; k < 5; ++k) {
+                for (int lane = 0; lane < LANES; ++lane) {
+                    step_[band][k][lane] = (targets_[band][k][lane] - coefficients_[band][k][lane]) / frames;
+                }
+            }
+        }
+        ramp_remaining_ = frames;
+    }
+
+    // Coefficients one band is filtering with right now, ramp included
+    BiquadCoefficients band(int band) const {
+        BiquadCoefficients c;
+        c.b0 = coefficients_[band][0][0];
+        c.b1 = coefficients_[band][1][0];
+        c.b2 = coefficients_[band][2][0];
+        c.a1 = coefficients_[band][3][0];
+        c.a2 = coefficients_[band][4][0];
+        return c;
+    }
+
+    bool ramping() const { return ramp_remaining_ > 0; }
+
+    void reset() {
+        std::memset(z1_, 0, sizeof(z1_));
+        std::memset(z2_, 0, sizeof(z2_));
+        std::memset(block_, 0, sizeof(block_));
+    }
+
+    void process(float* interleaved, uint32_t frames) {
+        const int stride = groups_ * LANES;
+
+        for (uint32_t offset = 0; offset < frames; offset += BLOCK_FRAMES) {
+            const uint32_t count = std::min(BLOCK_FRAMES, frames - offset);
+            float* samples = interleaved + static_cast<size_t>(offset) * channels_;
+
+            // Padding lanes stay zero, so their filters stay silent
+            for (uint32_t f = 0; f < count; ++f) {
+                std::memcpy(block_ + f * stride, samples + f * channels_, channels_ * sizeof(float));
+            }
+
+            // Frames still inside a coefficient ramp, then the steady rest
+            uint32_t ramped = std::min(count, ramp_remaining_);
+            if (ramped > 0) {
+                run<Lanes4, true>(block_, ramped, stride);
+                ramp_remaining_ -= ramped;
+                if (ramp_remaining_ == 0) {
+                    // Land exactly on the target, whatever the rounding on the way
+                    std::memcpy(coefficients_, targets_, sizeof(coefficients_));
+                }
+            }
+            run<Lanes4, false>(block_ + ramped * stride, count - ramped, stride);
+
+            for (uint32_t f = 0; f < count; ++f) {
+                std::memcpy(samples + f * channels_, block_ + f * stride, channels_ * sizeof(float));
+            }
+        }
+    }
+
+private:
+    static void fill(float (&lanes)[5][LANES], const BiquadCoefficients& c) {
+        const float values[5] = { c.b0, c.b1, c.b2, c.a1, c.a2 };
+        for (int k = 0; k < 5; ++k) {
+            for (int lane = 0; lane < LANES; ++lane) {
+                lanes[k][lane] = values[k];
+            }
+        }
+    }
+
+    template <typename V, bool Ramp>
+    void run(float* block, uint32_t frames, int stride) {
+        for (uint32_t f = 0; f < frames; ++f) {
+            float* frame = block + f * stride;
+            for (int g = 0; g < stride; g += LANES) {
+                typename V::reg x = V::load(frame + g);
+                for (int band = 0; band < Bands; ++band) {
+                    const float (*c)[LANES] = coefficients_[band];
+                    float* s1 = z1_[band] + g;
+                    float* s2 = z2_[band] + g;
+
+                    // y = b0 x + z1; z1 = b1 x - a1 y + z2; z2 = b2 x - a2 y
+                    typename V::reg y = V::add(V::mul(V::load(c[0]), x), V::load(s1));
+                    V::store(s1, V::add(V::sub(V::mul(V::load(c[1]), x), V::mul(V::load(c[3]), y)),
+                                        V::load(s2)));
+                    V::store(s2, V::sub(V::mul(V::load(c[2]), x), V::mul(V::load(c[4]), y)));
+                    x = y;
+                }
+                V::store(frame + g, x);
+            }
+
+            if (Ramp) {
+                for (int band = 0; band < Bands; ++band) {
+                    for (int k = 0; k < 5; ++k) {
+                        V::store(coefficients_[band][k],
+                                 V::add(V::load(coefficients_[band][k]), V::load(step_[band][k])));
+                    }
+                }
+            }
+        }
+    }
+
+    int channels_;
+    int groups_;
+    alignas(16) float coefficients_[Bands][5][LANES];   // b0, b1, b2, a1, a2 per lane
+    alignas(16) float targets_[Bands][5][LANES];        // End of the current ramp
+    alignas(16) float step_[Bands][5][LANES];           // Change per frame while ramping
+    uint32_t ramp_remaining_;
+    alignas(16) float z1_[Bands][MAX_CHANNELS];
+    alignas(16) float z2_[Bands][MAX_CHANNELS];
+    alignas(16) float block_[BLOCK_FRAMES * MAX_CHANNELS];
+};
+
+}} // namespace mp::dsp
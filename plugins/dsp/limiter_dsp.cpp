@@ -0,0 +1,510 @@
+#include "mp_dsp.h"
+#include "simd_lanes.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace mp {
+namespace dsp {
+
+// True-peak meter of ITU-R BS.1770-4 Annex 2: each channel is interpolated
+// 4x with the recommendation's 48-tap polyphase filter, and the largest
+// magnitude of a sample and the four interpolated points after it is taken
+// across all channels. Using the reference filter itself means the ceiling
+// holds on a BS.1770 meter, ripple included. Four consecutive outputs share
+// each register, which needs no horizontal reductions.
+//
+// peak[i] covers the interval after input sample i - DELAY, counting from
+// the first sample ever processed: the interpolator looks DELAY samples
+// ahead.
+class TruePeakDetector {
+public:
+    static constexpr int TAPS = 12;             // Per phase
+    static constexpr int PHASES = 4;
+    static constexpr uint32_t DELAY = TAPS / 2;
+    static constexpr int CENTER = TAPS / 2 - 1; // Tap holding the sample itself
+
+    TruePeakDetector() : channels_(0), stride_(0) {
+        // The phases are mirror images of each other, so applying them to
+        // the history in reading order only changes which phase is which
+        static const float bs1770[PHASES][TAPS] = {
+            { 0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f,
+              -0.0594482421875f, 0.1373291015625f, 0.9721679687500f, -0.1022949218750f,
+              0.0476074218750f, -0.0266113281250f, 0.0148925781250f, -0.0083007812500f },
+            { -0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f,
+              -0.1665039062500f, 0.4650878906250f, 0.7797851562500f, -0.2003173828125f,
+              0.1015625000000f, -0.0582275390625f, 0.0330810546875f, -0.0189208984375f },
+            { -0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f,
+              -0.2003173828125f, 0.7797851562500f, 0.4650878906250f, -0.1665039062500f,
+              0.0891113281250f, -0.0517578125000f, 0.0292968750000f, -0.0291748046875f },
+            { -0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f,
+              -0.1022949218750f, 0.9721679687500f, 0.1373291015625f, -0.0594482421875f,
+              0.0332031250000f, -0.0196533203125f, 0.0109863281250f, 0.0017089843750f }
+        };
+        for (int phase = 0; phase < PHASES; ++phase) {
+            for (int t = 0; t < TAPS; ++t) {
+                for (int lane = 0; lane < 4; ++lane) {
+                    coefficients_[phase][t][lane] = bs1770[phase][t];
+                }
+            }
+        }
+    }
+
+    void initialize(uint16_t channels, uint32_t max_frames) {
+        channels_ = channels;
+        // History, the block, and slack for the last group of four
+        history_.assign(static_cast<size_t>(channels) * (TAPS - 1 + max_frames + 4), 0.0f);
+        stride_ = TAPS - 1 + max_frames + 4;
+    }
+
+    void reset() {
+        std::fill(history_.begin(), history_.end(), 0.0f);
+    }
+
+    // peaks must hold frames rounded up to a multiple of four
+    void process(const float* samples, uint32_t frames, float* peaks) {
+        typedef Lanes4 V;
+        for (uint16_t ch = 0; ch < channels_; ++ch) {
+            float* x = history_.data() + static_cast<size_t>(ch) * stride_;
+            for (uint32_t i = 0; i < frames; ++i) {
+                x[TAPS - 1 + i] = samples[static_cast<size_t>(i) * channels_ + ch];
+            }
+
+            for (uint32_t i = 0; i < frames; i += 4) {
+                V::reg peak = V::abs(V::load(x + i + CENTER));
+                for (int phase = 0; phase < PHASES; ++phase) {
+                    V::reg acc = V::mul(V::load(x + i), V::load(coefficients_[phase][0]));
+                    for (int t = 1; t < TAPS; ++t) {
+                        acc = V::add(acc, V::mul(V::load(x + i + t), V::load(coefficients_[phase][t])));
+                    }
+                    peak = V::max(peak, V::abs(acc));
+                }
+                V::store(peaks + i, ch == 0 ? peak : V::max(peak, V::load(peaks + i)));
+            }
+
+            std::memmove(x, x + frames, (TAPS - 1) * sizeof(float));
+        }
+    }
+
+private:
+    uint16_t channels_;
+    size_t stride_;
+    std::vector<float> history_;              // Per channel: TAPS - 1 old samples, then the block
+    float coefficients_[PHASES][TAPS][4];     // Pre-broadcast to four lanes
+};
+
+// Running maximum over the last `window` values in constant time per value
+// (van Herk / Gil-Werman). The stream is cut into segments of one window;
+// a window ending in the current segment is the suffix of the previous
+// segment from the same position on plus the prefix of the current one.
+// Suffix maxima are filled in when a segment completes, so every value
+// costs three comparisons whatever the signal does.
+class SlidingMax {
+public:
+    SlidingMax() : window_(1), position_(0), prefix_(0.0f) {}
+
+    void initialize(uint32_t window) {
+        window_ = std::max(1u, window);
+        segment_.assign(window_, 0.0f);
+        suffix_.assign(window_, 0.0f);
+        reset();
+    }
+
+    void reset() {
+        std::fill(segment_.begin(), segment_.end(), 0.0f);
+        std::fill(suffix_.begin(), suffix_.end(), 0.0f);
+        position_ = 0;
+        prefix_ = 0.0f;
+    }
+
+    float push(float value) {
+        segment_[position_] = value;
+        prefix_ = std::max(prefix_, value);
+        float result = position_ + 1 < window_ ? std::max(suffix_[position_ + 1], prefix_) : prefix_;
+
+        if (++position_ == window_) {
+            float running = 0.0f;
+            for (uint32_t i = window_; i-- > 0;) {
+                running = std::max(running, segment_[i]);
+                suffix_[i] = running;
+            }
+            position_ = 0;
+            prefix_ = 0.0f;
+        }
+        return result;
+    }
+
+private:
+    uint32_t window_;
+    uint32_t position_;
+    float prefix_;
+    std::vector<float> segment_;   // Current segment so far
+    std::vector<float> suffix_;    // Suffix maxima of the previous segment
+};
+
+// Look-ahead brickwall limiter on the true-peak envelope. The gain for a
+// sample is the smallest one any peak within the look-ahead asks for,
+// released exponentially and then averaged over the look-ahead, so the
+// gain has already ramped down smoothly when the peak arrives. Channels
+// share one gain, which keeps the stereo image.
+//
+// Each sample's gain covers the intervals on both sides of it: the peak
+// window is one longer than the averaging window. The audio is delayed to
+// line up with that gain, including the detector's own look-ahead.
+class TruePeakLimiter {
+public:
+    static constexpr float DETECTOR_MARGIN = 0.98855309f;  // -0.1 dB
+
+    TruePeakLimiter()
+        : channels_(0), window_(1), latency_(0)
+        , ceiling_(1.0f), release_coefficient_(1.0f)
+        , release_gain_(1.0f), average_sum_(0.0), average_position_(0)
+        , delay_frames_(0), delay_position_(0) {}
+
+    void initialize(uint32_t sample_rate, uint16_t channels, uint32_t max_frames, float lookahead_ms) {
+        channels_ = channels;
+        window_ = std::max(1u, static_cast<uint32_t>(sample_rate * lookahead_ms / 1000.0f + 0.5f));
+        latency_ = window_ + TruePeakDetector::DELAY - 1;
+
+        detector_.initialize(channels, max_frames);
+        window_max_.initialize(window_ + 1);
+        const size_t padded = (static_cast<size_t>(max_frames) + 3) & ~static_cast<size_t>(3);
+        peaks_.assign(padded, 0.0f);
+        gains_.assign(padded, 1.0f);
+        average_.assign(window_, 1.0f);
+        delay_frames_ = latency_ + max_frames;
+        delay_.assign(static_cast<size_t>(delay_frames_) * channels, 0.0f);
+        reset();
+    }
+
+    void reset() {
+        detector_.reset();
+        window_max_.reset();
+        std::fill(average_.begin(), average_.end(), 1.0f);
+        std::fill(delay_.begin(), delay_.end(), 0.0f);
+        release_gain_ = 1.0f;
+        average_sum_ = static_cast<double>(window_);
+        average_position_ = 0;
+        delay_position_ = 0;
+    }
+
+    // The ceiling holds on a BS.1770 4x meter. The detector reads the input,
+    // and a gain that moves within the interpolator's span lifts the output
+    // reading slightly: up to 0.02 dB with heavy limiting and a 1 ms release.
+    // DETECTOR_MARGIN covers that. Finer meters (8x and up) see peaks
+    // between the 4x points and read full-band noise up to about 0.9 dB
+    // higher; the ceiling is not specified against them.
+    void set_ceiling(float linear) { ceiling_ = linear * DETECTOR_MARGIN; }
+
+    void set_release(float sample_rate, float release_ms) {
+        release_coefficient_ = 1.0f - std::exp(-1000.0f / (release_ms * sample_rate));
+    }
+
+    uint32_t latency() const { return latency_; }
+
+    // Limit interleaved frames in place. While bypassed the input is only
+    // delayed, so toggling does not shift the signal.
+    void process(float* samples, uint32_t frames, bool bypass) {
+        typedef Lanes4 V;
+
+        detector_.process(samples, frames, peaks_.data());
+        for (uint32_t i = 0; i < frames; ++i) {
+            peaks_[i] = window_max_.push(peaks_[i]);
+        }
+
+        // Gain computer: the largest gain keeping each held peak at the ceiling
+        const V::reg ceiling = V::set1(ceiling_);
+        const V::reg unity = V::set1(1.0f);
+        const V::reg floor = V::set1(1e-9f);
+        for (uint32_t i = 0; i < frames; i += 4) {
+            V::reg held = V::max(V::load(peaks_.data() + i), floor);
+            V::store(gains_.data() + i, V::min(unity, V::div(ceiling, held)));
+        }
+
+        // Attack is immediate here; the moving average spreads it over the look-ahead
+        for (uint32_t i = 0; i < frames; ++i) {
+            const float target = gains_[i];
+            release_gain_ = target < release_gain_ ? target
+                                                   : release_gain_ + (target - release_gain_) * release_coefficient_;
+            average_sum_ += static_cast<double>(release_gain_) - average_[average_position_];
+            average_[average_position_] = release_gain_;
+            if (++average_position_ == window_) {
+                average_position_ = 0;
+            }
+            gains_[i] = bypass ? 1.0f : static_cast<float>(average_sum_ / window_);
+        }
+
+        // Write the block behind the delayed audio, then read back `latency_`
+        // frames earlier with the gain applied
+        uint32_t write = delay_position_;
+        uint32_t read = (delay_position_ + delay_frames_ - latency_) % delay_frames_;
+        for (uint32_t i = 0; i < frames; ++i) {
+            float* in = samples + static_cast<size_t>(i) * channels_;
+            std::memcpy(delay_.data() + static_cast<size_t>(write) * channels_, in, channels_ * sizeof(float));
+            const float* delayed = delay_.data() + static_cast<size_t>(read) * channels_;
+            const float gain = gains_[i];
+            for (uint16_t ch = 0; ch < channels_; ++ch) {
+                in[ch] = delayed[ch] * gain;
+            }
+            if (++write == delay_frames_) {
+                write = 0;
+            }
+            if (++read == delay_frames_) {
+                read = 0;
+            }
+        }
+        delay_position_ = write;
+    }
+
+private:
+    uint16_t channels_;
+    uint32_t window_;              // Look-ahead in samples
+    uint32_t latency_;
+    float ceiling_;                // Linear
+    float release_coefficient_;
+
+    TruePeakDetector detector_;
+    SlidingMax window_max_;
+    std::vector<float> peaks_;     // Per block: true peaks, then held peaks
+    std::vector<float> gains_;     // Per block: target gains, then applied gains
+
+    float release_gain_;
+    std::vector<float> average_;   // Last `window_` released gains
+    double average_sum_;
+    uint32_t average_position_;
+
+    std::vector<float> delay_;     // Interleaved ring of delay_frames_ frames
+    uint32_t delay_frames_;
+    uint32_t delay_position_;
+};
+
+class LimiterDSP : public IDSPProcessor, public IPlugin {
+public:
+    static constexpr uint16_t MAX_CHANNELS = 8;
+    static constexpr float LOOKAHEAD_MS = 2.0f;
+    static constexpr float DEFAULT_CEILING_DB = -1.0f;
+    static constexpr float DEFAULT_RELEASE_MS = 50.0f;
+
+    enum Parameter : uint32_t {
+        CEILING = 0,
+        RELEASE = 1,
+        PARAMETER_COUNT = 2
+    };
+
+    LimiterDSP()
+        : sample_rate_(0)
+        , channels_(0)
+        , max_frames_(0)
+        , bypassed_(false)
+        , initialized_(false)
+        , applied_ceiling_db_(0.0f)
+        , applied_release_ms_(0.0f)
+        , ceiling_db_(DEFAULT_CEILING_DB)
+        , release_ms_(DEFAULT_RELEASE_MS) {
+    }
+
+    ~LimiterDSP() override {
+        shutdown();
+    }
+
+    // IDSPProcessor implementation
+    Result initialize(const DSPConfig* config) override {
+        if (!config) {
+            return Result::InvalidParameter;
+        }
+        if (config->channels == 0 || config->channels > MAX_CHANNELS || config->max_buffer_frames == 0) {
+            return Result::NotSupported;
+        }
+
+        sample_rate_ = config->sample_rate;
+        channels_ = config->channels;
+        max_frames_ = config->max_buffer_frames;
+        limiter_.initialize(sample_rate_, channels_, max_frames_, LOOKAHEAD_MS);
+        apply_parameters(true);
+        initialized_ = true;
+
+        return Result::Success;
+    }
+
+    Result process(AudioBuffer* input, AudioBuffer* output) override {
+        if (!input || !input->data) {
+            return Result::InvalidParameter;
+        }
+        if (!initialized_) {
+            return Result::NotInitialized;
+        }
+
+        apply_parameters(false);
+
+        // The limiter's scratch buffers are sized for max_buffer_frames
+        float* samples = static_cast<float*>(input->data);
+        uint32_t done = 0;
+        while (done < input->frames) {
+            uint32_t frames = std::min(input->frames - done, max_frames_);
+            limiter_.process(samples + static_cast<size_t>(done) * channels_, frames, bypassed_);
+            done += frames;
+        }
+
+        // If output buffer provided, copy result
+        if (output && output != input) {
+            std::memcpy(output->data, input->data,
+                       input->frames * channels_ * sizeof(float));
+            output->frames = input->frames;
+        }
+
+        return Result::Success;
+    }
+
+    uint32_t get_latency_samples() const override {
+        // The look-ahead, also while bypassed
+        return limiter_.latency();
+    }
+
+    void reset() override {
+        limiter_.reset();
+    }
+
+    void set_bypass(bool bypass) override {
+        bypassed_ = bypass;
+    }
+
+    bool is_bypassed() const override {
+        return bypassed_;
+    }
+
+    uint32_t get_dsp_capabilities() const override {
+        return static_cast<uint32_t>(DSPCapability::InPlace) |
+               static_cast<uint32_t>(DSPCapability::Bypass) |
+               static_cast<uint32_t>(DSPCapability::Stereo) |
+               static_cast<uint32_t>(DSPCapability::Multichannel);
+    }
+
+    PluginCapability get_capabilities() const override {
+        return PluginCapability::None;
+    }
+
+    uint32_t get_parameter_count() const override {
+        return PARAMETER_COUNT;
+    }
+
+    Result get_parameter_info(uint32_t index, DSPParameter* param) const override {
+        if (!param || index >= PARAMETER_COUNT) {
+            return Result::InvalidParameter;
+        }
+
+        if (index == CEILING) {
+            param->name = "ceiling";
+            param->label = "Ceiling";
+            param->min_value = -12.0f;
+            param->max_value = 0.0f;
+            param->default_value = DEFAULT_CEILING_DB;
+            param->current_value = ceiling_db_.load(std::memory_order_relaxed);
+            param->unit = "dBTP";
+        } else {
+            param->name = "release";
+            param->label = "Release";
+            param->min_value = 1.0f;
+            param->max_value = 1000.0f;
+            param->default_value = DEFAULT_RELEASE_MS;
+            param->current_value = release_ms_.load(std::memory_order_relaxed);
+            param->unit = "ms";
+        }
+
+        return Result::Success;
+    }
+
+    Result set_parameter(uint32_t index, float value) override {
+        if (index >= PARAMETER_COUNT) {
+            return Result::InvalidParameter;
+        }
+
+        // Picked up by the audio thread at the next block
+        if (index == CEILING) {
+            ceiling_db_.store(std::max(-12.0f, std::min(value, 0.0f)), std::memory_order_relaxed);
+        } else {
+            release_ms_.store(std::max(1.0f, std::min(value, 1000.0f)), std::memory_order_relaxed);
+        }
+
+        return Result::Success;
+    }
+
+    float get_parameter(uint32_t index) const override {
+        if (index == CEILING) {
+            return ceiling_db_.load(std::memory_order_relaxed);
+        }
+        if (index == RELEASE) {
+            return release_ms_.load(std::memory_order_relaxed);
+        }
+        return 0.0f;
+    }
+
+    void shutdown() override {
+        initialized_ = false;
+    }
+
+    // IPlugin implementation
+    const PluginInfo& get_plugin_info() const override {
+        static PluginInfo info = {
+            "True-Peak Limiter",
+            "Music Player",
+            "Look-ahead brickwall limiter with 4x oversampled true-peak detection",
+            {1, 0, 0},
+            API_VERSION,
+            "mp.dsp.limiter"
+        };
+        return info;
+    }
+
+    Result initialize(IServiceRegistry* services) override {
+        (void)services;
+        return Result::Success;
+    }
+
+    // Plugin type info methods (for macro)
+    const char* get_uuid() const;
+    const char* get_name() const;
+    const char* get_author() const;
+    const char* get_description() const;
+    Version get_version() const;
+    uint32_t get_type() const;
+
+private:
+    // Audio thread: follow parameter changes made since the last block
+    void apply_parameters(bool force) {
+        const float ceiling_db = ceiling_db_.load(std::memory_order_relaxed);
+        if (force || ceiling_db != applied_ceiling_db_) {
+            applied_ceiling_db_ = ceiling_db;
+            limiter_.set_ceiling(std::pow(10.0f, ceiling_db / 20.0f));
+        }
+        const float release_ms = release_ms_.load(std::memory_order_relaxed);
+        if (force || release_ms != applied_release_ms_) {
+            applied_release_ms_ = release_ms;
+            limiter_.set_release(static_cast<float>(sample_rate_), release_ms);
+        }
+    }
+
+    uint32_t sample_rate_;
+    uint16_t channels_;
+    uint32_t max_frames_;
+    bool bypassed_;
+    bool initialized_;
+    float applied_ceiling_db_;     // Audio thread only
+    float applied_release_ms_;
+    std::atomic<float> ceiling_db_;    // Written by any thread
+    std::atomic<float> release_ms_;
+    TruePeakLimiter limiter_;
+};
+
+}} // namespace mp::dsp
+
+// Register plugin
+MP_DEFINE_DSP_PLUGIN(
+    mp::dsp::LimiterDSP,
+    "mp.dsp.limiter",
+    "True-Peak Limiter",
+    "Music Player",
+    "Look-ahead brickwall limiter with 4x oversampled true-peak detection",
+    1, 0, 0
+)
@@ -0,0 +1,78 @@
+#pragma once
+
+// Four-lane float vectors shared by the DSP plugins
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DSP_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DSP_NEON 1
+#endif
+
+namespace mp {
+namespace dsp {
+
+// Four float lanes. SSE2 and NEON are part of the x86-64 and AArch64
+// baselines, so no runtime dispatch is needed. Loads and stores are
+// unaligned; on aligned data they cost the same as the aligned forms.
+#if DSP_SSE2
+struct Lanes4 {
+    typedef __m128 reg;
+    static reg load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+    static reg set1(float v) { return _mm_set1_ps(v); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+    static reg abs(reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+};
+#elif DSP_NEON
+struct Lanes4 {
+    typedef float32x4_t reg;
+    static reg load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, reg v) { vst1q_f32(p, v); }
+    static reg set1(float v) { return vdupq_n_f32(v); }
+    static reg add(reg a, reg b) { return vaddq_f32(a, b); }
+    static reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+    static reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+    static reg div(reg a, reg b) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+        return vdivq_f32(a, b);
+#else
+        // 32-bit NEON has no vector divide
+        float x[4], y[4];
+        vst1q_f32(x, a);
+        vst1q_f32(y, b);
+        for (int i = 0; i < 4; ++i) x[i] /= y[i];
+        return vld1q_f32(x);
+#endif
+    }
+    static reg min(reg a, reg b) { return vminq_f32(a, b); }
+    static reg max(reg a, reg b) { return vmaxq_f32(a, b); }
+    static reg abs(reg a) { return vabsq_f32(a); }
+};
+#else
+struct Lanes4 {
+    struct reg { float v[4]; };
+    static reg load(const float* p) { reg r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+    static void store(float* p, reg a) { std::memcpy(p, a.v, sizeof(a.v)); }
+    static reg set1(float x) { reg r; for (int i = 0; i < 4; ++i) r.v[i] = x; return r; }
+    static reg add(reg a, reg b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+    static reg sub(reg a, reg b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+    static reg mul(reg a, reg b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+    static reg div(reg a, reg b) { for (int i = 0; i < 4; ++i) a.v[i] /= b.v[i]; return a; }
+    static reg min(reg a, reg b) { for (int i = 0; i < 4; ++i) a.v[i] = std::min(a.v[i], b.v[i]); return a; }
+    static reg max(reg a, reg b) { for (int i = 0; i < 4; ++i) a.v[i] = std::max(a.v[i], b.v[i]); return a; }
+    static reg abs(reg a) { for (int i = 0; i < 4; ++i) a.v[i] = std::fabs(a.v[i]); return a; }
+};
+#endif
+
+}} // namespace mp::dsp
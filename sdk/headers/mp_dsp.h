@@ -2,6 +2,7 @@
 
 #include "mp_types.h"
 #include "mp_plugin.h"
+#include "mp_decoder.h"
 
 namespace mp {
 
@@ -77,6 +78,25 @@ public:
     virtual void shutdown() = 0;
 };
 
+// Optional interface for processors filtering through an impulse response.
+// Hosts reach it with IPlugin::get_service(SERVICE_IMPULSE_RESPONSE) on the
+// processor instance.
+class IImpulseResponseLoader {
+public:
+    virtual ~IImpulseResponseLoader() = default;
+    
+    // Decode an impulse response through a decoder plugin (e.g. the WAV
+    // decoder). Runs on the calling thread; playback switches to the new
+    // response at the next block.
+    virtual Result load_impulse_response(IDecoder* decoder, const char* file_path) = 0;
+    
+    // Set an impulse response from planar float channels
+    virtual Result set_impulse_response(const float* const* channels, uint32_t channel_count,
+                                        uint32_t frames, uint32_t sample_rate) = 0;
+};
+
+constexpr ServiceID SERVICE_IMPULSE_RESPONSE = hash_string("mp.service.impulse_response");
+
 // DSP plugin type
 constexpr uint32_t PLUGIN_TYPE_DSP = hash_string("mp.plugin.dsp");
 
@@ -20,6 +20,7 @@ constexpr EventID EVENT_CONFIG_CHANGED = hash_string("mp.event.config_changed");
 constexpr EventID EVENT_LIBRARY_UPDATED = hash_string("mp.event.library_updated");
 constexpr EventID EVENT_PLAYLIST_CHANGED = hash_string("mp.event.playlist_changed");
 constexpr EventID EVENT_METADATA_LOADED = hash_string("mp.event.metadata_loaded");
+constexpr EventID EVENT_NEXT_TRACK_REQUESTED = hash_string("mp.event.next_track_requested");
 
 // Event data structure
 struct Event {
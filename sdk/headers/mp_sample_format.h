@@ -0,0 +1,65 @@
+#pragma once
+
+#include "mp_types.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mp {
+
+// Bytes per sample of a packed format, 0 if unknown
+inline size_t sample_format_bytes(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int16: return 2;
+        case SampleFormat::Int24: return 3;
+        case SampleFormat::Int32: return 4;
+        case SampleFormat::Float32: return 4;
+        case SampleFormat::Float64: return 8;
+        default: return 0;
+    }
+}
+
+// Packed little-endian samples, as decoders produce them, to floats in
+// [-1, 1]. Unknown formats come out as silence.
+inline void samples_to_float(const uint8_t* src, SampleFormat format, size_t count, float* dst) {
+    switch (format) {
+        case SampleFormat::Int16:
+            for (size_t i = 0; i < count; ++i) {
+                int16_t v;
+                std::memcpy(&v, src + 2 * i, sizeof(v));
+                dst[i] = v / 32768.0f;
+            }
+            break;
+        case SampleFormat::Int24:
+            for (size_t i = 0; i < count; ++i) {
+                // Sign-extended from bit 23
+                const uint8_t* p = src + 3 * i;
+                int32_t v = static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 |
+                                                 static_cast<uint32_t>(p[1]) << 16 |
+                                                 static_cast<uint32_t>(p[2]) << 24) >> 8;
+                dst[i] = v / 8388608.0f;
+            }
+            break;
+        case SampleFormat::Int32:
+            for (size_t i = 0; i < count; ++i) {
+                int32_t v;
+                std::memcpy(&v, src + 4 * i, sizeof(v));
+                dst[i] = static_cast<float>(v / 2147483648.0);
+            }
+            break;
+        case SampleFormat::Float32:
+            std::memcpy(dst, src, count * sizeof(float));
+            break;
+        case SampleFormat::Float64:
+            for (size_t i = 0; i < count; ++i) {
+                double v;
+                std::memcpy(&v, src + 8 * i, sizeof(v));
+                dst[i] = static_cast<float>(v);
+            }
+            break;
+        default:
+            std::fill(dst, dst + count, 0.0f);
+            break;
+    }
+}
+
+} // namespace mp
@@ -6,7 +6,7 @@
 
 #include "adaptive_resampler.h"
 #include <algorithm>
-#include <iostream>
+#include <cmath>
 
 namespace audio {
 
@@ -16,14 +16,33 @@ AdaptiveSampleRateConverter::AdaptiveSampleRateConverter(
     ResampleQuality max_quality,
     bool auto_adjust,
     double cpu_threshold)
-    : current_quality_(ResampleQuality::Good)
+    : converter_(nullptr)
+    , fading_converter_(nullptr)
+    , current_quality_(ResampleQuality::Good)
     , min_quality_(min_quality)
     , max_quality_(max_quality)
     , auto_adjust_(auto_adjust)
     , cpu_threshold_(cpu_threshold)
     , input_rate_(0)
     , output_rate_(0)
-    , channels_(0) {
+    , channels_(0)
+    , external_load_(false)
+    , calm_callbacks_(0)
+    , total_conversions_(0)
+    , crossfade_ms_(20.0)
+    , crossfade_frames_(0)
+    , crossfade_position_(0)
+    , carried_frames_(0)
+    , pending_frames_(0)
+    , discard_frames_(0)
+    , crossfade_capacity_(0)
+    , history_frames_(0)
+    , stream_frames_(0)
+    , converter_origin_(0)
+    , converter_frames_(0)
+    , log_written_(0)
+    , log_drained_(0)
+    , dropped_transitions_(0) {
 }
 
 bool AdaptiveSampleRateConverter::initialize(int input_rate, int output_rate, int channels) {
@@ -35,30 +54,57 @@ bool AdaptiveSampleRateConverter::initialize(int input_rate, int output_rate, in
     output_rate_ = output_rate;
     channels_ = channels;
 
-    // Select initial quality
-    current_quality_ = select_quality();
-    create_converter(current_quality_);
+    // Every quality up front, so a change never builds a filter while
+    // converting; the range can widen later
+    converter_ = nullptr;
+    fading_converter_ = nullptr;
+    for (int quality = 0; quality < QUALITY_LEVELS; ++quality) {
+        converters_[quality] = EnhancedSampleRateConverterFactory::create(static_cast<ResampleQuality>(quality));
+        if (!converters_[quality] || !converters_[quality]->initialize(input_rate, output_rate, channels)) {
+            return false;
+        }
+    }
+
+    // Start inside the allowed range; load decides from here
+    current_quality_ = std::min(std::max(current_quality_, min_quality_), max_quality_);
+    converter_ = converters_[static_cast<int>(current_quality_)].get();
+
+    // Room for the priming output plus two crossfade steps: frames one
+    // stream has ahead of the other, and the next step's output
+    const int64_t step_frames = static_cast<int64_t>(CROSSFADE_BLOCK_FRAMES) * output_rate_ / input_rate_ + 16;
+    const int64_t prime_frames = static_cast<int64_t>(PRIME_FRAMES) * output_rate_ / input_rate_ + 16;
+    crossfade_capacity_ = static_cast<int>(prime_frames + 2 * step_frames);
+    pending_buffer_.assign(static_cast<size_t>(crossfade_capacity_) * channels_, 0.0f);
+    crossfade_buffer_.assign(static_cast<size_t>(crossfade_capacity_) * channels_, 0.0f);
+
+    input_history_.assign(static_cast<size_t>(PRIME_FRAMES) * channels_, 0.0f);
+    history_frames_ = 0;
+    stream_frames_ = 0;
+    converter_origin_ = 0;
+    converter_frames_ = 0;
+    pending_frames_ = 0;
+    discard_frames_ = 0;
+    carried_frames_ = 0;
+    performance_monitor_.reset();
+    calm_callbacks_ = 0;
 
-    return converter_ && converter_->initialize(input_rate, output_rate, channels);
+    return true;
 }
 
 ResampleQuality AdaptiveSampleRateConverter::select_quality() {
-    // For real-time applications, prefer speed
-    if (!auto_adjust_) {
+    if (!auto_adjust_ || performance_monitor_.get_sample_count() < MIN_DECISION_CALLBACKS) {
         return current_quality_;
     }
 
-    // Check current system load
-    double cpu_usage = performance_monitor_.get_cpu_estimate();
+    double usage = performance_monitor_.get_cpu_estimate();
 
-    // Select quality based on CPU usage
-    if (cpu_usage > cpu_threshold_) {
-        // High CPU usage - use lower quality
+    if (usage > cpu_threshold_) {
+        // Deadline at risk - step down straight away
         if (current_quality_ > min_quality_) {
             return static_cast<ResampleQuality>(static_cast<int>(current_quality_) - 1);
         }
-    } else if (cpu_usage < cpu_threshold_ / 2) {
-        // Low CPU usage - can use higher quality
+    } else if (calm_callbacks_ >= UPGRADE_HOLD_CALLBACKS) {
+        // Sustained headroom - step up
         if (current_quality_ < max_quality_) {
             return static_cast<ResampleQuality>(static_cast<int>(current_quality_) + 1);
         }
@@ -76,38 +122,235 @@ bool AdaptiveSampleRateConverter::should_adjust_quality() {
     return suggested_quality != current_quality_;
 }
 
-void AdaptiveSampleRateConverter::create_converter(ResampleQuality quality) {
-    converter_ = EnhancedSampleRateConverterFactory::create(quality);
+void AdaptiveSampleRateConverter::track_headroom() {
+    // Any busy callback restarts the hold, even if the average is low
+    if (performance_monitor_.get_last_usage() < cpu_threshold_ / 2) {
+        calm_callbacks_++;
+    } else {
+        calm_callbacks_ = 0;
+    }
+}
+
+void AdaptiveSampleRateConverter::begin_transition(ResampleQuality quality,
+                                                   QualityTransition::Reason reason) {
+    EnhancedSampleRateConverter* next = converters_[static_cast<int>(quality)].get();
+    if (!next) {
+        return;
+    }
+    next->reset();
+
+    // Input position of the old converter's next frame, relative to the
+    // end of the input so far (negative: it looks ahead)
+    double ratio = static_cast<double>(input_rate_) / output_rate_;
+    double next_position = static_cast<double>(converter_origin_ - stream_frames_) +
+                           static_cast<double>(converter_frames_) * ratio;
+
+    // The new converter's frames land at next_position + prime_frames
+    // plus multiples of ratio; prime with the length of recent input that
+    // puts one of them closest to the old converter's next frame
+    int prime_frames = history_frames_;
+    double best_offset = 1.0;
+    for (int frames = history_frames_; frames >= std::min(history_frames_, PRIME_FRAMES / 2); --frames) {
+        double index = (next_position + frames) / ratio;
+        double offset = std::fabs(index - std::round(index));
+        if (offset < best_offset) {
+            best_offset = offset;
+            prime_frames = frames;
+        }
+    }
+
+    // Fill the new filter's history with that input
+    int primed = 0;
+    if (prime_frames > 0) {
+        primed = next->convert(input_history_.data() + static_cast<size_t>(history_frames_ - prime_frames) * channels_,
+                               prime_frames, pending_buffer_.data(), crossfade_capacity_);
+    }
+
+    // New frame at the old one's next instant: keep the priming output
+    // from there on, or drop new output until it is reached
+    int64_t aligned = std::max<int64_t>(0, std::llround((next_position + prime_frames) / ratio));
+    if (aligned <= primed) {
+        pending_frames_ = primed - static_cast<int>(aligned);
+        discard_frames_ = 0;
+        std::copy(pending_buffer_.begin() + static_cast<size_t>(aligned) * channels_,
+                  pending_buffer_.begin() + static_cast<size_t>(primed) * channels_,
+                  pending_buffer_.begin());
+    } else {
+        pending_frames_ = 0;
+        discard_frames_ = static_cast<int>(aligned - primed);
+    }
+
+    QualityTransition transition;
+    transition.time = std::chrono::steady_clock::now();
+    transition.from = current_quality_;
+    transition.to = quality;
+    transition.reason = reason;
+    transition.deadline_usage = performance_monitor_.get_cpu_estimate();
+    transition.peak_usage = performance_monitor_.get_peak_usage();
+
+    fading_converter_ = converter_;
+    converter_ = next;
+    converter_origin_ = stream_frames_ - prime_frames;
+    converter_frames_ = primed;
+    current_quality_ = quality;
+    crossfade_frames_ = std::max(1, static_cast<int>(crossfade_ms_ * output_rate_ / 1000.0));
+    crossfade_position_ = 0;
+    carried_frames_ = 0;
+
+    // Judge the new quality on its own load
+    performance_monitor_.reset();
+    calm_callbacks_ = 0;
+
+    log_transition(transition);
+}
+
+int AdaptiveSampleRateConverter::convert_crossfade(const float* input, int input_frames,
+                                                   float* output, int max_output_frames) {
+    // Each stream continues after the frames it has ahead of the other
+    size_t channels = static_cast<size_t>(channels_);
+    int fresh = converter_->convert(input, input_frames, pending_buffer_.data() + pending_frames_ * channels,
+                                    std::min(max_output_frames, crossfade_capacity_ - pending_frames_));
+    converter_frames_ += fresh;
+
+    int dropped = std::min(discard_frames_, fresh);
+    std::copy(pending_buffer_.begin() + (pending_frames_ + dropped) * channels,
+              pending_buffer_.begin() + (pending_frames_ + fresh) * channels,
+              pending_buffer_.begin() + pending_frames_ * channels);
+    discard_frames_ -= dropped;
+    int available = pending_frames_ + fresh - dropped;
+
+    int faded = carried_frames_ + fading_converter_->convert(
+        input, input_frames, crossfade_buffer_.data() + carried_frames_ * channels,
+        std::min(max_output_frames, crossfade_capacity_ - carried_frames_));
+
+    // Blend while both streams have frames; new frames past the end of
+    // the old stream wait until the fade is complete
+    int generated = std::min(available, max_output_frames);
+    int blended = std::min(generated, faded);
+    if (crossfade_position_ + blended < crossfade_frames_) {
+        generated = blended;
+    }
+
+    for (int i = 0; i < generated; ++i) {
+        float gain = std::min(1.0f, static_cast<float>(crossfade_position_ + i + 1) / crossfade_frames_);
+        const float* next_frame = pending_buffer_.data() + i * channels;
+        const float* old_frame = i < faded ? crossfade_buffer_.data() + i * channels : next_frame;
+        float* out = output + i * channels;
+        for (size_t ch = 0; ch < channels; ++ch) {
+            out[ch] = old_frame[ch] + gain * (next_frame[ch] - old_frame[ch]);
+        }
+    }
+
+    pending_frames_ = available - generated;
+    std::copy(pending_buffer_.begin() + generated * channels,
+              pending_buffer_.begin() + available * channels,
+              pending_buffer_.begin());
+    carried_frames_ = std::max(0, faded - generated);
+    std::copy(crossfade_buffer_.begin() + (faded - carried_frames_) * channels,
+              crossfade_buffer_.begin() + faded * channels,
+              crossfade_buffer_.begin());
+
+    crossfade_position_ += generated;
+    if (crossfade_position_ >= crossfade_frames_ && pending_frames_ == 0 && discard_frames_ == 0) {
+        fading_converter_ = nullptr;
+        carried_frames_ = 0;
+    }
+
+    return generated;
+}
+
+void AdaptiveSampleRateConverter::remember_input(const float* input, int input_frames) {
+    if (input_frames >= PRIME_FRAMES) {
+        std::copy(input + static_cast<size_t>(input_frames - PRIME_FRAMES) * channels_,
+                  input + static_cast<size_t>(input_frames) * channels_,
+                  input_history_.begin());
+        history_frames_ = PRIME_FRAMES;
+        return;
+    }
+
+    int keep = std::min(history_frames_, PRIME_FRAMES - input_frames);
+    std::copy(input_history_.begin() + static_cast<size_t>(history_frames_ - keep) * channels_,
+              input_history_.begin() + static_cast<size_t>(history_frames_) * channels_,
+              input_history_.begin());
+    std::copy(input, input + static_cast<size_t>(input_frames) * channels_,
+              input_history_.begin() + static_cast<size_t>(keep) * channels_);
+    history_frames_ = keep + input_frames;
+}
+
+void AdaptiveSampleRateConverter::log_transition(const QualityTransition& transition) {
+    const size_t written = log_written_.load(std::memory_order_relaxed);
+    if (written - log_drained_.load(std::memory_order_acquire) < MAX_LOG_ENTRIES) {
+        transition_log_[written % MAX_LOG_ENTRIES] = transition;
+        log_written_.store(written + 1, std::memory_order_release);
+    } else {
+        dropped_transitions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (transition_listener_) {
+        transition_listener_(transition);
+    }
 }
 
 int AdaptiveSampleRateConverter::convert(const float* input, int input_frames,
                                           float* output, int max_output_frames) {
-    if (!input || !output || input_frames <= 0 || max_output_frames <= 0) {
+    if (!input || !output || input_frames <= 0 || max_output_frames <= 0 || !converter_) {
         return 0;
     }
 
-    // Check if we need to adjust quality
-    if (should_adjust_quality()) {
-        ResampleQuality new_quality = select_quality();
-        create_converter(new_quality);
-        if (converter_) {
-            converter_->initialize(input_rate_, output_rate_, channels_);
-            current_quality_ = new_quality;
+    // Only decide between fades so a switch always completes; a range
+    // change made during a fade takes effect here
+    if (!fading_converter_) {
+        ResampleQuality clamped = std::min(std::max(current_quality_, min_quality_), max_quality_);
+        if (clamped != current_quality_) {
+            begin_transition(clamped, QualityTransition::Reason::Range);
+        } else if (should_adjust_quality()) {
+            ResampleQuality new_quality = select_quality();
+            begin_transition(new_quality, new_quality < current_quality_ ?
+                             QualityTransition::Reason::Overload : QualityTransition::Reason::Headroom);
         }
     }
 
     // Start performance monitoring
     performance_monitor_.start_timing();
 
-    // Perform conversion
-    int result = converter_->convert(input, input_frames, output, max_output_frames);
+    // Perform conversion; a fade runs in bounded steps so it stays within
+    // its buffers, and the new converter takes over alone once it ends
+    int result = 0;
+    int offset = 0;
+    while (offset < input_frames) {
+        const float* block = input + static_cast<size_t>(offset) * channels_;
+        float* out = output + static_cast<size_t>(result) * channels_;
+        if (fading_converter_) {
+            int frames = std::min(CROSSFADE_BLOCK_FRAMES, input_frames - offset);
+            result += convert_crossfade(block, frames, out, max_output_frames - result);
+            offset += frames;
+        } else {
+            int generated = converter_->convert(block, input_frames - offset, out, max_output_frames - result);
+            converter_frames_ += generated;
+            result += generated;
+            offset = input_frames;
+        }
+    }
+
+    // Without host reports, our own work against the buffer's playback time
+    if (!external_load_) {
+        performance_monitor_.end_timing(result, output_rate_);
+        track_headroom();
+    }
 
-    // End performance monitoring
-    performance_monitor_.end_timing(result);
+    remember_input(input, input_frames);
+    stream_frames_ += input_frames;
+    total_conversions_++;
 
     return result;
 }
 
+void AdaptiveSampleRateConverter::report_callback(double elapsed_seconds, double deadline_seconds) {
+    external_load_ = true;
+    performance_monitor_.add_sample(elapsed_seconds, deadline_seconds);
+    track_headroom();
+}
+
 int AdaptiveSampleRateConverter::get_latency() const {
     if (!converter_) {
         return 0;
@@ -119,7 +362,16 @@ void AdaptiveSampleRateConverter::reset() {
     if (converter_) {
         converter_->reset();
     }
-    performance_monitor_ = ResamplerPerformanceMonitor();
+    fading_converter_ = nullptr;
+    history_frames_ = 0;
+    stream_frames_ = 0;
+    converter_origin_ = 0;
+    converter_frames_ = 0;
+    pending_frames_ = 0;
+    discard_frames_ = 0;
+    carried_frames_ = 0;
+    performance_monitor_.reset();
+    calm_callbacks_ = 0;
 }
 
 void AdaptiveSampleRateConverter::set_quality_range(
@@ -128,20 +380,49 @@ void AdaptiveSampleRateConverter::set_quality_range(
     max_quality_ = max_quality;
 
     // Ensure current quality is within range
-    if (current_quality_ < min_quality_) {
-        current_quality_ = min_quality;
-    } else if (current_quality_ > max_quality_) {
-        current_quality_ = max_quality;
+    ResampleQuality clamped = std::min(std::max(current_quality_, min_quality_), max_quality_);
+    if (clamped == current_quality_) {
+        return;
+    }
+
+    if (fading_converter_) {
+        // convert() switches once the current fade completes
+        return;
+    }
+    if (converter_) {
+        begin_transition(clamped, QualityTransition::Reason::Range);
+    } else {
+        current_quality_ = clamped;
+    }
+}
+
+std::vector<QualityTransition> AdaptiveSampleRateConverter::drain_transition_log() {
+    const size_t drained = log_drained_.load(std::memory_order_relaxed);
+    const size_t written = log_written_.load(std::memory_order_acquire);
+
+    std::vector<QualityTransition> transitions;
+    transitions.reserve(written - drained);
+    for (size_t i = drained; i < written; ++i) {
+        transitions.push_back(transition_log_[i % MAX_LOG_ENTRIES]);
     }
+
+    // Hand the slots back to the converting thread
+    log_drained_.store(written, std::memory_order_release);
+    return transitions;
+}
+
+void AdaptiveSampleRateConverter::set_transition_listener(TransitionListener listener) {
+    transition_listener_ = std::move(listener);
 }
 
 AdaptiveSampleRateConverter::PerformanceStats
 AdaptiveSampleRateConverter::get_performance_stats() const {
     PerformanceStats stats;
     stats.current_cpu_usage = performance_monitor_.get_cpu_estimate();
+    stats.peak_cpu_usage = performance_monitor_.get_peak_usage();
     stats.current_quality = current_quality_;
-    stats.total_conversions = 0;  // Could add counter if needed
-    stats.average_realtime_factor = 0.0;  // Could calculate if needed
+    stats.total_conversions = total_conversions_;
+    stats.average_realtime_factor = stats.current_cpu_usage > 0.0 ? 100.0 / stats.current_cpu_usage : 0.0;
 
     return stats;
 }
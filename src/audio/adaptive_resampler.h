@@ -7,93 +7,216 @@
 #pragma once
 
 #include "enhanced_sample_rate_converter.h"
-#include <memory>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace audio {
 
 /**
- * @brief Performance monitoring for resampler
+ * @brief Tracks how much of each audio callback's deadline is consumed
+ *
+ * Each sample is the time spent against the time available: a callback
+ * producing 512 frames at 48 kHz has a 10.7 ms deadline, and 8 ms of work
+ * is 75% usage. Usage is smoothed so single slow callbacks do not flip
+ * the quality, while the peak is kept for auditing.
  */
 class ResamplerPerformanceMonitor {
 private:
-    std::chrono::high_resolution_clock::time_point start_time_;
-    double total_conversion_time_;
-    int total_frames_;
-    int update_interval_;
-    double last_cpu_estimate_;
+    std::chrono::steady_clock::time_point start_time_;
+    double average_usage_;      // Smoothed fraction of the deadline used
+    double peak_usage_;         // Highest single-callback usage since reset
+    double last_usage_;         // Most recent callback
+    int sample_count_;
+
+    static constexpr double SMOOTHING = 0.2;   // Weight of the newest callback
 
 public:
     ResamplerPerformanceMonitor()
-        : total_conversion_time_(0.0)
-        , total_frames_(0)
-        , update_interval_(1000)  // Update every 1000 frames
-        , last_cpu_estimate_(0.0) {
-        start_time_ = std::chrono::high_resolution_clock::now();
+        : start_time_(std::chrono::steady_clock::now())
+        , average_usage_(0.0)
+        , peak_usage_(0.0)
+        , last_usage_(0.0)
+        , sample_count_(0) {
     }
 
     /**
      * Start timing conversion
      */
     void start_timing() {
-        start_time_ = std::chrono::high_resolution_clock::now();
+        start_time_ = std::chrono::steady_clock::now();
     }
 
     /**
-     * End timing conversion and update metrics
+     * End timing conversion; the deadline is the playback time of the output
+     * @param frames Output frames produced
+     * @param output_rate Output sample rate
      */
-    void end_timing(int frames) {
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
-            end - start_time_);
-        total_conversion_time_ += duration.count() / 1000.0;  // Convert to ms
-        total_frames_ += frames;
+    void end_timing(int frames, int output_rate) {
+        if (frames <= 0 || output_rate <= 0) {
+            return;
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+        add_sample(elapsed, static_cast<double>(frames) / output_rate);
+    }
 
-        // Update CPU estimate every interval frames
-        if (total_frames_ >= update_interval_) {
-            update_cpu_estimate();
-            total_frames_ = 0;
-            total_conversion_time_ = 0.0;
+    /**
+     * Record one callback
+     * @param elapsed_seconds Time spent in the callback
+     * @param deadline_seconds Time available before the device needs the data
+     */
+    void add_sample(double elapsed_seconds, double deadline_seconds) {
+        if (deadline_seconds <= 0.0) {
+            return;
         }
+        double usage = elapsed_seconds / deadline_seconds;
+        average_usage_ = sample_count_ == 0 ? usage : average_usage_ + SMOOTHING * (usage - average_usage_);
+        peak_usage_ = std::max(peak_usage_, usage);
+        last_usage_ = usage;
+        sample_count_++;
     }
 
     /**
-     * Get current CPU usage estimate (percentage)
+     * Get smoothed deadline usage (percentage of the callback deadline)
      */
     double get_cpu_estimate() const {
-        return last_cpu_estimate_;
+        return average_usage_ * 100.0;
     }
 
-private:
-    void update_cpu_estimate() {
-        if (total_conversion_time_ > 0) {
-            // Estimate based on conversion time vs real time
-            last_cpu_estimate_ = std::min(100.0, total_conversion_time_ / 10.0);
-        }
+    /**
+     * Get highest single-callback deadline usage (percentage)
+     */
+    double get_peak_usage() const {
+        return peak_usage_ * 100.0;
+    }
+
+    /**
+     * Get deadline usage of the most recent callback (percentage)
+     */
+    double get_last_usage() const {
+        return last_usage_ * 100.0;
+    }
+
+    /**
+     * Number of callbacks recorded since the last reset
+     */
+    int get_sample_count() const {
+        return sample_count_;
     }
+
+    /**
+     * Forget history, e.g. after the converter changed
+     */
+    void reset() {
+        average_usage_ = 0.0;
+        peak_usage_ = 0.0;
+        last_usage_ = 0.0;
+        sample_count_ = 0;
+    }
+};
+
+/**
+ * @brief Record of one quality change
+ */
+struct QualityTransition {
+    enum class Reason {
+        Overload,   // Deadline usage above the threshold
+        Headroom,   // Deadline usage well below the threshold
+        Range       // Quality range changed by the application
+    };
+
+    std::chrono::steady_clock::time_point time;
+    ResampleQuality from;
+    ResampleQuality to;
+    Reason reason;
+    double deadline_usage;      // Smoothed usage when deciding (%)
+    double peak_usage;          // Peak usage since the previous change (%)
 };
 
 /**
  * @brief Adaptive sample rate converter that adjusts quality based on performance
  *
- * This class automatically selects the best quality level based on:
- * - System performance (CPU usage)
- * - Audio parameters (sample rates, channels)
- * - User preferences
+ * The load signal is the share of each audio callback's deadline that was
+ * used. The host can report whole-callback timing with report_callback();
+ * otherwise the converter times its own work against the playback time of
+ * the frames it produced.
+ *
+ * Quality drops one step when usage exceeds the threshold and rises one
+ * step after usage stays below half of it for UPGRADE_HOLD_CALLBACKS
+ * callbacks. A change never resets the audio: the new converter is primed
+ * with recent input, then both run for a short crossfade before the old
+ * one is released. Every change is recorded in a transition log.
+ *
+ * Nothing on the converting thread allocates, designs a filter or takes a
+ * lock: one converter per quality is built in initialize(), a change only
+ * resets and primes the one it switches to, the crossfade buffers are
+ * sized once, and transitions are published through a fixed-size
+ * lock-free log that another thread drains with drain_transition_log().
+ *
+ * The converters look ahead by different amounts, so after priming the
+ * new one's next frame is not the old one's. Every converter puts its
+ * output frame n at input position n * ratio from where it started; the
+ * priming length is chosen so the two output grids fall closest, and new
+ * frames are dropped or held back until frame i of both streams is the
+ * same instant. The signal keeps its timing to a fraction of a frame
+ * across a switch; only the I/O latency follows the new converter.
  */
 class AdaptiveSampleRateConverter : public ISampleRateConverter {
+public:
+    static constexpr int MIN_DECISION_CALLBACKS = 8;    // Samples needed after a change
+    static constexpr int UPGRADE_HOLD_CALLBACKS = 50;   // Calm callbacks before stepping up
+    static constexpr int PRIME_FRAMES = 128;            // Input history fed to a new converter
+    static constexpr int CROSSFADE_BLOCK_FRAMES = 1024; // Input frames per crossfade step
+    static constexpr int QUALITY_LEVELS = 4;            // Fast, Good, High, Best
+    static constexpr size_t MAX_LOG_ENTRIES = 64;       // Undrained transitions the log holds
+
+    typedef std::function<void(const QualityTransition&)> TransitionListener;
+
 private:
-    std::unique_ptr<EnhancedSampleRateConverter> converter_;
+    std::unique_ptr<EnhancedSampleRateConverter> converters_[QUALITY_LEVELS];   // Built by initialize()
+    EnhancedSampleRateConverter* converter_;          // Current quality
+    EnhancedSampleRateConverter* fading_converter_;   // Previous quality during a crossfade
     ResamplerPerformanceMonitor performance_monitor_;
     ResampleQuality current_quality_;
-    ResampleQuality max_quality_;
     ResampleQuality min_quality_;
+    ResampleQuality max_quality_;
     bool auto_adjust_;
     double cpu_threshold_;
     int input_rate_;
     int output_rate_;
     int channels_;
 
+    bool external_load_;            // Load comes from report_callback()
+    int calm_callbacks_;            // Consecutive callbacks below half the threshold
+    int total_conversions_;
+    double crossfade_ms_;
+    int crossfade_frames_;
+    int crossfade_position_;
+    int carried_frames_;                    // Old output frames not yet mixed
+    int pending_frames_;                    // New output frames held back to line up with the old
+    int discard_frames_;                    // New output frames still to drop for the same reason
+    int crossfade_capacity_;                // Frames each crossfade buffer holds
+    std::vector<float> crossfade_buffer_;   // Old converter output during a crossfade
+    std::vector<float> pending_buffer_;     // New converter output during a crossfade
+    std::vector<float> input_history_;      // Last PRIME_FRAMES input frames
+    int history_frames_;
+
+    int64_t stream_frames_;                 // Input frames since initialize() or reset()
+    int64_t converter_origin_;              // Stream frame converter_ started from
+    int64_t converter_frames_;              // Output frames converter_ has produced
+
+    // Single-producer, single-consumer ring: the converting thread writes,
+    // drain_transition_log() reads
+    QualityTransition transition_log_[MAX_LOG_ENTRIES];
+    std::atomic<size_t> log_written_;
+    std::atomic<size_t> log_drained_;
+    std::atomic<size_t> dropped_transitions_;   // Changes that found the log full
+    TransitionListener transition_listener_;
+
     /**
      * Select quality based on current conditions
      */
@@ -105,9 +228,30 @@ private:
     bool should_adjust_quality();
 
     /**
-     * Create converter with specified quality
+     * Count consecutive calm callbacks after each load sample
+     */
+    void track_headroom();
+
+    /**
+     * Switch to a new quality, crossfading from the current converter
+     */
+    void begin_transition(ResampleQuality quality, QualityTransition::Reason reason);
+
+    /**
+     * Run both converters and blend from the old to the new one
+     */
+    int convert_crossfade(const float* input, int input_frames,
+                          float* output, int max_output_frames);
+
+    /**
+     * Keep the tail of the input for priming the next converter
      */
-    void create_converter(ResampleQuality quality);
+    void remember_input(const float* input, int input_frames);
+
+    /**
+     * Publish to the transition log and notify the listener
+     */
+    void log_transition(const QualityTransition& transition);
 
 public:
     /**
@@ -115,7 +259,7 @@ public:
      * @param min_quality Minimum quality to use
      * @param max_quality Maximum quality to use
      * @param auto_adjust Enable automatic quality adjustment
-     * @param cpu_threshold CPU usage threshold for quality adjustment (%)
+     * @param cpu_threshold Callback deadline usage that triggers a quality drop (%)
      */
     AdaptiveSampleRateConverter(
         ResampleQuality min_quality = ResampleQuality::Fast,
@@ -134,7 +278,7 @@ public:
     }
 
     /**
-     * Set quality range
+     * Set quality range; crossfades to the nearest allowed quality if needed
      */
     void set_quality_range(ResampleQuality min_quality, ResampleQuality max_quality);
 
@@ -144,23 +288,63 @@ public:
     void set_auto_adjust(bool enable) { auto_adjust_ = enable; }
 
     /**
-     * Set CPU usage threshold for quality adjustment
+     * Set deadline usage threshold for quality adjustment (%)
      */
     void set_cpu_threshold(double threshold) { cpu_threshold_ = threshold; }
 
+    /**
+     * Set crossfade length used when the quality changes
+     */
+    void set_crossfade_ms(double ms) { crossfade_ms_ = ms; }
+
+    /**
+     * Report the timing of a whole audio callback. Once called, this
+     * replaces the converter's own timing as the load signal.
+     * @param elapsed_seconds Time spent in the callback
+     * @param deadline_seconds Buffer duration the callback had to fill
+     */
+    void report_callback(double elapsed_seconds, double deadline_seconds);
+
     /**
      * Get current quality level
      */
     ResampleQuality get_current_quality() const { return current_quality_; }
 
+    /**
+     * True while the previous quality is still being faded out
+     */
+    bool is_crossfading() const { return fading_converter_ != nullptr; }
+
+    /**
+     * Take the quality changes published since the last call, oldest
+     * first. Safe to call from one other thread (e.g. the UI) while
+     * converting; changes made while the log holds MAX_LOG_ENTRIES
+     * undrained ones are counted by get_dropped_transitions() instead.
+     */
+    std::vector<QualityTransition> drain_transition_log();
+
+    /**
+     * Number of quality changes the log had no room for
+     */
+    size_t get_dropped_transitions() const {
+        return dropped_transitions_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Called on the converting thread for every quality change; must not
+     * block. Set before conversion starts.
+     */
+    void set_transition_listener(TransitionListener listener);
+
     /**
      * Get performance statistics
      */
     struct PerformanceStats {
-        double current_cpu_usage;
+        double current_cpu_usage;       // Smoothed deadline usage (%)
+        double peak_cpu_usage;          // Peak deadline usage since the last change (%)
         ResampleQuality current_quality;
         int total_conversions;
-        double average_realtime_factor;
+        double average_realtime_factor; // Playback time per unit of processing time
     };
 
     PerformanceStats get_performance_stats() const;
@@ -185,6 +369,7 @@ public:
 
     /**
      * Create adaptive converter with custom settings
+     * @param cpu_threshold Callback deadline usage that triggers a quality drop (%)
      */
     static std::unique_ptr<AdaptiveSampleRateConverter> create_with_settings(
         ResampleQuality min_quality,
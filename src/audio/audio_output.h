@@ -120,6 +120,15 @@ public:
      */
     virtual int get_buffer_size() const = 0;
 
+    /**
+     * @brief Get frames written but not yet played
+     *
+     * Used to lock a stream to the device clock. Backends that can ask
+     * the device override this.
+     * @return Queued frames, or -1 if the backend cannot tell
+     */
+    virtual int get_queued_frames() const { return -1; }
+
     /**
      * @brief Check if device is ready
      * @return true if ready
@@ -206,6 +206,16 @@ public:
         return buffer_size_;
     }
 
+    int get_queued_frames() const override {
+        if (!is_open_) return -1;
+
+        snd_pcm_sframes_t delay = 0;
+        if (snd_pcm_delay(pcm_, &delay) < 0) {
+            return -1;
+        }
+        return static_cast<int>(delay);
+    }
+
     bool is_ready() const override {
         return is_open_ && pcm_;
     }
@@ -125,6 +125,17 @@ public:
         return buffer_size_;
     }
 
+    int get_queued_frames() const override {
+        if (!is_open_) return -1;
+
+        int error;
+        pa_usec_t latency = pa_simple_get_latency(pa_, &error);
+        if (latency == static_cast<pa_usec_t>(-1)) {
+            return -1;
+        }
+        return static_cast<int>(latency * format_.sample_rate / 1000000);
+    }
+
     bool is_ready() const override {
         return is_open_ && pa_;
     }
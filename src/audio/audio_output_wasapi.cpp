@@ -259,6 +259,16 @@ public:
         return buffer_size_;
     }
 
+    int get_queued_frames() const override {
+        if (!is_open_ || !client_) return -1;
+
+        UINT32 padding = 0;
+        if (FAILED(client_->GetCurrentPadding(&padding))) {
+            return -1;
+        }
+        return static_cast<int>(padding);
+    }
+
     bool is_ready() const override {
         return is_open_ && client_ && render_client_;
     }
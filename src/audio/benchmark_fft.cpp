@@ -0,0 +1,144 @@
+/**
+ * @file benchmark_fft.cpp
+ * @brief Time per transform of the real FFT kernels against the complex
+ *        radix-2 FFT the visualization engine used before, for 512 to
+ *        65536 points
+ * @date 2026-10-17
+ */
+
+#include "fft.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+using namespace audio;
+
+namespace {
+
+const float PI = 3.14159265358979323846f;
+
+// Keeps the results observable so the calls are not optimized away
+volatile float g_sink = 0.0f;
+
+// Deterministic broadband input
+std::vector<float> make_input(size_t size) {
+    std::vector<float> input(size);
+    uint32_t state = 12345u;
+    for (float& sample : input) {
+        state = state * 1664525u + 1013904223u;
+        sample = static_cast<float>(static_cast<int32_t>(state)) * (0.5f / 2147483648.0f);
+    }
+    return input;
+}
+
+// The previous VisualizationEngine::compute_fft: complex Cooley-Tukey on
+// real input, twiddles recomputed on every call
+void textbook_fft(const std::vector<float>& input, std::vector<std::complex<float>>& output) {
+    size_t N = input.size();
+    output.resize(N);
+
+    for (size_t i = 0; i < N; ++i) {
+        output[i] = std::complex<float>(input[i], 0.0f);
+    }
+
+    for (size_t i = 0; i < N; ++i) {
+        size_t j = 0;
+        size_t k = i;
+        size_t m = N / 2;
+        while (m >= 1) {
+            j = (j << 1) | (k & 1);
+            k >>= 1;
+            m >>= 1;
+        }
+        if (j > i) {
+            std::swap(output[i], output[j]);
+        }
+    }
+
+    for (size_t s = 1; s <= std::log2(N); ++s) {
+        size_t m = static_cast<size_t>(1) << s;
+        size_t m2 = m >> 1;
+        std::complex<float> w(1.0f, 0.0f);
+        std::complex<float> wm = std::exp(std::complex<float>(0.0f, -2.0f * PI / m));
+        for (size_t j = 0; j < m2; ++j) {
+            for (size_t k = j; k < N; k += m) {
+                std::complex<float> t = w * output[k + m2];
+                std::complex<float> u = output[k];
+                output[k] = u + t;
+                output[k + m2] = u - t;
+            }
+            w *= wm;
+        }
+    }
+}
+
+// Repeat a transform for about a quarter of a second; microseconds per call
+template <typename Transform>
+double time_transform(Transform transform, size_t size) {
+    const int calls = std::max(8, static_cast<int>((size_t(1) << 24) / size));
+    transform();   // Warm up caches and tables
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) {
+        transform();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return elapsed * 1e6 / calls;
+}
+
+void benchmark_sizes() {
+    std::cout << "\nReal FFT, microseconds per transform (dispatch selects "
+              << get_fft_kernels().name << ")\n" << std::string(72, '-') << "\n";
+    std::cout << std::setw(8) << "Size" << std::setw(12) << "textbook";
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2,
+                                 SimdLevel::AVX512, SimdLevel::NEON };
+    std::vector<const FFTKernels*> kernels;
+    for (SimdLevel level : levels) {
+        if (const FFTKernels* k = get_fft_kernels(level)) {
+            kernels.push_back(k);
+            std::cout << std::setw(12) << k->name;
+        }
+    }
+    std::cout << std::setw(10) << "Speedup" << "\n";
+
+    for (size_t size = 512; size <= 65536; size *= 2) {
+        std::vector<float> input = make_input(size);
+
+        std::vector<std::complex<float>> complex_output;
+        double textbook_us = time_transform([&] {
+            textbook_fft(input, complex_output);
+            g_sink = complex_output[1].real();
+        }, size);
+        std::cout << std::setw(8) << size << std::setw(12) << std::fixed << std::setprecision(2) << textbook_us;
+
+        double best_us = textbook_us;
+        for (const FFTKernels* k : kernels) {
+            RealFFT fft(size);
+            fft.set_kernels(*k);
+            std::vector<float> real(fft.bins()), imag(fft.bins());
+            double us = time_transform([&] {
+                fft.forward(input.data(), real.data(), imag.data());
+                g_sink = real[1];
+            }, size);
+            best_us = std::min(best_us, us);
+            std::cout << std::setw(12) << us;
+        }
+        std::cout << std::setw(9) << std::setprecision(1) << textbook_us / best_us << "x\n";
+    }
+}
+
+} // namespace
+
+int main() {
+    std::cout << "FFT benchmark: real-input radix-4 kernels with cached tables against\n"
+              << "the complex radix-2 transform with per-call twiddles\n";
+
+    benchmark_sizes();
+
+    return 0;
+}
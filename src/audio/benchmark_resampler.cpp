@@ -0,0 +1,462 @@
+/**
+ * @file benchmark_resampler.cpp
+ * @brief Throughput of the sinc converters (direct versus polyphase table),
+ *        the rational converter, cascaded large-ratio conversion, each FIR
+ *        kernel the CPU supports, fixed-shape against generic kernels,
+ *        32-bit, mixed and 64-bit precision, shared filter table setup and
+ *        drift-compensated conversion
+ * @date 2025-12-10
+ */
+
+#include "sinc_resampler.h"
+#include "sample_rate_converter_64.h"
+#include "drift_compensating_resampler.h"
+#include "rational_resampler.h"
+#include "cascaded_resampler.h"
+#include "enhanced_sample_rate_converter.h"
+#include "filter_coefficient_cache.h"
+#include "fir_kernels.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+using namespace audio;
+
+namespace {
+
+const int CHANNELS = 2;
+const int BLOCK_FRAMES = 1024;
+const double SECONDS = 10.0;
+
+// Keeps the kernel results observable so the calls are not optimized away
+volatile float g_sink = 0.0f;
+
+struct BenchmarkResult {
+    double frames_per_second;   // Output frames per wall-clock second
+    std::vector<float> output;
+};
+
+// Deterministic broadband input
+std::vector<float> make_input(int frames) {
+    std::vector<float> input(static_cast<size_t>(frames) * CHANNELS);
+    uint32_t state = 12345u;
+    for (float& sample : input) {
+        state = state * 1664525u + 1013904223u;
+        sample = static_cast<float>(static_cast<int32_t>(state)) * (0.5f / 2147483648.0f);
+    }
+    return input;
+}
+
+// Stream the input through a converter block by block
+BenchmarkResult run(ISampleRateConverter& converter, const std::vector<float>& input,
+                    int input_rate, int output_rate) {
+    converter.initialize(input_rate, output_rate, CHANNELS);
+
+    const int input_frames = static_cast<int>(input.size() / CHANNELS);
+    const int max_block_output = static_cast<int>(
+        static_cast<int64_t>(BLOCK_FRAMES) * output_rate / input_rate) + 16;
+
+    BenchmarkResult result;
+    result.output.resize((static_cast<size_t>(input_frames) * output_rate / input_rate + 64) * CHANNELS);
+
+    size_t written = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int offset = 0; offset < input_frames; offset += BLOCK_FRAMES) {
+        int frames = std::min(BLOCK_FRAMES, input_frames - offset);
+        int space = static_cast<int>(result.output.size() / CHANNELS - written);
+        int generated = converter.convert(input.data() + static_cast<size_t>(offset) * CHANNELS, frames,
+                                          result.output.data() + written * CHANNELS,
+                                          std::min(max_block_output, space));
+        written += generated;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.output.resize(written * CHANNELS);
+    result.frames_per_second = elapsed > 0.0 ? written / elapsed : 0.0;
+    return result;
+}
+
+void benchmark(int input_rate, int output_rate) {
+    std::cout << "\n" << input_rate << " Hz -> " << output_rate << " Hz, "
+              << CHANNELS << " channels, " << std::fixed << std::setprecision(0) << SECONDS << " s\n"
+              << std::string(60, '-') << "\n";
+    std::cout << std::setw(6) << "Taps" << std::setw(16) << "Direct (fr/s)"
+              << std::setw(18) << "Polyphase (fr/s)" << std::setw(10) << "Speedup"
+              << std::setw(12) << "Max diff" << std::setw(17) << "Rational (fr/s)" << "\n";
+
+    std::vector<float> input = make_input(static_cast<int>(SECONDS * input_rate));
+
+    const int tap_counts[] = { 8, 16 };
+    for (int taps : tap_counts) {
+        SincSampleRateConverter direct_converter(taps, false);
+        SincSampleRateConverter polyphase_converter(taps, true);
+        RationalSampleRateConverter rational_converter(taps);
+        BenchmarkResult direct = run(direct_converter, input, input_rate, output_rate);
+        BenchmarkResult polyphase = run(polyphase_converter, input, input_rate, output_rate);
+        BenchmarkResult rational = run(rational_converter, input, input_rate, output_rate);
+
+        float max_diff = 0.0f;
+        size_t samples = std::min(direct.output.size(), polyphase.output.size());
+        for (size_t i = 0; i < samples; ++i) {
+            max_diff = std::max(max_diff, std::abs(direct.output[i] - polyphase.output[i]));
+        }
+
+        std::cout << std::setw(6) << taps
+                  << std::setw(16) << std::fixed << std::setprecision(0) << direct.frames_per_second
+                  << std::setw(18) << polyphase.frames_per_second
+                  << std::setw(9) << std::setprecision(1)
+                  << polyphase.frames_per_second / direct.frames_per_second << "x"
+                  << std::setw(12) << std::scientific << std::setprecision(1) << max_diff
+                  << std::setw(17) << std::fixed << std::setprecision(0) << rational.frames_per_second
+                  << "\n";
+    }
+}
+
+// Level of a tone above the output Nyquist frequency after conversion, in dB
+double alias_level_db(ISampleRateConverter& converter, int input_rate, int output_rate) {
+    const double frequency = output_rate * 0.68;   // Aliases to 0.32 of the output rate
+    std::vector<float> input(static_cast<size_t>(input_rate / 4) * CHANNELS);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * frequency * (i / CHANNELS) / input_rate));
+    }
+
+    BenchmarkResult result = run(converter, input, input_rate, output_rate);
+
+    // Skip the filter start-up
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t i = static_cast<size_t>(converter.get_latency() + 256) * CHANNELS;
+         i < result.output.size(); i += CHANNELS) {
+        sum += static_cast<double>(result.output[i]) * result.output[i];
+        count++;
+    }
+    double rms = count > 0 ? std::sqrt(sum / count) : 0.0;
+    return 20.0 * std::log10(std::max(rms, 1e-12) / (0.5 / std::sqrt(2.0)));
+}
+
+// Single-stage conversion at the input rate versus the half-band cascade
+void benchmark_cascade(int input_rate, int output_rate) {
+    std::vector<float> input = make_input(static_cast<int>(2.0 * input_rate));
+    std::cout << "\n" << input_rate << " Hz -> " << output_rate << " Hz, "
+              << CHANNELS << " channels, 2 s\n" << std::string(60, '-') << "\n";
+    std::cout << std::setw(8) << "Quality" << std::setw(16) << "Single (fr/s)"
+              << std::setw(12) << "Alias (dB)" << std::setw(17) << "Cascaded (fr/s)"
+              << std::setw(12) << "Alias (dB)" << "  Plan\n";
+
+    const ResampleQuality qualities[] = { ResampleQuality::Good, ResampleQuality::High,
+                                          ResampleQuality::Best };
+    for (ResampleQuality quality : qualities) {
+        EnhancedSampleRateConverter single(quality);
+        CascadedSampleRateConverter cascaded(quality);
+        BenchmarkResult single_result = run(single, input, input_rate, output_rate);
+        BenchmarkResult cascaded_result = run(cascaded, input, input_rate, output_rate);
+        double single_alias = alias_level_db(single, input_rate, output_rate);
+        double cascaded_alias = alias_level_db(cascaded, input_rate, output_rate);
+
+        std::cout << std::setw(8) << EnhancedSampleRateConverter::get_quality_name(quality)
+                  << std::setw(16) << std::fixed << std::setprecision(0) << single_result.frames_per_second
+                  << std::setw(12) << std::setprecision(1) << single_alias
+                  << std::setw(17) << std::setprecision(0) << cascaded_result.frames_per_second
+                  << std::setw(12) << std::setprecision(1) << cascaded_alias << "  "
+                  << CascadedSampleRateConverter::describe(cascaded.get_stages()) << "\n";
+    }
+}
+
+// One output frame per kernel call, as the converters use it
+void benchmark_kernels() {
+    std::cout << "\nFIR kernels, " << CHANNELS << " channels (dispatch selects "
+              << get_fir_kernels().name << ")\n" << std::string(60, '-') << "\n";
+    std::cout << std::setw(10) << "Kernel" << std::setw(6) << "Taps"
+              << std::setw(18) << "Calls/s" << std::setw(10) << "Speedup" << "\n";
+
+    const int calls = 2000000;
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2,
+                                 SimdLevel::AVX512, SimdLevel::NEON };
+    const int tap_counts[] = { 16, 32, 64 };
+
+    for (int taps : tap_counts) {
+        std::vector<float> input = make_input(taps + 64);
+        std::vector<float> coefficients(input.begin(), input.begin() + taps);
+        double scalar_rate = 0.0;
+
+        for (SimdLevel level : levels) {
+            const FirKernels* kernels = get_fir_kernels(level);
+            if (!kernels) {
+                continue;
+            }
+
+            float output[CHANNELS] = {};
+            float sink = 0.0f;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < calls; ++i) {
+                // Slide the window so every call reads different frames
+                kernels->fir_float(input.data() + (i % 64) * CHANNELS, coefficients.data(),
+                                   taps, CHANNELS, output);
+                sink += output[0];
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double rate = elapsed > 0.0 ? calls / elapsed : 0.0;
+            if (level == SimdLevel::Scalar) {
+                scalar_rate = rate;
+            }
+
+            std::cout << std::setw(10) << kernels->name << std::setw(6) << taps
+                      << std::setw(18) << std::fixed << std::setprecision(0) << rate
+                      << std::setw(9) << std::setprecision(1) << rate / scalar_rate << "x\n";
+            g_sink = sink;
+        }
+    }
+}
+
+// Compile-time channel and tap counts against the runtime-shaped kernel
+void benchmark_fixed_shapes() {
+    const FirKernels& kernels = get_fir_kernels();
+    std::cout << "\nFixed-shape FIR kernels (" << kernels.name << ")\n" << std::string(60, '-') << "\n";
+    std::cout << std::setw(10) << "Channels" << std::setw(6) << "Taps" << std::setw(16) << "Generic/s"
+              << std::setw(16) << "Fixed/s" << std::setw(10) << "Speedup" << "\n";
+
+    const int calls = 2000000;
+    const int channel_counts[] = { 1, 2, 6, 8 };
+    const int tap_counts[] = { 8, 9, 16, 17, 32, 33, 64, 65 };
+
+    for (int channels : channel_counts) {
+        for (int taps : tap_counts) {
+            // make_input() is interleaved for CHANNELS; only the sample count matters here
+            std::vector<float> input = make_input((taps + 64) * channels);
+            std::vector<float> coefficients(input.begin(), input.begin() + taps);
+            FirKernelFloat fixed_kernel = get_fir_kernel_float(kernels, taps, channels);
+            const FirKernelFloat candidates[] = { kernels.fir_float, fixed_kernel };
+            double rates[2] = {};
+
+            for (int k = 0; k < 2; ++k) {
+                float output[8] = {};
+                float sink = 0.0f;
+                auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < calls; ++i) {
+                    candidates[k](input.data() + (i % 64) * channels, coefficients.data(),
+                                  taps, channels, output);
+                    sink += output[0];
+                }
+                double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                rates[k] = elapsed > 0.0 ? calls / elapsed : 0.0;
+                g_sink = sink;
+            }
+
+            std::cout << std::setw(10) << channels << std::setw(6) << taps
+                      << std::setw(16) << std::fixed << std::setprecision(0) << rates[0]
+                      << std::setw(16) << rates[1]
+                      << std::setw(9) << std::setprecision(2) << rates[1] / rates[0] << "x\n";
+        }
+    }
+}
+
+// Float, float with double accumulation, and double: rounding error of
+// one dot product and the cost of each converter
+void benchmark_precision() {
+    const FirKernels& kernels = get_fir_kernels();
+    std::cout << "\nPrecision modes, " << CHANNELS << " channels (" << kernels.name << ")\n"
+              << std::string(60, '-') << "\n";
+    std::cout << std::setw(8) << "Mode" << std::setw(6) << "Taps" << std::setw(16) << "Calls/s"
+              << std::setw(16) << "Error (dB)" << "\n";
+
+    const int calls = 2000000;
+    const int tap_counts[] = { 17, 33, 65 };
+
+    for (int taps : tap_counts) {
+        std::vector<float> input = make_input(taps + 64);
+        std::vector<float> coefficients(input.begin() + 64 * CHANNELS, input.begin() + 64 * CHANNELS + taps);
+        std::vector<double> wide_input(input.begin(), input.end());
+        std::vector<double> wide_coefficients(coefficients.begin(), coefficients.end());
+
+        for (int mode = 0; mode < 3; ++mode) {
+            double sink = 0.0;
+            double error = 0.0;
+            double power = 0.0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < calls; ++i) {
+                const size_t offset = static_cast<size_t>(i % 64) * CHANNELS;
+                double result[CHANNELS];
+                if (mode == 2) {
+                    kernels.fir_double(wide_input.data() + offset, wide_coefficients.data(), taps, CHANNELS, result);
+                } else {
+                    float output[CHANNELS];
+                    (mode == 0 ? kernels.fir_float : kernels.fir_mixed)(
+                        input.data() + offset, coefficients.data(), taps, CHANNELS, output);
+                    for (int ch = 0; ch < CHANNELS; ++ch) {
+                        result[ch] = output[ch];
+                    }
+                }
+                sink += result[0];
+
+                if (i < 64) {
+                    // Long double reference on the same (float) values
+                    for (int ch = 0; ch < CHANNELS; ++ch) {
+                        long double exact = 0.0L;
+                        for (int t = 0; t < taps; ++t) {
+                            exact += static_cast<long double>(input[offset + t * CHANNELS + ch]) * coefficients[t];
+                        }
+                        error += std::pow(static_cast<double>(result[ch] - exact), 2.0);
+                        power += std::pow(static_cast<double>(exact), 2.0);
+                    }
+                }
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            g_sink = static_cast<float>(sink);
+
+            const char* names[] = { "32-bit", "mixed", "64-bit" };
+            std::cout << std::setw(8) << names[mode] << std::setw(6) << taps
+                      << std::setw(16) << std::fixed << std::setprecision(0) << (elapsed > 0.0 ? calls / elapsed : 0.0)
+                      << std::setw(16) << std::setprecision(1)
+                      << (error > 0.0 ? 10.0 * std::log10(error / power) : -400.0) << "\n";
+        }
+    }
+
+    const int input_rate = 44100;
+    const int output_rate = 48000;
+    std::cout << "\nSinc converters, " << input_rate << " Hz -> " << output_rate << " Hz\n"
+              << std::string(60, '-') << "\n";
+    std::cout << std::setw(6) << "Taps" << std::setw(16) << "32-bit (fr/s)" << std::setw(16) << "Mixed (fr/s)"
+              << std::setw(16) << "64-bit (fr/s)" << "\n";
+
+    std::vector<float> input = make_input(static_cast<int>(SECONDS * input_rate));
+    std::vector<double> wide_input(input.begin(), input.end());
+    const int input_frames = static_cast<int>(input.size() / CHANNELS);
+
+    for (int taps : { 16, 32 }) {
+        SincSampleRateConverter single(taps);
+        BenchmarkResult single_result = run(single, input, input_rate, output_rate);
+
+        SincSampleRateConverter mixed(taps);
+        mixed.set_double_accumulation(true);
+        BenchmarkResult mixed_result = run(mixed, input, input_rate, output_rate);
+
+        // The 64-bit converter writes every frame it can, so size for a whole block
+        SincSampleRateConverter64 wide(taps);
+        wide.configure(input_rate, output_rate, CHANNELS);
+        std::vector<double> output((static_cast<size_t>(BLOCK_FRAMES) * output_rate / input_rate + 16) * CHANNELS);
+        size_t written = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int offset = 0; offset < input_frames; offset += BLOCK_FRAMES) {
+            int frames = std::min(BLOCK_FRAMES, input_frames - offset);
+            written += wide.process(wide_input.data() + static_cast<size_t>(offset) * CHANNELS,
+                                    output.data(), frames);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        g_sink = static_cast<float>(output[0]);
+
+        std::cout << std::setw(6) << taps << std::fixed << std::setprecision(0)
+                  << std::setw(16) << single_result.frames_per_second
+                  << std::setw(16) << mixed_result.frames_per_second
+                  << std::setw(16) << (elapsed > 0.0 ? written / elapsed : 0.0) << "\n";
+    }
+}
+
+// Many streams with one ratio: only the first initialize builds a table
+void benchmark_shared_tables() {
+    const int streams = 64;
+    std::cout << "\nShared filter tables, " << streams << " streams at 44100 Hz -> 48000 Hz\n"
+              << std::string(60, '-') << "\n";
+    std::cout << std::setw(10) << "Converter" << std::setw(6) << "Taps" << std::setw(16) << "First init (us)"
+              << std::setw(16) << "Next inits (us)" << std::setw(14) << "Table bytes" << "\n";
+
+    FilterCoefficientCache& cache = FilterCoefficientCache::instance();
+    const int tap_counts[] = { 16, 32 };
+
+    for (int taps : tap_counts) {
+        for (int type = 0; type < 2; ++type) {
+            cache.clear();
+            std::vector<std::unique_ptr<ISampleRateConverter>> converters;
+            double first_us = 0.0;
+            double rest_us = 0.0;
+
+            for (int i = 0; i < streams; ++i) {
+                std::unique_ptr<ISampleRateConverter> converter;
+                if (type == 0) {
+                    converter = std::make_unique<SincSampleRateConverter>(taps);
+                } else {
+                    converter = std::make_unique<RationalSampleRateConverter>(taps);
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                converter->initialize(44100, 48000, CHANNELS);
+                double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                (i == 0 ? first_us : rest_us) += us;
+                converters.push_back(std::move(converter));
+            }
+
+            FilterCoefficientCache::Stats stats = cache.get_stats();
+            std::cout << std::setw(10) << (type == 0 ? "sinc" : "rational") << std::setw(6) << taps
+                      << std::setw(16) << std::fixed << std::setprecision(1) << first_us
+                      << std::setw(16) << rest_us / (streams - 1)
+                      << std::setw(14) << stats.live_bytes << "\n";
+        }
+    }
+    cache.clear();
+}
+
+// Fixed ratio versus a ratio steered every block
+void benchmark_drift() {
+    const int input_rate = 44100;
+    const int output_rate = 48000;
+    std::cout << "\nDrift compensation, " << input_rate << " Hz -> " << output_rate << " Hz\n"
+              << std::string(60, '-') << "\n";
+    std::cout << std::setw(6) << "Taps" << std::setw(16) << "Fixed (fr/s)"
+              << std::setw(18) << "Steered (fr/s)" << std::setw(10) << "Cost" << "\n";
+
+    std::vector<float> input = make_input(static_cast<int>(SECONDS * input_rate));
+    const int input_frames = static_cast<int>(input.size() / CHANNELS);
+    std::vector<float> output((BLOCK_FRAMES * 2) * CHANNELS);
+
+    const int tap_counts[] = { 16, 32 };
+    for (int taps : tap_counts) {
+        SincSampleRateConverter fixed_converter(taps);
+        BenchmarkResult fixed = run(fixed_converter, input, input_rate, output_rate);
+
+        DriftCompensatingResampler steered(taps);
+        steered.initialize(input_rate, output_rate, CHANNELS);
+
+        // A fill level wandering by a block keeps the ratio changing
+        size_t written = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int offset = 0; offset < input_frames; offset += BLOCK_FRAMES) {
+            int frames = std::min(BLOCK_FRAMES, input_frames - offset);
+            steered.update_fill_level(4096 + ((offset / BLOCK_FRAMES) % 2 ? BLOCK_FRAMES : 0));
+            written += steered.convert(input.data() + static_cast<size_t>(offset) * CHANNELS, frames,
+                                       output.data(), BLOCK_FRAMES * 2);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double steered_rate = elapsed > 0.0 ? written / elapsed : 0.0;
+        g_sink = output[0];
+
+        std::cout << std::setw(6) << taps
+                  << std::setw(16) << std::fixed << std::setprecision(0) << fixed.frames_per_second
+                  << std::setw(18) << steered_rate
+                  << std::setw(9) << std::setprecision(2) << fixed.frames_per_second / steered_rate << "x\n";
+    }
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Sinc resampler benchmark: direct window evaluation vs polyphase table,\n"
+              << "the rational (integer phase) converter and cascaded large ratios\n";
+
+    benchmark(44100, 48000);
+    benchmark(96000, 44100);
+    benchmark_cascade(705600, 44100);
+    benchmark_cascade(768000, 48000);
+    benchmark_cascade(768000, 44100);
+    benchmark_kernels();
+    benchmark_fixed_shapes();
+    benchmark_precision();
+    benchmark_shared_tables();
+    benchmark_drift();
+
+    return 0;
+}
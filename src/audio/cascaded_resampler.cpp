@@ -0,0 +1,376 @@
+/**
+ * @file cascaded_resampler.cpp
+ * @brief Multi-stage resampling implementation
+ * @date 2025-12-10
+ */
+
+#include "cascaded_resampler.h"
+#include "enhanced_sample_rate_converter.h"
+#include "polyphase_filter_bank.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace audio {
+
+// HalfBandFilter implementation
+HalfBandFilter::HalfBandFilter(int taps)
+    : taps_(std::max(taps, 3)) {
+
+    // 4k + 3 taps put the centre on an odd index, so the non-zero side taps
+    // are exactly the even ones
+    while (taps_ % 4 != 3) {
+        taps_++;
+    }
+
+    const int centre = (taps_ - 1) / 2;
+    even_taps_.resize(centre + 1);
+
+    double sum = 0.0;
+    for (int i = 0; i <= centre; ++i) {
+        // Cutoff at a quarter of the sample rate; window ends just outside the filter
+        double value = PolyphaseFilterBank::evaluate(2 * i - centre, 0.25, centre + 1);
+        even_taps_[i] = static_cast<float>(value);
+        sum += value;
+    }
+
+    // Side taps sum to 0.5 so that with the 0.5 centre tap the DC gain is 1
+    for (float& tap : even_taps_) {
+        tap = static_cast<float>(tap * 0.5 / sum);
+    }
+}
+
+// HalfBandDecimator implementation
+HalfBandDecimator::HalfBandDecimator(int taps)
+    : filter_(taps)
+    , fir_(get_fir_kernels().fir_float)
+    , channels_(0)
+    , parity_(0) {
+}
+
+bool HalfBandDecimator::initialize(int input_rate, int output_rate, int channels) {
+    if (channels <= 0 || input_rate != output_rate * 2) {
+        return false;
+    }
+
+    channels_ = channels;
+    parity_ = 0;
+    side_sums_.assign(static_cast<size_t>(channels_) * 2, 0.0f);
+    fir_ = get_fir_kernel_float(static_cast<int>(filter_.get_even_taps().size()), channels_ * 2);
+    history_.assign(static_cast<size_t>(filter_.get_taps() - 1) * channels_, 0.0f);
+    return true;
+}
+
+int HalfBandDecimator::convert(const float* input, int input_frames,
+                               float* output, int max_output_frames) {
+    if (!input || !output || input_frames <= 0 || max_output_frames <= 0 || channels_ <= 0) {
+        return 0;
+    }
+
+    const int history_frames = filter_.get_taps() - 1;
+    const int centre = history_frames / 2;
+    const std::vector<float>& taps = filter_.get_even_taps();
+    const int tap_count = static_cast<int>(taps.size());
+    // One spare frame: the paired kernel reads a frame past the last window
+    const size_t total_samples = static_cast<size_t>(history_frames + input_frames + 1) * channels_;
+
+    if (extended_input_.size() < total_samples) {
+        extended_input_.resize(total_samples, 0.0f);
+    }
+    std::memcpy(extended_input_.data(), history_.data(), history_.size() * sizeof(float));
+    std::memcpy(extended_input_.data() + history_.size(), input,
+                static_cast<size_t>(input_frames) * channels_ * sizeof(float));
+
+    int output_frames = 0;
+    for (int j = parity_; j < input_frames && output_frames < max_output_frames; j += 2) {
+        // Window covers input frames j - (taps - 1) .. j; the filter is
+        // symmetric, so the side taps can run oldest first
+        const float* oldest = extended_input_.data() + static_cast<size_t>(j) * channels_;
+        float* out = output + static_cast<size_t>(output_frames) * channels_;
+
+        // Treating frame pairs as one frame of 2 * channels steps the
+        // kernel over every other input frame; the first half is the result
+        fir_(oldest, taps.data(), tap_count, channels_ * 2, side_sums_.data());
+
+        const float* centre_frame = oldest + static_cast<ptrdiff_t>(centre) * channels_;
+        for (int ch = 0; ch < channels_; ++ch) {
+            out[ch] = side_sums_[ch] + 0.5f * centre_frame[ch];
+        }
+        output_frames++;
+    }
+
+    parity_ = (parity_ + input_frames) & 1;
+
+    // Last taps - 1 frames carry over
+    std::memcpy(history_.data(), extended_input_.data() + static_cast<size_t>(input_frames) * channels_,
+                history_.size() * sizeof(float));
+
+    return output_frames;
+}
+
+int HalfBandDecimator::get_latency() const {
+    return (filter_.get_taps() - 1) / 4;
+}
+
+void HalfBandDecimator::reset() {
+    parity_ = 0;
+    std::fill(history_.begin(), history_.end(), 0.0f);
+}
+
+// HalfBandInterpolator implementation
+HalfBandInterpolator::HalfBandInterpolator(int taps)
+    : filter_(taps)
+    , fir_(get_fir_kernels().fir_float)
+    , side_taps_(filter_.get_even_taps())
+    , channels_(0) {
+
+    for (float& tap : side_taps_) {
+        tap *= 2.0f;
+    }
+}
+
+bool HalfBandInterpolator::initialize(int input_rate, int output_rate, int channels) {
+    if (channels <= 0 || output_rate != input_rate * 2) {
+        return false;
+    }
+
+    channels_ = channels;
+    history_.assign(static_cast<size_t>(filter_.get_taps() / 2) * channels_, 0.0f);
+    fir_ = get_fir_kernel_float(static_cast<int>(side_taps_.size()), channels_);
+    return true;
+}
+
+int HalfBandInterpolator::convert(const float* input, int input_frames,
+                                  float* output, int max_output_frames) {
+    if (!input || !output || input_frames <= 0 || max_output_frames <= 0 || channels_ <= 0) {
+        return 0;
+    }
+
+    const int history_frames = filter_.get_taps() / 2;
+    const int centre_delay = (history_frames - 1) / 2;
+    const int tap_count = static_cast<int>(side_taps_.size());
+    const size_t total_samples = static_cast<size_t>(history_frames + input_frames) * channels_;
+
+    if (extended_input_.size() < total_samples) {
+        extended_input_.resize(total_samples);
+    }
+    std::memcpy(extended_input_.data(), history_.data(), history_.size() * sizeof(float));
+    std::memcpy(extended_input_.data() + history_.size(), input,
+                static_cast<size_t>(input_frames) * channels_ * sizeof(float));
+
+    int output_frames = 0;
+    for (int j = 0; j < input_frames && output_frames + 2 <= max_output_frames; ++j) {
+        // Window covers input frames j - taps / 2 .. j (symmetric taps)
+        const float* oldest = extended_input_.data() + static_cast<size_t>(j) * channels_;
+        float* even = output + static_cast<size_t>(output_frames) * channels_;
+        float* odd = even + channels_;
+
+        // Even outputs: the side taps
+        fir_(oldest, side_taps_.data(), tap_count, channels_, even);
+
+        // Odd outputs: only the centre tap lands on a real sample
+        std::memcpy(odd, oldest + static_cast<ptrdiff_t>(history_frames - centre_delay) * channels_,
+                    channels_ * sizeof(float));
+        output_frames += 2;
+    }
+
+    // Last taps / 2 frames carry over
+    std::memcpy(history_.data(), extended_input_.data() + static_cast<size_t>(input_frames) * channels_,
+                history_.size() * sizeof(float));
+
+    return output_frames;
+}
+
+int HalfBandInterpolator::get_latency() const {
+    return (filter_.get_taps() - 1) / 2;
+}
+
+void HalfBandInterpolator::reset() {
+    std::fill(history_.begin(), history_.end(), 0.0f);
+}
+
+// CascadedSampleRateConverter implementation
+CascadedSampleRateConverter::CascadedSampleRateConverter(ResampleQuality quality)
+    : quality_(quality)
+    , channels_(0) {
+}
+
+int CascadedSampleRateConverter::halfband_taps_for(ResampleQuality quality) {
+    switch (quality) {
+        case ResampleQuality::Fast: return 15;
+        case ResampleQuality::Good: return 31;
+        case ResampleQuality::High: return 47;
+        case ResampleQuality::Best: return 63;
+        default: return 31;
+    }
+}
+
+std::vector<ConversionStage> CascadedSampleRateConverter::plan(int input_rate, int output_rate,
+                                                                ResampleQuality quality) {
+    std::vector<ConversionStage> stages;
+    if (input_rate <= 0 || output_rate <= 0 || input_rate == output_rate) {
+        return stages;
+    }
+
+    const int long_taps = halfband_taps_for(quality);
+
+    if (input_rate > output_rate) {
+        // Halve while the result stays at or above the output rate
+        int rate = input_rate;
+        while (rate % 2 == 0 && rate / 2 >= output_rate) {
+            stages.push_back({ ConversionStage::Type::Decimate2, rate, rate / 2, SHORT_HALFBAND_TAPS });
+            rate /= 2;
+        }
+        // The last 2:1 stage bounds the final passband
+        if (!stages.empty()) {
+            stages.back().taps = long_taps;
+        }
+        if (rate != output_rate) {
+            stages.push_back({ ConversionStage::Type::Fractional, rate, output_rate, 0 });
+        }
+    } else {
+        // Fractional step at the input end, then double up to the output rate
+        int rate = output_rate;
+        int doublings = 0;
+        while (rate % 2 == 0 && rate / 2 >= input_rate) {
+            rate /= 2;
+            doublings++;
+        }
+        if (rate != input_rate) {
+            stages.push_back({ ConversionStage::Type::Fractional, input_rate, rate, 0 });
+        }
+        for (int i = 0; i < doublings; ++i) {
+            // The first 1:2 stage bounds the final passband
+            stages.push_back({ ConversionStage::Type::Interpolate2, rate, rate * 2,
+                               i == 0 ? long_taps : SHORT_HALFBAND_TAPS });
+            rate *= 2;
+        }
+    }
+
+    return stages;
+}
+
+std::string CascadedSampleRateConverter::describe(const std::vector<ConversionStage>& stages) {
+    std::string text;
+    size_t i = 0;
+    while (i < stages.size()) {
+        // Collapse runs of identical 2x stages
+        size_t run = 1;
+        while (i + run < stages.size() && stages[i + run].type == stages[i].type &&
+               stages[i].type != ConversionStage::Type::Fractional) {
+            run++;
+        }
+
+        if (!text.empty()) {
+            text += " -> ";
+        }
+        switch (stages[i].type) {
+            case ConversionStage::Type::Decimate2:
+                text += "2:1";
+                break;
+            case ConversionStage::Type::Interpolate2:
+                text += "1:2";
+                break;
+            case ConversionStage::Type::Fractional:
+                text += std::to_string(stages[i].input_rate) + ":" + std::to_string(stages[i].output_rate);
+                break;
+        }
+        if (run > 1) {
+            text += " x" + std::to_string(run);
+        }
+        i += run;
+    }
+    return text.empty() ? "bypass" : text;
+}
+
+bool CascadedSampleRateConverter::initialize(int input_rate, int output_rate, int channels) {
+    if (input_rate <= 0 || output_rate <= 0 || channels <= 0) {
+        return false;
+    }
+
+    channels_ = channels;
+    stages_ = plan(input_rate, output_rate, quality_);
+    converters_.clear();
+
+    for (const ConversionStage& stage : stages_) {
+        std::unique_ptr<ISampleRateConverter> converter;
+        switch (stage.type) {
+            case ConversionStage::Type::Decimate2:
+                converter = std::make_unique<HalfBandDecimator>(stage.taps);
+                break;
+            case ConversionStage::Type::Interpolate2:
+                converter = std::make_unique<HalfBandInterpolator>(stage.taps);
+                break;
+            case ConversionStage::Type::Fractional:
+                converter = EnhancedSampleRateConverterFactory::create(quality_);
+                break;
+        }
+
+        if (!converter || !converter->initialize(stage.input_rate, stage.output_rate, channels)) {
+            converters_.clear();
+            return false;
+        }
+        converters_.push_back(std::move(converter));
+    }
+
+    scratch_.resize(converters_.empty() ? 0 : converters_.size() - 1);
+    return true;
+}
+
+int CascadedSampleRateConverter::convert(const float* input, int input_frames,
+                                         float* output, int max_output_frames) {
+    if (!input || !output || input_frames <= 0 || max_output_frames <= 0 || channels_ <= 0) {
+        return 0;
+    }
+
+    if (converters_.empty()) {
+        int frames = std::min(input_frames, max_output_frames);
+        std::memcpy(output, input, static_cast<size_t>(frames) * channels_ * sizeof(float));
+        return frames;
+    }
+
+    const float* stage_input = input;
+    int stage_frames = input_frames;
+
+    for (size_t i = 0; i + 1 < converters_.size(); ++i) {
+        const ConversionStage& stage = stages_[i];
+        const int capacity = static_cast<int>(
+            static_cast<int64_t>(stage_frames) * stage.output_rate / stage.input_rate) + 16;
+
+        std::vector<float>& buffer = scratch_[i];
+        if (buffer.size() < static_cast<size_t>(capacity) * channels_) {
+            buffer.resize(static_cast<size_t>(capacity) * channels_);
+        }
+
+        stage_frames = converters_[i]->convert(stage_input, stage_frames, buffer.data(), capacity);
+        stage_input = buffer.data();
+        if (stage_frames <= 0) {
+            return 0;
+        }
+    }
+
+    return converters_.back()->convert(stage_input, stage_frames, output, max_output_frames);
+}
+
+int CascadedSampleRateConverter::get_latency() const {
+    if (stages_.empty()) {
+        return 0;
+    }
+
+    // Each stage reports latency at its own output rate
+    const int output_rate = stages_.back().output_rate;
+    int64_t latency = 0;
+    for (size_t i = 0; i < converters_.size(); ++i) {
+        latency += static_cast<int64_t>(converters_[i]->get_latency()) * output_rate / stages_[i].output_rate;
+    }
+    return static_cast<int>(latency);
+}
+
+void CascadedSampleRateConverter::reset() {
+    for (auto& converter : converters_) {
+        converter->reset();
+    }
+}
+
+} // namespace audio
@@ -0,0 +1,176 @@
+/**
+ * @file cascaded_resampler.h
+ * @brief Multi-stage resampling: half-band 2x stages plus one fractional stage
+ * @date 2025-12-10
+ */
+
+#pragma once
+
+#include "sample_rate_converter.h"
+#include "fir_kernels.h"
+#include <vector>
+#include <memory>
+#include <string>
+
+namespace audio {
+
+enum class ResampleQuality;
+
+/**
+ * @brief Half-band low-pass FIR shared by the 2x stages
+ *
+ * Every other coefficient of a half-band filter is zero and the centre tap
+ * is exactly 0.5, so a 2x stage only evaluates the (taps + 1) / 2 even taps
+ * plus the centre.
+ */
+class HalfBandFilter {
+public:
+    /**
+     * Design the filter
+     * @param taps Filter length, rounded up to the next 4k + 3
+     */
+    explicit HalfBandFilter(int taps);
+
+    int get_taps() const { return taps_; }
+
+    /**
+     * Non-zero side taps h[0], h[2], ..., h[taps - 1]
+     */
+    const std::vector<float>& get_even_taps() const { return even_taps_; }
+
+private:
+    int taps_;
+    std::vector<float> even_taps_;
+};
+
+/**
+ * @brief Exact 2:1 decimator using a half-band filter
+ */
+class HalfBandDecimator : public ISampleRateConverter {
+public:
+    explicit HalfBandDecimator(int taps);
+
+    bool initialize(int input_rate, int output_rate, int channels) override;
+    int convert(const float* input, int input_frames,
+               float* output, int max_output_frames) override;
+    int get_latency() const override;
+    void reset() override;
+    const char* get_name() const override { return "HalfBandDecimator"; }
+    const char* get_description() const override { return "Half-band 2:1 decimator"; }
+
+private:
+    HalfBandFilter filter_;
+    FirKernelFloat fir_;                // Side taps, stepping two frames at a time
+    int channels_;
+    int parity_;                        // 1 if the next input frame is odd (no output)
+    std::vector<float> side_sums_;      // Kernel output for both frame parities
+    std::vector<float> history_;        // Last taps - 1 input frames
+    std::vector<float> extended_input_; // History + input scratch, reused across calls
+};
+
+/**
+ * @brief Exact 1:2 interpolator using a half-band filter
+ */
+class HalfBandInterpolator : public ISampleRateConverter {
+public:
+    explicit HalfBandInterpolator(int taps);
+
+    bool initialize(int input_rate, int output_rate, int channels) override;
+    int convert(const float* input, int input_frames,
+               float* output, int max_output_frames) override;
+    int get_latency() const override;
+    void reset() override;
+    const char* get_name() const override { return "HalfBandInterpolator"; }
+    const char* get_description() const override { return "Half-band 1:2 interpolator"; }
+
+private:
+    HalfBandFilter filter_;
+    FirKernelFloat fir_;                // Side taps over consecutive frames
+    std::vector<float> side_taps_;      // Side taps doubled for the inserted zeros
+    int channels_;
+    std::vector<float> history_;        // Last taps / 2 input frames
+    std::vector<float> extended_input_; // History + input scratch, reused across calls
+};
+
+/**
+ * @brief One step of a conversion plan
+ */
+struct ConversionStage {
+    enum class Type {
+        Decimate2,      // Half-band 2:1
+        Interpolate2,   // Half-band 1:2
+        Fractional      // Remaining ratio, converter chosen by quality
+    };
+
+    Type type;
+    int input_rate;
+    int output_rate;
+    int taps;           // Half-band length (0 for the fractional stage)
+};
+
+/**
+ * @brief Converter running a plan of cascaded stages
+ *
+ * Large integer-power-of-two factors are taken by half-band stages, so the
+ * only long filter runs at the lower of the two rates and the cost scales
+ * with the output rate: 768000 -> 48000 is four 2:1 stages whose work
+ * halves at each step. Any remaining non-power-of-two ratio is done by a
+ * single fractional stage at the low-rate end of the chain.
+ */
+class CascadedSampleRateConverter : public ISampleRateConverter {
+public:
+    /**
+     * Half-band length used by the stage next to the low-rate end; the
+     * other stages have a wide transition band and use this short length
+     */
+    static constexpr int SHORT_HALFBAND_TAPS = 11;
+
+    /**
+     * Constructor
+     * @param quality Quality of the fractional stage and final half-band
+     */
+    explicit CascadedSampleRateConverter(ResampleQuality quality);
+
+    /**
+     * Plan a conversion
+     * @param input_rate Input sample rate
+     * @param output_rate Output sample rate
+     * @param quality Conversion quality
+     * @return Stages in processing order (empty if the rates are equal)
+     */
+    static std::vector<ConversionStage> plan(int input_rate, int output_rate, ResampleQuality quality);
+
+    /**
+     * Half-band length for the stage next to the low-rate end
+     */
+    static int halfband_taps_for(ResampleQuality quality);
+
+    /**
+     * Human readable plan, e.g. "2:1 x4" or "2:1 x3 -> 48000:44100"
+     */
+    static std::string describe(const std::vector<ConversionStage>& stages);
+
+    bool initialize(int input_rate, int output_rate, int channels) override;
+    int convert(const float* input, int input_frames,
+               float* output, int max_output_frames) override;
+    int get_latency() const override;
+    void reset() override;
+    const char* get_name() const override { return "Cascaded"; }
+    const char* get_description() const override {
+        return "Half-band 2x stages plus one fractional stage";
+    }
+
+    /**
+     * Stages of the current plan
+     */
+    const std::vector<ConversionStage>& get_stages() const { return stages_; }
+
+private:
+    ResampleQuality quality_;
+    int channels_;
+    std::vector<ConversionStage> stages_;
+    std::vector<std::unique_ptr<ISampleRateConverter>> converters_;
+    std::vector<std::vector<float>> scratch_;   // Output of every stage but the last
+};
+
+} // namespace audio
@@ -28,7 +28,6 @@ bool CubicSampleRateConverter::initialize(int input_rate, int output_rate, int c
     output_rate_ = output_rate;
     channels_ = channels;
     ratio_ = static_cast<double>(input_rate) / output_rate;
-    position_ = 0.0;
 
     // Initialize history buffer (need 4 frames per channel for cubic interpolation)
     history_buffer_.resize(channels_ * history_size_, 0.0f);
@@ -37,8 +36,14 @@ bool CubicSampleRateConverter::initialize(int input_rate, int output_rate, int c
     if (output_rate < input_rate) {
         double cutoff = output_rate / (2.0 * input_rate) * 0.95;  // 95% of Nyquist
         filter_ = std::make_unique<AntiAliasingFilter>(cutoff, 101);
+    } else {
+        filter_.reset();
     }
 
+    // Read the filtered signal where input frame 0 comes out, so output
+    // frame n is input position n * ratio like the other converters
+    position_ = filter_ ? filter_->get_delay() : 0.0;
+
     return true;
 }
 
@@ -62,37 +67,43 @@ int CubicSampleRateConverter::convert(const float* input, int input_frames,
     int output_frames = 0;
     int total_input_frames = input_frames + history_size_;
 
-    // Create extended buffer with history
-    std::vector<float> extended_input(total_input_frames * channels_);
+    // Extended buffer: history frames followed by new input (grows only)
+    if (extended_input_.size() < static_cast<size_t>(total_input_frames * channels_)) {
+        extended_input_.resize(total_input_frames * channels_);
+    }
 
     // Copy history buffer first
-    std::memcpy(extended_input.data(), history_buffer_.data(),
+    std::memcpy(extended_input_.data(), history_buffer_.data(),
                 history_buffer_.size() * sizeof(float));
 
-    // Copy new input
-    std::memcpy(extended_input.data() + history_buffer_.size(),
-                input, input_frames * channels_ * sizeof(float));
-
-    // Apply anti-aliasing filter if downsampling
+    // Apply anti-aliasing filter to the new input only; history is already filtered
+    float* new_input = extended_input_.data() + history_buffer_.size();
     if (filter_ && output_rate_ < input_rate_) {
-        std::vector<float> filtered_input(total_input_frames * channels_);
-        filter_->process(extended_input.data(), filtered_input.data(),
-                        total_input_frames, channels_);
-        extended_input = std::move(filtered_input);
+        filter_->process(input, new_input, input_frames, channels_);
+    } else {
+        std::memcpy(new_input, input, input_frames * channels_ * sizeof(float));
     }
 
-    // Process each output sample
-    while (output_frames < max_output_frames && position_ < input_frames + 1) {
-        int pos_int = static_cast<int>(position_);
+    // position_ is relative to the first new frame; frame j lives at
+    // extended index j + history_size_
+    const float* base = extended_input_.data() + history_size_ * channels_;
+
+    // Process each output sample while samples j-1 .. j+2 are available
+    while (output_frames < max_output_frames) {
+        int pos_int = static_cast<int>(std::floor(position_));
         double pos_frac = position_ - pos_int;
 
+        if (pos_int + 2 >= input_frames) {
+            break;
+        }
+
         // Cubic interpolation for each channel
         for (int ch = 0; ch < channels_; ++ch) {
             // Get 4 consecutive samples for cubic interpolation
-            float y0 = extended_input[(pos_int - 1) * channels_ + ch];
-            float y1 = extended_input[(pos_int) * channels_ + ch];
-            float y2 = extended_input[(pos_int + 1) * channels_ + ch];
-            float y3 = extended_input[(pos_int + 2) * channels_ + ch];
+            float y0 = base[(pos_int - 1) * channels_ + ch];
+            float y1 = base[(pos_int) * channels_ + ch];
+            float y2 = base[(pos_int + 1) * channels_ + ch];
+            float y3 = base[(pos_int + 2) * channels_ + ch];
 
             output[output_frames * channels_ + ch] =
                 cubic_interpolate(y0, y1, y2, y3, static_cast<float>(pos_frac));
@@ -102,20 +113,13 @@ int CubicSampleRateConverter::convert(const float* input, int input_frames,
         position_ += ratio_;
     }
 
-    // Update history buffer for next call
-    if (input_frames >= history_size_) {
-        std::memcpy(history_buffer_.data(),
-                    input + (input_frames - history_size_) * channels_,
-                    history_size_ * channels_ * sizeof(float));
-    } else {
-        // Not enough frames, shift existing history
-        int shift = std::min(input_frames, history_size_ - 1);
-        std::memmove(history_buffer_.data(),
-                     history_buffer_.data() + shift * channels_,
-                     (history_size_ - shift) * channels_ * sizeof(float));
-        std::memcpy(history_buffer_.data() + (history_size_ - shift) * channels_,
-                    input, input_frames * channels_ * sizeof(float));
-    }
+    // Continue from the same point in the next block
+    position_ -= input_frames;
+
+    // Last history_size_ frames of the extended buffer carry over
+    std::memcpy(history_buffer_.data(),
+                extended_input_.data() + input_frames * channels_,
+                history_buffer_.size() * sizeof(float));
 
     return output_frames;
 }
@@ -127,7 +131,7 @@ int CubicSampleRateConverter::get_latency() const {
 }
 
 void CubicSampleRateConverter::reset() {
-    position_ = 0.0;
+    position_ = filter_ ? filter_->get_delay() : 0.0;
     std::fill(history_buffer_.begin(), history_buffer_.end(), 0.0f);
     if (filter_) {
         filter_->reset();
@@ -41,6 +41,11 @@ public:
      */
     void process(const float* input, float* output, int frames, int channels);
 
+    /**
+     * Group delay of the linear-phase filter in frames
+     */
+    int get_delay() const { return (taps_ - 1) / 2; }
+
     /**
      * Reset filter state
      */
@@ -64,6 +69,7 @@ private:
     int history_size_;                // Number of frames to keep in history
 
     std::vector<float> history_buffer_; // History for continuity
+    std::vector<float> extended_input_; // History + input scratch, reused across calls
     std::unique_ptr<AntiAliasingFilter> filter_; // Anti-aliasing filter
 
     /**
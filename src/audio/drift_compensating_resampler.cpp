@@ -0,0 +1,147 @@
+/**
+ * @file drift_compensating_resampler.cpp
+ * @brief Variable-ratio sinc resampler locked to an output device clock
+ * @date 2025-12-10
+ */
+
+#include "drift_compensating_resampler.h"
+#include "audio_output.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace audio {
+
+// DriftController Implementation
+DriftController::DriftController(double time_constant, double max_correction_ppm)
+    : kp_(2.0 / time_constant)
+    , ki_(1.0 / (time_constant * time_constant))
+    , smoothing_(time_constant / 10.0)
+    , max_correction_(max_correction_ppm * 1e-6)
+    , output_rate_(48000)
+    , requested_target_(-1.0)
+    , target_fill_(-1.0)
+    , smoothed_fill_(0.0)
+    , integral_(0.0)
+    , correction_(0.0)
+    , has_reading_(false) {
+}
+
+void DriftController::set_target_fill(double frames) {
+    requested_target_ = frames;
+    target_fill_ = frames;
+}
+
+double DriftController::update(double fill_frames, double elapsed_seconds) {
+    if (!has_reading_) {
+        smoothed_fill_ = fill_frames;
+        if (target_fill_ < 0.0) {
+            target_fill_ = fill_frames;
+        }
+        has_reading_ = true;
+        return correction_;
+    }
+
+    if (elapsed_seconds <= 0.0 || output_rate_ <= 0) {
+        return correction_;
+    }
+
+    smoothed_fill_ += (1.0 - std::exp(-elapsed_seconds / smoothing_)) * (fill_frames - smoothed_fill_);
+
+    // Positive error: the buffer is running low, so produce more output
+    double error = (target_fill_ - smoothed_fill_) / output_rate_;
+    double integral = integral_ + ki_ * error * elapsed_seconds;
+    double correction = kp_ * error + integral;
+
+    // Anti-windup: stop integrating while pinned at the limit
+    if (correction > max_correction_) {
+        correction = max_correction_;
+        integral = std::min(integral, integral_);
+    } else if (correction < -max_correction_) {
+        correction = -max_correction_;
+        integral = std::max(integral, integral_);
+    }
+
+    integral_ = integral;
+    correction_ = correction;
+    return correction_;
+}
+
+void DriftController::reset() {
+    target_fill_ = requested_target_;
+    smoothed_fill_ = 0.0;
+    integral_ = 0.0;
+    correction_ = 0.0;
+    has_reading_ = false;
+}
+
+// DriftCompensatingResampler Implementation
+DriftCompensatingResampler::DriftCompensatingResampler(int taps, double time_constant)
+    : sinc_(taps)
+    , controller_(time_constant)
+    , output_rate_(0)
+    , frames_since_update_(0) {
+}
+
+bool DriftCompensatingResampler::initialize(int input_rate, int output_rate, int channels) {
+    if (!sinc_.initialize(input_rate, output_rate, channels)) {
+        return false;
+    }
+
+    output_rate_ = output_rate;
+    controller_.set_output_rate(output_rate);
+    controller_.reset();
+    frames_since_update_ = 0;
+    return true;
+}
+
+int DriftCompensatingResampler::convert(const float* input, int input_frames,
+                                        float* output, int max_output_frames) {
+    int generated = sinc_.convert(input, input_frames, output, max_output_frames);
+    frames_since_update_ += generated;
+    return generated;
+}
+
+int DriftCompensatingResampler::get_latency() const {
+    return sinc_.get_latency();
+}
+
+void DriftCompensatingResampler::reset() {
+    sinc_.reset();
+    sinc_.set_ratio_scale(1.0);
+    controller_.reset();
+    frames_since_update_ = 0;
+}
+
+void DriftCompensatingResampler::set_target_fill(int frames) {
+    controller_.set_target_fill(frames);
+}
+
+void DriftCompensatingResampler::update_fill_level(int queued_frames) {
+    if (output_rate_ <= 0) {
+        return;
+    }
+
+    double elapsed = static_cast<double>(frames_since_update_) / output_rate_;
+    frames_since_update_ = 0;
+
+    // Producing more output per input frame means a shorter input step
+    double correction = controller_.update(queued_frames, elapsed);
+    sinc_.set_ratio_scale(1.0 / (1.0 + correction));
+}
+
+bool DriftCompensatingResampler::update_from_output(const IAudioOutput& output) {
+    int queued = output.get_queued_frames();
+    if (queued < 0) {
+        int latency_ms = output.get_latency();
+        if (latency_ms < 0) {
+            return false;
+        }
+        queued = static_cast<int>(static_cast<int64_t>(latency_ms) * output_rate_ / 1000);
+    }
+
+    update_fill_level(queued);
+    return true;
+}
+
+} // namespace audio
@@ -0,0 +1,156 @@
+/**
+ * @file drift_compensating_resampler.h
+ * @brief Variable-ratio sinc resampler locked to an output device clock
+ * @date 2025-12-10
+ */
+
+#pragma once
+
+#include "sample_rate_converter.h"
+#include "sinc_resampler.h"
+
+namespace audio {
+
+class IAudioOutput;
+
+/**
+ * @brief PI controller turning an output buffer fill level into a ratio correction
+ *
+ * When a device consumes frames slightly faster or slower than nominal, its
+ * buffer fill drifts at (correction - drift) * output_rate frames per
+ * second. The controller steers the correction so the smoothed fill stays at
+ * the target; the integral term converges to the clock drift itself, so the
+ * fill holds its level indefinitely without frames being dropped or
+ * inserted.
+ *
+ * The loop is critically damped with the given time constant. The fill
+ * reading is low-pass filtered first, since it jumps by a whole block at
+ * every write and every device period.
+ */
+class DriftController {
+public:
+    static constexpr double DEFAULT_TIME_CONSTANT = 10.0;       // Seconds
+    static constexpr double DEFAULT_MAX_CORRECTION_PPM = 1000.0;
+
+    /**
+     * Constructor
+     * @param time_constant Loop time constant in seconds (larger = smoother, slower lock)
+     * @param max_correction_ppm Largest correction applied, in parts per million
+     */
+    explicit DriftController(double time_constant = DEFAULT_TIME_CONSTANT,
+                             double max_correction_ppm = DEFAULT_MAX_CORRECTION_PPM);
+
+    /**
+     * Set the output rate used to turn frames into time
+     */
+    void set_output_rate(int output_rate) { output_rate_ = output_rate; }
+
+    /**
+     * Set the fill level to hold; a negative value adopts the first reading
+     */
+    void set_target_fill(double frames);
+
+    /**
+     * Feed one fill reading
+     * @param fill_frames Frames queued in the output
+     * @param elapsed_seconds Playback time since the previous reading
+     * @return Correction as a fraction: 1e-4 means produce output 100 ppm faster
+     */
+    double update(double fill_frames, double elapsed_seconds);
+
+    /**
+     * Forget the loop state and the adopted target
+     */
+    void reset();
+
+    double get_correction() const { return correction_; }
+    double get_target_fill() const { return target_fill_; }
+    double get_smoothed_fill() const { return smoothed_fill_; }
+
+    /**
+     * Estimated device clock drift relative to the source (fraction)
+     */
+    double get_drift() const { return integral_; }
+
+private:
+    double kp_;                    // Per second of fill error
+    double ki_;                    // Per second of fill error per second
+    double smoothing_;             // Fill low-pass time constant (s)
+    double max_correction_;
+    int output_rate_;
+
+    double requested_target_;      // As set; negative = adopt the first reading
+    double target_fill_;
+    double smoothed_fill_;
+    double integral_;
+    double correction_;
+    bool has_reading_;
+};
+
+/**
+ * @brief Sinc resampler whose ratio follows an output device clock
+ *
+ * One instance per output: the same stream sent to two devices goes
+ * through two of these, each steered by its own device's fill level. The
+ * correction only changes the step between output frames, so the cost is
+ * that of the fixed-ratio sinc converter.
+ *
+ * Call update_fill_level() (or update_from_output()) once per callback.
+ */
+class DriftCompensatingResampler : public ISampleRateConverter {
+public:
+    /**
+     * Constructor
+     * @param taps Sinc filter taps
+     * @param time_constant Loop time constant in seconds
+     */
+    explicit DriftCompensatingResampler(int taps = 16,
+                                        double time_constant = DriftController::DEFAULT_TIME_CONSTANT);
+
+    bool initialize(int input_rate, int output_rate, int channels) override;
+    int convert(const float* input, int input_frames,
+               float* output, int max_output_frames) override;
+    int get_latency() const override;
+    void reset() override;
+    const char* get_name() const override { return "DriftCompensating"; }
+    const char* get_description() const override {
+        return "Sinc resampler with PI-controlled ratio locked to the output clock";
+    }
+
+    /**
+     * Set the output fill level to hold; by default the first reading is kept
+     */
+    void set_target_fill(int frames);
+
+    /**
+     * Report how many frames are queued in the output
+     */
+    void update_fill_level(int queued_frames);
+
+    /**
+     * Read the fill level from an output. Uses get_queued_frames() and
+     * falls back to get_latency() when the backend cannot tell.
+     * @return false if neither is available
+     */
+    bool update_from_output(const IAudioOutput& output);
+
+    /**
+     * Current ratio correction in parts per million
+     */
+    double get_correction_ppm() const { return controller_.get_correction() * 1e6; }
+
+    /**
+     * Estimated device clock drift in parts per million
+     */
+    double get_drift_ppm() const { return controller_.get_drift() * 1e6; }
+
+    const DriftController& get_controller() const { return controller_; }
+
+private:
+    SincSampleRateConverter sinc_;
+    DriftController controller_;
+    int output_rate_;
+    long frames_since_update_;     // Output produced since the last fill reading
+};
+
+} // namespace audio
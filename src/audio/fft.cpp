@@ -0,0 +1,178 @@
+/**
+ * @file fft.cpp
+ * @brief FFT tables, scalar kernel and runtime instruction set dispatch
+ * @date 2026-10-17
+ */
+
+#include "fft.h"
+#include "fft_impl.h"
+#include <cmath>
+#include <mutex>
+
+namespace audio {
+
+// Per-ISA kernels, each in its own translation unit
+#if AUDIO_FIR_X86
+void fft_forward_real_sse2(const FFTTables&, const float*, float*, float*, float*);
+void fft_forward_real_avx2(const FFTTables&, const float*, float*, float*, float*);
+void fft_inverse_real_sse2(const FFTTables&, const float*, const float*, float*, float*);
+void fft_inverse_real_avx2(const FFTTables&, const float*, const float*, float*, float*);
+#endif
+#if AUDIO_FIR_NEON
+void fft_forward_real_neon(const FFTTables&, const float*, float*, float*, float*);
+void fft_inverse_real_neon(const FFTTables&, const float*, const float*, float*, float*);
+#endif
+
+namespace {
+
+void fft_forward_real_scalar(const FFTTables& tables, const float* input,
+                             float* real, float* imag, float* work) {
+    forward_real<ScalarLanes>(tables, input, real, imag, work);
+}
+
+void fft_inverse_real_scalar(const FFTTables& tables, const float* real,
+                             const float* imag, float* output, float* work) {
+    inverse_real<ScalarLanes>(tables, real, imag, output, work);
+}
+
+const FFTKernels SCALAR_FFT_KERNELS = {
+    SimdLevel::Scalar, "scalar", fft_forward_real_scalar, fft_inverse_real_scalar
+};
+#if AUDIO_FIR_X86
+const FFTKernels SSE2_FFT_KERNELS = { SimdLevel::SSE2, "sse2", fft_forward_real_sse2, fft_inverse_real_sse2 };
+const FFTKernels AVX2_FFT_KERNELS = { SimdLevel::AVX2, "avx2", fft_forward_real_avx2, fft_inverse_real_avx2 };
+#endif
+#if AUDIO_FIR_NEON
+const FFTKernels NEON_FFT_KERNELS = { SimdLevel::NEON, "neon", fft_forward_real_neon, fft_inverse_real_neon };
+#endif
+
+std::shared_ptr<const FFTTables> build_tables(size_t size) {
+    const double pi = 3.14159265358979323846;
+    auto tables = std::make_shared<FFTTables>();
+    tables->size = size;
+    tables->half = size / 2;
+
+    int bits = 0;
+    while ((size_t(1) << bits) < tables->half) {
+        ++bits;
+    }
+    tables->radix2_first = (bits & 1) != 0;
+
+    tables->bitrev.resize(tables->half);
+    for (size_t k = 0; k < tables->half; ++k) {
+        uint32_t reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            reversed |= static_cast<uint32_t>((k >> b) & 1) << (bits - 1 - b);
+        }
+        tables->bitrev[k] = reversed;
+    }
+
+    for (size_t span = tables->radix2_first ? 2 : 1; span * 4 <= tables->half; span *= 4) {
+        tables->stage_span.push_back(static_cast<uint32_t>(span));
+        tables->stage_offset.push_back(tables->twiddles.size());
+        for (int power = 1; power <= 3; ++power) {
+            for (size_t k = 0; k < span; ++k) {
+                tables->twiddles.push_back(static_cast<float>(std::cos(-2.0 * pi * power * k / (4 * span))));
+            }
+            for (size_t k = 0; k < span; ++k) {
+                tables->twiddles.push_back(static_cast<float>(std::sin(-2.0 * pi * power * k / (4 * span))));
+            }
+        }
+    }
+
+    const size_t quarter = tables->half / 2;
+    tables->split_real.resize(quarter + 1);
+    tables->split_imag.resize(quarter + 1);
+    for (size_t k = 0; k <= quarter; ++k) {
+        tables->split_real[k] = static_cast<float>(std::cos(-2.0 * pi * k / size));
+        tables->split_imag[k] = static_cast<float>(std::sin(-2.0 * pi * k / size));
+    }
+    tables->split_real[quarter] = 0.0f;   // Exactly -i at N / 4
+    tables->split_imag[quarter] = -1.0f;
+
+    return tables;
+}
+
+} // namespace
+
+std::shared_ptr<const FFTTables> FFTTables::get(size_t size) {
+    if (size < MIN_SIZE || size > MAX_SIZE || (size & (size - 1)) != 0) {
+        return nullptr;
+    }
+
+    static std::mutex mutex;
+    static std::shared_ptr<const FFTTables> cache[25];
+
+    int log2_size = 0;
+    while ((size_t(1) << log2_size) < size) {
+        ++log2_size;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!cache[log2_size]) {
+        cache[log2_size] = build_tables(size);
+    }
+    return cache[log2_size];
+}
+
+const FFTKernels* get_fft_kernels(SimdLevel level) {
+    static const SimdLevel detected = detect_simd_level();
+    switch (level) {
+    case SimdLevel::Scalar:
+        return &SCALAR_FFT_KERNELS;
+#if AUDIO_FIR_X86
+    case SimdLevel::SSE2:
+        return detected != SimdLevel::Scalar ? &SSE2_FFT_KERNELS : nullptr;
+    case SimdLevel::AVX2:
+        return (detected == SimdLevel::AVX2 || detected == SimdLevel::AVX512) ? &AVX2_FFT_KERNELS : nullptr;
+#endif
+#if AUDIO_FIR_NEON
+    case SimdLevel::NEON:
+        return detected == SimdLevel::NEON ? &NEON_FFT_KERNELS : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const FFTKernels& get_fft_kernels() {
+    static const FFTKernels* best = [] {
+        const SimdLevel order[] = { SimdLevel::AVX2, SimdLevel::SSE2, SimdLevel::NEON };
+        for (SimdLevel level : order) {
+            if (const FFTKernels* kernels = get_fft_kernels(level)) {
+                return kernels;
+            }
+        }
+        return &SCALAR_FFT_KERNELS;
+    }();
+    return *best;
+}
+
+RealFFT::RealFFT()
+    : kernels_(&get_fft_kernels()) {
+}
+
+RealFFT::RealFFT(size_t size)
+    : kernels_(&get_fft_kernels()) {
+    initialize(size);
+}
+
+bool RealFFT::initialize(size_t size) {
+    std::shared_ptr<const FFTTables> tables = FFTTables::get(size);
+    if (!tables) {
+        return false;
+    }
+    tables_ = tables;
+    work_.assign(2 * tables_->half, 0.0f);
+    return true;
+}
+
+void RealFFT::forward(const float* input, float* real, float* imag) {
+    kernels_->forward_real(*tables_, input, real, imag, work_.data());
+}
+
+void RealFFT::inverse(const float* real, const float* imag, float* output) {
+    kernels_->inverse_real(*tables_, real, imag, output, work_.data());
+}
+
+} // namespace audio
@@ -0,0 +1,137 @@
+/**
+ * @file fft.h
+ * @brief Real-input FFT with cached tables and runtime-dispatched kernels
+ * @date 2026-10-17
+ */
+
+#pragma once
+
+#include "fir_kernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace audio {
+
+/**
+ * @brief Immutable tables for one transform size, shared by every RealFFT
+ * of that size
+ *
+ * A real transform of N points runs as a complex transform of N / 2
+ * points over the even/odd sample pairs, followed by a split pass that
+ * separates the two halves again. The complex transform is decimation in
+ * time: a bit-reversed load, an optional radix-2 pass when log2(N / 2) is
+ * odd, then radix-4 passes.
+ */
+struct FFTTables {
+    size_t size;                       // Real points N
+    size_t half;                       // Complex points N / 2
+    bool radix2_first;                 // log2(half) is odd
+    std::vector<uint32_t> bitrev;      // half entries
+
+    // Radix-4 passes in order; pass p has quarter span stage_span[p] and
+    // its twiddles at stage_offset[p]: w1, w2, w3 as real then imaginary
+    // runs of stage_span[p] values each
+    std::vector<uint32_t> stage_span;
+    std::vector<size_t> stage_offset;
+    std::vector<float> twiddles;
+
+    // exp(-2 pi i k / N) for k = 0..N / 4, for the split pass
+    std::vector<float> split_real;
+    std::vector<float> split_imag;
+
+    /**
+     * Get the tables for a size, building them on first use. Tables are
+     * kept for the life of the process; there are at most a few dozen.
+     * @param size Power of two, at least 4 and at most MAX_SIZE
+     * @return Shared tables, or nullptr if the size is invalid
+     */
+    static std::shared_ptr<const FFTTables> get(size_t size);
+
+    static constexpr size_t MIN_SIZE = 4;
+    static constexpr size_t MAX_SIZE = size_t(1) << 24;
+};
+
+/**
+ * Forward real transform: input holds tables.size samples, real and imag
+ * receive tables.half + 1 bins, work holds 2 * tables.half floats
+ */
+typedef void (*RealFFTKernel)(const FFTTables& tables, const float* input,
+                              float* real, float* imag, float* work);
+
+/**
+ * Inverse real transform: real and imag hold tables.half + 1 bins, output
+ * receives tables.size samples, work holds 2 * tables.half floats
+ */
+typedef void (*RealIFFTKernel)(const FFTTables& tables, const float* real,
+                               const float* imag, float* output, float* work);
+
+/**
+ * @brief FFT kernel for one instruction set
+ */
+struct FFTKernels {
+    SimdLevel level;
+    const char* name;
+    RealFFTKernel forward_real;
+    RealIFFTKernel inverse_real;
+};
+
+/**
+ * Get the fastest kernels this CPU supports (AVX-512 CPUs use AVX2)
+ */
+const FFTKernels& get_fft_kernels();
+
+/**
+ * Get the kernels for a specific instruction set
+ * @return Kernels, or nullptr if not built in or not supported by this CPU
+ */
+const FFTKernels* get_fft_kernels(SimdLevel level);
+
+/**
+ * @brief Unnormalized FFT of real samples
+ *
+ * Bin k of the forward result is sum(x[n] * exp(-2 pi i n k / N)) for
+ * k = 0..N / 2; the rest of the spectrum is the conjugate mirror. The
+ * inverse is unscaled too, so inverse(forward(x)) is N * x. One instance
+ * owns its scratch memory, so neither direction allocates; use one
+ * instance per thread.
+ */
+class RealFFT {
+public:
+    RealFFT();
+    explicit RealFFT(size_t size);
+
+    /**
+     * Set the transform size; allocates
+     * @return false if size is not a power of two in
+     *         [FFTTables::MIN_SIZE, FFTTables::MAX_SIZE]
+     */
+    bool initialize(size_t size);
+
+    size_t size() const { return tables_ ? tables_->size : 0; }
+    size_t bins() const { return tables_ ? tables_->half + 1 : 0; }
+
+    /**
+     * Transform size() samples into bins() complex values
+     */
+    void forward(const float* input, float* real, float* imag);
+
+    /**
+     * Transform bins() complex values into size() samples. The imaginary
+     * parts of bins 0 and size() / 2 are ignored.
+     */
+    void inverse(const float* real, const float* imag, float* output);
+
+    /**
+     * Use specific kernels instead of the detected ones, e.g. to test them
+     */
+    void set_kernels(const FFTKernels& kernels) { kernels_ = &kernels; }
+
+private:
+    std::shared_ptr<const FFTTables> tables_;
+    const FFTKernels* kernels_;
+    std::vector<float> work_;
+};
+
+} // namespace audio
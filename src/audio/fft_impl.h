@@ -0,0 +1,302 @@
+/**
+ * @file fft_impl.h
+ * @brief Vector-width generic FFT pass bodies shared by the per-ISA sources
+ * @date 2026-10-17
+ *
+ * Included only by fft*.cpp. Like fir_kernels_impl.h, each fft_<isa>.cpp
+ * is compiled for its own instruction set and instantiates these
+ * templates with its lane traits, so everything here stays in an unnamed
+ * namespace.
+ *
+ * Lane traits provide: reg, width, narrow (next smaller traits, used for
+ * spans shorter than a register), load(), store(), set1(), add(), sub(),
+ * mul() and reverse() (lanes in opposite order). Data is split into real
+ * and imaginary arrays, so one register holds the same part of width
+ * consecutive points and a complex multiply is four plain multiplies.
+ */
+
+#pragma once
+
+#include "fft.h"
+#include "fir_kernels_impl.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace audio {
+namespace {
+
+// One float per "register": the fallback for spans narrower than a vector
+struct ScalarLanes {
+    typedef float reg;
+    typedef ScalarLanes narrow;
+    static const size_t width = 1;
+
+    static reg load(const float* p) { return *p; }
+    static void store(float* p, reg v) { *p = v; }
+    static reg set1(float x) { return x; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg reverse(reg a) { return a; }
+};
+
+// Even samples become the real part and odd samples the imaginary part,
+// stored in bit-reversed order
+inline void load_bit_reversed(const FFTTables& tables, const float* input, float* re, float* im) {
+    const uint32_t* bitrev = tables.bitrev.data();
+    for (size_t k = 0; k < tables.half; ++k) {
+        const float* pair = input + 2 * static_cast<size_t>(bitrev[k]);
+        re[k] = pair[0];
+        im[k] = pair[1];
+    }
+}
+
+inline void radix2_first_pass(float* re, float* im, size_t half) {
+    for (size_t k = 0; k < half; k += 2) {
+        float ar = re[k], ai = im[k];
+        float br = re[k + 1], bi = im[k + 1];
+        re[k] = ar + br;
+        im[k] = ai + bi;
+        re[k + 1] = ar - br;
+        im[k + 1] = ai - bi;
+    }
+}
+
+// Quarter span 1: every twiddle is 1
+inline void radix4_first_pass(float* re, float* im, size_t half) {
+    for (size_t k = 0; k < half; k += 4) {
+        float t0r = re[k] + re[k + 1], t0i = im[k] + im[k + 1];
+        float t1r = re[k] - re[k + 1], t1i = im[k] - im[k + 1];
+        float t2r = re[k + 2] + re[k + 3], t2i = im[k + 2] + im[k + 3];
+        float t3r = re[k + 2] - re[k + 3], t3i = im[k + 2] - im[k + 3];
+        re[k] = t0r + t2r;
+        im[k] = t0i + t2i;
+        re[k + 1] = t1r + t3i;
+        im[k + 1] = t1i - t3r;
+        re[k + 2] = t0r - t2r;
+        im[k + 2] = t0i - t2i;
+        re[k + 3] = t1r - t3i;
+        im[k + 3] = t1i + t3r;
+    }
+}
+
+// Decimation-in-time radix-4 pass over blocks of 4 * span points. After
+// the bit-reversed load, the quarters of a block hold the sub-transforms
+// of residues 0, 2, 1 and 3, so quarter 1 takes w2 and quarter 2 takes w1.
+template <typename V>
+void radix4_pass(float* re, float* im, size_t half, size_t span, const float* twiddles) {
+    if (span < V::width) {
+        radix4_pass<typename V::narrow>(re, im, half, span, twiddles);
+        return;
+    }
+
+    const float* w1r = twiddles;
+    const float* w1i = twiddles + span;
+    const float* w2r = twiddles + 2 * span;
+    const float* w2i = twiddles + 3 * span;
+    const float* w3r = twiddles + 4 * span;
+    const float* w3i = twiddles + 5 * span;
+
+    for (size_t base = 0; base < half; base += 4 * span) {
+        float* r0 = re + base;
+        float* i0 = im + base;
+        float* r1 = r0 + span;
+        float* i1 = i0 + span;
+        float* r2 = r1 + span;
+        float* i2 = i1 + span;
+        float* r3 = r2 + span;
+        float* i3 = i2 + span;
+
+        for (size_t k = 0; k < span; k += V::width) {
+            typename V::reg ar = V::load(r0 + k), ai = V::load(i0 + k);
+
+            typename V::reg xr = V::load(r1 + k), xi = V::load(i1 + k);
+            typename V::reg wr = V::load(w2r + k), wi = V::load(w2i + k);
+            typename V::reg cr = V::sub(V::mul(xr, wr), V::mul(xi, wi));
+            typename V::reg ci = V::add(V::mul(xr, wi), V::mul(xi, wr));
+
+            xr = V::load(r2 + k); xi = V::load(i2 + k);
+            wr = V::load(w1r + k); wi = V::load(w1i + k);
+            typename V::reg br = V::sub(V::mul(xr, wr), V::mul(xi, wi));
+            typename V::reg bi = V::add(V::mul(xr, wi), V::mul(xi, wr));
+
+            xr = V::load(r3 + k); xi = V::load(i3 + k);
+            wr = V::load(w3r + k); wi = V::load(w3i + k);
+            typename V::reg dr = V::sub(V::mul(xr, wr), V::mul(xi, wi));
+            typename V::reg di = V::add(V::mul(xr, wi), V::mul(xi, wr));
+
+            typename V::reg t0r = V::add(ar, cr), t0i = V::add(ai, ci);
+            typename V::reg t1r = V::sub(ar, cr), t1i = V::sub(ai, ci);
+            typename V::reg t2r = V::add(br, dr), t2i = V::add(bi, di);
+            typename V::reg t3r = V::sub(br, dr), t3i = V::sub(bi, di);
+
+            V::store(r0 + k, V::add(t0r, t2r));
+            V::store(i0 + k, V::add(t0i, t2i));
+            V::store(r1 + k, V::add(t1r, t3i));   // t1 - i * t3
+            V::store(i1 + k, V::sub(t1i, t3r));
+            V::store(r2 + k, V::sub(t0r, t2r));
+            V::store(i2 + k, V::sub(t0i, t2i));
+            V::store(r3 + k, V::sub(t1r, t3i));   // t1 + i * t3
+            V::store(i3 + k, V::add(t1i, t3r));
+        }
+    }
+}
+
+// Separate the transforms of the even and odd samples, Z = E + i O:
+// X[k] = E[k] + W^k O[k] and X[half - k] = conj(E[k] - W^k O[k]), with
+// E[k] = (Z[k] + conj(Z[half - k])) / 2, O[k] = (Z[k] - conj(Z[half - k])) / 2i
+template <typename V>
+void split_pass(const FFTTables& tables, const float* re, const float* im,
+                float* real, float* imag) {
+    const size_t half = tables.half;
+    const size_t quarter = half / 2;
+    const float* wr_table = tables.split_real.data();
+    const float* wi_table = tables.split_imag.data();
+
+    real[0] = re[0] + im[0];
+    imag[0] = 0.0f;
+    real[half] = re[0] - im[0];
+    imag[half] = 0.0f;
+
+    const typename V::reg scale = V::set1(0.5f);
+    size_t k = 1;
+    for (; k + V::width <= quarter; k += V::width) {
+        const size_t m = half - k - (V::width - 1);   // Mirror block, reversed
+        typename V::reg zr = V::load(re + k), zi = V::load(im + k);
+        typename V::reg mr = V::reverse(V::load(re + m)), mi = V::reverse(V::load(im + m));
+
+        typename V::reg er = V::mul(V::add(zr, mr), scale);
+        typename V::reg ei = V::mul(V::sub(zi, mi), scale);
+        typename V::reg orr = V::mul(V::add(zi, mi), scale);
+        typename V::reg oi = V::mul(V::sub(mr, zr), scale);
+
+        typename V::reg wr = V::load(wr_table + k), wi = V::load(wi_table + k);
+        typename V::reg pr = V::sub(V::mul(wr, orr), V::mul(wi, oi));
+        typename V::reg pi = V::add(V::mul(wr, oi), V::mul(wi, orr));
+
+        V::store(real + k, V::add(er, pr));
+        V::store(imag + k, V::add(ei, pi));
+        V::store(real + m, V::reverse(V::sub(er, pr)));
+        V::store(imag + m, V::reverse(V::sub(pi, ei)));
+    }
+    for (; k <= quarter; ++k) {
+        const size_t m = half - k;
+        float er = 0.5f * (re[k] + re[m]);
+        float ei = 0.5f * (im[k] - im[m]);
+        float orr = 0.5f * (im[k] + im[m]);
+        float oi = 0.5f * (re[m] - re[k]);
+        float pr = wr_table[k] * orr - wi_table[k] * oi;
+        float pi = wr_table[k] * oi + wi_table[k] * orr;
+        real[k] = er + pr;
+        imag[k] = ei + pi;
+        real[m] = er - pr;
+        imag[m] = pi - ei;
+    }
+}
+
+// Undo split_pass, without its halving: Z[k] = (X[k] + conj(X[half - k]))
+// + i W^-k (X[k] - conj(X[half - k])). Z is written as planar arrays with
+// real and imaginary parts exchanged, ready for the forward passes to run
+// an inverse transform; W^(half - k) = -conj(W^k) gives the mirror bins.
+template <typename V>
+void unsplit_pass(const FFTTables& tables, const float* real, const float* imag,
+                  float* swapped_re, float* swapped_im) {
+    const size_t half = tables.half;
+    const size_t quarter = half / 2;
+    const float* wr_table = tables.split_real.data();
+    const float* wi_table = tables.split_imag.data();
+
+    swapped_im[0] = real[0] + real[half];
+    swapped_re[0] = real[0] - real[half];
+
+    size_t k = 1;
+    for (; k + V::width <= quarter; k += V::width) {
+        const size_t m = half - k - (V::width - 1);   // Mirror block, reversed
+        typename V::reg xr = V::load(real + k), xi = V::load(imag + k);
+        typename V::reg mr = V::reverse(V::load(real + m)), mi = V::reverse(V::load(imag + m));
+
+        typename V::reg er = V::add(xr, mr), ei = V::sub(xi, mi);
+        typename V::reg dr = V::sub(xr, mr), di = V::add(xi, mi);
+
+        typename V::reg wr = V::load(wr_table + k), wi = V::load(wi_table + k);
+        typename V::reg orr = V::add(V::mul(dr, wr), V::mul(di, wi));
+        typename V::reg oi = V::sub(V::mul(di, wr), V::mul(dr, wi));
+
+        V::store(swapped_im + k, V::sub(er, oi));
+        V::store(swapped_re + k, V::add(ei, orr));
+        V::store(swapped_im + m, V::reverse(V::add(er, oi)));
+        V::store(swapped_re + m, V::reverse(V::sub(orr, ei)));
+    }
+    for (; k <= quarter; ++k) {
+        const size_t m = half - k;
+        float er = real[k] + real[m], ei = imag[k] - imag[m];
+        float dr = real[k] - real[m], di = imag[k] + imag[m];
+        float orr = dr * wr_table[k] + di * wi_table[k];
+        float oi = di * wr_table[k] - dr * wi_table[k];
+        swapped_im[k] = er - oi;
+        swapped_re[k] = ei + orr;
+        swapped_im[m] = er + oi;
+        swapped_re[m] = orr - ei;
+    }
+}
+
+// Complex passes shared by both directions, over data already in
+// bit-reversed order
+template <typename V>
+void complex_passes(const FFTTables& tables, float* re, float* im) {
+    const size_t half = tables.half;
+    size_t pass = 0;
+    if (tables.radix2_first) {
+        radix2_first_pass(re, im, half);
+    } else if (!tables.stage_span.empty()) {
+        radix4_first_pass(re, im, half);
+        pass = 1;
+    }
+    for (; pass < tables.stage_span.size(); ++pass) {
+        radix4_pass<V>(re, im, half, tables.stage_span[pass],
+                       tables.twiddles.data() + tables.stage_offset[pass]);
+    }
+}
+
+template <typename V>
+void forward_real(const FFTTables& tables, const float* input,
+                  float* real, float* imag, float* work) {
+    const size_t half = tables.half;
+    float* re = work;
+    float* im = work + half;
+
+    load_bit_reversed(tables, input, re, im);
+    complex_passes<V>(tables, re, im);
+    split_pass<V>(tables, re, im, real, imag);
+}
+
+// Exchanging real and imaginary parts before and after a forward
+// transform gives the inverse one
+template <typename V>
+void inverse_real(const FFTTables& tables, const float* real, const float* imag,
+                  float* output, float* work) {
+    const size_t half = tables.half;
+    float* re = work;
+    float* im = work + half;
+
+    // The output doubles as scratch for Z until the final interleave
+    float* swapped_re = output;
+    float* swapped_im = output + half;
+    unsplit_pass<V>(tables, real, imag, swapped_re, swapped_im);
+
+    const uint32_t* bitrev = tables.bitrev.data();
+    for (size_t k = 0; k < half; ++k) {
+        re[k] = swapped_re[bitrev[k]];
+        im[k] = swapped_im[bitrev[k]];
+    }
+
+    complex_passes<V>(tables, re, im);
+
+    for (size_t k = 0; k < half; ++k) {
+        output[2 * k] = im[k];
+        output[2 * k + 1] = re[k];
+    }
+}
+
+} // namespace
+} // namespace audio
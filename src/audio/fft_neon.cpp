@@ -0,0 +1,49 @@
+/**
+ * @file fft_neon.cpp
+ * @brief NEON FFT kernel
+ * @date 2026-10-17
+ */
+
+#include "fft.h"
+#include "fft_impl.h"
+
+#if AUDIO_FIR_NEON
+
+#include <arm_neon.h>
+
+namespace audio {
+
+namespace {
+
+struct NeonLanes {
+    typedef float32x4_t reg;
+    typedef ScalarLanes narrow;
+    static const size_t width = 4;
+
+    static reg load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, reg v) { vst1q_f32(p, v); }
+    static reg set1(float x) { return vdupq_n_f32(x); }
+    static reg add(reg a, reg b) { return vaddq_f32(a, b); }
+    static reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+    static reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+    static reg reverse(reg a) {
+        float32x4_t pairs = vrev64q_f32(a);
+        return vcombine_f32(vget_high_f32(pairs), vget_low_f32(pairs));
+    }
+};
+
+} // namespace
+
+void fft_forward_real_neon(const FFTTables& tables, const float* input,
+                           float* real, float* imag, float* work) {
+    forward_real<NeonLanes>(tables, input, real, imag, work);
+}
+
+void fft_inverse_real_neon(const FFTTables& tables, const float* real,
+                           const float* imag, float* output, float* work) {
+    inverse_real<NeonLanes>(tables, real, imag, output, work);
+}
+
+} // namespace audio
+
+#endif // AUDIO_FIR_NEON
@@ -0,0 +1,46 @@
+/**
+ * @file fft_sse2.cpp
+ * @brief SSE2 FFT kernel (built with -msse2)
+ * @date 2026-10-17
+ */
+
+#include "fft.h"
+#include "fft_impl.h"
+
+#if AUDIO_FIR_X86
+
+#include <emmintrin.h>
+
+namespace audio {
+
+namespace {
+
+struct Sse2Lanes {
+    typedef __m128 reg;
+    typedef ScalarLanes narrow;
+    static const size_t width = 4;
+
+    static reg load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm_set1_ps(x); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg reverse(reg a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3)); }
+};
+
+} // namespace
+
+void fft_forward_real_sse2(const FFTTables& tables, const float* input,
+                           float* real, float* imag, float* work) {
+    forward_real<Sse2Lanes>(tables, input, real, imag, work);
+}
+
+void fft_inverse_real_sse2(const FFTTables& tables, const float* real,
+                           const float* imag, float* output, float* work) {
+    inverse_real<Sse2Lanes>(tables, real, imag, output, work);
+}
+
+} // namespace audio
+
+#endif // AUDIO_FIR_X86
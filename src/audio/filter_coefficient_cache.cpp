@@ -0,0 +1,168 @@
+/**
+ * @file filter_coefficient_cache.cpp
+ * @brief Process-wide store of immutable resampler filter tables
+ * @date 2025-12-10
+ */
+
+#include "filter_coefficient_cache.h"
+
+namespace audio {
+
+namespace {
+
+int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+} // namespace
+
+FilterCoefficientCache& FilterCoefficientCache::instance() {
+    static FilterCoefficientCache cache;
+    return cache;
+}
+
+FilterCoefficientCache::FilterCoefficientCache()
+    : pinned_bytes_(0)
+    , max_pinned_tables_(DEFAULT_MAX_PINNED_TABLES)
+    , max_pinned_bytes_(DEFAULT_MAX_PINNED_BYTES)
+    , hits_(0)
+    , misses_(0)
+    , evictions_(0) {
+}
+
+std::shared_ptr<const PolyphaseFilterBank> FilterCoefficientCache::get(int input_rate, int output_rate,
+                                                                      int taps, int phases,
+                                                                      PolyphaseFilterBank::Precision precision) {
+    if (input_rate <= 0 || output_rate <= 0 || taps <= 0 || phases <= 0) {
+        return nullptr;
+    }
+
+    // 44100->48000 and 88200->96000 share a table: only the ratio matters
+    const int divisor = gcd(input_rate, output_rate);
+    const double cutoff = PolyphaseFilterBank::cutoff_for(input_rate, output_rate);
+    const Key key(input_rate / divisor, output_rate / divisor, taps, phases,
+                  cutoff, PolyphaseFilterBank::KAISER_BETA, precision);
+
+    std::shared_ptr<Slot> slot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<Slot>& entry = slots_[key];
+        if (!entry) {
+            entry = std::make_shared<Slot>();
+        }
+        slot = entry;
+
+        std::shared_ptr<const PolyphaseFilterBank> table = slot->table.lock();
+        if (table) {
+            hits_++;
+            touch(key, table);
+            return table;
+        }
+    }
+
+    // Build without holding the cache lock; requests for the same key wait
+    // here and pick up the finished table
+    std::lock_guard<std::mutex> build_lock(slot->build_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<const PolyphaseFilterBank> table = slot->table.lock();
+        if (table) {
+            hits_++;
+            touch(key, table);
+            return table;
+        }
+    }
+
+    auto table = std::make_shared<const PolyphaseFilterBank>(taps, cutoff, phases, precision);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    slot->table = table;
+    misses_++;
+    touch(key, table);
+    return table;
+}
+
+void FilterCoefficientCache::touch(const Key& key, const std::shared_ptr<const PolyphaseFilterBank>& table) {
+    auto it = pins_.find(key);
+    if (it != pins_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        return;
+    }
+
+    lru_.push_front(key);
+    pins_[key] = Pin{ table, lru_.begin() };
+    pinned_bytes_ += table->get_memory_usage();
+    enforce_limits();
+}
+
+void FilterCoefficientCache::enforce_limits() {
+    bool evicted = false;
+    while (!lru_.empty() &&
+           (pins_.size() > max_pinned_tables_ || pinned_bytes_ > max_pinned_bytes_)) {
+        auto it = pins_.find(lru_.back());
+        pinned_bytes_ -= it->second.table->get_memory_usage();
+        pins_.erase(it);
+        lru_.pop_back();
+        evictions_++;
+        evicted = true;
+    }
+
+    if (evicted) {
+        prune_expired();
+    }
+}
+
+void FilterCoefficientCache::prune_expired() {
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        // A slot referenced elsewhere is being built
+        if (it->second.use_count() == 1 && it->second->table.expired()) {
+            it = slots_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FilterCoefficientCache::set_limits(size_t max_tables, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_pinned_tables_ = max_tables;
+    max_pinned_bytes_ = max_bytes;
+    enforce_limits();
+}
+
+FilterCoefficientCache::Stats FilterCoefficientCache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Stats stats = {};
+    for (const auto& [key, slot] : slots_) {
+        std::shared_ptr<const PolyphaseFilterBank> table = slot->table.lock();
+        if (table) {
+            stats.live_tables++;
+            stats.live_bytes += table->get_memory_usage();
+        }
+    }
+    stats.pinned_tables = pins_.size();
+    stats.pinned_bytes = pinned_bytes_;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.evictions = evictions_;
+    return stats;
+}
+
+void FilterCoefficientCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pins_.clear();
+    lru_.clear();
+    pinned_bytes_ = 0;
+    prune_expired();
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
+}
+
+} // namespace audio
@@ -0,0 +1,132 @@
+/**
+ * @file filter_coefficient_cache.h
+ * @brief Process-wide store of immutable resampler filter tables
+ * @date 2025-12-10
+ */
+
+#pragma once
+
+#include "polyphase_filter_bank.h"
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace audio {
+
+/**
+ * @brief Shared, reference-counted cache of PolyphaseFilterBank tables
+ *
+ * Tables are keyed by the reduced conversion ratio, taps, phases, cutoff,
+ * window and precision, so every stream converting 44100 -> 48000 (or 88200 ->
+ * 96000) with the same filter uses one table. Each table is built once,
+ * outside the cache lock, even when many threads ask for it at the same
+ * time. Tables are immutable, so converters read them without locking.
+ *
+ * Tables stay alive while any converter holds them. On top of that the
+ * cache pins the most recently used tables so that sessions opening and
+ * closing do not rebuild them. Pinned tables are limited by count and by
+ * bytes, and the least recently used ones are released first.
+ */
+class FilterCoefficientCache {
+public:
+    static constexpr size_t DEFAULT_MAX_PINNED_TABLES = 32;
+    static constexpr size_t DEFAULT_MAX_PINNED_BYTES = 8 * 1024 * 1024;
+
+    /**
+     * @brief Cache counters
+     */
+    struct Stats {
+        size_t live_tables;      // Tables alive (pinned or held by converters)
+        size_t live_bytes;       // Memory used by live tables
+        size_t pinned_tables;    // Tables kept alive by the cache itself
+        size_t pinned_bytes;     // Memory used by pinned tables
+        size_t hits;             // Requests served by an existing table
+        size_t misses;           // Requests that built a table
+        size_t evictions;        // Pinned tables released by the LRU limits
+    };
+
+    /**
+     * Get the process-wide cache
+     */
+    static FilterCoefficientCache& instance();
+
+    /**
+     * Get the table for a conversion, building it on first use
+     * @param input_rate Input sample rate
+     * @param output_rate Output sample rate
+     * @param taps Filter taps per phase
+     * @param phases Number of fractional phases
+     * @param precision Coefficient type to store
+     * @return Shared table, or nullptr if the parameters are invalid
+     */
+    std::shared_ptr<const PolyphaseFilterBank> get(int input_rate, int output_rate, int taps, int phases,
+                                                   PolyphaseFilterBank::Precision precision =
+                                                       PolyphaseFilterBank::Precision::Float);
+
+    /**
+     * Set the limits for pinned tables; evicts immediately if over
+     * @param max_tables Maximum number of pinned tables
+     * @param max_bytes Maximum memory used by pinned tables
+     */
+    void set_limits(size_t max_tables, size_t max_bytes);
+
+    /**
+     * Get the current counters
+     */
+    Stats get_stats() const;
+
+    /**
+     * Release all pinned tables and reset the counters.
+     * Tables still held by converters stay valid.
+     */
+    void clear();
+
+private:
+    // (input ratio, output ratio, taps, phases, cutoff, Kaiser beta, precision)
+    typedef std::tuple<int, int, int, int, double, double, PolyphaseFilterBank::Precision> Key;
+
+    struct Slot {
+        std::mutex build_mutex;                            // Serializes the one build
+        std::weak_ptr<const PolyphaseFilterBank> table;    // Guarded by the cache mutex
+    };
+
+    struct Pin {
+        std::shared_ptr<const PolyphaseFilterBank> table;
+        std::list<Key>::iterator lru_position;
+    };
+
+    FilterCoefficientCache();
+
+    /**
+     * Mark a table most recently used and apply the limits.
+     * Caller holds mutex_.
+     */
+    void touch(const Key& key, const std::shared_ptr<const PolyphaseFilterBank>& table);
+
+    /**
+     * Release least recently used pins until within the limits.
+     * Caller holds mutex_.
+     */
+    void enforce_limits();
+
+    /**
+     * Drop slots whose table has expired. Caller holds mutex_.
+     */
+    void prune_expired();
+
+    mutable std::mutex mutex_;
+    std::map<Key, std::shared_ptr<Slot>> slots_;
+    std::map<Key, Pin> pins_;
+    std::list<Key> lru_;                 // Most recently used first
+    size_t pinned_bytes_;
+    size_t max_pinned_tables_;
+    size_t max_pinned_bytes_;
+    size_t hits_;
+    size_t misses_;
+    size_t evictions_;
+};
+
+} // namespace audio
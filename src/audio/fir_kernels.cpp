@@ -0,0 +1,241 @@
+/**
+ * @file fir_kernels.cpp
+ * @brief Scalar reference kernels and runtime instruction set dispatch
+ * @date 2025-12-10
+ */
+
+#include "fir_kernels.h"
+#include "fir_kernels_impl.h"
+#include <cstdint>
+
+#if AUDIO_FIR_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if AUDIO_FIR_NEON && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace audio {
+
+// Per-ISA kernels, each in its own translation unit
+#if AUDIO_FIR_X86
+void fir_float_sse2(const float*, const float*, int, int, float*);
+void fir_double_sse2(const double*, const double*, int, int, double*);
+void fir_mixed_sse2(const float*, const float*, int, int, float*);
+FirKernelFloat select_fir_float_sse2(int taps, int channels);
+void fir_float_avx2(const float*, const float*, int, int, float*);
+void fir_double_avx2(const double*, const double*, int, int, double*);
+void fir_mixed_avx2(const float*, const float*, int, int, float*);
+FirKernelFloat select_fir_float_avx2(int taps, int channels);
+void fir_float_avx512(const float*, const float*, int, int, float*);
+void fir_double_avx512(const double*, const double*, int, int, double*);
+void fir_mixed_avx512(const float*, const float*, int, int, float*);
+FirKernelFloat select_fir_float_avx512(int taps, int channels);
+#endif
+#if AUDIO_FIR_NEON
+void fir_float_neon(const float*, const float*, int, int, float*);
+void fir_double_neon(const double*, const double*, int, int, double*);
+void fir_mixed_neon(const float*, const float*, int, int, float*);
+FirKernelFloat select_fir_float_neon(int taps, int channels);
+#endif
+
+void fir_float_scalar(const float* input, const float* coefficients,
+                      int taps, int channels, float* output) {
+    for (int ch = 0; ch < channels; ++ch) {
+        float sum = 0.0f;
+        for (int i = 0; i < taps; ++i) {
+            sum += input[i * channels + ch] * coefficients[i];
+        }
+        output[ch] = sum;
+    }
+}
+
+void fir_double_scalar(const double* input, const double* coefficients,
+                       int taps, int channels, double* output) {
+    for (int ch = 0; ch < channels; ++ch) {
+        double sum = 0.0;
+        for (int i = 0; i < taps; ++i) {
+            sum += input[i * channels + ch] * coefficients[i];
+        }
+        output[ch] = sum;
+    }
+}
+
+void fir_mixed_scalar(const float* input, const float* coefficients,
+                      int taps, int channels, float* output) {
+    for (int ch = 0; ch < channels; ++ch) {
+        double sum = 0.0;
+        for (int i = 0; i < taps; ++i) {
+            sum += static_cast<double>(input[i * channels + ch]) * coefficients[i];
+        }
+        output[ch] = static_cast<float>(sum);
+    }
+}
+
+namespace {
+
+// Scalar loops with constant bounds, for CPUs without a vector kernel
+struct ScalarShapes {
+    template <int Channels, int Taps>
+    static void run(const float* input, const float* coefficients, int, int, float* output) {
+        float sums[Channels] = {};
+        for (int i = 0; i < Taps; ++i) {
+            for (int ch = 0; ch < Channels; ++ch) {
+                sums[ch] += input[i * Channels + ch] * coefficients[i];
+            }
+        }
+        for (int ch = 0; ch < Channels; ++ch) {
+            output[ch] = sums[ch];
+        }
+    }
+};
+
+FirKernelFloat select_fir_float_scalar(int taps, int channels) {
+    return select_fixed_shape<ScalarShapes>(taps, channels);
+}
+
+#if AUDIO_FIR_X86
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<uint32_t>(info[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switch (XCR0)
+uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+const FirKernels SCALAR_KERNELS = {
+    SimdLevel::Scalar, "scalar", fir_float_scalar, fir_double_scalar, fir_mixed_scalar,
+    select_fir_float_scalar
+};
+#if AUDIO_FIR_X86
+const FirKernels SSE2_KERNELS = {
+    SimdLevel::SSE2, "sse2", fir_float_sse2, fir_double_sse2, fir_mixed_sse2,
+    select_fir_float_sse2
+};
+const FirKernels AVX2_KERNELS = {
+    SimdLevel::AVX2, "avx2", fir_float_avx2, fir_double_avx2, fir_mixed_avx2,
+    select_fir_float_avx2
+};
+const FirKernels AVX512_KERNELS = {
+    SimdLevel::AVX512, "avx512", fir_float_avx512, fir_double_avx512, fir_mixed_avx512,
+    select_fir_float_avx512
+};
+#endif
+#if AUDIO_FIR_NEON
+const FirKernels NEON_KERNELS = {
+    SimdLevel::NEON, "neon", fir_float_neon, fir_double_neon, fir_mixed_neon,
+    select_fir_float_neon
+};
+#endif
+
+} // namespace
+
+SimdLevel detect_simd_level() {
+#if AUDIO_FIR_X86
+    uint32_t regs[4] = { 0, 0, 0, 0 };
+    cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    const bool sse2 = (regs[3] & (1u << 26)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    const bool fma = (regs[2] & (1u << 12)) != 0;
+
+    bool avx2 = false;
+    bool avx512f = false;
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        avx2 = (regs[1] & (1u << 5)) != 0;
+        avx512f = (regs[1] & (1u << 16)) != 0;
+    }
+
+    // The OS must also save the wider registers
+    const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    const bool ymm_state = (xcr0 & 0x6) == 0x6;
+    const bool zmm_state = (xcr0 & 0xE6) == 0xE6;
+
+    if (avx512f && avx2 && fma && zmm_state) {
+        return SimdLevel::AVX512;
+    }
+    if (avx2 && avx && fma && ymm_state) {
+        return SimdLevel::AVX2;
+    }
+    if (sse2) {
+        return SimdLevel::SSE2;
+    }
+    return SimdLevel::Scalar;
+#elif AUDIO_FIR_NEON
+#if defined(__aarch64__) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) ? SimdLevel::NEON : SimdLevel::Scalar;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) ? SimdLevel::NEON : SimdLevel::Scalar;
+#else
+    return SimdLevel::NEON;  // Built with NEON enabled: the target guarantees it
+#endif
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const FirKernels* get_fir_kernels(SimdLevel level) {
+    const SimdLevel supported = detect_simd_level();
+
+    switch (level) {
+    case SimdLevel::Scalar:
+        return &SCALAR_KERNELS;
+#if AUDIO_FIR_X86
+    case SimdLevel::SSE2:
+        return supported >= SimdLevel::SSE2 ? &SSE2_KERNELS : nullptr;
+    case SimdLevel::AVX2:
+        return supported >= SimdLevel::AVX2 ? &AVX2_KERNELS : nullptr;
+    case SimdLevel::AVX512:
+        return supported >= SimdLevel::AVX512 ? &AVX512_KERNELS : nullptr;
+#endif
+#if AUDIO_FIR_NEON
+    case SimdLevel::NEON:
+        return supported == SimdLevel::NEON ? &NEON_KERNELS : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const FirKernels& get_fir_kernels() {
+    static const FirKernels* kernels = get_fir_kernels(detect_simd_level());
+    return kernels ? *kernels : SCALAR_KERNELS;
+}
+
+FirKernelFloat get_fir_kernel_float(const FirKernels& kernels, int taps, int channels) {
+    FirKernelFloat fixed = kernels.fixed_float ? kernels.fixed_float(taps, channels) : nullptr;
+    return fixed ? fixed : kernels.fir_float;
+}
+
+FirKernelFloat get_fir_kernel_float(int taps, int channels) {
+    return get_fir_kernel_float(get_fir_kernels(), taps, channels);
+}
+
+} // namespace audio
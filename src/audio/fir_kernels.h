@@ -0,0 +1,85 @@
+/**
+ * @file fir_kernels.h
+ * @brief Runtime-dispatched FIR dot-product kernels for interleaved audio
+ * @date 2025-12-10
+ */
+
+#pragma once
+
+namespace audio {
+
+/**
+ * @brief Instruction set used by a kernel
+ */
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,     // AVX2 + FMA
+    AVX512,   // AVX-512F
+    NEON
+};
+
+/**
+ * FIR over interleaved frames:
+ * output[ch] = sum(input[i * channels + ch] * coefficients[i]) for i < taps
+ */
+typedef void (*FirKernelFloat)(const float* input, const float* coefficients,
+                               int taps, int channels, float* output);
+typedef void (*FirKernelDouble)(const double* input, const double* coefficients,
+                                int taps, int channels, double* output);
+
+/**
+ * Kernel compiled for exactly one tap count and channel count (the taps
+ * and channels arguments of the returned kernel are ignored), or nullptr
+ * if that shape has no specialization
+ */
+typedef FirKernelFloat (*FirKernelSelector)(int taps, int channels);
+
+/**
+ * @brief Kernel set for one instruction set
+ */
+struct FirKernels {
+    SimdLevel level;
+    const char* name;
+    FirKernelFloat fir_float;
+    FirKernelDouble fir_double;
+    FirKernelFloat fir_mixed;        // Float samples, double accumulators
+    FirKernelSelector fixed_float;   // 1/2/4/6/8 channels x 8/9/16/17/32/33/64/65 taps
+};
+
+/**
+ * Get the fastest kernels this CPU supports.
+ * Detected once (CPUID on x86, HWCAP on ARM); safe from any thread.
+ */
+const FirKernels& get_fir_kernels();
+
+/**
+ * Get the kernels for a specific instruction set
+ * @return Kernels, or nullptr if not built in or not supported by this CPU
+ */
+const FirKernels* get_fir_kernels(SimdLevel level);
+
+/**
+ * Get the float kernel for a filter shape that stays fixed, e.g. for the
+ * lifetime of a converter. Common shapes get a kernel specialized at
+ * compile time; anything else gets the generic kernel.
+ */
+FirKernelFloat get_fir_kernel_float(int taps, int channels);
+FirKernelFloat get_fir_kernel_float(const FirKernels& kernels, int taps, int channels);
+
+/**
+ * Detect the best instruction set supported by this CPU and OS
+ */
+SimdLevel detect_simd_level();
+
+/**
+ * Scalar reference kernels, used to validate the vector versions
+ */
+void fir_float_scalar(const float* input, const float* coefficients,
+                      int taps, int channels, float* output);
+void fir_double_scalar(const double* input, const double* coefficients,
+                       int taps, int channels, double* output);
+void fir_mixed_scalar(const float* input, const float* coefficients,
+                      int taps, int channels, float* output);
+
+} // namespace audio
@@ -0,0 +1,158 @@
+/**
+ * @file fir_kernels_avx512.cpp
+ * @brief AVX-512F FIR kernels (built with -mavx512f or /arch:AVX512)
+ * @date 2025-12-10
+ */
+
+#include "fir_kernels.h"
+#include "fir_kernels_impl.h"
+
+#if AUDIO_FIR_X86
+
+#include <immintrin.h>
+
+namespace audio {
+
+namespace {
+
+struct Fma128Float {
+    typedef __m128 reg;
+    typedef NoVector narrow;
+    static const int width = 4;
+
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm_set1_ps(x); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm_fmadd_ps(a, b, acc); }
+    static reg dup_pairs(const float* c) { return _mm_set_ps(c[1], c[1], c[0], c[0]); }
+};
+
+struct Fma256Float {
+    typedef __m256 reg;
+    typedef Fma128Float narrow;
+    static const int width = 8;
+
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm256_set1_ps(x); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm256_fmadd_ps(a, b, acc); }
+    static reg dup_pairs(const float* c) {
+        __m128 v = _mm_loadu_ps(c);
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(v, v)), _mm_unpackhi_ps(v, v), 1);
+    }
+};
+
+struct Avx512Float {
+    typedef __m512 reg;
+    typedef Fma256Float narrow;
+    static const int width = 16;
+
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm512_set1_ps(x); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm512_fmadd_ps(a, b, acc); }
+    static reg dup_pairs(const float* c) {
+        const __m512i index = _mm512_set_epi32(7, 7, 6, 6, 5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0, 0);
+        // Zero-masked forms: GCC warns about the undefined lanes of the plain ones
+        return _mm512_maskz_permutexvar_ps(0xFFFF, index, _mm512_maskz_loadu_ps(0x00FF, c));
+    }
+};
+
+struct Fma128Double {
+    typedef __m128d reg;
+    typedef NoVector narrow;
+    static const int width = 2;
+
+    static reg zero() { return _mm_setzero_pd(); }
+    static reg load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+    static reg set1(double x) { return _mm_set1_pd(x); }
+    static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm_fmadd_pd(a, b, acc); }
+    static reg dup_pairs(const double* c) { return _mm_set1_pd(c[0]); }
+
+    // Float memory, for the mixed precision kernel
+    static reg load(const float* p) {
+        return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+    }
+    static void store(float* p, reg v) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_castps_si128(_mm_cvtpd_ps(v)));
+    }
+    static reg dup_pairs(const float* c) { return _mm_set1_pd(c[0]); }
+};
+
+struct Fma256Double {
+    typedef __m256d reg;
+    typedef Fma128Double narrow;
+    static const int width = 4;
+
+    static reg zero() { return _mm256_setzero_pd(); }
+    static reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+    static reg set1(double x) { return _mm256_set1_pd(x); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm256_fmadd_pd(a, b, acc); }
+    static reg dup_pairs(const double* c) {
+        return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_set1_pd(c[0])), _mm_set1_pd(c[1]), 1);
+    }
+
+    // Float memory, for the mixed precision kernel
+    static reg load(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+    static void store(float* p, reg v) { _mm_storeu_ps(p, _mm256_cvtpd_ps(v)); }
+    static reg dup_pairs(const float* c) { return _mm256_set_pd(c[1], c[1], c[0], c[0]); }
+};
+
+struct Avx512Double {
+    typedef __m512d reg;
+    typedef Fma256Double narrow;
+    static const int width = 8;
+
+    static reg zero() { return _mm512_setzero_pd(); }
+    static reg load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+    static reg set1(double x) { return _mm512_set1_pd(x); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm512_fmadd_pd(a, b, acc); }
+    static reg dup_pairs(const double* c) {
+        const __m512i index = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+        return _mm512_maskz_permutexvar_pd(0xFF, index, _mm512_maskz_loadu_pd(0x0F, c));
+    }
+
+    // Float memory, for the mixed precision kernel
+    static reg load(const float* p) { return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(p)); }
+    static void store(float* p, reg v) { _mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps(0xFF, v)); }
+    static reg dup_pairs(const float* c) {
+        const __m512i index = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+        // The index only reads the low four lanes, so the upper half may stay undefined
+        const __m512d widened = _mm512_castpd256_pd512(_mm256_cvtps_pd(_mm_loadu_ps(c)));
+        return _mm512_maskz_permutexvar_pd(0xFF, index, widened);
+    }
+};
+
+} // namespace
+
+void fir_float_avx512(const float* input, const float* coefficients, int taps, int channels, float* output) {
+    fir_interleaved<Avx512Float>(input, coefficients, taps, channels, output);
+}
+
+FirKernelFloat select_fir_float_avx512(int taps, int channels) {
+    return select_fixed_shape<VectorShapes<Avx512Float>>(taps, channels);
+}
+
+void fir_double_avx512(const double* input, const double* coefficients, int taps, int channels, double* output) {
+    fir_interleaved<Avx512Double>(input, coefficients, taps, channels, output);
+}
+
+void fir_mixed_avx512(const float* input, const float* coefficients, int taps, int channels, float* output) {
+    fir_mixed<Avx512Double>(input, coefficients, taps, channels, output);
+}
+
+} // namespace audio
+
+#endif // AUDIO_FIR_X86
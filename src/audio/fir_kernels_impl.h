@@ -0,0 +1,201 @@
+/**
+ * @file fir_kernels_impl.h
+ * @brief Vector-width generic FIR kernel bodies shared by the per-ISA sources
+ * @date 2025-12-10
+ *
+ * Included only by fir_kernels*.cpp. Each fir_kernels_<isa>.cpp is
+ * compiled for its own instruction set and instantiates these templates
+ * with its vector traits, so everything here stays in an unnamed
+ * namespace: instantiations built for different instruction sets must
+ * never be merged by the linker.
+ *
+ * Vector traits provide: reg, width, narrow (next smaller traits or
+ * NoVector), zero(), load(), store(), set1(), add(), fmadd(a, b, acc)
+ * and dup_pairs(c) (c[0], c[0], c[1], c[1], ... across the register).
+ * Double traits also load, store and dup_pairs float memory, converting
+ * on the way; with Acc = double and T = float that gives the mixed
+ * precision kernels.
+ *
+ * A non-zero FixedChannels / FixedTaps replaces the runtime argument with a
+ * compile-time constant, so the loops unroll and the accumulators stay in
+ * registers; select_fixed_shape() maps a runtime shape to one of those
+ * instantiations.
+ */
+
+#pragma once
+
+#include "fir_kernels.h"
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AUDIO_FIR_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define AUDIO_FIR_NEON 1
+#define AUDIO_FIR_NEON_DOUBLE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AUDIO_FIR_NEON 1
+#endif
+
+namespace audio {
+namespace {
+
+// Ends the chain of narrower vector types
+struct NoVector {
+    static const int width = 0;
+};
+
+// Channels in blocks of the vector width: each coefficient is broadcast
+// and applied to adjacent channels of one frame
+template <typename V, typename T, int FixedChannels = 0, int FixedTaps = 0>
+struct ChannelBlocks {
+    static int run(const T* input, const T* coefficients, int taps, int channels, T* output, int ch) {
+        if (FixedTaps > 0) taps = FixedTaps;
+        if (FixedChannels > 0) channels = FixedChannels;
+
+        for (; ch + V::width <= channels; ch += V::width) {
+            typename V::reg acc = V::zero();
+            for (int i = 0; i < taps; ++i) {
+                acc = V::fmadd(V::load(input + i * channels + ch), V::set1(coefficients[i]), acc);
+            }
+            V::store(output + ch, acc);
+        }
+        if (V::narrow::width == 0 && ch < channels && channels > V::width) {
+            // Leftover channels of the narrowest vector: one block ending at
+            // the last channel, overlapping (and rewriting) ones already done
+            ch = channels - V::width;
+            typename V::reg acc = V::zero();
+            for (int i = 0; i < taps; ++i) {
+                acc = V::fmadd(V::load(input + i * channels + ch), V::set1(coefficients[i]), acc);
+            }
+            V::store(output + ch, acc);
+            return channels;
+        }
+        return ChannelBlocks<typename V::narrow, T, FixedChannels, FixedTaps>::run(
+            input, coefficients, taps, channels, output, ch);
+    }
+};
+
+template <typename T, int FixedChannels, int FixedTaps>
+struct ChannelBlocks<NoVector, T, FixedChannels, FixedTaps> {
+    static int run(const T*, const T*, int, int, T*, int ch) { return ch; }
+};
+
+template <typename V, typename T, int FixedChannels = 0, int FixedTaps = 0, typename Acc = T>
+void fir_interleaved(const T* input, const T* coefficients, int taps, int channels, T* output) {
+    if (FixedTaps > 0) taps = FixedTaps;
+    if (FixedChannels > 0) channels = FixedChannels;
+
+    const int width = V::width;
+    Acc lanes[V::width];
+
+    if (channels == 1) {
+        // Plain dot product, two accumulators to hide FMA latency
+        typename V::reg acc0 = V::zero();
+        typename V::reg acc1 = V::zero();
+        int i = 0;
+        for (; i + 2 * width <= taps; i += 2 * width) {
+            acc0 = V::fmadd(V::load(input + i), V::load(coefficients + i), acc0);
+            acc1 = V::fmadd(V::load(input + i + width), V::load(coefficients + i + width), acc1);
+        }
+        for (; i + width <= taps; i += width) {
+            acc0 = V::fmadd(V::load(input + i), V::load(coefficients + i), acc0);
+        }
+        V::store(lanes, V::add(acc0, acc1));
+
+        Acc sum = 0;
+        for (int j = 0; j < width; ++j) {
+            sum += lanes[j];
+        }
+        for (; i < taps; ++i) {
+            sum += static_cast<Acc>(input[i]) * coefficients[i];
+        }
+        output[0] = static_cast<T>(sum);
+        return;
+    }
+
+    if (channels == 2) {
+        // Each register holds width / 2 stereo frames; coefficients are
+        // duplicated to line up with left and right
+        const int frames = width / 2;
+        typename V::reg acc = V::zero();
+        int i = 0;
+        for (; i + frames <= taps; i += frames) {
+            acc = V::fmadd(V::load(input + 2 * i), V::dup_pairs(coefficients + i), acc);
+        }
+        V::store(lanes, acc);
+
+        Acc left = 0;
+        Acc right = 0;
+        for (int j = 0; j < width; j += 2) {
+            left += lanes[j];
+            right += lanes[j + 1];
+        }
+        for (; i < taps; ++i) {
+            const size_t frame = 2 * static_cast<size_t>(i);
+            left += static_cast<Acc>(input[frame]) * coefficients[i];
+            right += static_cast<Acc>(input[frame + 1]) * coefficients[i];
+        }
+        output[0] = static_cast<T>(left);
+        output[1] = static_cast<T>(right);
+        return;
+    }
+
+    int ch = ChannelBlocks<V, T, FixedChannels, FixedTaps>::run(input, coefficients, taps, channels, output, 0);
+    for (; ch < channels; ++ch) {
+        Acc sum = 0;
+        for (int i = 0; i < taps; ++i) {
+            sum += static_cast<Acc>(input[static_cast<size_t>(i) * channels + ch]) * coefficients[i];
+        }
+        output[ch] = static_cast<T>(sum);
+    }
+}
+
+// Float samples and coefficients, double accumulators
+template <typename VDouble>
+void fir_mixed(const float* input, const float* coefficients, int taps, int channels, float* output) {
+    fir_interleaved<VDouble, float, 0, 0, double>(input, coefficients, taps, channels, output);
+}
+
+// Float kernels for one vector type at every specialized shape
+template <typename V>
+struct VectorShapes {
+    template <int Channels, int Taps>
+    static void run(const float* input, const float* coefficients, int, int, float* output) {
+        fir_interleaved<V, float, Channels, Taps>(input, coefficients, Taps, Channels, output);
+    }
+};
+
+template <typename Shapes, int Channels>
+FirKernelFloat select_fixed_taps(int taps) {
+    // The 8/16/32/64 tap qualities, plus the odd lengths the symmetric
+    // sinc filters round them up to
+    switch (taps) {
+    case 8:  return &Shapes::template run<Channels, 8>;
+    case 9:  return &Shapes::template run<Channels, 9>;
+    case 16: return &Shapes::template run<Channels, 16>;
+    case 17: return &Shapes::template run<Channels, 17>;
+    case 32: return &Shapes::template run<Channels, 32>;
+    case 33: return &Shapes::template run<Channels, 33>;
+    case 64: return &Shapes::template run<Channels, 64>;
+    case 65: return &Shapes::template run<Channels, 65>;
+    default: return nullptr;
+    }
+}
+
+// Mono, stereo, quad, 5.1 and 7.1; nullptr for any other shape
+template <typename Shapes>
+FirKernelFloat select_fixed_shape(int taps, int channels) {
+    switch (channels) {
+    case 1: return select_fixed_taps<Shapes, 1>(taps);
+    case 2: return select_fixed_taps<Shapes, 2>(taps);
+    case 4: return select_fixed_taps<Shapes, 4>(taps);
+    case 6: return select_fixed_taps<Shapes, 6>(taps);
+    case 8: return select_fixed_taps<Shapes, 8>(taps);
+    default: return nullptr;
+    }
+}
+
+} // namespace
+} // namespace audio
@@ -0,0 +1,81 @@
+/**
+ * @file fir_kernels_neon.cpp
+ * @brief NEON FIR kernels (double precision on AArch64 only)
+ * @date 2025-12-10
+ */
+
+#include "fir_kernels.h"
+#include "fir_kernels_impl.h"
+
+#if AUDIO_FIR_NEON
+
+#include <arm_neon.h>
+
+namespace audio {
+
+namespace {
+
+struct NeonFloat {
+    typedef float32x4_t reg;
+    typedef NoVector narrow;
+    static const int width = 4;
+
+    static reg zero() { return vdupq_n_f32(0.0f); }
+    static reg load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, reg v) { vst1q_f32(p, v); }
+    static reg set1(float x) { return vdupq_n_f32(x); }
+    static reg add(reg a, reg b) { return vaddq_f32(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return vmlaq_f32(acc, a, b); }
+    static reg dup_pairs(const float* c) { return vcombine_f32(vdup_n_f32(c[0]), vdup_n_f32(c[1])); }
+};
+
+#if AUDIO_FIR_NEON_DOUBLE
+struct NeonDouble {
+    typedef float64x2_t reg;
+    typedef NoVector narrow;
+    static const int width = 2;
+
+    static reg zero() { return vdupq_n_f64(0.0); }
+    static reg load(const double* p) { return vld1q_f64(p); }
+    static void store(double* p, reg v) { vst1q_f64(p, v); }
+    static reg set1(double x) { return vdupq_n_f64(x); }
+    static reg add(reg a, reg b) { return vaddq_f64(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return vfmaq_f64(acc, a, b); }
+    static reg dup_pairs(const double* c) { return vdupq_n_f64(c[0]); }
+
+    // Float memory, for the mixed precision kernel
+    static reg load(const float* p) { return vcvt_f64_f32(vld1_f32(p)); }
+    static void store(float* p, reg v) { vst1_f32(p, vcvt_f32_f64(v)); }
+    static reg dup_pairs(const float* c) { return vdupq_n_f64(c[0]); }
+};
+#endif
+
+} // namespace
+
+void fir_float_neon(const float* input, const float* coefficients, int taps, int channels, float* output) {
+    fir_interleaved<NeonFloat>(input, coefficients, taps, channels, output);
+}
+
+FirKernelFloat select_fir_float_neon(int taps, int channels) {
+    return select_fixed_shape<VectorShapes<NeonFloat>>(taps, channels);
+}
+
+void fir_double_neon(const double* input, const double* coefficients, int taps, int channels, double* output) {
+#if AUDIO_FIR_NEON_DOUBLE
+    fir_interleaved<NeonDouble>(input, coefficients, taps, channels, output);
+#else
+    fir_double_scalar(input, coefficients, taps, channels, output);
+#endif
+}
+
+void fir_mixed_neon(const float* input, const float* coefficients, int taps, int channels, float* output) {
+#if AUDIO_FIR_NEON_DOUBLE
+    fir_mixed<NeonDouble>(input, coefficients, taps, channels, output);
+#else
+    fir_mixed_scalar(input, coefficients, taps, channels, output);
+#endif
+}
+
+} // namespace audio
+
+#endif // AUDIO_FIR_NEON
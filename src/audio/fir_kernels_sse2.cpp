@@ -0,0 +1,75 @@
+/**
+ * @file fir_kernels_sse2.cpp
+ * @brief SSE2 FIR kernels
+ * @date 2025-12-10
+ */
+
+#include "fir_kernels.h"
+#include "fir_kernels_impl.h"
+
+#if AUDIO_FIR_X86
+
+#include <emmintrin.h>
+
+namespace audio {
+
+namespace {
+
+struct Sse2Float {
+    typedef __m128 reg;
+    typedef NoVector narrow;
+    static const int width = 4;
+
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm_set1_ps(x); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm_add_ps(_mm_mul_ps(a, b), acc); }
+    static reg dup_pairs(const float* c) { return _mm_set_ps(c[1], c[1], c[0], c[0]); }
+};
+
+struct Sse2Double {
+    typedef __m128d reg;
+    typedef NoVector narrow;
+    static const int width = 2;
+
+    static reg zero() { return _mm_setzero_pd(); }
+    static reg load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+    static reg set1(double x) { return _mm_set1_pd(x); }
+    static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg acc) { return _mm_add_pd(_mm_mul_pd(a, b), acc); }
+    static reg dup_pairs(const double* c) { return _mm_set1_pd(c[0]); }
+
+    // Float memory, for the mixed precision kernel
+    static reg load(const float* p) {
+        return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+    }
+    static void store(float* p, reg v) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_castps_si128(_mm_cvtpd_ps(v)));
+    }
+    static reg dup_pairs(const float* c) { return _mm_set1_pd(c[0]); }
+};
+
+} // namespace
+
+void fir_float_sse2(const float* input, const float* coefficients, int taps, int channels, float* output) {
+    fir_interleaved<Sse2Float>(input, coefficients, taps, channels, output);
+}
+
+FirKernelFloat select_fir_float_sse2(int taps, int channels) {
+    return select_fixed_shape<VectorShapes<Sse2Float>>(taps, channels);
+}
+
+void fir_double_sse2(const double* input, const double* coefficients, int taps, int channels, double* output) {
+    fir_interleaved<Sse2Double>(input, coefficients, taps, channels, output);
+}
+
+void fir_mixed_sse2(const float* input, const float* coefficients, int taps, int channels, float* output) {
+    fir_mixed<Sse2Double>(input, coefficients, taps, channels, output);
+}
+
+} // namespace audio
+
+#endif // AUDIO_FIR_X86
@@ -0,0 +1,78 @@
+/**
+ * @file polyphase_filter_bank.cpp
+ * @brief Precomputed windowed sinc filter table implementation
+ * @date 2025-12-10
+ */
+
+#include "polyphase_filter_bank.h"
+#include "filter_coefficient_cache.h"
+#include <cmath>
+
+namespace audio {
+
+PolyphaseFilterBank::PolyphaseFilterBank(int taps, double cutoff, int phases, Precision precision)
+    : taps_(taps)
+    , phases_(phases)
+    , cutoff_(cutoff)
+    , precision_(precision) {
+
+    const int half_taps = taps_ / 2;
+    const size_t size = static_cast<size_t>(phases_ + 1) * taps_;
+    if (precision_ == Precision::Double) {
+        table_double_.resize(size);
+    } else {
+        table_.resize(size);
+    }
+
+    std::vector<double> values(taps_);
+    for (int p = 0; p <= phases_; ++p) {
+        const double frac = static_cast<double>(p) / phases_;
+
+        double sum = 0.0;
+        for (int i = 0; i < taps_; ++i) {
+            values[i] = evaluate((i - half_taps) - frac, cutoff_, half_taps);
+            sum += values[i];
+        }
+
+        // Unity gain at DC for every phase
+        const double scale = sum != 0.0 ? 1.0 / sum : 1.0;
+        const size_t row = static_cast<size_t>(p) * taps_;
+        for (int i = 0; i < taps_; ++i) {
+            if (precision_ == Precision::Double) {
+                table_double_[row + i] = values[i] * scale;
+            } else {
+                table_[row + i] = static_cast<float>(values[i] * scale);
+            }
+        }
+    }
+}
+
+double PolyphaseFilterBank::evaluate(double tap_pos, double cutoff, int half_taps) {
+    if (std::abs(tap_pos) < 1e-6) {
+        return 2.0 * cutoff;
+    }
+
+    double x = M_PI * tap_pos;
+    double sinc = std::sin(2.0 * cutoff * x) / x;
+
+    double arg = 1.0 - (tap_pos / half_taps) * (tap_pos / half_taps);
+    double window = arg > 0 ? std::cosh(KAISER_BETA * std::sqrt(arg)) / std::cosh(KAISER_BETA) : 0.0;
+
+    return sinc * window;
+}
+
+double PolyphaseFilterBank::cutoff_for(int input_rate, int output_rate) {
+    if (output_rate < input_rate) {
+        // Downsampling - need anti-aliasing
+        return (output_rate / 2.0) / input_rate * 0.95;  // 95% of Nyquist
+    }
+    // Upsampling - can use full bandwidth
+    return 0.45;  // 90% of Nyquist
+}
+
+std::shared_ptr<const PolyphaseFilterBank> PolyphaseFilterBank::get(int input_rate, int output_rate, int taps,
+                                                                   int phases, Precision precision) {
+    return FilterCoefficientCache::instance().get(input_rate, output_rate, taps, phases, precision);
+}
+
+} // namespace audio
@@ -0,0 +1,137 @@
+/**
+ * @file polyphase_filter_bank.h
+ * @brief Precomputed windowed sinc filter table for polyphase resampling
+ * @date 2025-12-10
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace audio {
+
+/**
+ * @brief Windowed sinc filters sampled at evenly spaced fractional phases
+ *
+ * Row p holds the taps for an interpolation point p / phases past an input
+ * frame. One extra row (p == phases) lets linear interpolation between
+ * neighbouring phases run without a wrap check. Every row is normalized to
+ * unity DC gain.
+ *
+ * Tables are immutable once built, so one table is shared by all
+ * converters with the same ratio and tap count (see get()). A table stores
+ * either float or double coefficients, for the 32-bit and 64-bit
+ * converters respectively.
+ */
+class PolyphaseFilterBank {
+public:
+    static constexpr int DEFAULT_PHASES = 256;
+    static constexpr double KAISER_BETA = 6.0;   // Window parameter for good stop-band attenuation
+
+    /**
+     * @brief Sample type of the stored coefficients
+     */
+    enum class Precision {
+        Float,
+        Double
+    };
+
+    /**
+     * Build a table
+     * @param taps Filter taps per phase (odd)
+     * @param cutoff Cutoff frequency relative to the input rate
+     * @param phases Number of fractional phases
+     * @param precision Coefficient type to store
+     */
+    PolyphaseFilterBank(int taps, double cutoff, int phases = DEFAULT_PHASES,
+                        Precision precision = Precision::Float);
+
+    /**
+     * Get the shared table for a conversion from FilterCoefficientCache,
+     * building it on first use
+     * @param input_rate Input sample rate
+     * @param output_rate Output sample rate
+     * @param taps Filter taps per phase
+     * @param phases Number of fractional phases
+     * @param precision Coefficient type to store
+     * @return Table shared with every converter using the same ratio, taps,
+     *         phase count and precision
+     */
+    static std::shared_ptr<const PolyphaseFilterBank> get(int input_rate, int output_rate, int taps,
+                                                          int phases = DEFAULT_PHASES,
+                                                          Precision precision = Precision::Float);
+
+    /**
+     * Cutoff frequency, relative to the input rate, used for a conversion
+     */
+    static double cutoff_for(int input_rate, int output_rate);
+
+    /**
+     * Evaluate the Kaiser-windowed sinc directly
+     * @param tap_pos Distance from the interpolation point in input frames
+     * @param cutoff Cutoff frequency relative to the input rate
+     * @param half_taps Half the filter length
+     * @return Unnormalized filter value
+     */
+    static double evaluate(double tap_pos, double cutoff, int half_taps);
+
+    /**
+     * Filter for a fractional position, linearly interpolated between phases.
+     * Float tables only.
+     * @param frac Position past the centre input frame, in [0, 1)
+     * @param coefficients Receives taps() values
+     */
+    void interpolate(double frac, float* coefficients) const {
+        double phase = frac * phases_;
+        int p = static_cast<int>(phase);
+        if (p >= phases_) {
+            p = phases_ - 1;
+        }
+        const float t = static_cast<float>(phase - p);
+        const float* row = &table_[static_cast<size_t>(p) * taps_];
+        const float* next = row + taps_;
+        for (int i = 0; i < taps_; ++i) {
+            coefficients[i] = row[i] + t * (next[i] - row[i]);
+        }
+    }
+
+    /**
+     * Filter for exactly phase / phases past the centre input frame.
+     * Float tables only.
+     * @param phase Phase index in [0, phases]
+     * @return taps() coefficients
+     */
+    const float* get_row(int phase) const {
+        return &table_[static_cast<size_t>(phase) * taps_];
+    }
+
+    /**
+     * Same as get_row(), for double tables
+     */
+    const double* get_row_double(int phase) const {
+        return &table_double_[static_cast<size_t>(phase) * taps_];
+    }
+
+    int get_taps() const { return taps_; }
+    int get_phases() const { return phases_; }
+    double get_cutoff() const { return cutoff_; }
+    Precision get_precision() const { return precision_; }
+
+    /**
+     * Table size in bytes
+     */
+    size_t get_memory_usage() const {
+        return table_.size() * sizeof(float) + table_double_.size() * sizeof(double);
+    }
+
+private:
+    int taps_;
+    int phases_;
+    double cutoff_;
+    Precision precision_;
+    std::vector<float> table_;            // (phases_ + 1) rows of taps_ coefficients, float tables
+    std::vector<double> table_double_;    // The same, double tables
+};
+
+} // namespace audio
@@ -0,0 +1,140 @@
+/**
+ * @file rational_resampler.cpp
+ * @brief Rational-ratio polyphase resampler implementation
+ * @date 2025-12-10
+ */
+
+#include "rational_resampler.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace audio {
+
+namespace {
+
+int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+} // namespace
+
+RationalSampleRateConverter::RationalSampleRateConverter(int taps)
+    : taps_(taps)
+    , channels_(0)
+    , up_(1)
+    , down_(1)
+    , step_frames_(1)
+    , step_phase_(0)
+    , frame_(0)
+    , phase_(0)
+    , exact_(true)
+    , fir_(get_fir_kernels().fir_float) {
+
+    // Symmetric filter around the centre frame
+    if (taps_ % 2 == 0) {
+        taps_++;
+    }
+}
+
+bool RationalSampleRateConverter::initialize(int input_rate, int output_rate, int channels) {
+    if (input_rate <= 0 || output_rate <= 0 || channels <= 0) {
+        return false;
+    }
+
+    channels_ = channels;
+
+    const int divisor = gcd(input_rate, output_rate);
+    up_ = output_rate / divisor;
+    down_ = input_rate / divisor;
+    step_frames_ = down_ / up_;
+    step_phase_ = down_ % up_;
+
+    exact_ = up_ <= MAX_EXACT_PHASES;
+    filter_bank_ = PolyphaseFilterBank::get(input_rate, output_rate, taps_,
+                                            exact_ ? up_ : PolyphaseFilterBank::DEFAULT_PHASES);
+    if (!filter_bank_) {
+        return false;
+    }
+    phase_coefficients_.assign(exact_ ? 0 : taps_, 0.0f);
+    fir_ = get_fir_kernel_float(taps_, channels_);
+
+    delay_buffer_.assign(static_cast<size_t>(taps_) * channels_, 0.0f);
+    frame_ = 0;
+    phase_ = 0;
+
+    return true;
+}
+
+int RationalSampleRateConverter::convert(const float* input, int input_frames,
+                                         float* output, int max_output_frames) {
+    if (!input || !output || input_frames <= 0 || max_output_frames <= 0 || !filter_bank_) {
+        return 0;
+    }
+
+    const int half_taps = taps_ / 2;
+    const size_t total_samples = static_cast<size_t>(input_frames + taps_) * channels_;
+
+    // Extended buffer: overlap from the previous call followed by new input
+    if (extended_input_.size() < total_samples) {
+        extended_input_.resize(total_samples);
+    }
+    std::memcpy(extended_input_.data(), delay_buffer_.data(),
+                delay_buffer_.size() * sizeof(float));
+    std::memcpy(extended_input_.data() + delay_buffer_.size(),
+                input, static_cast<size_t>(input_frames) * channels_ * sizeof(float));
+
+    // frame_ is relative to the first new frame, which lives at extended
+    // index taps_
+    const float* base = extended_input_.data() + static_cast<size_t>(taps_) * channels_;
+
+    int output_frames = 0;
+    while (output_frames < max_output_frames && frame_ + half_taps < input_frames) {
+        const float* coefficients;
+        if (exact_) {
+            coefficients = filter_bank_->get_row(phase_);
+        } else {
+            filter_bank_->interpolate(static_cast<double>(phase_) / up_, phase_coefficients_.data());
+            coefficients = phase_coefficients_.data();
+        }
+
+        fir_(base + static_cast<ptrdiff_t>(frame_ - half_taps) * channels_, coefficients,
+             taps_, channels_, output + static_cast<size_t>(output_frames) * channels_);
+        output_frames++;
+
+        // Advance by exactly M / L input frames
+        frame_ += step_frames_;
+        phase_ += step_phase_;
+        if (phase_ >= up_) {
+            phase_ -= up_;
+            frame_++;
+        }
+    }
+
+    // Continue from the same point in the next block
+    frame_ -= input_frames;
+
+    // Last taps_ frames of the extended buffer carry over
+    std::memcpy(delay_buffer_.data(),
+                extended_input_.data() + static_cast<size_t>(input_frames) * channels_,
+                delay_buffer_.size() * sizeof(float));
+
+    return output_frames;
+}
+
+int RationalSampleRateConverter::get_latency() const {
+    return taps_ / 2;
+}
+
+void RationalSampleRateConverter::reset() {
+    frame_ = 0;
+    phase_ = 0;
+    std::fill(delay_buffer_.begin(), delay_buffer_.end(), 0.0f);
+}
+
+} // namespace audio
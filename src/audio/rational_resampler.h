@@ -0,0 +1,86 @@
+/**
+ * @file rational_resampler.h
+ * @brief Rational-ratio polyphase resampler with integer phase tracking
+ * @date 2025-12-10
+ */
+
+#pragma once
+
+#include "sample_rate_converter.h"
+#include "polyphase_filter_bank.h"
+#include "fir_kernels.h"
+#include <vector>
+#include <memory>
+
+namespace audio {
+
+/**
+ * @brief Polyphase resampler stepping an exact integer phase
+ *
+ * The rates are reduced by their GCD to L output frames per M input frames
+ * (44100 -> 48000 is 147:160, so L = 160, M = 147). Output frame n sits at
+ * input position n * M / L, tracked as a whole frame index plus a phase in
+ * [0, L). Nothing is accumulated in floating point, so the output after
+ * hours of playback is identical to converting the same input in one call,
+ * whatever the block sizes.
+ *
+ * When L fits in MAX_EXACT_PHASES the shared table has exactly one row per
+ * phase and each output frame is a single dot product. Larger L still uses
+ * the integer phase but interpolates between rows of the default table.
+ */
+class RationalSampleRateConverter : public ISampleRateConverter {
+public:
+    static constexpr int MAX_EXACT_PHASES = 1024;
+
+    /**
+     * Constructor
+     * @param taps Number of filter taps (rounded up to odd)
+     */
+    explicit RationalSampleRateConverter(int taps = 16);
+
+    bool initialize(int input_rate, int output_rate, int channels) override;
+    int convert(const float* input, int input_frames,
+               float* output, int max_output_frames) override;
+    int get_latency() const override;
+    void reset() override;
+    const char* get_name() const override { return "Rational"; }
+    const char* get_description() const override {
+        return "Polyphase resampler with exact rational phase (sample-exact over long sessions)";
+    }
+
+    /**
+     * Output frames per cycle (L), after reducing the rates by their GCD
+     */
+    int get_interpolation_factor() const { return up_; }
+
+    /**
+     * Input frames per cycle (M), after reducing the rates by their GCD
+     */
+    int get_decimation_factor() const { return down_; }
+
+    /**
+     * True if every phase has its own table row (no interpolation)
+     */
+    bool is_exact() const { return exact_; }
+
+private:
+    int taps_;                     // Number of filter taps
+    int channels_;                 // Number of audio channels
+    int up_;                       // L: phases per input frame
+    int down_;                     // M: phase advance per output frame
+    int step_frames_;              // M / L
+    int step_phase_;               // M % L
+
+    int frame_;                    // Centre input frame of the next output, relative to the next block
+    int phase_;                    // Position past frame_, in 1/L frames
+
+    bool exact_;                                          // One table row per phase
+    std::shared_ptr<const PolyphaseFilterBank> filter_bank_;
+    std::vector<float> phase_coefficients_;               // Interpolated filter when not exact
+    FirKernelFloat fir_;                                  // Dot product for this CPU
+
+    std::vector<float> delay_buffer_;   // Last taps_ frames of the previous block
+    std::vector<float> extended_input_; // Overlap + input scratch, reused across calls
+};
+
+} // namespace audio
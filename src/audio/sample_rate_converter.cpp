@@ -5,10 +5,12 @@
  */
 
 #include "sample_rate_converter.h"
+#include "rational_resampler.h"
 #include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <fstream>
+#include <cmath>
 
 namespace audio {
 
@@ -45,23 +47,24 @@ int LinearSampleRateConverter::convert(const float* input, int input_frames,
 
     int output_frames = 0;
 
-    // Process each output sample
+    // position_ is relative to the start of this block; frame -1 is the
+    // last frame of the previous block, kept in last_frame_
     while (output_frames < max_output_frames) {
         // Find current integer position in input
-        int pos_int = static_cast<int>(position_);
+        int pos_int = static_cast<int>(std::floor(position_));
         double pos_frac = position_ - pos_int;
 
         // Check if we have enough input data
-        if (pos_int >= input_frames) {
+        if (pos_int + 1 >= input_frames) {
             break;
         }
 
         // Linear interpolation for each channel
         for (int ch = 0; ch < channels_; ++ch) {
-            float sample1 = input[pos_int * channels_ + ch];
-            float sample2 = (pos_int < input_frames - 1) ?
-                          input[(pos_int + 1) * channels_ + ch] :
+            float sample1 = (pos_int >= 0) ?
+                          input[pos_int * channels_ + ch] :
                           last_frame_[ch];
+            float sample2 = input[(pos_int + 1) * channels_ + ch];
 
             // Linear interpolation
             output[output_frames * channels_ + ch] =
@@ -72,12 +75,13 @@ int LinearSampleRateConverter::convert(const float* input, int input_frames,
         position_ += ratio_;
     }
 
+    // Continue from the same point in the next block
+    position_ -= input_frames;
+
     // Store last frame for next conversion
-    if (input_frames > 0) {
-        ::memcpy(last_frame_.data(),
-                  &input[(input_frames - 1) * channels_],
-                  channels_ * sizeof(float));
-    }
+    ::memcpy(last_frame_.data(),
+              &input[(input_frames - 1) * channels_],
+              channels_ * sizeof(float));
 
     return output_frames;
 }
@@ -98,6 +102,9 @@ std::unique_ptr<ISampleRateConverter> SampleRateConverterFactory::create(const s
     if (type == "linear") {
         return std::make_unique<LinearSampleRateConverter>();
     }
+    else if (type == "rational") {
+        return std::make_unique<RationalSampleRateConverter>();
+    }
     // TODO: Add other converter types
     // else if (type == "cubic") {
     //     return std::make_unique<CubicSampleRateConverter>();
@@ -113,6 +120,7 @@ std::unique_ptr<ISampleRateConverter> SampleRateConverterFactory::create(const s
 std::vector<std::string> SampleRateConverterFactory::list_available() {
     std::vector<std::string> types;
     types.push_back("linear");
+    types.push_back("rational");
     // TODO: Add other types when implemented
     // types.push_back("cubic");
     // types.push_back("sinc");
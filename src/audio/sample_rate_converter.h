@@ -93,7 +93,7 @@ public:
 
     /**
      * Create a sample rate converter
-     * @param type Type of converter ("linear", "cubic", "sinc")
+     * @param type Type of converter ("linear", "rational")
      * @return Unique pointer to converter
      */
     static std::unique_ptr<ISampleRateConverter> create(const std::string& type = "linear");
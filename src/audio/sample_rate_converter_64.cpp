@@ -8,9 +8,23 @@
 #include <algorithm>
 #include <cstring>
 #include <chrono>
+#include <cstddef>
 
 namespace audio {
 
+namespace {
+
+int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+} // namespace
+
 // ============================================================================
 // LinearSampleRateConverter64
 // ============================================================================
@@ -173,141 +187,115 @@ SincSampleRateConverter64::SincSampleRateConverter64(int taps)
     , channels_(2)
     , ratio_(1.0)
     , taps_(taps)
-    , cutoff_(0.45)
-    , buffer_pos_(0)
-    , phase_(0.0)
-    , kaiser_beta_(6.0) {
-
-    generate_sinc_table();
+    , up_(1)
+    , down_(1)
+    , step_frames_(1)
+    , step_phase_(0)
+    , frame_(0)
+    , phase_(0)
+    , exact_(true)
+    , fir_(get_fir_kernels().fir_double) {
+
+    // Symmetric filter around the centre frame
+    if (taps_ % 2 == 0) {
+        taps_++;
+    }
 }
 
 bool SincSampleRateConverter64::configure(int input_rate, int output_rate, int channels) {
+    if (input_rate <= 0 || output_rate <= 0 || channels <= 0) {
+        return false;
+    }
+
     input_rate_ = input_rate;
     output_rate_ = output_rate;
     channels_ = channels;
     ratio_ = static_cast<double>(input_rate) / output_rate;
-    phase_ = 0.0;
 
-    // Calculate cutoff frequency
-    if (ratio_ > 1.0) {
-        cutoff_ = 0.45 / ratio_;  // Low-pass filter for downsampling
-    } else {
-        cutoff_ = 0.45;  // For upsampling
+    const int divisor = gcd(input_rate, output_rate);
+    up_ = output_rate / divisor;
+    down_ = input_rate / divisor;
+    step_frames_ = down_ / up_;
+    step_phase_ = down_ % up_;
+
+    exact_ = up_ <= MAX_EXACT_PHASES;
+    filter_bank_ = PolyphaseFilterBank::get(input_rate, output_rate, taps_,
+                                            exact_ ? up_ : PolyphaseFilterBank::DEFAULT_PHASES,
+                                            PolyphaseFilterBank::Precision::Double);
+    if (!filter_bank_) {
+        return false;
     }
 
-    // Calculate buffer size needed
-    int buffer_size = taps_ * 4;  // Extra space for smooth interpolation
-    buffer_.resize(buffer_size * channels_, 0.0);
-    buffer_pos_ = taps_ / 2;  // Start in middle
+    delay_buffer_.assign(static_cast<size_t>(taps_) * channels_, 0.0);
+    row_output_.assign(exact_ ? 0 : 2 * channels_, 0.0);
+    frame_ = 0;
+    phase_ = 0;
 
     return true;
 }
 
-double SincSampleRateConverter64::kaiser_bessel_i0(double x) const {
-    const double epsilon = 1e-21;
-    double sum = 1.0;
-    double term = 1.0;
-    double x_squared = x * x / 4.0;
-
-    for (int k = 1; k < 100; ++k) {
-        term *= x_squared / (k * k);
-        sum += term;
-        if (term < epsilon * sum) break;
-    }
-
-    return sum;
-}
-
-void SincSampleRateConverter64::generate_sinc_table() {
-    sinc_window_.resize(taps_ * 4 + 1);  // 4x oversampling for smooth interpolation
-
-    int half_taps = taps_ / 2;
-    for (int i = 0; i <= taps_ * 4; ++i) {
-        double x = i / 4.0 - half_taps;
-
-        if (x == 0.0) {
-            sinc_window_[i] = 1.0;
-        } else {
-            // Sinc function
-            double sinc_x = sin(M_PI * x) / (M_PI * x);
+int SincSampleRateConverter64::process(const double* input, double* output, int input_frames) {
+    if (!input || !output || input_frames <= 0 || !filter_bank_) return 0;
 
-            // Kaiser window
-            double alpha = x / half_taps;
-            double window = kaiser_bessel_i0(kaiser_beta_ * sqrt(1 - alpha * alpha)) /
-                           kaiser_bessel_i0(kaiser_beta_);
+    const int half_taps = taps_ / 2;
+    const size_t total_samples = static_cast<size_t>(input_frames + taps_) * channels_;
 
-            sinc_window_[i] = sinc_x * window;
-        }
+    // Extended buffer: overlap from the previous call followed by new input
+    if (extended_input_.size() < total_samples) {
+        extended_input_.resize(total_samples);
     }
-}
+    std::memcpy(extended_input_.data(), delay_buffer_.data(),
+                delay_buffer_.size() * sizeof(double));
+    std::memcpy(extended_input_.data() + delay_buffer_.size(),
+                input, static_cast<size_t>(input_frames) * channels_ * sizeof(double));
 
-double SincSampleRateConverter64::interpolate(const double* buffer, int pos, int channels, int ch, double phase) const {
-    double sum = 0.0;
-    int half_taps = taps_ / 2;
+    // frame_ is relative to the first new frame, which lives at extended
+    // index taps_
+    const double* base = extended_input_.data() + static_cast<size_t>(taps_) * channels_;
+    const int phases = filter_bank_->get_phases();
 
-    // Use pre-computed sinc table with linear interpolation
-    double table_phase = phase * 4.0;
-    int table_index = static_cast<int>(table_phase);
-    double frac = table_phase - table_index;
-
-    for (int i = -half_taps; i <= half_taps; ++i) {
-        int buf_pos = pos + i;
-        if (buf_pos < 0 || buf_pos >= static_cast<int>(buffer_.size() / channels)) {
-            continue;
-        }
-
-        double sample = buffer[buf_pos * channels + ch];
-
-        // Interpolate sinc values
-        int sinc_idx = (i + half_taps) * 4 + table_index;
-        double sinc_val;
-
-        if (sinc_idx + 1 < static_cast<int>(sinc_window_.size())) {
-            sinc_val = sinc_window_[sinc_idx] * (1.0 - frac) + sinc_window_[sinc_idx + 1] * frac;
-        } else {
-            sinc_val = sinc_window_[sinc_idx];
-        }
-
-        sum += sample * sinc_val;
-    }
-
-    return sum;
-}
-
-int SincSampleRateConverter64::process(const double* input, double* output, int input_frames) {
-    if (!input || !output || input_frames <= 0) return 0;
-
-    const double* src = input;
-    double* dst = output;
     int output_frames = 0;
-    double phase = phase_;
-
-    // Copy input samples to circular buffer
-    for (int i = 0; i < input_frames; ++i) {
-        for (int ch = 0; ch < channels_; ++ch) {
-            buffer_[buffer_pos_ * channels_ + ch] = src[ch];
-        }
-
-        buffer_pos_++;
-        if (buffer_pos_ * channels_ >= static_cast<int>(buffer_.size())) {
-            buffer_pos_ = 0;
-        }
+    while (frame_ + half_taps < input_frames) {
+        const double* window = base + static_cast<ptrdiff_t>(frame_ - half_taps) * channels_;
+        double* dst = output + static_cast<size_t>(output_frames) * channels_;
 
-        // Generate output samples
-        while (phase < 1.0) {
+        if (exact_) {
+            fir_(window, filter_bank_->get_row_double(phase_), taps_, channels_, dst);
+        } else {
+            // Interpolating the output of two rows is the same as
+            // interpolating the rows themselves
+            const double position = static_cast<double>(phase_) / up_ * phases;
+            int row = static_cast<int>(position);
+            if (row >= phases) {
+                row = phases - 1;
+            }
+            const double t = position - row;
+            double* next = row_output_.data() + channels_;
+            fir_(window, filter_bank_->get_row_double(row), taps_, channels_, row_output_.data());
+            fir_(window, filter_bank_->get_row_double(row + 1), taps_, channels_, next);
             for (int ch = 0; ch < channels_; ++ch) {
-                double interpolated = interpolate(buffer_.data(), buffer_pos_, channels_, ch, phase);
-                *dst++ = interpolated;
+                dst[ch] = row_output_[ch] + t * (next[ch] - row_output_[ch]);
             }
-            output_frames++;
-            phase += ratio_;
         }
-
-        src += channels_;
-        phase -= 1.0;
+        output_frames++;
+
+        // Advance by exactly M / L input frames
+        frame_ += step_frames_;
+        phase_ += step_phase_;
+        if (phase_ >= up_) {
+            phase_ -= up_;
+            frame_++;
+        }
     }
 
-    phase_ = phase;
+    // Continue from the same point in the next block
+    frame_ -= input_frames;
+
+    // Last taps_ frames of the extended buffer carry over
+    std::memcpy(delay_buffer_.data(),
+                extended_input_.data() + static_cast<size_t>(input_frames) * channels_,
+                delay_buffer_.size() * sizeof(double));
+
     return output_frames;
 }
 
@@ -316,9 +304,9 @@ int SincSampleRateConverter64::get_output_latency(int input_frames) const {
 }
 
 void SincSampleRateConverter64::reset() {
-    phase_ = 0.0;
-    buffer_pos_ = taps_ / 2;
-    std::fill(buffer_.begin(), buffer_.end(), 0.0);
+    frame_ = 0;
+    phase_ = 0;
+    std::fill(delay_buffer_.begin(), delay_buffer_.end(), 0.0);
 }
 
 // ============================================================================
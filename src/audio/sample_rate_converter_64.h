@@ -6,7 +6,10 @@
 
 #pragma once
 
+#include "fir_kernels.h"
+#include "polyphase_filter_bank.h"
 #include <memory>
+#include <string>
 #include <vector>
 #include <cmath>
 
@@ -110,29 +113,42 @@ public:
 /**
  * @brief 64-bit Sinc interpolation resampler with windowing
  * High quality resampler using windowed sinc function
+ *
+ * Filters come from a shared double-precision PolyphaseFilterBank built
+ * once at configure(). Positions are tracked exactly as a fraction of the
+ * reduced ratio L/M, as in RationalSampleRateConverter: for up to
+ * MAX_EXACT_PHASES phases the table has one row per phase, so each output
+ * frame is a row lookup and one SIMD dot product over all channels.
+ * Larger L use a DEFAULT_PHASES table and blend the dot products of the
+ * two neighbouring rows.
  */
 class SincSampleRateConverter64 : public ISampleRateConverter64 {
+public:
+    static constexpr int MAX_EXACT_PHASES = 1024;
+
 private:
     int input_rate_;
     int output_rate_;
     int channels_;
     double ratio_;
     int taps_;
-    double cutoff_;
-    std::vector<double> buffer_;
-    int buffer_pos_;
-    double phase_;
-
-    // Pre-computed sinc window
-    std::vector<double> sinc_window_;
-
-    // Kaiser window parameters
-    double kaiser_beta_;
-    double kaiser_bessel_i0(double x) const;
-    void generate_sinc_table();
 
-    // Interpolation function
-    double interpolate(const double* buffer, int pos, int channels, int ch, double phase) const;
+    // Position of the next output frame: frame_ + phase_ / up_ input frames
+    // past the first frame of the current block
+    int up_;                  // L
+    int down_;                // M
+    int step_frames_;         // M / L
+    int step_phase_;          // M % L
+    int frame_;
+    int phase_;
+    bool exact_;              // One table row per phase
+
+    std::shared_ptr<const PolyphaseFilterBank> filter_bank_;
+    FirKernelDouble fir_;
+
+    std::vector<double> delay_buffer_;    // Last taps_ frames of the previous block
+    std::vector<double> extended_input_;  // Overlap + input scratch, reused across calls
+    std::vector<double> row_output_;      // Dot products of the two rows around a phase
 
 public:
     explicit SincSampleRateConverter64(int taps = 16);
@@ -10,13 +10,18 @@
 
 namespace audio {
 
-SincSampleRateConverter::SincSampleRateConverter(int taps)
+SincSampleRateConverter::SincSampleRateConverter(int taps, bool polyphase)
     : taps_(taps)
     , cutoff_(0.45)
+    , nominal_ratio_(1.0)
+    , ratio_(1.0)
     , position_(0.0)
     , channels_(0)
     , input_rate_(0)
-    , output_rate_(0) {
+    , output_rate_(0)
+    , polyphase_(polyphase)
+    , fir_(get_fir_kernels().fir_float)
+    , double_accumulation_(false) {
 
     // Validate taps (must be odd for symmetric filter)
     if (taps_ % 2 == 0) {
@@ -35,63 +40,40 @@ bool SincSampleRateConverter::initialize(int input_rate, int output_rate, int ch
     position_ = 0.0;
 
     // Calculate conversion ratio
-    ratio_ = static_cast<double>(input_rate) / output_rate;
+    nominal_ratio_ = static_cast<double>(input_rate) / output_rate;
+    ratio_ = nominal_ratio_;
 
     // Calculate cutoff frequency (for anti-aliasing)
-    if (output_rate < input_rate) {
-        // Downsampling - need anti-aliasing
-        cutoff_ = (output_rate / 2.0) / input_rate * 0.95;  // 95% of Nyquist
-    } else {
-        // Upsampling - can use full bandwidth
-        cutoff_ = 0.45;  // 90% of Nyquist
-    }
+    cutoff_ = PolyphaseFilterBank::cutoff_for(input_rate, output_rate);
 
-    // Generate sinc filter coefficients
-    generate_sinc_coefficients();
+    // Table shared with every converter using the same ratio and taps
+    if (polyphase_) {
+        filter_bank_ = PolyphaseFilterBank::get(input_rate, output_rate, taps_);
+        phase_coefficients_.resize(taps_);
+    }
 
     // Allocate buffers
     delay_buffer_.resize(taps_ * channels_, 0.0f);
 
+    set_double_accumulation(double_accumulation_);
+
     return true;
 }
 
-void SincSampleRateConverter::generate_sinc_coefficients() {
-    coefficients_.resize(taps_);
-
-    // Generate Kaiser-windowed sinc coefficients
-    double beta = 6.0;  // Kaiser window parameter for good stop-band attenuation
-    double m = (taps_ - 1) / 2.0;
-
-    for (int i = 0; i < taps_; ++i) {
-        double sinc;
-        if (i == m) {
-            sinc = 2.0 * cutoff_;
-        } else {
-            double x = M_PI * (i - m);
-            sinc = sin(2.0 * cutoff_ * x) / x;
-        }
-
-        // Apply Kaiser window
-        double alpha = m;
-        double arg = 1.0 - ((i - alpha) / alpha) * ((i - alpha) / alpha);
-        double window = arg > 0 ?
-            std::cosh(beta * std::sqrt(arg)) / std::cosh(beta) : 0.0;
-
-        coefficients_[i] = static_cast<float>(sinc * window);
-    }
-
-    // Normalize coefficients
-    float sum = 0.0f;
-    for (float coeff : coefficients_) {
-        sum += coeff;
-    }
-    for (float& coeff : coefficients_) {
-        coeff /= sum;
+void SincSampleRateConverter::set_double_accumulation(bool enable) {
+    double_accumulation_ = enable;
+    if (enable) {
+        fir_ = get_fir_kernels().fir_mixed;
+    } else if (channels_ > 0) {
+        // Kernel specialized for this tap and channel count, if there is one
+        fir_ = get_fir_kernel_float(taps_, channels_);
+    } else {
+        fir_ = get_fir_kernels().fir_float;
     }
 }
 
 float SincSampleRateConverter::sinc_interpolate(const float* input, double position) {
-    int pos_int = static_cast<int>(position);
+    int pos_int = static_cast<int>(std::floor(position));
     double pos_frac = position - pos_int;
 
     float sum = 0.0f;
@@ -102,26 +84,12 @@ float SincSampleRateConverter::sinc_interpolate(const float* input, double posit
     for (int i = 0; i < taps_; ++i) {
         int sample_idx = pos_int + i - half_taps;
 
-        // Skip if outside buffer bounds
-        if (sample_idx < 0) continue;
+        // Distance from the interpolation point to this tap
+        double tap_pos = (i - half_taps) - pos_frac;
+        double sinc_val = PolyphaseFilterBank::evaluate(tap_pos, cutoff_, half_taps);
 
-        // Calculate fractional position for this tap
-        double tap_pos = (i - half_taps) + pos_frac;
-
-        // Calculate sinc value (simplified for performance)
-        double sinc_val;
-        if (std::abs(tap_pos) < 1e-6) {
-            sinc_val = 1.0;
-        } else {
-            double x = M_PI * tap_pos;
-            sinc_val = sin(2.0 * cutoff_ * x) / x;
-            // Apply Kaiser window
-            double arg = 1.0 - (tap_pos / half_taps) * (tap_pos / half_taps);
-            double window = arg > 0 ? std::cosh(6.0 * std::sqrt(arg)) / std::cosh(6.0) : 0.0;
-            sinc_val *= window;
-        }
-
-        sum += input[sample_idx] * static_cast<float>(sinc_val);
+        // Input is interleaved: step by channel count
+        sum += input[sample_idx * channels_] * static_cast<float>(sinc_val);
         scale += sinc_val;
     }
 
@@ -136,52 +104,56 @@ int SincSampleRateConverter::convert(const float* input, int input_frames,
 
     int output_frames = 0;
     int half_taps = taps_ / 2;
+    int total_input_frames = input_frames + taps_;
 
-    // Create extended input buffer with overlap
-    std::vector<float> extended_input((input_frames + taps_) * channels_);
+    // Extended buffer: overlap from the previous call followed by new input
+    if (extended_input_.size() < static_cast<size_t>(total_input_frames * channels_)) {
+        extended_input_.resize(total_input_frames * channels_);
+    }
 
     // Copy previous data from delay buffer
-    std::memcpy(extended_input.data(), delay_buffer_.data(),
+    std::memcpy(extended_input_.data(), delay_buffer_.data(),
                 delay_buffer_.size() * sizeof(float));
 
     // Copy new input data
-    std::memcpy(extended_input.data() + delay_buffer_.size(),
+    std::memcpy(extended_input_.data() + delay_buffer_.size(),
                 input, input_frames * channels_ * sizeof(float));
 
-    // Process each output frame
-    while (output_frames < max_output_frames && position_ < input_frames) {
-        int pos_int = static_cast<int>(position_);
+    // position_ is relative to the first new frame; frame j lives at
+    // extended index j + taps_
+    const float* base = extended_input_.data() + taps_ * channels_;
 
-        // Sinc interpolation for each channel
-        for (int ch = 0; ch < channels_; ++ch) {
-            // Get pointer to channel data
-            const float* channel_data = extended_input.data() + ch;
+    // Process each output frame once all of its taps are available
+    while (output_frames < max_output_frames) {
+        int pos_int = static_cast<int>(std::floor(position_));
+        if (pos_int + half_taps >= input_frames) {
+            break;
+        }
 
-            // Perform sinc interpolation
-            output[output_frames * channels_ + ch] =
-                sinc_interpolate(channel_data, position_ + half_taps);
+        if (filter_bank_) {
+            // One filter per output frame, applied to every channel
+            filter_bank_->interpolate(position_ - pos_int, phase_coefficients_.data());
+            fir_(base + (pos_int - half_taps) * channels_, phase_coefficients_.data(),
+                 taps_, channels_, output + output_frames * channels_);
+        } else {
+            // Sinc interpolation for each channel
+            for (int ch = 0; ch < channels_; ++ch) {
+                output[output_frames * channels_ + ch] =
+                    sinc_interpolate(base + ch, position_);
+            }
         }
 
         output_frames++;
         position_ += ratio_;
     }
 
-    // Update delay buffer for next call
-    if (input_frames >= taps_) {
-        std::memcpy(delay_buffer_.data(),
-                    input + (input_frames - taps_) * channels_,
-                    taps_ * channels_ * sizeof(float));
-    } else {
-        // Not enough frames, shift and copy what we have
-        int shift = std::max(0, taps_ - input_frames);
-        if (shift > 0) {
-            std::memmove(delay_buffer_.data(),
-                         delay_buffer_.data() + (taps_ - shift) * channels_,
-                         shift * channels_ * sizeof(float));
-        }
-        std::memcpy(delay_buffer_.data() + shift * channels_,
-                    input, input_frames * channels_ * sizeof(float));
-    }
+    // Continue from the same point in the next block
+    position_ -= input_frames;
+
+    // Last taps_ frames of the extended buffer carry over
+    std::memcpy(delay_buffer_.data(),
+                extended_input_.data() + input_frames * channels_,
+                delay_buffer_.size() * sizeof(float));
 
     return output_frames;
 }
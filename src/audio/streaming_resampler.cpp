@@ -0,0 +1,302 @@
+/**
+ * @file streaming_resampler.cpp
+ * @brief Pull-based streaming sample rate conversion stage implementation
+ * @date 2025-12-10
+ */
+
+#include "streaming_resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace audio {
+
+namespace {
+
+// Input frames pulled per source call are capped to keep the scratch small
+const int MAX_INPUT_BLOCK_FRAMES = 4096;
+
+// Extra output slots per block beyond the nominal ratio
+const int CONVERT_BLOCK_SLACK_FRAMES = 16;
+
+} // namespace
+
+StreamingResampler::StreamingResampler()
+    : quality_(ResampleQuality::Good)
+    , input_rate_(0)
+    , output_rate_(0)
+    , channels_(0)
+    , max_output_frames_(0)
+    , input_block_frames_(0)
+    , source_(nullptr)
+    , source_user_data_(nullptr)
+    , fifo_read_(0)
+    , fifo_write_(0)
+    , call_produced_(0)
+    , input_consumed_(0)
+    , output_generated_(0)
+    , drained_(false)
+    , cpu_time_ns_(0)
+    , cpu_output_frames_(0) {
+}
+
+bool StreamingResampler::initialize(int input_rate, int output_rate, int channels,
+                                    ResampleQuality quality, int max_output_frames) {
+    if (input_rate <= 0 || output_rate <= 0 || channels <= 0 || max_output_frames <= 0) {
+        return false;
+    }
+
+    output_rate_ = output_rate;
+    channels_ = channels;
+    quality_ = quality;
+    max_output_frames_ = max_output_frames;
+    fifo_read_ = 0;
+    fifo_write_ = 0;
+    cpu_time_ns_ = 0;
+    cpu_output_frames_ = 0;
+
+    return set_input_rate(input_rate);
+}
+
+bool StreamingResampler::set_input_rate(int input_rate) {
+    if (input_rate <= 0 || output_rate_ <= 0) {
+        return false;
+    }
+
+    input_rate_ = input_rate;
+    input_consumed_ = 0;
+    output_generated_ = 0;
+    drained_ = false;
+
+    if (is_passthrough()) {
+        converter_.reset();
+        return true;
+    }
+
+    converter_ = EnhancedSampleRateConverterFactory::create(quality_);
+    if (!converter_->initialize(input_rate_, output_rate_, channels_)) {
+        converter_.reset();
+        return false;
+    }
+
+    // One input block yields roughly one produce() request of output
+    input_block_frames_ = static_cast<int>(
+        (static_cast<int64_t>(max_output_frames_) * input_rate_) / output_rate_) + 1;
+    input_block_frames_ = std::max(input_block_frames_, converter_->get_latency() + 4);
+    input_block_frames_ = std::min(input_block_frames_, MAX_INPUT_BLOCK_FRAMES);
+
+    int convert_frames = static_cast<int>(output_frames_for_input(input_block_frames_)) +
+                         CONVERT_BLOCK_SLACK_FRAMES;
+
+    input_block_.assign(static_cast<size_t>(input_block_frames_) * channels_, 0.0f);
+    convert_block_.assign(static_cast<size_t>(convert_frames) * channels_, 0.0f);
+
+    // Surplus of one block is all that can be left over between calls,
+    // plus whatever a previous rate left behind
+    size_t fifo_frames = static_cast<size_t>(convert_frames + max_output_frames_) +
+                         static_cast<size_t>(fifo_write_ - fifo_read_);
+    if (fifo_.size() < fifo_frames * channels_) {
+        std::vector<float> fifo(fifo_frames * channels_, 0.0f);
+        if (fifo_write_ > fifo_read_) {
+            std::memcpy(fifo.data(), fifo_.data() + fifo_read_ * channels_,
+                        (fifo_write_ - fifo_read_) * channels_ * sizeof(float));
+        }
+        fifo_.swap(fifo);
+        fifo_write_ -= fifo_read_;
+        fifo_read_ = 0;
+    }
+
+    return true;
+}
+
+void StreamingResampler::set_source(SourceCallback source, void* user_data) {
+    source_ = source;
+    source_user_data_ = user_data;
+}
+
+int StreamingResampler::produce(float* output, int frames) {
+    if (!output || frames <= 0 || channels_ <= 0) {
+        return 0;
+    }
+    frames = std::min(frames, max_output_frames_);
+    call_produced_ = 0;
+
+    // Frames converted by an earlier call come first
+    int take = std::min(frames, fifo_write_ - fifo_read_);
+    if (take > 0) {
+        std::memcpy(output, fifo_.data() + fifo_read_ * channels_, take * channels_ * sizeof(float));
+        fifo_read_ += take;
+        call_produced_ = take;
+    }
+    if (fifo_read_ == fifo_write_) {
+        fifo_read_ = 0;
+        fifo_write_ = 0;
+    }
+
+    while (call_produced_ < frames && source_) {
+        float* dst = output + call_produced_ * channels_;
+        int wanted = frames - call_produced_;
+
+        if (is_passthrough()) {
+            int got = source_(dst, wanted, source_user_data_);
+            if (got <= 0) {
+                break;
+            }
+            call_produced_ += std::min(got, wanted);
+            continue;
+        }
+
+        int got = source_(input_block_.data(), input_block_frames_, source_user_data_);
+        if (got > 0) {
+            drained_ = false;
+            input_consumed_ += got;
+            convert_block(input_block_.data(), got);
+        } else if (!drained_) {
+            // Source ended: let the converter emit what it still holds
+            drain();
+            drained_ = true;
+        } else {
+            break;
+        }
+
+        // Move as much as fits straight to the caller
+        take = std::min(wanted, fifo_write_ - fifo_read_);
+        std::memcpy(dst, fifo_.data() + fifo_read_ * channels_, take * channels_ * sizeof(float));
+        fifo_read_ += take;
+        call_produced_ += take;
+        if (fifo_read_ == fifo_write_) {
+            fifo_read_ = 0;
+            fifo_write_ = 0;
+        }
+    }
+
+    int produced = call_produced_;
+    call_produced_ = 0;
+    return produced;
+}
+
+void StreamingResampler::convert_block(const float* input, int input_frames) {
+    // Compact so a full converter block always fits behind unread frames
+    if (fifo_read_ > 0) {
+        int unread = fifo_write_ - fifo_read_;
+        std::memmove(fifo_.data(), fifo_.data() + fifo_read_ * channels_, unread * channels_ * sizeof(float));
+        fifo_read_ = 0;
+        fifo_write_ = unread;
+    }
+
+    const int convert_frames = static_cast<int>(convert_block_.size() / channels_);
+
+    auto start = std::chrono::steady_clock::now();
+    int generated = converter_->convert(input, input_frames, convert_block_.data(), convert_frames);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    cpu_time_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    cpu_output_frames_ += generated;
+
+    int space = static_cast<int>(fifo_.size() / channels_) - fifo_write_;
+    generated = std::min(generated, space);
+    std::memcpy(fifo_.data() + fifo_write_ * channels_, convert_block_.data(),
+                generated * channels_ * sizeof(float));
+    fifo_write_ += generated;
+    output_generated_ += generated;
+}
+
+void StreamingResampler::drain() {
+    if (!converter_ || input_consumed_ == 0) {
+        return;
+    }
+
+    // Push the last real samples through the filter with silence
+    int zero_frames = std::min(converter_->get_latency() + 4, input_block_frames_);
+    std::fill(input_block_.begin(), input_block_.begin() + zero_frames * channels_, 0.0f);
+
+    int64_t generated_before = output_generated_;
+    convert_block(input_block_.data(), zero_frames);
+
+    // Keep only the output that corresponds to real input
+    int64_t expected = output_frames_for_input(input_consumed_);
+    int64_t keep = std::max<int64_t>(0, expected - generated_before);
+    int64_t added = output_generated_ - generated_before;
+    if (keep < added) {
+        fifo_write_ -= static_cast<int>(added - keep);
+        output_generated_ = generated_before + keep;
+    }
+}
+
+int StreamingResampler::pending_output_frames() const {
+    return call_produced_ + (fifo_write_ - fifo_read_);
+}
+
+int64_t StreamingResampler::output_frames_for_input(int64_t input_frames) const {
+    if (input_rate_ <= 0) {
+        return 0;
+    }
+    return (input_frames * output_rate_ + input_rate_ - 1) / input_rate_;
+}
+
+void StreamingResampler::reset() {
+    if (converter_) {
+        converter_->reset();
+    }
+    fifo_read_ = 0;
+    fifo_write_ = 0;
+    call_produced_ = 0;
+    input_consumed_ = 0;
+    output_generated_ = 0;
+    drained_ = false;
+}
+
+double StreamingResampler::get_cpu_cost() const {
+    if (cpu_output_frames_ == 0 || output_rate_ <= 0) {
+        return 0.0;
+    }
+    double audio_seconds = static_cast<double>(cpu_output_frames_) / output_rate_;
+    return (cpu_time_ns_ * 1e-9) / audio_seconds;
+}
+
+namespace {
+
+// Deterministic noise source for measure_cpu_cost()
+struct NoiseSource {
+    int channels;
+    int64_t remaining;
+    uint32_t state;
+};
+
+int noise_source(float* buffer, int max_frames, void* user_data) {
+    NoiseSource* source = static_cast<NoiseSource*>(user_data);
+    int frames = static_cast<int>(std::min<int64_t>(max_frames, source->remaining));
+    for (int i = 0; i < frames * source->channels; ++i) {
+        source->state = source->state * 1664525u + 1013904223u;
+        buffer[i] = static_cast<float>(static_cast<int32_t>(source->state)) * (0.5f / 2147483648.0f);
+    }
+    source->remaining -= frames;
+    return frames;
+}
+
+} // namespace
+
+double StreamingResampler::measure_cpu_cost(ResampleQuality quality, int input_rate, int output_rate,
+                                            int channels, double seconds) {
+    const int block_frames = 1024;
+
+    StreamingResampler resampler;
+    if (!resampler.initialize(input_rate, output_rate, channels, quality, block_frames)) {
+        return 0.0;
+    }
+
+    NoiseSource source = { channels, static_cast<int64_t>(seconds * input_rate), 12345u };
+    resampler.set_source(noise_source, &source);
+
+    std::vector<float> output(static_cast<size_t>(block_frames) * channels);
+    while (resampler.produce(output.data(), block_frames) == block_frames) {
+    }
+
+    return resampler.get_cpu_cost();
+}
+
+ResampleQuality StreamingResampler::parse_quality(const std::string& quality_name) {
+    return EnhancedSampleRateConverterFactory::parse_quality(quality_name);
+}
+
+} // namespace audio
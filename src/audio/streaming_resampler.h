@@ -0,0 +1,158 @@
+/**
+ * @file streaming_resampler.h
+ * @brief Pull-based streaming sample rate conversion stage
+ * @date 2025-12-10
+ */
+
+#pragma once
+
+#include "sample_rate_converter.h"
+#include "enhanced_sample_rate_converter.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace audio {
+
+/**
+ * @brief Streaming resampler that produces an exact number of output frames
+ *
+ * Wraps one of the ISampleRateConverter implementations (selected by
+ * ResampleQuality) and pulls input on demand from a source callback.
+ * All buffers are allocated in initialize(); produce() never allocates,
+ * so it can run on a real-time or decode-ahead thread.
+ *
+ * When input and output rates match the converter is bypassed and input
+ * is copied straight through.
+ */
+class StreamingResampler {
+public:
+    /**
+     * Input source callback
+     * @param buffer Interleaved float buffer to fill
+     * @param max_frames Maximum frames to write
+     * @param user_data User data passed to set_source()
+     * @return Frames written, 0 at end of input
+     */
+    typedef int (*SourceCallback)(float* buffer, int max_frames, void* user_data);
+
+    StreamingResampler();
+
+    /**
+     * Allocate buffers and create the converter
+     * @param input_rate Input sample rate
+     * @param output_rate Output sample rate
+     * @param channels Number of interleaved channels
+     * @param quality Converter quality level
+     * @param max_output_frames Largest request passed to produce()
+     * @return True if initialization successful
+     */
+    bool initialize(int input_rate, int output_rate, int channels,
+                    ResampleQuality quality, int max_output_frames);
+
+    /**
+     * Change the input rate, keeping output already generated
+     * @param input_rate New input sample rate
+     * @return True if the converter could be configured
+     */
+    bool set_input_rate(int input_rate);
+
+    /**
+     * Set the input source
+     */
+    void set_source(SourceCallback source, void* user_data);
+
+    /**
+     * Produce exactly frames output frames
+     * @param output Interleaved output buffer
+     * @param frames Frames requested (at most max_output_frames)
+     * @return Frames produced; fewer than requested only at end of input
+     */
+    int produce(float* output, int frames);
+
+    /**
+     * Output frames generated but not yet returned by produce().
+     * Valid from inside the source callback.
+     */
+    int pending_output_frames() const;
+
+    /**
+     * Output frames corresponding to a number of input frames
+     */
+    int64_t output_frames_for_input(int64_t input_frames) const;
+
+    /**
+     * Drop buffered audio and converter history
+     */
+    void reset();
+
+    /**
+     * Check if input is copied through without conversion
+     */
+    bool is_passthrough() const { return input_rate_ == output_rate_; }
+
+    int get_input_rate() const { return input_rate_; }
+    int get_output_rate() const { return output_rate_; }
+    ResampleQuality get_quality() const { return quality_; }
+
+    /**
+     * Measured CPU seconds spent converting per second of audio produced
+     */
+    double get_cpu_cost() const;
+
+    /**
+     * Measure CPU cost of a quality level on synthetic input
+     * @param quality Converter quality level
+     * @param input_rate Input sample rate
+     * @param output_rate Output sample rate
+     * @param channels Number of channels
+     * @param seconds Seconds of audio to convert
+     * @return CPU seconds per second of audio
+     */
+    static double measure_cpu_cost(ResampleQuality quality, int input_rate, int output_rate,
+                                   int channels, double seconds = 1.0);
+
+    /**
+     * Parse a ResamplerConfig quality string ("fast", "good", "high", "best")
+     */
+    static ResampleQuality parse_quality(const std::string& quality_name);
+
+private:
+    /**
+     * Convert one block of input and append the result to the output FIFO
+     */
+    void convert_block(const float* input, int input_frames);
+
+    /**
+     * Flush the converter tail once the source has ended
+     */
+    void drain();
+
+    std::unique_ptr<ISampleRateConverter> converter_;
+    ResampleQuality quality_;
+    int input_rate_;
+    int output_rate_;
+    int channels_;
+    int max_output_frames_;
+    int input_block_frames_;
+
+    SourceCallback source_;
+    void* source_user_data_;
+
+    std::vector<float> input_block_;     // Input pulled from the source
+    std::vector<float> convert_block_;   // Converter output for one input block
+    std::vector<float> fifo_;            // Converted frames not yet returned
+    int fifo_read_;                      // Frame offsets into fifo_
+    int fifo_write_;
+    int call_produced_;                  // Frames returned so far by this produce()
+
+    int64_t input_consumed_;             // Since initialize/reset/set_input_rate
+    int64_t output_generated_;
+    bool drained_;
+
+    int64_t cpu_time_ns_;                // Time spent inside the converter
+    int64_t cpu_output_frames_;          // Output frames covered by cpu_time_ns_
+};
+
+} // namespace audio
@@ -5,6 +5,8 @@
  */
 
 #include "universal_sample_rate_converter.h"
+#include "cascaded_resampler.h"
+#include "enhanced_sample_rate_converter.h"
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
@@ -92,22 +94,63 @@ std::string AudioSampleRate::get_rate_description(int rate) {
     }
 }
 
+int AudioSampleRate::get_rate_family(int rate) {
+    if (is_integer_ratio(rate, RATE_44100)) return RATE_44100;
+    if (is_integer_ratio(rate, RATE_48000)) return RATE_48000;
+    return 0;
+}
+
+bool AudioSampleRate::is_integer_ratio(int rate_a, int rate_b) {
+    if (rate_a <= 0 || rate_b <= 0) {
+        return false;
+    }
+    return std::max(rate_a, rate_b) % std::min(rate_a, rate_b) == 0;
+}
+
+int AudioSampleRate::select_device_rate(int track_rate, const std::vector<int>& supported_rates,
+                                        int fallback_rate) {
+    const std::vector<int> rates = supported_rates.empty() ? get_studio_rates() : supported_rates;
+
+    if (std::find(rates.begin(), rates.end(), track_rate) != rates.end()) {
+        return track_rate;
+    }
+
+    // Lowest rate above the track, otherwise highest rate below it
+    int best_above = 0;
+    int best_below = 0;
+    for (int rate : rates) {
+        if (!is_integer_ratio(rate, track_rate)) {
+            continue;
+        }
+        if (rate > track_rate && (best_above == 0 || rate < best_above)) {
+            best_above = rate;
+        } else if (rate < track_rate && rate > best_below) {
+            best_below = rate;
+        }
+    }
+
+    if (best_above != 0) return best_above;
+    if (best_below != 0) return best_below;
+    return fallback_rate;
+}
+
 // UniversalSampleRateConverter implementations
 UniversalSampleRateConverter::UniversalSampleRateConverter(int default_output_rate)
     : default_output_rate_(default_output_rate)
-    , auto_optimize_(true) {
+    , auto_optimize_(true)
+    , quality_(ResampleQuality::Fast) {
 }
 
 ISampleRateConverter* UniversalSampleRateConverter::get_converter(int input_rate, int output_rate, int channels) {
-    ConversionCacheKey key{input_rate, output_rate, channels};
+    ConversionCacheKey key{input_rate, output_rate, channels, quality_};
 
     auto it = converter_cache_.find(key);
     if (it != converter_cache_.end()) {
         return it->second.get();
     }
 
-    // Create new converter
-    auto converter = audio::SampleRateConverterFactory::create("linear");
+    // Plan the stage chain once per conversion
+    auto converter = std::make_unique<CascadedSampleRateConverter>(quality_);
 
     if (converter && converter->initialize(input_rate, output_rate, channels)) {
         it = converter_cache_.emplace(key, std::move(converter)).first;
@@ -233,6 +276,10 @@ void UniversalSampleRateConverter::set_auto_optimize(bool enable) {
     auto_optimize_ = enable;
 }
 
+void UniversalSampleRateConverter::set_quality(ResampleQuality quality) {
+    quality_ = quality;
+}
+
 void UniversalSampleRateConverter::clear_cache() {
     converter_cache_.clear();
 }
@@ -243,11 +290,14 @@ size_t UniversalSampleRateConverter::get_cache_size() const {
 
 std::vector<std::string> UniversalSampleRateConverter::get_cached_conversions() {
     std::vector<std::string> conversions;
-    for (const auto& [key, _] : converter_cache_) {
+    for (const auto& [key, converter] : converter_cache_) {
+        const auto* cascaded = static_cast<const CascadedSampleRateConverter*>(converter.get());
         conversions.push_back(
             std::to_string(key.input_rate) + "Hz → " +
             std::to_string(key.output_rate) + "Hz (" +
-            std::to_string(key.channels) + " channels)"
+            std::to_string(key.channels) + " channels, " +
+            EnhancedSampleRateConverter::get_quality_name(key.quality) + "): " +
+            CascadedSampleRateConverter::describe(cascaded->get_stages())
         );
     }
     return conversions;
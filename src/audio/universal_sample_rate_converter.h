@@ -15,6 +15,8 @@
 
 namespace audio {
 
+enum class ResampleQuality;
+
 /**
  * @brief Common audio sample rates supported
  */
@@ -77,10 +79,40 @@ struct AudioSampleRate {
      * Get description for rate
      */
     static std::string get_rate_description(int rate);
+
+    /**
+     * Get rate family base (44100 or 48000)
+     * @return Family base, or 0 if the rate belongs to neither family
+     */
+    static int get_rate_family(int rate);
+
+    /**
+     * Check if one rate is an integer multiple of the other
+     */
+    static bool is_integer_ratio(int rate_a, int rate_b);
+
+    /**
+     * Select the device rate that plays a track with the least conversion
+     *
+     * Prefers the track rate itself, then the closest supported rate an
+     * integer ratio away (upsampling before downsampling).
+     * @param track_rate Track sample rate
+     * @param supported_rates Rates the device accepts (empty: studio rates)
+     * @param fallback_rate Rate used when no supported rate is an integer ratio away
+     * @return Selected device rate
+     */
+    static int select_device_rate(int track_rate, const std::vector<int>& supported_rates,
+                                  int fallback_rate);
 };
 
 /**
  * @brief Universal sample rate converter with caching
+ *
+ * Each conversion is planned as a CascadedSampleRateConverter: half-band
+ * 2x stages for the power-of-two part of the ratio plus one fractional
+ * stage, so 705600 -> 44100 costs a few short filters instead of one long
+ * filter at the input rate. Planned converters are cached per rates,
+ * channels and quality.
  */
 class UniversalSampleRateConverter {
 private:
@@ -88,11 +120,13 @@ private:
         int input_rate;
         int output_rate;
         int channels;
+        ResampleQuality quality;
 
         bool operator==(const ConversionCacheKey& other) const {
             return input_rate == other.input_rate &&
                    output_rate == other.output_rate &&
-                   channels == other.channels;
+                   channels == other.channels &&
+                   quality == other.quality;
         }
     };
 
@@ -100,7 +134,8 @@ private:
         size_t operator()(const ConversionCacheKey& key) const {
             return std::hash<int>()(key.input_rate) ^
                    std::hash<int>()(key.output_rate * 17) ^
-                   std::hash<int>()(key.channels * 31);
+                   std::hash<int>()(key.channels * 31) ^
+                   std::hash<int>()(static_cast<int>(key.quality) * 131);
         }
     };
 
@@ -109,6 +144,7 @@ private:
 
     int default_output_rate_;
     bool auto_optimize_;
+    ResampleQuality quality_;
 
     /**
      * Get or create converter for specific conversion
@@ -171,6 +207,17 @@ public:
      */
     void set_auto_optimize(bool enable);
 
+    /**
+     * Set quality for new conversions (Fast by default).
+     * Converters already cached for other qualities are kept.
+     */
+    void set_quality(ResampleQuality quality);
+
+    /**
+     * Get quality used for new conversions
+     */
+    ResampleQuality get_quality() const { return quality_; }
+
     /**
      * Clear converter cache
      */
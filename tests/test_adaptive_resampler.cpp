@@ -0,0 +1,274 @@
+#include "../src/audio/adaptive_resampler.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace audio;
+
+namespace {
+
+const int CHANNELS = 2;
+const int INPUT_RATE = 44100;
+const int OUTPUT_RATE = 48000;
+const int BLOCK = 256;
+const double TONE = 1000.0;
+
+// Streams a sine through the converter one callback at a time
+class SineFeeder {
+public:
+    explicit SineFeeder(AdaptiveSampleRateConverter& converter, int input_rate = INPUT_RATE, int block = BLOCK)
+        : converter_(converter), input_rate_(input_rate), block_(block), position_(0)
+        , input_(static_cast<size_t>(block) * CHANNELS), output_(static_cast<size_t>(block) * 2 * CHANNELS) {
+    }
+
+    void step() {
+        for (int i = 0; i < block_; ++i) {
+            float value = static_cast<float>(0.5 * std::sin(2.0 * M_PI * TONE * (position_ + i) / input_rate_));
+            for (int ch = 0; ch < CHANNELS; ++ch) {
+                input_[static_cast<size_t>(i) * CHANNELS + ch] = value;
+            }
+        }
+        position_ += block_;
+
+        int generated = converter_.convert(input_.data(), block_, output_.data(), block_ * 2);
+        for (int i = 0; i < generated; ++i) {
+            history_.push_back(output_[static_cast<size_t>(i) * CHANNELS]);
+        }
+    }
+
+    // First channel of everything produced so far
+    const std::vector<float>& history() const { return history_; }
+
+private:
+    AdaptiveSampleRateConverter& converter_;
+    int input_rate_;
+    int block_;
+    long position_;
+    std::vector<float> input_;
+    std::vector<float> output_;
+    std::vector<float> history_;
+};
+
+// Largest step between neighbouring samples after the filter start-up
+float max_step(const std::vector<float>& samples, size_t skip) {
+    float largest = 0.0f;
+    for (size_t i = skip + 1; i < samples.size(); ++i) {
+        largest = std::max(largest, std::fabs(samples[i] - samples[i - 1]));
+    }
+    return largest;
+}
+
+// Delay in output frames of the test tone over samples [begin, end),
+// from a least squares fit of a sin + b cos
+double fitted_delay(const std::vector<float>& samples, size_t begin, size_t end, int output_rate) {
+    double w = 2.0 * M_PI * TONE / output_rate;
+    double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+    for (size_t n = begin; n < end; ++n) {
+        double s = std::sin(w * n);
+        double c = std::cos(w * n);
+        ss += s * s;
+        sc += s * c;
+        cc += c * c;
+        ys += samples[n] * s;
+        yc += samples[n] * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+
+    // A sin(w (n - d)) = A cos(w d) sin(w n) - A sin(w d) cos(w n)
+    return std::atan2(-b, a) / w;
+}
+
+} // namespace
+
+TEST(AdaptiveResamplerTest, OverloadStepsDownAndIsLogged) {
+    AdaptiveSampleRateConverter converter(ResampleQuality::Fast, ResampleQuality::Best, true, 80.0);
+    ASSERT_TRUE(converter.initialize(INPUT_RATE, OUTPUT_RATE, CHANNELS));
+    ASSERT_EQ(converter.get_current_quality(), ResampleQuality::Good);
+
+    int notified = 0;
+    converter.set_transition_listener([&notified](const QualityTransition&) { notified++; });
+
+    SineFeeder feeder(converter);
+    for (int i = 0; i < AdaptiveSampleRateConverter::MIN_DECISION_CALLBACKS - 1; ++i) {
+        converter.report_callback(0.009, 0.010);   // 90% of the deadline
+        feeder.step();
+    }
+    EXPECT_EQ(converter.get_current_quality(), ResampleQuality::Good);
+
+    converter.report_callback(0.009, 0.010);
+    feeder.step();
+    EXPECT_EQ(converter.get_current_quality(), ResampleQuality::Fast);
+    EXPECT_TRUE(converter.is_crossfading());
+
+    std::vector<QualityTransition> log = converter.drain_transition_log();
+    ASSERT_EQ(log.size(), 1u);
+    EXPECT_EQ(log[0].from, ResampleQuality::Good);
+    EXPECT_EQ(log[0].to, ResampleQuality::Fast);
+    EXPECT_EQ(log[0].reason, QualityTransition::Reason::Overload);
+    EXPECT_NEAR(log[0].deadline_usage, 90.0, 1.0);
+    EXPECT_EQ(notified, 1);
+
+    // Already at the floor: overload is logged no further
+    for (int i = 0; i < 50; ++i) {
+        converter.report_callback(0.009, 0.010);
+        feeder.step();
+    }
+    EXPECT_EQ(converter.get_current_quality(), ResampleQuality::Fast);
+    EXPECT_FALSE(converter.is_crossfading());
+    EXPECT_TRUE(converter.drain_transition_log().empty());
+}
+
+TEST(AdaptiveResamplerTest, HeadroomStepsUpOnlyAfterHold) {
+    AdaptiveSampleRateConverter converter(ResampleQuality::Fast, ResampleQuality::High, true, 80.0);
+    ASSERT_TRUE(converter.initialize(INPUT_RATE, OUTPUT_RATE, CHANNELS));
+
+    SineFeeder feeder(converter);
+    for (int i = 0; i < AdaptiveSampleRateConverter::UPGRADE_HOLD_CALLBACKS - 1; ++i) {
+        converter.report_callback(0.001, 0.010);
+        feeder.step();
+    }
+    EXPECT_EQ(converter.get_current_quality(), ResampleQuality::Good);
+
+    // One busy callback restarts the hold
+    converter.report_callback(0.009, 0.010);
+    feeder.step();
+    converter.report_callback(0.001, 0.010);
+    feeder.step();
+    EXPECT_EQ(converter.get_current_quality(), ResampleQuality::Good);
+
+    for (int i = 0; i < AdaptiveSampleRateConverter::UPGRADE_HOLD_CALLBACKS * 4; ++i) {
+        converter.report_callback(0.001, 0.010);
+        feeder.step();
+    }
+    EXPECT_EQ(converter.get_current_quality(), ResampleQuality::High);
+
+    std::vector<QualityTransition> log = converter.drain_transition_log();
+    ASSERT_EQ(log.size(), 1u);
+    EXPECT_EQ(log[0].reason, QualityTransition::Reason::Headroom);
+}
+
+TEST(AdaptiveResamplerTest, RangeChangeCrossfadesToAllowedQuality) {
+    AdaptiveSampleRateConverter converter(ResampleQuality::Fast, ResampleQuality::Best, false);
+    ASSERT_TRUE(converter.initialize(INPUT_RATE, OUTPUT_RATE, CHANNELS));
+
+    converter.set_quality_range(ResampleQuality::High, ResampleQuality::Best);
+    EXPECT_EQ(converter.get_current_quality(), ResampleQuality::High);
+    EXPECT_TRUE(converter.is_crossfading());
+
+    std::vector<QualityTransition> log = converter.drain_transition_log();
+    ASSERT_EQ(log.size(), 1u);
+    EXPECT_EQ(log[0].reason, QualityTransition::Reason::Range);
+}
+
+TEST(AdaptiveResamplerTest, QualitySwitchesDoNotClick) {
+    AdaptiveSampleRateConverter converter(ResampleQuality::Fast, ResampleQuality::Best, false);
+    ASSERT_TRUE(converter.initialize(INPUT_RATE, OUTPUT_RATE, CHANNELS));
+
+    SineFeeder feeder(converter);
+    const ResampleQuality sequence[] = {
+        ResampleQuality::Best, ResampleQuality::Fast, ResampleQuality::High, ResampleQuality::Good
+    };
+
+    for (ResampleQuality quality : sequence) {
+        for (int i = 0; i < 20; ++i) {
+            feeder.step();
+        }
+        converter.set_quality_range(quality, quality);
+        ASSERT_TRUE(converter.is_crossfading());
+    }
+    for (int i = 0; i < 20; ++i) {
+        feeder.step();
+    }
+    EXPECT_FALSE(converter.is_crossfading());
+    EXPECT_EQ(converter.drain_transition_log().size(), 4u);
+
+    // A 0.5 amplitude 1 kHz sine moves at most 0.065 per sample at 48 kHz;
+    // restarting a filter from silence would jump by up to 0.5
+    EXPECT_LT(max_step(feeder.history(), 64), 0.1f);
+}
+
+TEST(AdaptiveResamplerTest, QualitySwitchesKeepTheSignalDelay) {
+    const int rates[][2] = { { INPUT_RATE, OUTPUT_RATE }, { OUTPUT_RATE, INPUT_RATE } };
+    const ResampleQuality sequence[] = {
+        ResampleQuality::Best, ResampleQuality::Fast, ResampleQuality::Good,
+        ResampleQuality::High, ResampleQuality::Fast, ResampleQuality::Good, ResampleQuality::Best
+    };
+
+    // Callbacks shorter and longer than one crossfade step
+    const int blocks[] = { BLOCK, 3 * AdaptiveSampleRateConverter::CROSSFADE_BLOCK_FRAMES + 77 };
+
+    for (const auto& rate : rates) {
+        for (int block : blocks) {
+            AdaptiveSampleRateConverter converter(ResampleQuality::Fast, ResampleQuality::Best, false);
+            ASSERT_TRUE(converter.initialize(rate[0], rate[1], CHANNELS));
+            converter.set_quality_range(ResampleQuality::Fast, ResampleQuality::Fast);
+
+            SineFeeder feeder(converter, rate[0], block);
+            for (int i = 0; i < 20; ++i) {
+                feeder.step();
+            }
+            ASSERT_FALSE(converter.is_crossfading());
+
+            for (ResampleQuality quality : sequence) {
+                size_t before_end = feeder.history().size();
+                double before = fitted_delay(feeder.history(), before_end - 2048, before_end, rate[1]);
+
+                converter.set_quality_range(quality, quality);
+                ASSERT_TRUE(converter.is_crossfading());
+                for (int i = 0; i < 20; ++i) {
+                    feeder.step();
+                }
+                ASSERT_FALSE(converter.is_crossfading());
+
+                size_t after_end = feeder.history().size();
+                double after = fitted_delay(feeder.history(), after_end - 2048, after_end, rate[1]);
+                EXPECT_NEAR(after, before, 0.05)
+                    << rate[0] << " -> " << rate[1] << " Hz in blocks of " << block << ", switching to "
+                    << EnhancedSampleRateConverter::get_quality_name(quality);
+
+                // The fade itself mixes two copies of the same signal
+                double across = fitted_delay(feeder.history(), before_end - 1024, after_end, rate[1]);
+                EXPECT_NEAR(across, before, 0.05);
+            }
+        }
+    }
+}
+
+TEST(AdaptiveResamplerTest, TransitionLogHoldsWhatWasNotDrained) {
+    AdaptiveSampleRateConverter converter(ResampleQuality::Fast, ResampleQuality::Best, false);
+    ASSERT_TRUE(converter.initialize(INPUT_RATE, OUTPUT_RATE, CHANNELS));
+
+    // Alternate between two qualities, letting each fade finish
+    SineFeeder feeder(converter);
+    auto switches = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            ResampleQuality quality = converter.get_current_quality() == ResampleQuality::Fast ?
+                ResampleQuality::Best : ResampleQuality::Fast;
+            converter.set_quality_range(quality, quality);
+            for (int step = 0; step < 4; ++step) {
+                feeder.step();
+            }
+            ASSERT_FALSE(converter.is_crossfading());
+        }
+    };
+
+    switches(3);
+    EXPECT_EQ(converter.drain_transition_log().size(), 3u);
+    EXPECT_TRUE(converter.drain_transition_log().empty());
+
+    // Nobody draining: the log keeps the oldest changes and counts the rest
+    switches(AdaptiveSampleRateConverter::MAX_LOG_ENTRIES + 5);
+    EXPECT_EQ(converter.get_dropped_transitions(), 5u);
+    std::vector<QualityTransition> log = converter.drain_transition_log();
+    ASSERT_EQ(log.size(), AdaptiveSampleRateConverter::MAX_LOG_ENTRIES);
+    EXPECT_EQ(log[0].from, ResampleQuality::Fast);
+    EXPECT_EQ(log[0].to, ResampleQuality::Best);
+
+    // Draining made room again
+    switches(1);
+    EXPECT_EQ(converter.drain_transition_log().size(), 1u);
+    EXPECT_EQ(converter.get_dropped_transitions(), 5u);
+}
@@ -0,0 +1,164 @@
+#include "../src/audio/cascaded_resampler.h"
+#include "../src/audio/enhanced_sample_rate_converter.h"
+#include "../src/audio/universal_sample_rate_converter.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace audio;
+
+namespace {
+
+const int CHANNELS = 2;
+
+std::vector<float> make_sine(double frequency, int rate, int frames) {
+    std::vector<float> samples(static_cast<size_t>(frames) * CHANNELS);
+    for (int i = 0; i < frames; ++i) {
+        float value = static_cast<float>(0.5 * std::sin(2.0 * M_PI * frequency * i / rate));
+        for (int ch = 0; ch < CHANNELS; ++ch) {
+            samples[static_cast<size_t>(i) * CHANNELS + ch] = value;
+        }
+    }
+    return samples;
+}
+
+// Convert in fixed blocks, collecting all output
+std::vector<float> convert_all(ISampleRateConverter& converter, const std::vector<float>& input,
+                               int input_rate, int output_rate, int block) {
+    const int input_frames = static_cast<int>(input.size() / CHANNELS);
+    std::vector<float> output;
+    std::vector<float> block_output;
+
+    for (int offset = 0; offset < input_frames; offset += block) {
+        int frames = std::min(block, input_frames - offset);
+        int max_output = static_cast<int>(static_cast<int64_t>(frames) * output_rate / input_rate) + 64;
+        block_output.resize(static_cast<size_t>(max_output) * CHANNELS);
+
+        int generated = converter.convert(input.data() + static_cast<size_t>(offset) * CHANNELS, frames,
+                                          block_output.data(), max_output);
+        output.insert(output.end(), block_output.begin(), block_output.begin() + generated * CHANNELS);
+    }
+    return output;
+}
+
+// RMS of the first channel, skipping the filter start-up
+double rms_after(const std::vector<float>& samples, int skip_frames) {
+    double sum = 0.0;
+    int count = 0;
+    for (size_t i = static_cast<size_t>(skip_frames) * CHANNELS; i < samples.size(); i += CHANNELS) {
+        sum += samples[i] * samples[i];
+        count++;
+    }
+    return count > 0 ? std::sqrt(sum / count) : 0.0;
+}
+
+int count_stages(const std::vector<ConversionStage>& stages, ConversionStage::Type type) {
+    return static_cast<int>(std::count_if(stages.begin(), stages.end(),
+                                          [type](const ConversionStage& stage) { return stage.type == type; }));
+}
+
+} // namespace
+
+TEST(CascadedResamplerTest, PlansHalfBandChainsForLargeRatios) {
+    auto plan = CascadedSampleRateConverter::plan(705600, 44100, ResampleQuality::High);
+    ASSERT_EQ(plan.size(), 4u);
+    EXPECT_EQ(count_stages(plan, ConversionStage::Type::Decimate2), 4);
+    EXPECT_EQ(plan.back().output_rate, 44100);
+
+    plan = CascadedSampleRateConverter::plan(768000, 44100, ResampleQuality::High);
+    ASSERT_EQ(plan.size(), 5u);
+    EXPECT_EQ(count_stages(plan, ConversionStage::Type::Decimate2), 4);
+    EXPECT_EQ(plan.back().type, ConversionStage::Type::Fractional);
+    EXPECT_EQ(plan.back().input_rate, 48000);
+
+    plan = CascadedSampleRateConverter::plan(44100, 768000, ResampleQuality::High);
+    ASSERT_EQ(plan.size(), 5u);
+    EXPECT_EQ(plan.front().type, ConversionStage::Type::Fractional);
+    EXPECT_EQ(plan.front().output_rate, 48000);
+    EXPECT_EQ(count_stages(plan, ConversionStage::Type::Interpolate2), 4);
+
+    plan = CascadedSampleRateConverter::plan(48000, 44100, ResampleQuality::High);
+    ASSERT_EQ(plan.size(), 1u);
+    EXPECT_EQ(plan.front().type, ConversionStage::Type::Fractional);
+
+    EXPECT_TRUE(CascadedSampleRateConverter::plan(48000, 48000, ResampleQuality::High).empty());
+}
+
+TEST(CascadedResamplerTest, LongFilterRunsAtLowRateEnd) {
+    const int long_taps = CascadedSampleRateConverter::halfband_taps_for(ResampleQuality::Best);
+
+    auto plan = CascadedSampleRateConverter::plan(768000, 48000, ResampleQuality::Best);
+    ASSERT_EQ(plan.size(), 4u);
+    EXPECT_EQ(plan.back().taps, long_taps);
+    EXPECT_EQ(plan.front().taps, CascadedSampleRateConverter::SHORT_HALFBAND_TAPS);
+
+    plan = CascadedSampleRateConverter::plan(48000, 768000, ResampleQuality::Best);
+    ASSERT_EQ(plan.size(), 4u);
+    EXPECT_EQ(plan.front().taps, long_taps);
+    EXPECT_EQ(plan.back().taps, CascadedSampleRateConverter::SHORT_HALFBAND_TAPS);
+}
+
+TEST(CascadedResamplerTest, DecimatorIndependentOfBlockSize) {
+    std::vector<float> input = make_sine(1000.0, 96000, 4801);
+
+    HalfBandDecimator whole(31);
+    ASSERT_TRUE(whole.initialize(96000, 48000, CHANNELS));
+    std::vector<float> expected = convert_all(whole, input, 96000, 48000, 4801);
+
+    HalfBandDecimator blocked(31);
+    ASSERT_TRUE(blocked.initialize(96000, 48000, CHANNELS));
+    std::vector<float> actual = convert_all(blocked, input, 96000, 48000, 37);
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(actual[i], expected[i]) << "sample " << i;
+    }
+}
+
+TEST(CascadedResamplerTest, PreservesPassbandTone) {
+    const std::pair<int, int> conversions[] = {
+        { 705600, 44100 }, { 768000, 48000 }, { 768000, 44100 }, { 44100, 768000 }
+    };
+
+    for (const auto& conversion : conversions) {
+        CascadedSampleRateConverter converter(ResampleQuality::High);
+        ASSERT_TRUE(converter.initialize(conversion.first, conversion.second, CHANNELS));
+
+        std::vector<float> input = make_sine(1000.0, conversion.first, conversion.first / 4);
+        std::vector<float> output = convert_all(converter, input, conversion.first, conversion.second, 1024);
+
+        ASSERT_GT(output.size(), static_cast<size_t>(conversion.second / 5) * CHANNELS);
+        EXPECT_NEAR(rms_after(output, converter.get_latency() + 64), 0.5 / std::sqrt(2.0), 0.01)
+            << conversion.first << " -> " << conversion.second;
+    }
+}
+
+TEST(CascadedResamplerTest, RejectsToneAboveOutputNyquist) {
+    CascadedSampleRateConverter converter(ResampleQuality::Best);
+    ASSERT_TRUE(converter.initialize(705600, 44100, CHANNELS));
+
+    // 30 kHz would alias to 14.1 kHz
+    std::vector<float> input = make_sine(30000.0, 705600, 705600 / 4);
+    std::vector<float> output = convert_all(converter, input, 705600, 44100, 1024);
+
+    EXPECT_LT(rms_after(output, converter.get_latency() + 64), 0.01);
+}
+
+TEST(CascadedResamplerTest, UniversalCachesPlanPerQuality) {
+    UniversalSampleRateConverter universal;
+    std::vector<float> input = make_sine(1000.0, 705600, 7056);
+    std::vector<float> output(1024 * CHANNELS);
+
+    EXPECT_GT(universal.convert(input.data(), 7056, output.data(), 1024, 705600, 44100, CHANNELS), 0);
+    EXPECT_GT(universal.convert(input.data(), 7056, output.data(), 1024, 705600, 44100, CHANNELS), 0);
+    EXPECT_EQ(universal.get_cache_size(), 1u);
+
+    universal.set_quality(ResampleQuality::Best);
+    EXPECT_GT(universal.convert(input.data(), 7056, output.data(), 1024, 705600, 44100, CHANNELS), 0);
+    EXPECT_EQ(universal.get_cache_size(), 2u);
+
+    std::vector<std::string> conversions = universal.get_cached_conversions();
+    ASSERT_EQ(conversions.size(), 2u);
+    EXPECT_NE(conversions[0].find("2:1 x4"), std::string::npos) << conversions[0];
+}
@@ -0,0 +1,269 @@
+#include "mp_dsp.h"
+#include "mp_plugin.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Factory of the plugin source compiled into this test
+extern "C" mp::IDSPProcessor* create_dsp_processor();
+extern "C" void destroy_dsp_processor(mp::IDSPProcessor* processor);
+
+using namespace mp;
+
+namespace {
+
+const uint32_t SAMPLE_RATE = 48000;
+const uint32_t HEAD_BLOCK = 0;      // ConvolutionDSP parameter indices
+const uint32_t TAIL_BLOCK = 1;
+
+// Deterministic values in [-1, 1)
+class Random {
+public:
+    explicit Random(uint32_t seed) : state_(seed) {}
+
+    float next() {
+        state_ = state_ * 1664525u + 1013904223u;
+        return static_cast<float>(static_cast<int32_t>(state_)) / 2147483648.0f;
+    }
+
+    // Uniform in [low, high]
+    uint32_t range(uint32_t low, uint32_t high) {
+        state_ = state_ * 1664525u + 1013904223u;
+        return low + (state_ >> 8) % (high - low + 1);
+    }
+
+private:
+    uint32_t state_;
+};
+
+typedef std::vector<std::vector<float>> Planar;
+
+// Decaying noise, like a room response
+Planar make_response(uint16_t channels, uint32_t frames, uint32_t seed) {
+    Random random(seed);
+    Planar response(channels, std::vector<float>(frames));
+    for (auto& taps : response) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            taps[i] = 0.2f * random.next() * std::exp(-4.0f * i / frames);
+        }
+    }
+    return response;
+}
+
+std::vector<float> make_signal(uint16_t channels, uint32_t frames, uint32_t seed) {
+    Random random(seed);
+    std::vector<float> signal(static_cast<size_t>(channels) * frames);
+    for (float& value : signal) {
+        value = 0.5f * random.next();
+    }
+    return signal;
+}
+
+// Stream channel ch of the input through response channel ch % responses,
+// delayed by latency. Input before gate_frame is treated as silence, which
+// is what an engine that started at gate_frame has seen.
+std::vector<double> reference(const std::vector<float>& input, uint16_t channels, const Planar& response,
+                              uint32_t latency, uint32_t gate_frame = 0) {
+    const size_t frames = input.size() / channels;
+    std::vector<double> output(input.size(), 0.0);
+    for (uint16_t ch = 0; ch < channels; ++ch) {
+        const std::vector<float>& taps = response[ch % response.size()];
+        for (size_t n = latency; n < frames; ++n) {
+            double sum = 0.0;
+            const size_t t = n - latency;
+            for (size_t k = 0; k < taps.size() && k <= t; ++k) {
+                if (t - k >= gate_frame) {
+                    sum += static_cast<double>(taps[k]) * input[(t - k) * channels + ch];
+                }
+            }
+            output[n * channels + ch] = sum;
+        }
+    }
+    return output;
+}
+
+double max_error(const std::vector<float>& output, const std::vector<double>& expected,
+                 uint16_t channels, size_t first_frame, size_t end_frame) {
+    double worst = 0.0;
+    for (size_t i = first_frame * channels; i < end_frame * channels; ++i) {
+        worst = std::max(worst, std::fabs(output[i] - expected[i]));
+    }
+    return worst;
+}
+
+class ConvolutionDSPTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        processor_ = create_dsp_processor();
+        loader_ = static_cast<IImpulseResponseLoader*>(
+            dynamic_cast<IPlugin*>(processor_)->get_service(SERVICE_IMPULSE_RESPONSE));
+        ASSERT_NE(loader_, nullptr);
+    }
+
+    void TearDown() override {
+        destroy_dsp_processor(processor_);
+    }
+
+    void initialize(uint16_t channels) {
+        channels_ = channels;
+        DSPConfig config = {};
+        config.sample_rate = SAMPLE_RATE;
+        config.channels = channels;
+        config.format = SampleFormat::Float32;
+        config.max_buffer_frames = 512;
+        ASSERT_EQ(processor_->initialize(&config), Result::Success);
+    }
+
+    Result set_response(const Planar& response, uint32_t sample_rate = SAMPLE_RATE) {
+        std::vector<const float*> pointers;
+        for (const auto& taps : response) {
+            pointers.push_back(taps.data());
+        }
+        return loader_->set_impulse_response(pointers.data(), static_cast<uint32_t>(pointers.size()),
+                                             static_cast<uint32_t>(response[0].size()), sample_rate);
+    }
+
+    // Process frames [begin, end) of signal in place, in callbacks of
+    // random length
+    void process(std::vector<float>& signal, uint32_t begin, uint32_t end, Random& sizes) {
+        while (begin < end) {
+            AudioBuffer buffer = {};
+            buffer.data = signal.data() + static_cast<size_t>(begin) * channels_;
+            buffer.sample_rate = SAMPLE_RATE;
+            buffer.channels = channels_;
+            buffer.format = SampleFormat::Float32;
+            buffer.frames = std::min(sizes.range(1, 1500), end - begin);
+            buffer.capacity = buffer.frames;
+            ASSERT_EQ(processor_->process(&buffer, nullptr), Result::Success);
+            begin += buffer.frames;
+        }
+    }
+
+    IDSPProcessor* processor_;
+    IImpulseResponseLoader* loader_;
+    uint16_t channels_;
+};
+
+} // namespace
+
+TEST_F(ConvolutionDSPTest, MatchesDirectConvolutionDelayedByLatency) {
+    // Stereo response on stereo, and a mono response on three channels
+    const uint16_t layouts[][2] = { { 2, 2 }, { 3, 1 } };
+
+    for (const auto& layout : layouts) {
+        SCOPED_TRACE(layout[0]);
+        TearDown();
+        SetUp();
+        initialize(layout[0]);
+        ASSERT_EQ(processor_->set_parameter(HEAD_BLOCK, 64.0f), Result::Success);
+        ASSERT_EQ(processor_->set_parameter(TAIL_BLOCK, 1024.0f), Result::Success);
+
+        // Long enough for head, middle and tail segments
+        Planar response = make_response(layout[1], 6000, 11);
+        ASSERT_EQ(set_response(response), Result::Success);
+        const uint32_t latency = processor_->get_latency_samples();
+        EXPECT_EQ(latency, 64u);
+
+        const uint32_t frames = 24000;
+        std::vector<float> signal = make_signal(layout[0], frames, 5);
+        std::vector<double> expected = reference(signal, layout[0], response, latency);
+
+        Random sizes(3);
+        process(signal, 0, frames, sizes);
+        EXPECT_LT(max_error(signal, expected, layout[0], 0, frames), 1e-4);
+    }
+}
+
+TEST_F(ConvolutionDSPTest, PartitionAndResponseChangesWhileProcessing) {
+    const uint16_t channels = 2;
+    initialize(channels);
+    ASSERT_EQ(processor_->set_parameter(HEAD_BLOCK, 256.0f), Result::Success);
+    ASSERT_EQ(processor_->set_parameter(TAIL_BLOCK, 4096.0f), Result::Success);
+
+    Planar first = make_response(channels, 3000, 21);
+    Planar second = make_response(channels, 5000, 22);
+    ASSERT_EQ(set_response(first), Result::Success);
+
+    const uint32_t frames = 36000;
+    const uint32_t resized = 12000;
+    const uint32_t swapped = 24000;
+    std::vector<float> input = make_signal(channels, frames, 9);
+    std::vector<float> signal = input;
+    Random sizes(17);
+
+    process(signal, 0, resized, sizes);
+    EXPECT_LT(max_error(signal, reference(input, channels, first, 256), channels, 0, resized), 1e-4);
+
+    // New partition sizes: the new engine starts from silence at the next
+    // callback, and its latency is reported from that callback on
+    ASSERT_EQ(processor_->set_parameter(HEAD_BLOCK, 32.0f), Result::Success);
+    ASSERT_EQ(processor_->set_parameter(TAIL_BLOCK, 512.0f), Result::Success);
+    EXPECT_EQ(processor_->get_latency_samples(), 256u);
+    process(signal, resized, resized + 1, sizes);
+    EXPECT_EQ(processor_->get_latency_samples(), 32u);
+    process(signal, resized + 1, swapped, sizes);
+    EXPECT_LT(max_error(signal, reference(input, channels, first, 32, resized), channels, resized, swapped),
+              1e-4);
+
+    ASSERT_EQ(set_response(second), Result::Success);
+    EXPECT_EQ(processor_->get_latency_samples(), 32u);
+    process(signal, swapped, frames, sizes);
+    EXPECT_LT(max_error(signal, reference(input, channels, second, 32, swapped), channels, swapped, frames),
+              1e-4);
+}
+
+TEST_F(ConvolutionDSPTest, BypassKeepsTheLatency) {
+    const uint16_t channels = 2;
+    initialize(channels);
+    ASSERT_EQ(processor_->set_parameter(HEAD_BLOCK, 128.0f), Result::Success);
+    Planar response = make_response(channels, 2000, 31);
+    ASSERT_EQ(set_response(response), Result::Success);
+    const uint32_t latency = processor_->get_latency_samples();
+    ASSERT_EQ(latency, 128u);
+
+    const uint32_t frames = 20000;
+    const uint32_t bypassed = 6000;
+    const uint32_t resumed = 13000;
+    std::vector<float> input = make_signal(channels, frames, 13);
+    std::vector<float> signal = input;
+    Random sizes(29);
+
+    process(signal, 0, bypassed, sizes);
+
+    // The dry signal comes out one head block late, continuing seamlessly
+    // from the filtered input that was already queued
+    processor_->set_bypass(true);
+    EXPECT_TRUE(processor_->is_bypassed());
+    EXPECT_EQ(processor_->get_latency_samples(), latency);
+    process(signal, bypassed, resumed, sizes);
+    for (size_t i = static_cast<size_t>(bypassed) * channels; i < static_cast<size_t>(resumed) * channels; ++i) {
+        ASSERT_EQ(signal[i], input[i - static_cast<size_t>(latency) * channels]) << "sample " << i;
+    }
+
+    // Filtering restarts from silence, at the same latency
+    processor_->set_bypass(false);
+    process(signal, resumed, frames, sizes);
+    EXPECT_LT(max_error(signal, reference(input, channels, response, latency, resumed), channels, resumed, frames),
+              1e-4);
+}
+
+TEST_F(ConvolutionDSPTest, RefusesResponseAtAnotherRate) {
+    const uint16_t channels = 2;
+    initialize(channels);
+    Planar response = make_response(channels, 1500, 41);
+    ASSERT_EQ(set_response(response), Result::Success);
+
+    Planar other = make_response(channels, 1500, 42);
+    EXPECT_EQ(set_response(other, 44100), Result::NotSupported);
+
+    // The response that was accepted stays in use
+    const uint32_t frames = 8000;
+    std::vector<float> input = make_signal(channels, frames, 43);
+    std::vector<float> signal = input;
+    Random sizes(47);
+    process(signal, 0, frames, sizes);
+    const uint32_t latency = processor_->get_latency_samples();
+    EXPECT_LT(max_error(signal, reference(input, channels, response, latency), channels, 0, frames), 1e-4);
+}
@@ -0,0 +1,146 @@
+#include "../src/audio/drift_compensating_resampler.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace audio;
+
+namespace {
+
+const int OUTPUT_RATE = 48000;
+const int DEVICE_PERIOD = 256;     // Frames the device takes at a time
+
+// Output buffer drained by a device whose clock is off by drift_ppm
+class SimulatedDevice {
+public:
+    explicit SimulatedDevice(double drift_ppm)
+        : frames_per_second_(OUTPUT_RATE * (1.0 + drift_ppm * 1e-6)), due_(0.0), queued_(0) {
+    }
+
+    void write(int frames) { queued_ += frames; }
+
+    // Advance the device clock, consuming whole periods
+    void play(double seconds) {
+        due_ += frames_per_second_ * seconds;
+        while (due_ >= DEVICE_PERIOD) {
+            queued_ -= DEVICE_PERIOD;
+            due_ -= DEVICE_PERIOD;
+        }
+    }
+
+    long queued() const { return queued_; }
+
+private:
+    double frames_per_second_;
+    double due_;
+    long queued_;
+};
+
+} // namespace
+
+TEST(DriftCompensatingResamplerTest, ControllerHoldsTwoDevicesForAnHour) {
+    const double drifts[] = { 120.0, -250.0 };
+
+    for (double drift_ppm : drifts) {
+        DriftController controller;
+        controller.set_output_rate(OUTPUT_RATE);
+        SimulatedDevice device(drift_ppm);
+
+        // 10 ms callbacks: the source writes 480 frames scaled by the correction
+        double pending = 0.0;
+        long min_fill = 1L << 30;
+        long max_fill = -(1L << 30);
+        device.write(4096);
+
+        for (int tick = 0; tick < 360000; ++tick) {
+            controller.update(static_cast<double>(device.queued()), 0.01);
+            pending += 480.0 * (1.0 + controller.get_correction());
+            int frames = static_cast<int>(pending);
+            pending -= frames;
+            device.write(frames);
+            device.play(0.01);
+
+            if (tick >= 30000) {   // After five minutes to lock
+                min_fill = std::min(min_fill, device.queued());
+                max_fill = std::max(max_fill, device.queued());
+            }
+        }
+
+        EXPECT_NEAR(controller.get_drift() * 1e6, drift_ppm, 2.0);
+        // Only the device period's sawtooth remains around the first reading
+        EXPECT_GE(min_fill, 4096 - DEVICE_PERIOD) << drift_ppm;
+        EXPECT_LE(max_fill, 4096 + DEVICE_PERIOD) << drift_ppm;
+    }
+}
+
+TEST(DriftCompensatingResamplerTest, CorrectionIsLimited) {
+    DriftController controller(DriftController::DEFAULT_TIME_CONSTANT, 500.0);
+    controller.set_output_rate(OUTPUT_RATE);
+    controller.set_target_fill(4800.0);
+
+    controller.update(0.0, 0.0);
+    for (int i = 0; i < 10000; ++i) {
+        controller.update(0.0, 0.01);   // Buffer stays empty
+    }
+    EXPECT_NEAR(controller.get_correction() * 1e6, 500.0, 1e-6);
+
+    // No wind-up: the integral does not run past the limit
+    EXPECT_LE(controller.get_drift() * 1e6, 500.0 + 1e-6);
+}
+
+TEST(DriftCompensatingResamplerTest, RatioScaleChangesOutputCount) {
+    const int input_frames = 44100 * 4;
+    std::vector<float> input(input_frames, 0.25f);
+    std::vector<float> output(input_frames * 2);
+
+    SincSampleRateConverter nominal(16);
+    ASSERT_TRUE(nominal.initialize(44100, 48000, 1));
+    int nominal_frames = nominal.convert(input.data(), input_frames, output.data(), input_frames * 2);
+
+    SincSampleRateConverter scaled(16);
+    ASSERT_TRUE(scaled.initialize(44100, 48000, 1));
+    scaled.set_ratio_scale(1.0 / 1.001);
+    int scaled_frames = scaled.convert(input.data(), input_frames, output.data(), input_frames * 2);
+
+    EXPECT_NEAR(scaled_frames - nominal_frames, nominal_frames * 0.001, 2.0);
+}
+
+TEST(DriftCompensatingResamplerTest, ResamplerLocksToFastDevice) {
+    const int input_rate = 44100;
+    const int block = 441;
+    const double drift_ppm = 200.0;
+
+    DriftCompensatingResampler resampler(16);
+    ASSERT_TRUE(resampler.initialize(input_rate, OUTPUT_RATE, 1));
+
+    SimulatedDevice device(drift_ppm);
+    device.write(4096);
+
+    std::vector<float> input(block);
+    std::vector<float> output(block * 2);
+    long position = 0;
+    long min_fill = 1L << 30;
+    long max_fill = -(1L << 30);
+
+    // Three minutes of 10 ms callbacks
+    for (int tick = 0; tick < 18000; ++tick) {
+        for (int i = 0; i < block; ++i) {
+            input[i] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * 440.0 * (position + i) / input_rate));
+        }
+        position += block;
+
+        resampler.update_fill_level(static_cast<int>(device.queued()));
+        device.write(resampler.convert(input.data(), block, output.data(), block * 2));
+        device.play(0.01);
+
+        if (tick >= 12000) {
+            min_fill = std::min(min_fill, device.queued());
+            max_fill = std::max(max_fill, device.queued());
+        }
+    }
+
+    EXPECT_NEAR(resampler.get_drift_ppm(), drift_ppm, 10.0);
+    EXPECT_GE(min_fill, 4096 - DEVICE_PERIOD);
+    EXPECT_LE(max_fill, 4096 + DEVICE_PERIOD);
+}
@@ -0,0 +1,402 @@
+#include "../core/dsp_chain.h"
+#include "mp_dsp.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace mp::core;
+
+namespace {
+
+// Counts heap allocations made while armed
+std::atomic<bool> counting_allocations(false);
+std::atomic<int> allocations(0);
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (counting_allocations.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+const uint16_t CHANNELS = 2;
+const uint32_t MAX_FRAMES = 64;
+
+// Applies y = x * gain + offset after a delay of some frames, in place or not
+class TestProcessor : public mp::IDSPProcessor {
+public:
+    TestProcessor(float gain, float offset, uint32_t delay, bool in_place, int* destroyed = nullptr)
+        : gain_(gain), offset_(offset), delay_(delay), in_place_(in_place), destroyed_(destroyed)
+        , initializations(0), resets(0), fail_initialize(false), work_us(0)
+        , last_output(nullptr), last_input(nullptr) {}
+
+    ~TestProcessor() override {
+        if (destroyed_) {
+            (*destroyed_)++;
+        }
+    }
+
+    mp::Result initialize(const mp::DSPConfig* config) override {
+        initializations++;
+        if (fail_initialize) {
+            return mp::Result::NotSupported;
+        }
+        config_ = *config;
+        history_.assign(static_cast<size_t>(delay_ + config->max_buffer_frames) * config->channels, 0.0f);
+        return mp::Result::Success;
+    }
+
+    mp::Result process(mp::AudioBuffer* input, mp::AudioBuffer* output) override {
+        if (work_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(work_us));
+        }
+        last_input = input->data;
+        last_output = output ? output->data : nullptr;
+        float* in = static_cast<float*>(input->data);
+        float* out = output ? static_cast<float*>(output->data) : in;
+        const size_t samples = static_cast<size_t>(input->frames) * config_.channels;
+        const size_t delayed = static_cast<size_t>(delay_) * config_.channels;
+
+        // history_ holds the delayed samples followed by this block
+        for (size_t i = 0; i < samples; ++i) {
+            history_[delayed + i] = in[i];
+        }
+        for (size_t i = 0; i < samples; ++i) {
+            out[i] = history_[i] * gain_ + offset_;
+        }
+        for (size_t i = 0; i < delayed; ++i) {
+            history_[i] = history_[samples + i];
+        }
+        if (output) {
+            output->frames = input->frames;
+        }
+        return mp::Result::Success;
+    }
+
+    uint32_t get_latency_samples() const override { return delay_; }
+    void reset() override { resets++; }
+    void set_bypass(bool) override {}
+    bool is_bypassed() const override { return false; }
+    uint32_t get_dsp_capabilities() const override {
+        return in_place_ ? static_cast<uint32_t>(mp::DSPCapability::InPlace) : 0;
+    }
+    uint32_t get_parameter_count() const override { return 0; }
+    mp::Result get_parameter_info(uint32_t, mp::DSPParameter*) const override { return mp::Result::InvalidParameter; }
+    mp::Result set_parameter(uint32_t, float) override { return mp::Result::InvalidParameter; }
+    float get_parameter(uint32_t) const override { return 0.0f; }
+    void shutdown() override {}
+
+    const mp::DSPConfig& config() const { return config_; }
+
+private:
+    float gain_;
+    float offset_;
+    uint32_t delay_;
+    bool in_place_;
+    int* destroyed_;
+    mp::DSPConfig config_;
+    std::vector<float> history_;
+
+public:
+    int initializations;
+    int resets;
+    bool fail_initialize;
+    uint32_t work_us;                  // Time each block takes
+    void* last_output;
+    void* last_input;
+};
+
+int destroy_calls = 0;
+
+void destroy_processor(mp::IDSPProcessor* processor) {
+    destroy_calls++;
+    delete processor;
+}
+
+// Run one block of a constant through the chain, returning the first sample
+float run(DSPChain& chain, float value, uint32_t frames = MAX_FRAMES) {
+    float* input = chain.input();
+    for (uint32_t i = 0; i < frames * CHANNELS; ++i) {
+        input[i] = value;
+    }
+    return chain.process(frames)[0];
+}
+
+} // namespace
+
+TEST(DSPChainTest, EmptyChainPassesBlocksThrough) {
+    DSPChain chain;
+    ASSERT_EQ(chain.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+
+    EXPECT_EQ(run(chain, 0.25f), 0.25f);
+    EXPECT_EQ(chain.get_latency_frames(), 0u);
+}
+
+TEST(DSPChainTest, InPlaceStagesShareABufferAndOthersPingPong) {
+    DSPChain chain;
+    ASSERT_EQ(chain.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+
+    auto* doubler = new TestProcessor(2.0f, 0.0f, 0, true);
+    auto* plus_one = new TestProcessor(1.0f, 1.0f, 0, false);
+    auto* tripler = new TestProcessor(3.0f, 0.0f, 0, false);
+    ASSERT_EQ(chain.add_stage(doubler, nullptr), mp::Result::Success);
+    ASSERT_EQ(chain.add_stage(plus_one, nullptr), mp::Result::Success);
+    ASSERT_EQ(chain.add_stage(tripler, nullptr), mp::Result::Success);
+
+    const float* result = chain.process(0);
+    EXPECT_EQ(run(chain, 1.0f), (1.0f * 2.0f + 1.0f) * 3.0f);
+
+    EXPECT_EQ(doubler->last_output, nullptr);
+    EXPECT_EQ(doubler->last_input, chain.input());
+    EXPECT_EQ(plus_one->last_input, chain.input());
+    EXPECT_NE(plus_one->last_output, chain.input());
+    EXPECT_EQ(tripler->last_input, plus_one->last_output);
+    EXPECT_EQ(tripler->last_output, chain.input());
+    EXPECT_EQ(result, chain.input());
+
+    for (const void* buffer : { plus_one->last_input, plus_one->last_output }) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer) % DSPChain::BUFFER_ALIGNMENT, 0u);
+    }
+}
+
+TEST(DSPChainTest, ReorderAndBypassDoNotAllocate) {
+    DSPChain chain;
+    ASSERT_EQ(chain.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+
+    auto* plus_one = new TestProcessor(1.0f, 1.0f, 0, false);
+    auto* doubler = new TestProcessor(2.0f, 0.0f, 0, true);
+    ASSERT_EQ(chain.add_stage(plus_one, nullptr), mp::Result::Success);
+    ASSERT_EQ(chain.add_stage(doubler, nullptr), mp::Result::Success);
+    const mp::IDSPProcessor* reversed[] = { doubler, plus_one };
+    const mp::IDSPProcessor* duplicated[] = { doubler, doubler };
+
+    counting_allocations = true;
+    float in_order = run(chain, 1.0f);
+    mp::Result reordered = chain.set_order(reversed, 2);
+    float after_reorder = run(chain, 1.0f);
+    mp::Result bypassed = chain.set_stage_bypassed(doubler, true);
+    float after_bypass = run(chain, 1.0f);
+    mp::Result rejected = chain.set_order(duplicated, 2);
+    counting_allocations = false;
+
+    EXPECT_EQ(allocations.load(), 0);
+    EXPECT_EQ(reordered, mp::Result::Success);
+    EXPECT_EQ(bypassed, mp::Result::Success);
+    EXPECT_EQ(rejected, mp::Result::InvalidParameter);
+    EXPECT_EQ(in_order, 4.0f);
+    EXPECT_EQ(after_reorder, 3.0f);
+    EXPECT_EQ(after_bypass, 2.0f);
+}
+
+TEST(DSPChainTest, LatencySumsActiveStagesAndDelaysTheSignal) {
+    DSPChain chain;
+    ASSERT_EQ(chain.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+
+    auto* first = new TestProcessor(1.0f, 0.0f, 10, false);
+    auto* second = new TestProcessor(1.0f, 0.0f, 20, true);
+    ASSERT_EQ(chain.add_stage(first, nullptr), mp::Result::Success);
+    ASSERT_EQ(chain.add_stage(second, nullptr), mp::Result::Success);
+    EXPECT_EQ(chain.get_latency_frames(), 30u);
+
+    // An impulse comes out exactly the summed latency later
+    float* input = chain.input();
+    std::fill(input, input + MAX_FRAMES * CHANNELS, 0.0f);
+    input[0] = 1.0f;
+    const float* output = chain.process(MAX_FRAMES);
+    for (uint32_t frame = 0; frame < MAX_FRAMES; ++frame) {
+        EXPECT_EQ(output[frame * CHANNELS], frame == 30 ? 1.0f : 0.0f) << "frame " << frame;
+    }
+
+    chain.set_stage_bypassed(second, true);
+    EXPECT_EQ(chain.get_latency_frames(), 10u);
+    chain.remove_stage(first);
+    EXPECT_EQ(chain.get_latency_frames(), 0u);
+}
+
+TEST(DSPChainTest, StagesFollowTheFormat) {
+    DSPChain chain;
+    auto* early = new TestProcessor(1.0f, 0.0f, 0, true);
+    auto* failing = new TestProcessor(5.0f, 0.0f, 7, true);
+    failing->fail_initialize = true;
+
+    // Added before a format is known: initialized by configure()
+    ASSERT_EQ(chain.add_stage(early, nullptr), mp::Result::Success);
+    EXPECT_EQ(early->initializations, 0);
+    ASSERT_EQ(chain.configure(44100, CHANNELS, MAX_FRAMES), mp::Result::Success);
+    EXPECT_EQ(early->initializations, 1);
+    EXPECT_EQ(early->config().sample_rate, 44100u);
+    EXPECT_EQ(early->config().max_buffer_frames, MAX_FRAMES);
+
+    // Added later: initialized at once, and refused if it cannot run
+    EXPECT_EQ(chain.add_stage(failing, nullptr), mp::Result::NotSupported);
+    EXPECT_EQ(chain.get_stage_count(), 1u);
+    failing->fail_initialize = false;
+    ASSERT_EQ(chain.add_stage(failing, nullptr), mp::Result::Success);
+
+    // Same format only resets; a new one initializes again
+    ASSERT_EQ(chain.configure(44100, CHANNELS, MAX_FRAMES), mp::Result::Success);
+    EXPECT_EQ(early->initializations, 1);
+    EXPECT_EQ(early->resets, 1);
+
+    // A stage that cannot take the new format sits out without its latency
+    failing->fail_initialize = true;
+    EXPECT_EQ(chain.configure(96000, CHANNELS, MAX_FRAMES), mp::Result::NotSupported);
+    EXPECT_EQ(early->config().sample_rate, 96000u);
+    EXPECT_EQ(chain.get_latency_frames(), 0u);
+    EXPECT_EQ(run(chain, 1.0f), 1.0f);
+}
+
+TEST(DSPChainTest, RemovedStagesAreFreedWithTheirDestroyFunction) {
+    int destroyed = 0;
+    destroy_calls = 0;
+    {
+        DSPChain chain;
+        auto* removed = new TestProcessor(1.0f, 0.0f, 0, true, &destroyed);
+        auto* kept = new TestProcessor(1.0f, 0.0f, 0, true, &destroyed);
+        ASSERT_EQ(chain.add_stage(removed, destroy_processor), mp::Result::Success);
+        ASSERT_EQ(chain.add_stage(kept, nullptr), mp::Result::Success);
+        EXPECT_EQ(chain.add_stage(kept, nullptr), mp::Result::InvalidParameter);
+
+        ASSERT_EQ(chain.remove_stage(removed), mp::Result::Success);
+        EXPECT_EQ(destroyed, 1);
+        EXPECT_EQ(destroy_calls, 1);
+        EXPECT_EQ(chain.remove_stage(removed), mp::Result::InvalidParameter);
+    }
+    EXPECT_EQ(destroyed, 2);
+    EXPECT_EQ(destroy_calls, 1);
+}
+
+TEST(DSPChainTest, PipelineMatchesSequentialChainDelayedByBlocks) {
+    DSPChain sequential;
+    DSPChain pipelined;
+    pipelined.set_threads(3);
+    ASSERT_EQ(sequential.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+    ASSERT_EQ(pipelined.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+    EXPECT_EQ(pipelined.get_threads(), 3u);
+
+    TestProcessor* bypassed[2] = {};
+    for (DSPChain* chain : { &sequential, &pipelined }) {
+        ASSERT_EQ(chain->add_stage(new TestProcessor(2.0f, 0.0f, 5, true), nullptr), mp::Result::Success);
+        ASSERT_EQ(chain->add_stage(new TestProcessor(1.0f, 1.0f, 0, false), nullptr), mp::Result::Success);
+        auto* half = new TestProcessor(0.5f, 0.0f, 17, false);
+        ASSERT_EQ(chain->add_stage(half, nullptr), mp::Result::Success);
+        ASSERT_EQ(chain->add_stage(new TestProcessor(1.0f, -1.0f, 0, true), nullptr), mp::Result::Success);
+        bypassed[chain == &pipelined] = half;
+    }
+    const uint32_t pipeline_latency = 2 * MAX_FRAMES;
+    EXPECT_EQ(pipelined.get_latency_frames(), sequential.get_latency_frames() + pipeline_latency);
+
+    // Uneven blocks of a ramp, with a stage bypassed halfway
+    std::vector<float> expected(pipeline_latency * CHANNELS, 0.0f);
+    std::vector<float> actual;
+    const uint32_t sizes[] = { 64, 17, 64, 33, 1, 64, 50 };
+    uint32_t sample = 0;
+    for (uint32_t block = 0; block < 60; ++block) {
+        if (block == 30) {
+            sequential.set_stage_bypassed(bypassed[0], true);
+            pipelined.set_stage_bypassed(bypassed[1], true);
+        }
+        const uint32_t frames = sizes[block % 7];
+        for (uint32_t i = 0; i < frames * CHANNELS; ++i) {
+            sequential.input()[i] = pipelined.input()[i] = static_cast<float>(sample++) * 0.001f;
+        }
+        const float* reference = sequential.process(frames);
+        const float* result = pipelined.process(frames);
+        expected.insert(expected.end(), reference, reference + frames * CHANNELS);
+        actual.insert(actual.end(), result, result + frames * CHANNELS);
+    }
+
+    ASSERT_LE(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+    }
+
+    DSPChainStats stats;
+    pipelined.get_stats(&stats);
+    EXPECT_EQ(stats.thread_count, 3u);
+    EXPECT_EQ(stats.stage_count, 4u);
+    EXPECT_EQ(stats.pipeline_latency_frames, pipeline_latency);
+    EXPECT_TRUE(stats.stages[2].bypassed);
+    for (uint32_t group = 0; group < DSPChain::MAX_THREADS; ++group) {
+        EXPECT_LE(stats.queue_depth[group], 2u);
+    }
+}
+
+TEST(DSPChainTest, PipelineMovesCutsToBalanceMeasuredCost) {
+    DSPChain chain;
+    chain.set_threads(2);
+    ASSERT_EQ(chain.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+
+    // Unmeasured, the stages are split two and two; the last one is as
+    // slow as the other three together
+    const uint32_t work_us[] = { 1000, 1000, 1000, 3000 };
+    for (uint32_t us : work_us) {
+        auto* stage = new TestProcessor(1.0f, 0.0f, 0, true);
+        stage->work_us = us;
+        ASSERT_EQ(chain.add_stage(stage, nullptr), mp::Result::Success);
+    }
+
+    DSPChainStats stats;
+    chain.get_stats(&stats);
+    EXPECT_EQ(stats.stages[1].thread, 0u);
+    EXPECT_EQ(stats.stages[2].thread, 1u);
+    const uint64_t rebalances = stats.rebalances;
+
+    for (uint32_t block = 0; block < DSPChain::REBALANCE_BLOCKS + 4; ++block) {
+        run(chain, 1.0f);
+    }
+
+    chain.get_stats(&stats);
+    EXPECT_GT(stats.rebalances, rebalances);
+    for (uint32_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(stats.stages[i].thread, 0u) << "stage " << i;
+    }
+    EXPECT_EQ(stats.stages[3].thread, 1u);
+    EXPECT_GT(stats.stages[3].average_us, stats.stages[0].average_us);
+    EXPECT_GE(stats.stages[3].peak_us, stats.stages[3].average_us);
+}
+
+TEST(DSPChainTest, ResetDropsBlocksInFlight) {
+    DSPChain chain;
+    chain.set_threads(2);
+    ASSERT_EQ(chain.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+    ASSERT_EQ(chain.add_stage(new TestProcessor(2.0f, 0.0f, 0, false), nullptr), mp::Result::Success);
+
+    // The first block comes out one block later
+    EXPECT_EQ(run(chain, 1.0f), 0.0f);
+    EXPECT_EQ(run(chain, 1.0f), 2.0f);
+
+    chain.reset();
+    EXPECT_EQ(run(chain, 3.0f), 0.0f);
+    EXPECT_EQ(run(chain, 3.0f), 6.0f);
+
+    // Same format again only resets; more threads rebuild the pipeline
+    chain.set_threads(3);
+    ASSERT_EQ(chain.configure(48000, CHANNELS, MAX_FRAMES), mp::Result::Success);
+    EXPECT_EQ(chain.get_latency_frames(), 2 * MAX_FRAMES);
+    EXPECT_EQ(run(chain, 1.0f), 0.0f);
+    EXPECT_EQ(run(chain, 1.0f), 0.0f);
+    EXPECT_EQ(run(chain, 1.0f), 2.0f);
+}
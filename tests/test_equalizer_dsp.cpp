@@ -0,0 +1,289 @@
+#include "mp_dsp.h"
+#include "plugins/dsp/equalizer_dsp.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Factory of the plugin source compiled into this test
+extern "C" mp::IDSPProcessor* create_dsp_processor();
+extern "C" void destroy_dsp_processor(mp::IDSPProcessor* processor);
+
+using namespace mp::dsp;
+
+namespace {
+
+const int BANDS = 10;
+const float SAMPLE_RATE = 48000.0f;
+
+// Deterministic values in [-1, 1)
+class Random {
+public:
+    explicit Random(uint32_t seed) : state_(seed) {}
+
+    float next() {
+        state_ = state_ * 1664525u + 1013904223u;
+        return static_cast<float>(static_cast<int32_t>(state_)) / 2147483648.0f;
+    }
+
+private:
+    uint32_t state_;
+};
+
+// The same bands, one channel at a time, transposed direct form II
+class ScalarCascade {
+public:
+    ScalarCascade(const BiquadCoefficients* bands, int channels)
+        : bands_(bands, bands + BANDS)
+        , z1_(static_cast<size_t>(BANDS) * channels, 0.0f)
+        , z2_(static_cast<size_t>(BANDS) * channels, 0.0f)
+        , channels_(channels) {}
+
+    void process(float* interleaved, uint32_t frames) {
+        for (int ch = 0; ch < channels_; ++ch) {
+            for (uint32_t f = 0; f < frames; ++f) {
+                float x = interleaved[static_cast<size_t>(f) * channels_ + ch];
+                for (int band = 0; band < BANDS; ++band) {
+                    const BiquadCoefficients& c = bands_[band];
+                    float& s1 = z1_[band * channels_ + ch];
+                    float& s2 = z2_[band * channels_ + ch];
+                    float y = c.b0 * x + s1;
+                    s1 = c.b1 * x - c.a1 * y + s2;
+                    s2 = c.b2 * x - c.a2 * y;
+                    x = y;
+                }
+                interleaved[static_cast<size_t>(f) * channels_ + ch] = x;
+            }
+        }
+    }
+
+private:
+    std::vector<BiquadCoefficients> bands_;
+    std::vector<float> z1_;
+    std::vector<float> z2_;
+    int channels_;
+};
+
+// Every band of the plugin's layout, boosted or cut
+void design(BiquadCoefficients* bands, float scale) {
+    const float frequencies[BANDS] = { 31.25f, 62.5f, 125.0f, 250.0f, 500.0f,
+                                       1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f };
+    for (int band = 0; band < BANDS; ++band) {
+        float gain_db = scale * ((band % 3) - 1) * (4.0f + band);
+        bands[band] = BiquadCoefficients::peaking(SAMPLE_RATE, frequencies[band], gain_db, 1.0f);
+    }
+}
+
+typedef BiquadCascade<BANDS> Cascade;
+
+// Run frames of a quiet stereo tone through the cascade, in callbacks
+// that do not line up with BLOCK_FRAMES
+void run_frames(Cascade& cascade, uint32_t frames) {
+    std::vector<float> signal(2 * 300);
+    uint32_t done = 0;
+    while (done < frames) {
+        uint32_t count = std::min<uint32_t>(frames - done, 1 + (done * 7 + 131) % 300);
+        for (uint32_t f = 0; f < count; ++f) {
+            signal[2 * f] = signal[2 * f + 1] = 0.1f * std::sin(0.05f * (done + f));
+        }
+        cascade.process(signal.data(), count);
+        done += count;
+    }
+}
+
+float coefficient(const BiquadCoefficients& c, int k) {
+    const float values[5] = { c.b0, c.b1, c.b2, c.a1, c.a2 };
+    return values[k];
+}
+
+void expect_bands(const Cascade& cascade, const BiquadCoefficients* bands) {
+    for (int band = 0; band < BANDS; ++band) {
+        for (int k = 0; k < 5; ++k) {
+            EXPECT_EQ(coefficient(cascade.band(band), k), coefficient(bands[band], k))
+                << "band " << band << ", coefficient " << k;
+        }
+    }
+}
+
+} // namespace
+
+TEST(BiquadCascadeTest, MatchesScalarReferenceOnEveryLayout) {
+    BiquadCoefficients bands[BANDS];
+    design(bands, 1.0f);
+
+    // Callback sizes around and across BLOCK_FRAMES, none a multiple of it
+    const uint32_t callbacks[] = { 1, 255, 257, 3, 700, Cascade::BLOCK_FRAMES - 1, 1000, 129,
+                                   2 * Cascade::BLOCK_FRAMES + 7 };
+    const int layouts[] = { 1, 2, 5, 6, 8 };
+
+    for (int channels : layouts) {
+        SCOPED_TRACE(channels);
+        std::unique_ptr<Cascade> cascade(new Cascade());
+        ASSERT_TRUE(cascade->set_channels(channels));
+        for (int band = 0; band < BANDS; ++band) {
+            cascade->set_band(band, bands[band]);
+        }
+        ScalarCascade reference(bands, channels);
+
+        // A different signal on every channel, so crossed lanes show
+        Random random(channels);
+        uint32_t frame = 0;
+        for (uint32_t frames : callbacks) {
+            std::vector<float> signal(static_cast<size_t>(frames) * channels);
+            for (uint32_t f = 0; f < frames; ++f) {
+                for (int ch = 0; ch < channels; ++ch) {
+                    signal[static_cast<size_t>(f) * channels + ch] =
+                        0.3f * random.next() + 0.5f * std::sin(0.01f * (ch + 1) * (frame + f));
+                }
+            }
+            std::vector<float> expected = signal;
+            cascade->process(signal.data(), frames);
+            reference.process(expected.data(), frames);
+
+            for (size_t i = 0; i < signal.size(); ++i) {
+                ASSERT_NEAR(signal[i], expected[i], 1e-5f * std::max(1.0f, std::fabs(expected[i])))
+                    << "frame " << frame + i / channels << ", channel " << i % channels;
+            }
+            frame += frames;
+        }
+    }
+}
+
+TEST(BiquadCascadeTest, RejectsUnsupportedChannelCounts) {
+    std::unique_ptr<BiquadCascade<BANDS>> cascade(new BiquadCascade<BANDS>());
+    EXPECT_FALSE(cascade->set_channels(0));
+    EXPECT_FALSE(cascade->set_channels(BiquadCascade<BANDS>::MAX_CHANNELS + 1));
+    EXPECT_TRUE(cascade->set_channels(BiquadCascade<BANDS>::MAX_CHANNELS));
+}
+
+TEST(BiquadCascadeTest, RampLandsOnTargetAfterExactlyItsLength) {
+    // The plugin's 10 ms ramp at 48 kHz
+    const uint32_t ramp = 480;
+    BiquadCoefficients start[BANDS];
+    BiquadCoefficients target[BANDS];
+    design(start, 1.0f);
+    design(target, -1.0f);
+
+    std::unique_ptr<Cascade> cascade(new Cascade());
+    ASSERT_TRUE(cascade->set_channels(2));
+    for (int band = 0; band < BANDS; ++band) {
+        cascade->set_band(band, start[band]);
+    }
+    cascade->ramp_to(target, ramp);
+    expect_bands(*cascade, start);
+
+    // Linear on the way, and not there one frame early
+    run_frames(*cascade, ramp / 4);
+    for (int band = 0; band < BANDS; ++band) {
+        for (int k = 0; k < 5; ++k) {
+            float from = coefficient(start[band], k);
+            float to = coefficient(target[band], k);
+            EXPECT_NEAR(coefficient(cascade->band(band), k), from + 0.25f * (to - from), 1e-5f);
+        }
+    }
+    run_frames(*cascade, ramp - ramp / 4 - 1);
+    EXPECT_TRUE(cascade->ramping());
+
+    run_frames(*cascade, 1);
+    EXPECT_FALSE(cascade->ramping());
+    expect_bands(*cascade, target);
+
+    run_frames(*cascade, 1000);
+    expect_bands(*cascade, target);
+}
+
+TEST(BiquadCascadeTest, NewRampContinuesFromWhereTheLastOneGot) {
+    const uint32_t ramp = 480;
+    BiquadCoefficients start[BANDS];
+    BiquadCoefficients first[BANDS];
+    BiquadCoefficients second[BANDS];
+    design(start, 0.0f);
+    design(first, 1.0f);
+    design(second, -0.5f);
+
+    std::unique_ptr<Cascade> cascade(new Cascade());
+    ASSERT_TRUE(cascade->set_channels(2));
+    for (int band = 0; band < BANDS; ++band) {
+        cascade->set_band(band, start[band]);
+    }
+    cascade->ramp_to(first, ramp);
+    run_frames(*cascade, ramp / 3);
+
+    BiquadCoefficients reached[BANDS];
+    for (int band = 0; band < BANDS; ++band) {
+        reached[band] = cascade->band(band);
+    }
+
+    // No step when the new ramp starts, then one ramp-length glide
+    cascade->ramp_to(second, ramp);
+    expect_bands(*cascade, reached);
+    run_frames(*cascade, 1);
+    for (int band = 0; band < BANDS; ++band) {
+        for (int k = 0; k < 5; ++k) {
+            float from = coefficient(reached[band], k);
+            float to = coefficient(second[band], k);
+            EXPECT_NEAR(coefficient(cascade->band(band), k), from + (to - from) / ramp, 1e-6f);
+        }
+    }
+    run_frames(*cascade, ramp - 2);
+    EXPECT_TRUE(cascade->ramping());
+    run_frames(*cascade, 1);
+    expect_bands(*cascade, second);
+}
+
+TEST(EqualizerDSPTest, InitializeAfterShutdownRestartsTheDesigner) {
+    const uint32_t sample_rate = 48000;
+    const uint32_t BAND_1K = 5;
+    mp::IDSPProcessor* processor = create_dsp_processor();
+
+    mp::DSPConfig config = {};
+    config.sample_rate = sample_rate;
+    config.channels = 2;
+    config.format = mp::SampleFormat::Float32;
+    config.max_buffer_frames = 480;
+
+    // Initialize twice in a row, stop twice, then come back
+    ASSERT_EQ(processor->initialize(&config), mp::Result::Success);
+    ASSERT_EQ(processor->initialize(&config), mp::Result::Success);
+    processor->shutdown();
+    processor->shutdown();
+    ASSERT_EQ(processor->initialize(&config), mp::Result::Success);
+
+    // A gain change only reaches the audio through the designer thread
+    ASSERT_EQ(processor->set_parameter(BAND_1K, 12.0f), mp::Result::Success);
+
+    const float amplitude = 0.1f;
+    const float boosted = amplitude * std::pow(10.0f, 12.0f / 20.0f);
+    std::vector<float> block(2 * 480);
+    uint64_t frame = 0;
+    float peak = 0.0f;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (peak < 0.99f * boosted && std::chrono::steady_clock::now() < deadline) {
+        for (size_t f = 0; f < 480; ++f, ++frame) {
+            const double phase = 2.0 * 3.14159265358979323846 * 1000.0 * frame / sample_rate;
+            block[2 * f] = block[2 * f + 1] = amplitude * static_cast<float>(std::sin(phase));
+        }
+        mp::AudioBuffer buffer = {};
+        buffer.data = block.data();
+        buffer.sample_rate = sample_rate;
+        buffer.channels = 2;
+        buffer.format = mp::SampleFormat::Float32;
+        buffer.frames = 480;
+        buffer.capacity = 480;
+        ASSERT_EQ(processor->process(&buffer, nullptr), mp::Result::Success);
+
+        peak = 0.0f;
+        for (float value : block) {
+            peak = std::max(peak, std::fabs(value));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_NEAR(peak, boosted, 0.01f * boosted);
+
+    processor->shutdown();
+    destroy_dsp_processor(processor);
+}
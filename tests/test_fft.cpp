@@ -0,0 +1,188 @@
+#include "../src/audio/fft.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace audio;
+
+namespace {
+
+const SimdLevel ALL_LEVELS[] = {
+    SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON
+};
+const double PI = 3.14159265358979323846;
+
+// Deterministic values in [-1, 1)
+std::vector<float> make_signal(size_t size, uint32_t seed) {
+    std::vector<float> values(size);
+    for (float& value : values) {
+        seed = seed * 1664525u + 1013904223u;
+        value = static_cast<float>(static_cast<int32_t>(seed)) / 2147483648.0f;
+    }
+    return values;
+}
+
+// Direct DFT in double precision, bins 0..N / 2
+void reference_dft(const std::vector<float>& input, std::vector<double>& real, std::vector<double>& imag) {
+    const size_t n = input.size();
+    std::vector<double> cos_table(n), sin_table(n);
+    for (size_t i = 0; i < n; ++i) {
+        cos_table[i] = std::cos(2.0 * PI * i / n);
+        sin_table[i] = std::sin(2.0 * PI * i / n);
+    }
+    real.assign(n / 2 + 1, 0.0);
+    imag.assign(n / 2 + 1, 0.0);
+    for (size_t k = 0; k <= n / 2; ++k) {
+        double re = 0.0, im = 0.0;
+        size_t phase = 0;
+        for (size_t i = 0; i < n; ++i) {
+            re += input[i] * cos_table[phase];
+            im -= input[i] * sin_table[phase];
+            phase = (phase + k) % n;
+        }
+        real[k] = re;
+        imag[k] = im;
+    }
+}
+
+} // namespace
+
+TEST(FFTTest, RejectsInvalidSizes) {
+    RealFFT fft;
+    EXPECT_FALSE(fft.initialize(0));
+    EXPECT_FALSE(fft.initialize(2));
+    EXPECT_FALSE(fft.initialize(1000));
+    EXPECT_EQ(fft.size(), 0u);
+    EXPECT_TRUE(fft.initialize(4));
+    EXPECT_EQ(fft.bins(), 3u);
+}
+
+TEST(FFTTest, TablesAreSharedPerSize) {
+    auto a = FFTTables::get(1024);
+    auto b = FFTTables::get(1024);
+    ASSERT_TRUE(a);
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_NE(a.get(), FFTTables::get(2048).get());
+}
+
+TEST(FFTTest, MatchesDirectDFTOnEveryKernel) {
+    for (SimdLevel level : ALL_LEVELS) {
+        const FFTKernels* kernels = get_fft_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+        for (size_t size = 4; size <= 4096; size *= 2) {
+            SCOPED_TRACE(std::string(kernels->name) + " size " + std::to_string(size));
+            auto input = make_signal(size, static_cast<uint32_t>(size));
+            std::vector<double> ref_real, ref_imag;
+            reference_dft(input, ref_real, ref_imag);
+
+            RealFFT fft(size);
+            fft.set_kernels(*kernels);
+            std::vector<float> real(fft.bins()), imag(fft.bins());
+            fft.forward(input.data(), real.data(), imag.data());
+
+            // Rounding grows with log2(N); scale by the RMS bin magnitude
+            const double tolerance = 1e-6 * std::sqrt(static_cast<double>(size)) * std::log2(size) * 4;
+            double worst = 0.0;
+            for (size_t k = 0; k < fft.bins(); ++k) {
+                worst = std::max(worst, std::fabs(real[k] - ref_real[k]));
+                worst = std::max(worst, std::fabs(imag[k] - ref_imag[k]));
+            }
+            EXPECT_LT(worst, tolerance);
+        }
+    }
+}
+
+TEST(FFTTest, LargeSizesPlaceTonesInTheirBins) {
+    for (SimdLevel level : ALL_LEVELS) {
+        const FFTKernels* kernels = get_fft_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+        for (size_t size : { size_t(16384), size_t(32768), size_t(65536) }) {
+            SCOPED_TRACE(std::string(kernels->name) + " size " + std::to_string(size));
+            // Two tones exactly on bins, so there is no leakage
+            const size_t bin_a = size / 8 + 3;
+            const size_t bin_b = size / 2 - 5;
+            std::vector<float> input(size);
+            for (size_t i = 0; i < size; ++i) {
+                input[i] = static_cast<float>(std::cos(2.0 * PI * bin_a * i / size) +
+                                              0.5 * std::sin(2.0 * PI * bin_b * i / size));
+            }
+
+            RealFFT fft(size);
+            fft.set_kernels(*kernels);
+            std::vector<float> real(fft.bins()), imag(fft.bins());
+            fft.forward(input.data(), real.data(), imag.data());
+
+            const double half = size / 2.0;
+            EXPECT_NEAR(real[bin_a], half, half * 1e-4);
+            EXPECT_NEAR(imag[bin_a], 0.0, half * 1e-4);
+            EXPECT_NEAR(real[bin_b], 0.0, half * 1e-4);
+            EXPECT_NEAR(imag[bin_b], -0.5 * half, half * 1e-4);
+            double leakage = 0.0;
+            for (size_t k = 0; k < fft.bins(); ++k) {
+                if (k != bin_a && k != bin_b) {
+                    leakage = std::max(leakage, std::hypot(static_cast<double>(real[k]), static_cast<double>(imag[k])));
+                }
+            }
+            EXPECT_LT(leakage, half * 1e-4);
+        }
+    }
+}
+
+TEST(FFTTest, KernelsAgreeWithScalar) {
+    const size_t size = 8192;
+    auto input = make_signal(size, 7);
+    RealFFT scalar(size);
+    scalar.set_kernels(*get_fft_kernels(SimdLevel::Scalar));
+    std::vector<float> ref_real(scalar.bins()), ref_imag(scalar.bins());
+    scalar.forward(input.data(), ref_real.data(), ref_imag.data());
+
+    for (SimdLevel level : ALL_LEVELS) {
+        const FFTKernels* kernels = get_fft_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+        SCOPED_TRACE(kernels->name);
+        RealFFT fft(size);
+        fft.set_kernels(*kernels);
+        std::vector<float> real(fft.bins()), imag(fft.bins());
+        fft.forward(input.data(), real.data(), imag.data());
+        for (size_t k = 0; k < fft.bins(); ++k) {
+            ASSERT_NEAR(real[k], ref_real[k], 1e-3f) << "bin " << k;
+            ASSERT_NEAR(imag[k], ref_imag[k], 1e-3f) << "bin " << k;
+        }
+    }
+}
+
+TEST(FFTTest, InverseUndoesForwardOnEveryKernel) {
+    for (SimdLevel level : ALL_LEVELS) {
+        const FFTKernels* kernels = get_fft_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+        for (size_t size = 4; size <= 65536; size *= 2) {
+            SCOPED_TRACE(std::string(kernels->name) + " size " + std::to_string(size));
+            auto input = make_signal(size, static_cast<uint32_t>(size) + 1);
+
+            RealFFT fft(size);
+            fft.set_kernels(*kernels);
+            std::vector<float> real(fft.bins()), imag(fft.bins()), output(size);
+            fft.forward(input.data(), real.data(), imag.data());
+            fft.inverse(real.data(), imag.data(), output.data());
+
+            // Unscaled: the round trip multiplies by N
+            const double tolerance = 1e-6 * std::log2(size) * 4;
+            double worst = 0.0;
+            for (size_t i = 0; i < size; ++i) {
+                worst = std::max(worst, std::fabs(output[i] / static_cast<double>(size) - input[i]));
+            }
+            EXPECT_LT(worst, tolerance);
+        }
+    }
+}
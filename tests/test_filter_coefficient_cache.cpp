@@ -0,0 +1,135 @@
+#include "../src/audio/filter_coefficient_cache.h"
+#include "../src/audio/sinc_resampler.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace audio;
+
+namespace {
+
+// Fresh counters and default limits for every test
+class FilterCoefficientCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        cache().set_limits(FilterCoefficientCache::DEFAULT_MAX_PINNED_TABLES,
+                           FilterCoefficientCache::DEFAULT_MAX_PINNED_BYTES);
+        cache().clear();
+    }
+
+    void TearDown() override {
+        SetUp();
+    }
+
+    static FilterCoefficientCache& cache() { return FilterCoefficientCache::instance(); }
+};
+
+} // namespace
+
+TEST_F(FilterCoefficientCacheTest, ConvertersWithSameRatioShareOneTable) {
+    std::vector<std::unique_ptr<SincSampleRateConverter>> converters;
+    for (int i = 0; i < 50; ++i) {
+        converters.push_back(std::make_unique<SincSampleRateConverter>(16));
+        // Same 147:160 ratio at two base rates
+        ASSERT_TRUE(converters.back()->initialize(i % 2 ? 44100 : 88200, i % 2 ? 48000 : 96000, 2));
+    }
+
+    FilterCoefficientCache::Stats stats = cache().get_stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 49u);
+    EXPECT_EQ(stats.live_tables, 1u);
+    EXPECT_EQ(stats.live_bytes, PolyphaseFilterBank::get(44100, 48000, 17)->get_memory_usage());
+}
+
+TEST_F(FilterCoefficientCacheTest, KeyIncludesTapsAndPhases) {
+    auto a = cache().get(44100, 48000, 17, 256);
+    auto b = cache().get(44100, 48000, 17, 160);
+    auto c = cache().get(44100, 48000, 33, 256);
+    auto d = cache().get(88200, 96000, 17, 256);
+
+    EXPECT_NE(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a, d);
+    EXPECT_EQ(cache().get_stats().misses, 3u);
+}
+
+TEST_F(FilterCoefficientCacheTest, DoubleTablesAreKeptApartAndAgreeWithFloat) {
+    auto single = cache().get(44100, 48000, 17, 160);
+    auto wide = cache().get(44100, 48000, 17, 160, PolyphaseFilterBank::Precision::Double);
+
+    EXPECT_NE(single, wide);
+    EXPECT_EQ(wide->get_precision(), PolyphaseFilterBank::Precision::Double);
+    EXPECT_EQ(wide->get_memory_usage(), 2 * single->get_memory_usage());
+    EXPECT_EQ(cache().get_stats().misses, 2u);
+
+    for (int phase = 0; phase <= 160; ++phase) {
+        for (int i = 0; i < 17; ++i) {
+            EXPECT_FLOAT_EQ(static_cast<float>(wide->get_row_double(phase)[i]), single->get_row(phase)[i]);
+        }
+    }
+}
+
+TEST_F(FilterCoefficientCacheTest, PinnedTablesSurviveWithoutUsers) {
+    const PolyphaseFilterBank* first = cache().get(44100, 96000, 17, 256).get();
+
+    // No converter holds the table now, but the cache keeps it pinned
+    auto again = cache().get(44100, 96000, 17, 256);
+    EXPECT_EQ(again.get(), first);
+    EXPECT_EQ(cache().get_stats().misses, 1u);
+}
+
+TEST_F(FilterCoefficientCacheTest, LeastRecentlyUsedPinIsReleasedFirst) {
+    cache().set_limits(2, FilterCoefficientCache::DEFAULT_MAX_PINNED_BYTES);
+
+    cache().get(44100, 48000, 17, 256);
+    cache().get(48000, 44100, 17, 256);
+    cache().get(44100, 48000, 17, 256);   // Most recent again
+    cache().get(32000, 48000, 17, 256);   // Evicts 48000 -> 44100
+
+    FilterCoefficientCache::Stats stats = cache().get_stats();
+    EXPECT_EQ(stats.pinned_tables, 2u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.live_tables, 2u);
+
+    cache().get(44100, 48000, 17, 256);
+    EXPECT_EQ(cache().get_stats().misses, 3u);
+    cache().get(48000, 44100, 17, 256);
+    EXPECT_EQ(cache().get_stats().misses, 4u);
+}
+
+TEST_F(FilterCoefficientCacheTest, ByteLimitReleasesPinsButNotTablesInUse) {
+    auto held = cache().get(44100, 48000, 33, 256);
+    cache().set_limits(FilterCoefficientCache::DEFAULT_MAX_PINNED_TABLES, held->get_memory_usage());
+
+    cache().get(48000, 44100, 33, 256);
+
+    FilterCoefficientCache::Stats stats = cache().get_stats();
+    EXPECT_EQ(stats.pinned_tables, 1u);
+    EXPECT_LE(stats.pinned_bytes, held->get_memory_usage());
+
+    // The evicted table is still held here, so it is still shared
+    EXPECT_EQ(cache().get(44100, 48000, 33, 256), held);
+}
+
+TEST_F(FilterCoefficientCacheTest, ConcurrentRequestsBuildOnce) {
+    const int thread_count = 8;
+    std::vector<std::shared_ptr<const PolyphaseFilterBank>> tables(thread_count);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&tables, i]() {
+            tables[i] = FilterCoefficientCache::instance().get(22050, 48000, 63, 1024);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& table : tables) {
+        EXPECT_EQ(table, tables[0]);
+    }
+    FilterCoefficientCache::Stats stats = cache().get_stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, static_cast<size_t>(thread_count - 1));
+}
@@ -0,0 +1,195 @@
+#include "../src/audio/fir_kernels.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace audio;
+
+namespace {
+
+const SimdLevel ALL_LEVELS[] = {
+    SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON
+};
+const int TAP_COUNTS[] = { 1, 3, 7, 8, 9, 16, 17, 33, 64 };
+const int MAX_CHANNELS = 8;
+
+// Deterministic values in [-1, 1)
+template <typename T>
+std::vector<T> make_signal(size_t size, uint32_t seed) {
+    std::vector<T> values(size);
+    for (T& value : values) {
+        seed = seed * 1664525u + 1013904223u;
+        value = static_cast<T>(static_cast<int32_t>(seed)) / static_cast<T>(2147483648.0);
+    }
+    return values;
+}
+
+// Rounding bound for a sum of taps products: taps * eps * sum(|x * c|)
+template <typename T>
+T tolerance(const std::vector<T>& input, const std::vector<T>& coefficients,
+            int taps, int channels, int ch) {
+    T magnitude = 0;
+    for (int i = 0; i < taps; ++i) {
+        magnitude += std::abs(input[i * channels + ch] * coefficients[i]);
+    }
+    return (taps + 1) * std::numeric_limits<T>::epsilon() * magnitude;
+}
+
+template <typename T, typename Kernel>
+void check_against_scalar(const char* name, Kernel kernel, Kernel reference) {
+    for (int channels = 1; channels <= MAX_CHANNELS; ++channels) {
+        for (int taps : TAP_COUNTS) {
+            std::vector<T> input = make_signal<T>(static_cast<size_t>(taps) * channels, 7u * taps + channels);
+            std::vector<T> coefficients = make_signal<T>(taps, 31u * taps);
+            // Guard samples past the last channel catch out-of-range writes
+            std::vector<T> expected(channels + 1, T(-7));
+            std::vector<T> actual(channels + 1, T(-7));
+
+            reference(input.data(), coefficients.data(), taps, channels, expected.data());
+            kernel(input.data(), coefficients.data(), taps, channels, actual.data());
+
+            for (int ch = 0; ch < channels; ++ch) {
+                EXPECT_NEAR(actual[ch], expected[ch], tolerance(input, coefficients, taps, channels, ch))
+                    << name << ": taps " << taps << ", channels " << channels << ", channel " << ch;
+            }
+            EXPECT_EQ(actual[channels], T(-7)) << name << " wrote past the output";
+        }
+    }
+}
+
+} // namespace
+
+TEST(FirKernelsTest, ScalarMatchesDirectSum) {
+    const float input[] = { 1.0f, 10.0f, 2.0f, 20.0f, 3.0f, 30.0f };
+    const float coefficients[] = { 0.5f, 0.25f, 1.0f };
+    float output[2] = { 0.0f, 0.0f };
+
+    fir_float_scalar(input, coefficients, 3, 2, output);
+
+    EXPECT_FLOAT_EQ(output[0], 0.5f + 0.5f + 3.0f);
+    EXPECT_FLOAT_EQ(output[1], 5.0f + 5.0f + 30.0f);
+}
+
+TEST(FirKernelsTest, DispatchSelectsSupportedLevel) {
+    const FirKernels& kernels = get_fir_kernels();
+    EXPECT_EQ(kernels.level, detect_simd_level());
+    EXPECT_NE(get_fir_kernels(kernels.level), nullptr);
+    EXPECT_NE(get_fir_kernels(SimdLevel::Scalar), nullptr);
+}
+
+TEST(FirKernelsTest, FloatKernelsMatchScalar) {
+    for (SimdLevel level : ALL_LEVELS) {
+        const FirKernels* kernels = get_fir_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+        check_against_scalar<float>(kernels->name, kernels->fir_float, fir_float_scalar);
+    }
+}
+
+TEST(FirKernelsTest, DoubleKernelsMatchScalar) {
+    for (SimdLevel level : ALL_LEVELS) {
+        const FirKernels* kernels = get_fir_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+        check_against_scalar<double>(kernels->name, kernels->fir_double, fir_double_scalar);
+    }
+}
+
+TEST(FirKernelsTest, FixedShapeKernelsMatchScalar) {
+    const int channel_counts[] = { 1, 2, 4, 6, 8 };
+    const int tap_counts[] = { 8, 9, 16, 17, 32, 33, 64, 65 };
+
+    for (SimdLevel level : ALL_LEVELS) {
+        const FirKernels* kernels = get_fir_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+
+        for (int channels : channel_counts) {
+            for (int taps : tap_counts) {
+                FirKernelFloat kernel = kernels->fixed_float(taps, channels);
+                ASSERT_NE(kernel, nullptr) << kernels->name << ": taps " << taps << ", channels " << channels;
+
+                std::vector<float> input = make_signal<float>(static_cast<size_t>(taps) * channels, 5u * taps + channels);
+                std::vector<float> coefficients = make_signal<float>(taps, 17u * taps);
+                std::vector<float> expected(channels + 1, -7.0f);
+                std::vector<float> actual(channels + 1, -7.0f);
+
+                fir_float_scalar(input.data(), coefficients.data(), taps, channels, expected.data());
+                kernel(input.data(), coefficients.data(), taps, channels, actual.data());
+
+                for (int ch = 0; ch < channels; ++ch) {
+                    EXPECT_NEAR(actual[ch], expected[ch], tolerance(input, coefficients, taps, channels, ch))
+                        << kernels->name << ": taps " << taps << ", channels " << channels << ", channel " << ch;
+                }
+                EXPECT_EQ(actual[channels], -7.0f) << kernels->name << " wrote past the output";
+            }
+        }
+    }
+}
+
+TEST(FirKernelsTest, UncommonShapesUseGenericKernel) {
+    const FirKernels& kernels = get_fir_kernels();
+
+    EXPECT_EQ(kernels.fixed_float(17, 3), nullptr);
+    EXPECT_EQ(kernels.fixed_float(12, 2), nullptr);
+    EXPECT_EQ(get_fir_kernel_float(17, 3), kernels.fir_float);
+    EXPECT_NE(get_fir_kernel_float(17, 2), kernels.fir_float);
+}
+
+TEST(FirKernelsTest, MixedKernelsMatchDoubleReference) {
+    for (SimdLevel level : ALL_LEVELS) {
+        const FirKernels* kernels = get_fir_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+
+        for (int channels = 1; channels <= MAX_CHANNELS; ++channels) {
+            for (int taps : TAP_COUNTS) {
+                std::vector<float> input = make_signal<float>(static_cast<size_t>(taps) * channels, 3u * taps + channels);
+                std::vector<float> coefficients = make_signal<float>(taps, 11u * taps);
+                std::vector<double> wide_input(input.begin(), input.end());
+                std::vector<double> wide_coefficients(coefficients.begin(), coefficients.end());
+                std::vector<double> expected(channels);
+                std::vector<float> actual(channels + 1, -7.0f);
+
+                fir_double_scalar(wide_input.data(), wide_coefficients.data(), taps, channels, expected.data());
+                kernels->fir_mixed(input.data(), coefficients.data(), taps, channels, actual.data());
+
+                // Only the final rounding to float remains
+                for (int ch = 0; ch < channels; ++ch) {
+                    double bound = std::numeric_limits<float>::epsilon() * std::abs(expected[ch]) +
+                                   tolerance(wide_input, wide_coefficients, taps, channels, ch);
+                    EXPECT_NEAR(actual[ch], expected[ch], bound)
+                        << kernels->name << ": taps " << taps << ", channels " << channels << ", channel " << ch;
+                }
+                EXPECT_EQ(actual[channels], -7.0f) << kernels->name << " wrote past the output";
+            }
+        }
+    }
+}
+
+TEST(FirKernelsTest, MixedKernelsKeepSmallTermsNextToLargeOnes) {
+    // 1e4 and -1e4 around 63 terms of 1e-3: a float accumulator holding
+    // 1e4 has a step of about 1e-3, so the small terms are mostly lost
+    const int taps = 65;
+    std::vector<float> input(taps, 1e-3f);
+    input[0] = 1e4f;
+    input[taps - 1] = -1e4f;
+    std::vector<float> coefficients(taps, 1.0f);
+    const double exact = 63.0 * static_cast<double>(1e-3f);
+
+    for (SimdLevel level : ALL_LEVELS) {
+        const FirKernels* kernels = get_fir_kernels(level);
+        if (!kernels) {
+            continue;
+        }
+        float output = 0.0f;
+        kernels->fir_mixed(input.data(), coefficients.data(), taps, 1, &output);
+        EXPECT_NEAR(output, exact, 1e-7) << kernels->name;
+    }
+}
@@ -0,0 +1,258 @@
+#include "mp_dsp.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Factory of the plugin source compiled into this test
+extern "C" mp::IDSPProcessor* create_dsp_processor();
+extern "C" void destroy_dsp_processor(mp::IDSPProcessor* processor);
+
+using namespace mp;
+
+namespace {
+
+const uint32_t CEILING = 0;         // LimiterDSP parameter index
+const uint32_t MAX_FRAMES = 256;
+const uint16_t CHANNELS = 2;
+const double PI = 3.14159265358979323846;
+
+// ITU-R BS.1770-4 Annex 2 interpolator, 4x
+const double BS1770[4][12] = {
+    { 0.0017089843750, 0.0109863281250, -0.0196533203125, 0.0332031250000, -0.0594482421875, 0.1373291015625,
+      0.9721679687500, -0.1022949218750, 0.0476074218750, -0.0266113281250, 0.0148925781250, -0.0083007812500 },
+    { -0.0291748046875, 0.0292968750000, -0.0517578125000, 0.0891113281250, -0.1665039062500, 0.4650878906250,
+      0.7797851562500, -0.2003173828125, 0.1015625000000, -0.0582275390625, 0.0330810546875, -0.0189208984375 },
+    { -0.0189208984375, 0.0330810546875, -0.0582275390625, 0.1015625000000, -0.2003173828125, 0.7797851562500,
+      0.4650878906250, -0.1665039062500, 0.0891113281250, -0.0517578125000, 0.0292968750000, -0.0291748046875 },
+    { -0.0083007812500, 0.0148925781250, -0.0266113281250, 0.0476074218750, -0.1022949218750, 0.9721679687500,
+      0.1373291015625, -0.0594482421875, 0.0332031250000, -0.0196533203125, 0.0109863281250, 0.0017089843750 }
+};
+
+// True peak in dBTP of interleaved frames from first_frame on
+double true_peak_db(const std::vector<float>& signal, size_t first_frame) {
+    const size_t frames = signal.size() / CHANNELS;
+    double peak = 0.0;
+    for (uint16_t ch = 0; ch < CHANNELS; ++ch) {
+        for (size_t n = first_frame + 11; n < frames; ++n) {
+            for (int phase = 0; phase < 4; ++phase) {
+                double sum = 0.0;
+                for (int k = 0; k < 12; ++k) {
+                    sum += BS1770[phase][k] * signal[(n - k) * CHANNELS + ch];
+                }
+                peak = std::max(peak, std::fabs(sum));
+            }
+        }
+    }
+    return 20.0 * std::log10(peak);
+}
+
+// Deterministic values in [-1, 1)
+class Random {
+public:
+    explicit Random(uint32_t seed) : state_(seed) {}
+
+    float next() {
+        state_ = state_ * 1664525u + 1013904223u;
+        return static_cast<float>(static_cast<int32_t>(state_)) / 2147483648.0f;
+    }
+
+    // Uniform in [low, high]
+    uint32_t range(uint32_t low, uint32_t high) {
+        state_ = state_ * 1664525u + 1013904223u;
+        return low + (state_ >> 8) % (high - low + 1);
+    }
+
+private:
+    uint32_t state_;
+};
+
+struct TestSignal {
+    std::string name;
+    std::vector<float> samples;
+};
+
+// Material that drives the limiter well past the ceiling, one second long
+std::vector<TestSignal> make_signals(uint32_t sample_rate) {
+    const size_t frames = sample_rate;
+    std::vector<TestSignal> signals;
+    Random random(sample_rate);
+
+    const double tones[] = { 1000.0, 5000.0, 10000.0, 15000.0, 19000.0 };
+    for (double tone : tones) {
+        TestSignal sine = { "sine " + std::to_string(static_cast<int>(tone)) + " Hz",
+                            std::vector<float>(frames * CHANNELS) };
+        for (size_t n = 0; n < frames; ++n) {
+            float value = 2.0f * static_cast<float>(std::sin(2.0 * PI * tone * n / sample_rate + 0.3));
+            sine.samples[n * CHANNELS] = value;
+            sine.samples[n * CHANNELS + 1] = 0.7f * value;
+        }
+        signals.push_back(sine);
+    }
+
+    // Full-scale clicks over a quiet tone, at irregular spacing
+    TestSignal clicks = { "clicks", std::vector<float>(frames * CHANNELS) };
+    for (size_t n = 0; n < frames; ++n) {
+        clicks.samples[n * CHANNELS] = n % 997 == 0 ? 3.0f : 0.1f * static_cast<float>(std::sin(0.01 * n));
+        clicks.samples[n * CHANNELS + 1] = n % 1499 < 3 ? -3.0f : 0.0f;
+    }
+    signals.push_back(clicks);
+
+    // Full-band noise switching between quiet and 30 dB over
+    TestSignal noise = { "noise bursts", std::vector<float>(frames * CHANNELS) };
+    for (size_t n = 0; n < frames; ++n) {
+        float level = (n / 2000) % 3 == 0 ? 30.0f : 0.3f;
+        noise.samples[n * CHANNELS] = level * random.next();
+        noise.samples[n * CHANNELS + 1] = level * random.next();
+    }
+    signals.push_back(noise);
+
+    TestSignal bursts = { "15 kHz bursts", std::vector<float>(frames * CHANNELS) };
+    for (size_t n = 0; n < frames; ++n) {
+        float value = (n / 3000) % 2 ? 3.0f * static_cast<float>(std::sin(2.0 * PI * 15000.0 * n / sample_rate))
+                                     : 0.0f;
+        bursts.samples[n * CHANNELS] = value;
+        bursts.samples[n * CHANNELS + 1] = -value;
+    }
+    signals.push_back(bursts);
+
+    return signals;
+}
+
+class LimiterDSPTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        processor_ = create_dsp_processor();
+    }
+
+    void TearDown() override {
+        destroy_dsp_processor(processor_);
+    }
+
+    void initialize(uint32_t sample_rate) {
+        sample_rate_ = sample_rate;
+        DSPConfig config = {};
+        config.sample_rate = sample_rate;
+        config.channels = CHANNELS;
+        config.format = SampleFormat::Float32;
+        config.max_buffer_frames = MAX_FRAMES;
+        ASSERT_EQ(processor_->initialize(&config), Result::Success);
+    }
+
+    // Process frames [begin, end) of signal in place, in callbacks of
+    // random length, mostly larger than max_buffer_frames
+    void process(std::vector<float>& signal, size_t begin, size_t end, Random& sizes) {
+        while (begin < end) {
+            AudioBuffer buffer = {};
+            buffer.data = signal.data() + begin * CHANNELS;
+            buffer.sample_rate = sample_rate_;
+            buffer.channels = CHANNELS;
+            buffer.format = SampleFormat::Float32;
+            buffer.frames = static_cast<uint32_t>(std::min<size_t>(sizes.range(1, 4 * MAX_FRAMES), end - begin));
+            buffer.capacity = buffer.frames;
+            ASSERT_EQ(processor_->process(&buffer, nullptr), Result::Success);
+            begin += buffer.frames;
+        }
+    }
+
+    IDSPProcessor* processor_;
+    uint32_t sample_rate_;
+};
+
+} // namespace
+
+TEST_F(LimiterDSPTest, OutputStaysBelowCeilingOnATruePeakMeter) {
+    const uint32_t rates[] = { 48000, 96000 };
+    for (uint32_t rate : rates) {
+        for (TestSignal& signal : make_signals(rate)) {
+            SCOPED_TRACE(signal.name + " at " + std::to_string(rate));
+            TearDown();
+            SetUp();
+            initialize(rate);
+            ASSERT_EQ(processor_->get_parameter(CEILING), -1.0f);
+
+            Random sizes(rate);
+            process(signal.samples, 0, signal.samples.size() / CHANNELS, sizes);
+            const double peak = true_peak_db(signal.samples, processor_->get_latency_samples());
+            EXPECT_LE(peak, -1.0);
+            // Limited to the ceiling, not far below it
+            EXPECT_GT(peak, -1.5);
+        }
+    }
+
+    // A lower ceiling holds just the same
+    TearDown();
+    SetUp();
+    initialize(48000);
+    ASSERT_EQ(processor_->set_parameter(CEILING, -6.0f), Result::Success);
+    std::vector<float> noise = make_signals(48000)[6].samples;     // Noise bursts
+    Random sizes(1);
+    process(noise, 0, noise.size() / CHANNELS, sizes);
+    EXPECT_LE(true_peak_db(noise, processor_->get_latency_samples()), -6.0);
+}
+
+TEST_F(LimiterDSPTest, LatencyMatchesTheDelay) {
+    const uint32_t rates[] = { 44100, 48000, 96000 };
+    for (uint32_t rate : rates) {
+        SCOPED_TRACE(rate);
+        TearDown();
+        SetUp();
+        initialize(rate);
+        const uint32_t latency = processor_->get_latency_samples();
+        // The 2 ms look-ahead plus the detector's
+        EXPECT_GE(latency, rate / 500);
+        EXPECT_LT(latency, rate / 500 + 16);
+
+        // Below the ceiling the input comes out unchanged, latency frames late
+        const size_t frames = rate / 2;
+        Random random(rate);
+        std::vector<float> input(frames * CHANNELS);
+        for (float& value : input) {
+            value = 0.2f * random.next();
+        }
+        std::vector<float> signal = input;
+        Random sizes(rate + 1);
+        process(signal, 0, frames, sizes);
+        for (size_t i = 0; i < signal.size(); ++i) {
+            float expected = i < latency * CHANNELS ? 0.0f : input[i - latency * CHANNELS];
+            ASSERT_EQ(signal[i], expected) << "sample " << i;
+        }
+    }
+}
+
+TEST_F(LimiterDSPTest, BypassKeepsTheLatency) {
+    const uint32_t rate = 48000;
+    initialize(rate);
+    const uint32_t latency = processor_->get_latency_samples();
+
+    // Loud enough that limiting would show
+    const size_t frames = rate;
+    const size_t bypassed = rate / 4;
+    const size_t resumed = rate / 2;
+    Random random(3);
+    std::vector<float> input(frames * CHANNELS);
+    for (float& value : input) {
+        value = 4.0f * random.next();
+    }
+    std::vector<float> signal = input;
+    Random sizes(5);
+
+    process(signal, 0, bypassed, sizes);
+    processor_->set_bypass(true);
+    EXPECT_TRUE(processor_->is_bypassed());
+    EXPECT_EQ(processor_->get_latency_samples(), latency);
+
+    // Unlimited, on the same timeline
+    process(signal, bypassed, resumed, sizes);
+    for (size_t i = bypassed * CHANNELS; i < resumed * CHANNELS; ++i) {
+        ASSERT_EQ(signal[i], input[i - latency * CHANNELS]) << "sample " << i;
+    }
+
+    processor_->set_bypass(false);
+    EXPECT_EQ(processor_->get_latency_samples(), latency);
+    process(signal, resumed, frames, sizes);
+    std::vector<float> limited(signal.begin() + resumed * CHANNELS, signal.end());
+    EXPECT_LE(true_peak_db(limited, latency), -1.0);
+}
@@ -0,0 +1,495 @@
+#include "../core/playback_engine.h"
+#include "mp_dsp.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+using namespace mp::core;
+
+namespace {
+
+// Decoder producing a stereo ramp: sample n of a track is (base + n) << 8
+class RampDecoder : public mp::IDecoder {
+public:
+    RampDecoder(int32_t base, uint64_t total_frames, size_t max_block, uint32_t sample_rate = 48000)
+        : base_(base), total_(total_frames), max_block_(max_block), sample_rate_(sample_rate), pos_(0) {}
+
+    int probe_file(const void*, size_t) override { return 100; }
+    const char** get_extensions() const override { return nullptr; }
+
+    mp::Result open_stream(const char*, mp::DecoderHandle* handle) override {
+        handle->internal = this;
+        pos_ = 0;
+        return mp::Result::Success;
+    }
+
+    mp::Result get_stream_info(mp::DecoderHandle, mp::AudioStreamInfo* info) override {
+        info->sample_rate = sample_rate_;
+        info->channels = 2;
+        info->format = mp::SampleFormat::Int32;
+        info->total_samples = total_;
+        info->duration_ms = total_ * 1000 / sample_rate_;
+        return mp::Result::Success;
+    }
+
+    mp::Result decode_block(mp::DecoderHandle, void* buffer, size_t buffer_size, size_t* samples_decoded) override {
+        // Short, uneven blocks so track ends never line up with engine blocks
+        size_t frames = std::min(buffer_size / (2 * sizeof(int32_t)), max_block_);
+        frames = static_cast<size_t>(std::min<uint64_t>(frames, total_ - pos_));
+        int32_t* out = static_cast<int32_t*>(buffer);
+        for (size_t i = 0; i < frames; ++i) {
+            int32_t value = (base_ + static_cast<int32_t>(pos_ + i)) << 8;
+            out[i * 2] = value;
+            out[i * 2 + 1] = -value;
+        }
+        pos_ += frames;
+        *samples_decoded = frames;
+        return mp::Result::Success;
+    }
+
+    mp::Result seek(mp::DecoderHandle, uint64_t position_ms, uint64_t* actual_position) override {
+        pos_ = position_ms * sample_rate_ / 1000;
+        *actual_position = position_ms;
+        return mp::Result::Success;
+    }
+
+    mp::Result get_metadata(mp::DecoderHandle, const mp::MetadataTag**, size_t*) override {
+        return mp::Result::NotImplemented;
+    }
+
+    void close_stream(mp::DecoderHandle) override {}
+
+private:
+    int32_t base_;
+    uint64_t total_;
+    size_t max_block_;
+    uint32_t sample_rate_;
+    uint64_t pos_;
+};
+
+// Output that never runs a thread; the test pulls blocks through the callback.
+// Like a real device, the callback never runs while the output is stopped.
+class ManualOutput : public mp::IAudioOutput {
+public:
+    mp::Result enumerate_devices(const mp::AudioDeviceInfo**, size_t*) override {
+        return mp::Result::NotImplemented;
+    }
+    mp::Result open(const mp::AudioOutputConfig& config) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_ = config;
+        open_count_++;
+        return mp::Result::Success;
+    }
+    mp::Result start() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        started_ = true;
+        return mp::Result::Success;
+    }
+    mp::Result stop() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        started_ = false;
+        return mp::Result::Success;
+    }
+    void close() override {}
+    uint32_t get_latency() const override { return 0; }
+    mp::Result set_volume(float) override { return mp::Result::Success; }
+    float get_volume() const override { return 1.0f; }
+
+    bool pull(float* buffer, size_t frames) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_) {
+            return false;
+        }
+        config_.callback(buffer, frames, config_.user_data);
+        return true;
+    }
+
+    uint32_t sample_rate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return config_.sample_rate;
+    }
+
+    int open_count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return open_count_;
+    }
+
+private:
+    std::mutex mutex_;
+    mp::AudioOutputConfig config_;
+    bool started_ = false;
+    int open_count_ = 0;
+};
+
+// Counts events published by the engine thread
+class CountingEventBus : public mp::IEventBus {
+public:
+    std::atomic<int> next_track_requests{0};
+
+    mp::SubscriptionHandle subscribe(mp::EventID, mp::EventCallback) override { return 0; }
+    mp::Result unsubscribe(mp::SubscriptionHandle) override { return mp::Result::Success; }
+    mp::Result publish(const mp::Event& event) override {
+        if (event.id == mp::EVENT_NEXT_TRACK_REQUESTED) {
+            next_track_requests++;
+        }
+        return mp::Result::Success;
+    }
+    mp::Result publish_sync(const mp::Event& event) override { return publish(event); }
+};
+
+// Delays every channel by a fixed number of frames, reporting it as latency
+class DelayProcessor : public mp::IDSPProcessor {
+public:
+    explicit DelayProcessor(uint32_t frames) : delay_(frames), channels_(0) {}
+
+    mp::Result initialize(const mp::DSPConfig* config) override {
+        channels_ = config->channels;
+        history_.assign(static_cast<size_t>(delay_ + config->max_buffer_frames) * channels_, 0.0f);
+        return mp::Result::Success;
+    }
+
+    mp::Result process(mp::AudioBuffer* input, mp::AudioBuffer*) override {
+        float* data = static_cast<float*>(input->data);
+        const size_t samples = static_cast<size_t>(input->frames) * channels_;
+        const size_t delayed = static_cast<size_t>(delay_) * channels_;
+        std::copy(data, data + samples, history_.begin() + delayed);
+        std::copy(history_.begin(), history_.begin() + samples, data);
+        std::copy(history_.begin() + samples, history_.begin() + samples + delayed, history_.begin());
+        return mp::Result::Success;
+    }
+
+    uint32_t get_latency_samples() const override { return delay_; }
+    void reset() override { std::fill(history_.begin(), history_.end(), 0.0f); }
+    void set_bypass(bool) override {}
+    bool is_bypassed() const override { return false; }
+    uint32_t get_dsp_capabilities() const override { return static_cast<uint32_t>(mp::DSPCapability::InPlace); }
+    uint32_t get_parameter_count() const override { return 0; }
+    mp::Result get_parameter_info(uint32_t, mp::DSPParameter*) const override { return mp::Result::InvalidParameter; }
+    mp::Result set_parameter(uint32_t, float) override { return mp::Result::InvalidParameter; }
+    float get_parameter(uint32_t) const override { return 0.0f; }
+    void shutdown() override {}
+
+private:
+    uint32_t delay_;
+    uint16_t channels_;
+    std::vector<float> history_;
+};
+
+// Pull callback blocks until playback stops, waiting for the engine so the
+// test never records an underrun as a gap
+std::vector<int32_t> pull_until_stopped(PlaybackEngine& engine, ManualOutput& output, size_t frames) {
+    std::vector<int32_t> left;
+    std::vector<float> block(frames * 2);
+    while (engine.get_state() == PlaybackState::Playing) {
+        for (int i = 0; i < 200 && engine.get_buffer_stats().fill_frames < frames; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (!output.pull(block.data(), frames)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        for (size_t i = 0; i < frames; ++i) {
+            left.push_back(static_cast<int32_t>(block[i * 2] * 2147483648.0f) >> 8);
+        }
+    }
+    return left;
+}
+
+} // namespace
+
+class PlaybackEngineTest : public ::testing::Test {
+protected:
+    ManualOutput output_;
+    CountingEventBus event_bus_;
+    std::vector<std::unique_ptr<RampDecoder>> decoders_;  // Outlive the engine
+    PlaybackEngine engine_;
+
+    void SetUp() override {
+        ASSERT_EQ(engine_.initialize(&output_), mp::Result::Success);
+        engine_.set_event_bus(&event_bus_);
+        engine_.set_buffer_depth_ms(100);
+    }
+
+    void TearDown() override {
+        engine_.shutdown();
+    }
+
+    RampDecoder* make_decoder(int32_t base, uint64_t total_frames, size_t max_block,
+                              uint32_t sample_rate = 48000) {
+        decoders_.push_back(std::unique_ptr<RampDecoder>(
+            new RampDecoder(base, total_frames, max_block, sample_rate)));
+        return decoders_.back().get();
+    }
+};
+
+TEST_F(PlaybackEngineTest, GaplessTransitionIsSampleContinuous) {
+    const uint64_t first_frames = 48000 + 333;
+    const uint64_t second_frames = 24000 + 777;
+    RampDecoder* first = make_decoder(1, first_frames, 700);
+    RampDecoder* second = make_decoder(1 + static_cast<int32_t>(first_frames), second_frames, 523);
+
+    ASSERT_EQ(engine_.load_track("first", first), mp::Result::Success);
+    ASSERT_EQ(engine_.prepare_next_track("second", second), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 441);
+
+    // Both tracks back to back as one ramp: nothing dropped, nothing inserted
+    const uint64_t total = first_frames + second_frames;
+    ASSERT_GE(left.size(), total);
+    for (uint64_t i = 0; i < total; ++i) {
+        ASSERT_EQ(left[i], static_cast<int32_t>(i + 1)) << "at frame " << i;
+    }
+    for (size_t i = total; i < left.size(); ++i) {
+        ASSERT_EQ(left[i], 0) << "tail at frame " << i;
+    }
+
+    EXPECT_EQ(engine_.get_buffer_stats().underruns, 0u);
+    EXPECT_FALSE(engine_.is_next_track_ready());
+    EXPECT_EQ(engine_.get_current_track().file_path, "second");
+}
+
+TEST_F(PlaybackEngineTest, RequestsNextTrackNearEnd) {
+    RampDecoder* track = make_decoder(1, 48000 * 6, 1024);
+
+    ASSERT_EQ(engine_.load_track("track", track), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    pull_until_stopped(engine_, output_, 1024);
+
+    EXPECT_EQ(event_bus_.next_track_requests.load(), 1);
+}
+
+TEST_F(PlaybackEngineTest, NoTransitionWhenGaplessDisabled) {
+    RampDecoder* first = make_decoder(1, 4800, 512);
+    RampDecoder* second = make_decoder(100000, 4800, 512);
+
+    engine_.set_gapless_enabled(false);
+    ASSERT_EQ(engine_.load_track("first", first), mp::Result::Success);
+    ASSERT_EQ(engine_.prepare_next_track("second", second), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 441);
+
+    ASSERT_GE(left.size(), 4800u);
+    EXPECT_EQ(left[4799], 4800);
+    for (size_t i = 4800; i < left.size(); ++i) {
+        ASSERT_EQ(left[i], 0);
+    }
+    EXPECT_TRUE(engine_.is_next_track_ready());
+}
+
+TEST_F(PlaybackEngineTest, DSPLatencyDelaysAudioWithoutLosingTheTail) {
+    const uint32_t delay = 300;
+    const uint64_t first_frames = 4800 + 17;
+    const uint64_t second_frames = 4800 + 91;
+    RampDecoder* first = make_decoder(1, first_frames, 700);
+    RampDecoder* second = make_decoder(1 + static_cast<int32_t>(first_frames), second_frames, 523);
+
+    ASSERT_EQ(engine_.add_dsp_processor(new DelayProcessor(delay)), mp::Result::Success);
+    ASSERT_EQ(engine_.load_track("first", first), mp::Result::Success);
+    ASSERT_EQ(engine_.prepare_next_track("second", second), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 441);
+
+    // Silence for the latency, then both tracks whole and continuous
+    const uint64_t total = first_frames + second_frames;
+    ASSERT_GE(left.size(), delay + total);
+    for (uint32_t i = 0; i < delay; ++i) {
+        ASSERT_EQ(left[i], 0) << "at frame " << i;
+    }
+    for (uint64_t i = 0; i < total; ++i) {
+        ASSERT_EQ(left[delay + i], static_cast<int32_t>(i + 1)) << "at frame " << i;
+    }
+    EXPECT_EQ(engine_.get_dsp_latency_frames(), delay);
+}
+
+TEST_F(PlaybackEngineTest, PipelinedDSPAddsBlocksOfLatencyOnly) {
+    const uint32_t delay = 300;
+    const uint64_t track_frames = 48000 / 2 + 11;
+    RampDecoder* track = make_decoder(1, track_frames, 700);
+
+    engine_.set_dsp_threads(3);
+    DelayProcessor* first = new DelayProcessor(delay);
+    ASSERT_EQ(engine_.add_dsp_processor(first), mp::Result::Success);
+    ASSERT_EQ(engine_.add_dsp_processor(new DelayProcessor(0)), mp::Result::Success);
+    ASSERT_EQ(engine_.load_track("track", track), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 441);
+
+    // Two blocks of pipeline on top of the stage latency, and the whole
+    // track after it: the tail is pushed out of every thread
+    const uint32_t latency = delay + 2 * 1024;
+    EXPECT_EQ(engine_.get_dsp_latency_frames(), latency);
+    ASSERT_GE(left.size(), latency + track_frames);
+    for (uint32_t i = 0; i < latency; ++i) {
+        ASSERT_EQ(left[i], 0) << "at frame " << i;
+    }
+    for (uint64_t i = 0; i < track_frames; ++i) {
+        ASSERT_EQ(left[latency + i], static_cast<int32_t>(i + 1)) << "at frame " << i;
+    }
+
+    DSPChainStats stats = engine_.get_dsp_stats();
+    EXPECT_EQ(stats.thread_count, 3u);
+    EXPECT_EQ(stats.stage_count, 2u);
+    EXPECT_EQ(stats.pipeline_latency_frames, 2u * 1024u);
+    EXPECT_EQ(stats.stages[0].processor, first);
+    EXPECT_GT(stats.stages[0].average_us, 0.0f);
+}
+
+TEST_F(PlaybackEngineTest, ResamplesToDeviceRate) {
+    // One second at 44.1 kHz must last one second on the 48 kHz device
+    RampDecoder* track = make_decoder(1000, 44100, 1000, 44100);
+
+    ASSERT_EQ(engine_.load_track("track", track), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 480);
+
+    size_t audible = left.size();
+    while (audible > 0 && left[audible - 1] == 0) {
+        --audible;
+    }
+    EXPECT_EQ(audible, 48000u);
+    EXPECT_EQ(engine_.get_position(), 1000u);
+}
+
+TEST_F(PlaybackEngineTest, GaplessAcrossSampleRateChange) {
+    RampDecoder* first = make_decoder(1000, 44100, 1000, 44100);
+    RampDecoder* second = make_decoder(1, 4800, 512);
+
+    ASSERT_EQ(engine_.load_track("first", first), mp::Result::Success);
+    ASSERT_EQ(engine_.prepare_next_track("second", second), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 441);
+
+    // First track converted to exactly one second, second copied through
+    ASSERT_GE(left.size(), 48000u + 4800u);
+    for (size_t i = 0; i < 4800; ++i) {
+        ASSERT_EQ(left[48000 + i], static_cast<int32_t>(i + 1)) << "at frame " << i;
+    }
+}
+
+TEST_F(PlaybackEngineTest, NativeRateOpensDeviceAtTrackRate) {
+    RampDecoder* track = make_decoder(1, 4410, 512, 44100);
+
+    engine_.set_output_rate_mode(OutputRateMode::Native);
+    ASSERT_EQ(engine_.load_track("track", track), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    EXPECT_EQ(output_.sample_rate(), 44100u);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 441);
+
+    // Copied through untouched
+    ASSERT_GE(left.size(), 4410u);
+    for (size_t i = 0; i < 4410; ++i) {
+        ASSERT_EQ(left[i], static_cast<int32_t>(i + 1)) << "at frame " << i;
+    }
+    EXPECT_EQ(engine_.get_buffer_stats().resampler_cpu_cost, 0.0f);
+}
+
+TEST_F(PlaybackEngineTest, NativeRateFallsBackToIntegerRatio) {
+    RampDecoder* track = make_decoder(1, 8820, 512, 88200);
+
+    engine_.set_output_rate_mode(OutputRateMode::Native);
+    engine_.set_supported_output_rates({44100, 48000});
+    ASSERT_EQ(engine_.load_track("track", track), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    EXPECT_EQ(output_.sample_rate(), 44100u);
+    EXPECT_EQ(engine_.get_output_sample_rate(), 44100u);
+}
+
+TEST_F(PlaybackEngineTest, NativeRateReopensDeviceForOtherRateFamily) {
+    RampDecoder* first = make_decoder(1, 4410, 512, 44100);
+    RampDecoder* second = make_decoder(1, 4800, 512);
+
+    engine_.set_output_rate_mode(OutputRateMode::Native);
+    ASSERT_EQ(engine_.load_track("first", first), mp::Result::Success);
+    ASSERT_EQ(engine_.prepare_next_track("second", second), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    std::vector<int32_t> left = pull_until_stopped(engine_, output_, 441);
+
+    // Each track plays at its own rate, one after the other
+    ASSERT_GE(left.size(), 4410u + 4800u);
+    for (size_t i = 0; i < 4410; ++i) {
+        ASSERT_EQ(left[i], static_cast<int32_t>(i + 1)) << "first at frame " << i;
+    }
+    size_t start = 4410;
+    while (start < left.size() && left[start] == 0) {
+        ++start;
+    }
+    ASSERT_GE(left.size(), start + 4800);
+    for (size_t i = 0; i < 4800; ++i) {
+        ASSERT_EQ(left[start + i], static_cast<int32_t>(i + 1)) << "second at frame " << i;
+    }
+
+    EXPECT_EQ(output_.open_count(), 2);
+    EXPECT_EQ(output_.sample_rate(), 48000u);
+    EXPECT_EQ(engine_.get_current_track().file_path, "second");
+}
+
+TEST_F(PlaybackEngineTest, SeekRefillsTheBufferWhilePausedAndPlaying) {
+    RampDecoder* track = make_decoder(1, 48000 * 20, 700);
+    ASSERT_EQ(engine_.load_track("track", track), mp::Result::Success);
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+
+    const size_t frames = 480;
+    std::vector<float> block(frames * 2);
+    auto wait_for = [](auto condition) {
+        for (int i = 0; i < 2000 && !condition(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return condition();
+    };
+    // Left channel of one callback, once the engine has it buffered
+    auto pull = [&]() {
+        EXPECT_TRUE(wait_for([&] { return engine_.get_buffer_stats().fill_frames >= frames; }));
+        EXPECT_TRUE(output_.pull(block.data(), frames));
+        std::vector<int32_t> left(frames);
+        for (size_t i = 0; i < frames; ++i) {
+            left[i] = static_cast<int32_t>(block[i * 2] * 2147483648.0f) >> 8;
+        }
+        return left;
+    };
+    const uint32_t capacity = engine_.get_buffer_stats().capacity_frames;
+
+    for (int i = 0; i < 10; ++i) {
+        pull();
+    }
+    EXPECT_EQ(engine_.get_position(), 100u);
+
+    // Paused: the device reads nothing, so the engine itself must make
+    // room over the audio from before the seek
+    ASSERT_EQ(engine_.pause(), mp::Result::Success);
+    ASSERT_TRUE(wait_for([&] { return engine_.get_buffer_stats().fill_frames + 1024 > capacity; }));
+    ASSERT_EQ(engine_.seek(5000), mp::Result::Success);
+    EXPECT_TRUE(wait_for([&] { return engine_.get_position() == 5000; }));
+    EXPECT_TRUE(wait_for([&] { return engine_.get_buffer_stats().fill_frames + 1024 > capacity; }))
+        << "buffer not refilled after a seek while paused";
+
+    ASSERT_EQ(engine_.play(), mp::Result::Success);
+    std::vector<int32_t> left = pull();
+    EXPECT_EQ(left[0], 5000 * 48 + 1);
+    EXPECT_EQ(left[frames - 1], static_cast<int32_t>(5000 * 48 + frames));
+    EXPECT_EQ(engine_.get_position(), 5010u);
+
+    // Playing: the next callback starts at the seek point
+    ASSERT_EQ(engine_.seek(2000), mp::Result::Success);
+    EXPECT_TRUE(wait_for([&] { return engine_.get_position() == 2000; }));
+    left = pull();
+    EXPECT_EQ(left[0], 2000 * 48 + 1);
+    EXPECT_EQ(engine_.get_position(), 2010u);
+
+    EXPECT_EQ(engine_.get_buffer_stats().underruns, 0u);
+}
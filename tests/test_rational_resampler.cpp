@@ -0,0 +1,121 @@
+#include "../src/audio/rational_resampler.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace audio;
+
+namespace {
+
+const int CHANNELS = 2;
+
+// Deterministic broadband input
+std::vector<float> make_input(int frames) {
+    std::vector<float> input(static_cast<size_t>(frames) * CHANNELS);
+    uint32_t state = 12345u;
+    for (float& sample : input) {
+        state = state * 1664525u + 1013904223u;
+        sample = static_cast<float>(static_cast<int32_t>(state)) * (0.5f / 2147483648.0f);
+    }
+    return input;
+}
+
+// Convert input in blocks whose sizes cycle through block_sizes
+std::vector<float> convert_in_blocks(ISampleRateConverter& converter, const std::vector<float>& input,
+                                     const std::vector<int>& block_sizes) {
+    const int input_frames = static_cast<int>(input.size() / CHANNELS);
+    std::vector<float> output;
+    std::vector<float> block_output;
+
+    int offset = 0;
+    for (size_t i = 0; offset < input_frames; ++i) {
+        int frames = std::min(block_sizes[i % block_sizes.size()], input_frames - offset);
+        int max_output = frames * 4 + 16;
+        block_output.resize(static_cast<size_t>(max_output) * CHANNELS);
+
+        int generated = converter.convert(input.data() + static_cast<size_t>(offset) * CHANNELS, frames,
+                                          block_output.data(), max_output);
+        output.insert(output.end(), block_output.begin(), block_output.begin() + generated * CHANNELS);
+        offset += frames;
+    }
+    return output;
+}
+
+} // namespace
+
+TEST(RationalResamplerTest, ReducesRatesByGcd) {
+    RationalSampleRateConverter converter;
+    ASSERT_TRUE(converter.initialize(44100, 48000, CHANNELS));
+    EXPECT_EQ(converter.get_interpolation_factor(), 160);
+    EXPECT_EQ(converter.get_decimation_factor(), 147);
+    EXPECT_TRUE(converter.is_exact());
+
+    ASSERT_TRUE(converter.initialize(96000, 44100, CHANNELS));
+    EXPECT_EQ(converter.get_interpolation_factor(), 147);
+    EXPECT_EQ(converter.get_decimation_factor(), 320);
+}
+
+TEST(RationalResamplerTest, OutputIndependentOfBlockSize) {
+    std::vector<float> input = make_input(44100);
+
+    RationalSampleRateConverter whole;
+    ASSERT_TRUE(whole.initialize(44100, 48000, CHANNELS));
+    std::vector<float> expected = convert_in_blocks(whole, input, { 44100 });
+
+    RationalSampleRateConverter blocked;
+    ASSERT_TRUE(blocked.initialize(44100, 48000, CHANNELS));
+    std::vector<float> actual = convert_in_blocks(blocked, input, { 1, 441, 17, 1024, 3, 160 });
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(actual[i], expected[i]) << "sample " << i;
+    }
+}
+
+TEST(RationalResamplerTest, OutputCountExactOverLongSession) {
+    // Ten minutes of 44.1 kHz input in 441-frame blocks
+    const int64_t input_frames = 44100LL * 600;
+    const int block = 441;
+
+    RationalSampleRateConverter converter;
+    ASSERT_TRUE(converter.initialize(44100, 48000, CHANNELS));
+
+    std::vector<float> input(static_cast<size_t>(block) * CHANNELS, 0.25f);
+    std::vector<float> output(static_cast<size_t>(block) * 2 * CHANNELS);
+
+    int64_t generated = 0;
+    for (int64_t offset = 0; offset < input_frames; offset += block) {
+        generated += converter.convert(input.data(), block, output.data(), block * 2);
+    }
+
+    // Output n needs input frames up to n * 147 / 160 + latency
+    const int64_t usable = input_frames - converter.get_latency();
+    const int64_t expected = (usable * 160 + 146) / 147;
+    EXPECT_EQ(generated, expected);
+
+    // Constant input stays constant
+    EXPECT_NEAR(output[0], 0.25f, 1e-5f);
+}
+
+TEST(RationalResamplerTest, LargeFactorInterpolatesTable) {
+    RationalSampleRateConverter converter;
+    ASSERT_TRUE(converter.initialize(44100, 48001, CHANNELS));
+    EXPECT_FALSE(converter.is_exact());
+
+    std::vector<float> input(static_cast<size_t>(4096) * CHANNELS, 0.5f);
+    std::vector<float> output = convert_in_blocks(converter, input, { 512 });
+
+    ASSERT_GT(output.size(), 4000u * CHANNELS);
+    for (size_t i = converter.get_latency() * 2 * CHANNELS; i < output.size(); ++i) {
+        ASSERT_NEAR(output[i], 0.5f, 1e-4f) << "sample " << i;
+    }
+}
+
+TEST(RationalResamplerTest, AvailableFromFactory) {
+    EXPECT_TRUE(SampleRateConverterFactory::is_available("rational"));
+    std::unique_ptr<ISampleRateConverter> converter = SampleRateConverterFactory::create("rational");
+    ASSERT_NE(converter, nullptr);
+    EXPECT_STREQ(converter->get_name(), "Rational");
+}
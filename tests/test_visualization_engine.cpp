@@ -0,0 +1,401 @@
+#include "../core/visualization_engine.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace mp;
+
+namespace {
+
+// Counts heap allocations made by a thread while it has armed the counter;
+// the other threads in these tests allocate freely
+thread_local bool counting_allocations = false;
+std::atomic<int> allocations(0);
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (counting_allocations) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+VisualizationConfig make_config() {
+    VisualizationConfig config{};
+    config.waveform_width = 100;
+    config.waveform_time_span = 1.0f;
+    config.fft_size = 2048;
+    config.spectrum_bars = 30;
+    config.spectrum_min_freq = 20.0f;
+    config.spectrum_max_freq = 20000.0f;
+    config.spectrum_smoothing = 0.0f;
+    config.vu_peak_decay_rate = 10.0f;
+    config.vu_rms_window_ms = 100.0f;
+    config.update_rate_hz = 100;
+    return config;
+}
+
+// Interleaved sine, the same on every channel
+std::vector<float> make_sine(double frequency, float amplitude, uint32_t rate,
+                             uint16_t channels, size_t frames) {
+    std::vector<float> samples(frames * channels);
+    for (size_t i = 0; i < frames; ++i) {
+        float value = amplitude * static_cast<float>(std::sin(2.0 * PI * frequency * i / rate));
+        for (uint16_t ch = 0; ch < channels; ++ch) {
+            samples[i * channels + ch] = value;
+        }
+    }
+    return samples;
+}
+
+// Feed the samples in 10 ms callbacks, by default five times faster than
+// real time
+void play(VisualizationEngine& engine, const std::vector<float>& samples,
+          uint16_t channels, uint32_t rate, int pause_ms = 2) {
+    const size_t block = rate / 100;
+    const size_t frames = samples.size() / channels;
+    for (size_t pos = 0; pos < frames; pos += block) {
+        size_t n = std::min(block, frames - pos);
+        engine.process_audio(samples.data() + pos * channels, n, channels, rate);
+        std::this_thread::sleep_for(std::chrono::milliseconds(pause_ms));
+    }
+}
+
+// Wait until the analysis thread has published a VU reading
+bool wait_for_vu(VisualizationEngine& engine, float min_rms) {
+    for (int i = 0; i < 200; ++i) {
+        if (engine.get_vu_meter_data().rms_left >= min_rms) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+} // namespace
+
+TEST(VisualizationEngineTest, AnalysisThreadMetersAudio) {
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(make_config()), Result::Success);
+
+    const uint32_t rate = 48000;
+    auto samples = make_sine(1000.0, 0.5f, rate, 2, rate / 4);
+    play(engine, samples, 2, rate);
+    ASSERT_TRUE(wait_for_vu(engine, 0.3f));
+
+    VUMeterData vu = engine.get_vu_meter_data();
+    EXPECT_NEAR(vu.peak_left, 0.5f, 0.01f);
+    EXPECT_NEAR(vu.peak_right, 0.5f, 0.01f);
+    EXPECT_NEAR(vu.rms_left, 0.5f / std::sqrt(2.0f), 0.02f);
+    EXPECT_NEAR(vu.rms_db_left, 20.0f * std::log10(0.5f / std::sqrt(2.0f)), 0.3f);
+
+    // The loudest bar is the one nearest 1 kHz
+    SpectrumData spectrum = engine.get_spectrum_data();
+    ASSERT_EQ(spectrum.magnitudes.size(), 30u);
+    EXPECT_EQ(spectrum.sample_rate, rate);
+    size_t loudest = std::max_element(spectrum.magnitudes.begin(), spectrum.magnitudes.end()) -
+                     spectrum.magnitudes.begin();
+    EXPECT_NEAR(std::log2(spectrum.frequencies[loudest] / 1000.0f), 0.0f, 0.25f);
+
+    WaveformData waveform = engine.get_waveform_data();
+    EXPECT_EQ(waveform.channels, 2u);
+    EXPECT_NEAR(*std::max_element(waveform.max_values.begin(), waveform.max_values.end()), 0.5f, 0.01f);
+}
+
+TEST(VisualizationEngineTest, FormatChangeIsPickedUp) {
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(make_config()), Result::Success);
+
+    auto stereo = make_sine(1000.0, 0.5f, 44100, 2, 4410);
+    play(engine, stereo, 2, 44100);
+    ASSERT_TRUE(wait_for_vu(engine, 0.1f));
+
+    auto mono = make_sine(1000.0, 0.25f, 96000, 1, 9600);
+    play(engine, mono, 1, 96000);
+    for (int i = 0; i < 200 && engine.get_waveform_data().sample_rate != 96000; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    WaveformData waveform = engine.get_waveform_data();
+    EXPECT_EQ(waveform.sample_rate, 96000u);
+    EXPECT_EQ(waveform.channels, 1u);
+}
+
+TEST(VisualizationEngineTest, FormatChangeOnAFullRingKeepsTheNewAudio) {
+    // The analysis thread first looks at the ring a second in
+    VisualizationConfig config = make_config();
+    config.update_rate_hz = 1;
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(config), Result::Success);
+    auto start = std::chrono::steady_clock::now();
+
+    // Fill the ring to the brim with the old format (it holds four seconds
+    // of 192 kHz 8 channel audio, rounded up), then switch: the flushed
+    // frames are free for the new format straight away
+    const size_t frames = 96000;
+    auto old_format = make_sine(1000.0, 0.9f, 192000, 8, frames);
+    for (int i = 0; i < 16; ++i) {
+        engine.process_audio(old_format.data(), frames, 8, 192000);
+    }
+    auto new_format = make_sine(1000.0, 0.25f, 96000, 1, 9600);
+    engine.process_audio(new_format.data(), 9600, 1, 96000);
+    ASSERT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - start).count(), 500);
+
+    bool metered = false;
+    for (int i = 0; i < 600 && !metered; ++i) {
+        metered = engine.get_vu_meter_data().rms_left > 0.1f;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_TRUE(metered);
+    VUMeterData vu = engine.get_vu_meter_data();
+    EXPECT_NEAR(vu.peak_left, 0.25f, 0.01f);
+    EXPECT_NEAR(vu.rms_left, 0.25f / std::sqrt(2.0f), 0.01f);
+    EXPECT_EQ(engine.get_waveform_data().sample_rate, 96000u);
+}
+
+TEST(VisualizationEngineTest, ProcessAudioNeverAllocatesOrBlocks) {
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(make_config()), Result::Success);
+
+    // Readers hammering the getters must not hold up the audio side
+    std::atomic<bool> reading(true);
+    std::thread reader([&] {
+        while (reading) {
+            engine.get_spectrum_data();
+            engine.get_waveform_data();
+            engine.get_vu_meter_data();
+        }
+    });
+
+    const uint32_t rate = 192000;
+    auto block = make_sine(440.0, 0.5f, rate, 8, 1024);
+
+    // Far more than the ring holds, with no pause for the analysis thread:
+    // the excess is dropped
+    allocations = 0;
+    counting_allocations = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 2000; ++i) {
+        engine.process_audio(block.data(), 1024, 8, rate);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    counting_allocations = false;
+
+    reading = false;
+    reader.join();
+
+    EXPECT_EQ(allocations.load(), 0);
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 2000);
+}
+
+TEST(VisualizationEngineTest, ShutdownStopsAnalysis) {
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(make_config()), Result::Success);
+    EXPECT_EQ(engine.initialize(make_config()), Result::Error);
+    engine.shutdown();
+
+    // Ignored while shut down, usable again after initialize()
+    float silence[4] = {};
+    engine.process_audio(silence, 2, 2, 48000);
+    ASSERT_EQ(engine.initialize(make_config()), Result::Success);
+
+    auto samples = make_sine(1000.0, 0.5f, 48000, 2, 4800);
+    play(engine, samples, 2, 48000);
+    EXPECT_TRUE(wait_for_vu(engine, 0.1f));
+}
+
+TEST(VisualizationEngineTest, ReadersReuseTheirStorage) {
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(make_config()), Result::Success);
+
+    std::atomic<bool> playing(true);
+    std::thread audio([&] {
+        auto samples = make_sine(1000.0, 0.5f, 48000, 2, 4800);
+        while (playing) {
+            play(engine, samples, 2, 48000);
+        }
+    });
+
+    // Sized by the first read, then refreshed in place while the
+    // analysis thread keeps publishing
+    WaveformData waveform;
+    SpectrumData spectrum;
+    engine.read_waveform_data(waveform);
+    engine.read_spectrum_data(spectrum);
+
+    allocations = 0;
+    counting_allocations = true;
+    for (int i = 0; i < 200; ++i) {
+        engine.read_waveform_data(waveform);
+        engine.read_spectrum_data(spectrum);
+        engine.get_vu_meter_data();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    counting_allocations = false;
+
+    playing = false;
+    audio.join();
+
+    EXPECT_EQ(allocations.load(), 0);
+    EXPECT_EQ(waveform.min_values.size(), 100u);
+    EXPECT_EQ(waveform.max_values.size(), 100u);
+    EXPECT_EQ(spectrum.magnitudes.size(), 30u);
+    EXPECT_EQ(spectrum.frequencies.size(), 30u);
+}
+
+TEST(VisualizationEngineTest, LayoutChangesArePublishedWithoutAudio) {
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(make_config()), Result::Success);
+    EXPECT_EQ(engine.get_waveform_data().min_values.size(), 100u);
+    EXPECT_EQ(engine.get_spectrum_data().magnitudes.size(), 30u);
+
+    engine.set_waveform_width(640);
+    engine.set_spectrum_bars(64);
+    for (int i = 0; i < 200 && engine.get_spectrum_data().magnitudes.size() != 64; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    SpectrumData spectrum = engine.get_spectrum_data();
+    ASSERT_EQ(spectrum.magnitudes.size(), 64u);
+    ASSERT_EQ(spectrum.frequencies.size(), 64u);
+    EXPECT_NEAR(spectrum.frequencies.front(), 20.0f, 0.01f);
+    EXPECT_NEAR(spectrum.frequencies.back(), 20000.0f, 1.0f);
+    EXPECT_EQ(engine.get_waveform_data().min_values.size(), 640u);
+
+    // Out of range widths are clamped rather than overrunning the snapshot
+    engine.set_waveform_width(VisualizationEngine::MAX_WAVEFORM_WIDTH * 2);
+    for (int i = 0; i < 200 && engine.get_waveform_data().min_values.size() == 640; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(engine.get_waveform_data().max_values.size(), VisualizationEngine::MAX_WAVEFORM_WIDTH);
+}
+
+TEST(VisualizationEngineTest, SpectrogramKeepsUpAt192kHz) {
+    VisualizationConfig config = make_config();
+    config.spectrogram_columns = 64;
+    config.spectrogram_overlap = 0.75f;
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(config), Result::Success);
+
+    SpectrogramInfo info = engine.get_spectrogram_info();
+    ASSERT_EQ(info.columns, 64u);
+    ASSERT_EQ(info.fft_size, 2048u);
+    ASSERT_EQ(info.bins, 1025u);
+    ASSERT_EQ(info.hop_size, 512u);
+
+    // A view polling for new columns, as a UI blitting them would
+    std::atomic<bool> reading(true);
+    std::atomic<int> reader_allocations(0);
+    uint64_t received = 0;
+    uint64_t next_column = 0;
+    bool contiguous = true;
+    std::vector<float> latest(info.bins);
+    std::thread reader([&] {
+        std::vector<float> columns(8 * static_cast<size_t>(info.bins));
+        counting_allocations = true;
+        int before = allocations.load();
+        auto poll = [&] {
+            for (;;) {
+                uint64_t expected = next_column;
+                size_t count = engine.read_spectrogram_columns(next_column, columns.data(), 8);
+                if (count == 0) {
+                    break;
+                }
+                contiguous = contiguous && next_column == expected + count;
+                received += count;
+                const float* last = columns.data() + (count - 1) * info.bins;
+                std::copy(last, last + info.bins, latest.begin());
+            }
+        };
+        while (reading) {
+            poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        }
+        poll();
+        reader_allocations = allocations.load() - before;
+        counting_allocations = false;
+    });
+
+    // Half a second of 192 kHz stereo at real time; 9375 Hz is bin 100
+    const uint32_t rate = 192000;
+    const size_t frames = rate / 2;
+    auto samples = make_sine(9375.0, 0.5f, rate, 2, frames);
+    play(engine, samples, 2, rate, 10);
+
+    const uint64_t expected = frames / info.hop_size;
+    for (int i = 0; i < 200 && engine.get_spectrogram_column_count() < expected; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    reading = false;
+    reader.join();
+
+    // Every hop made a column and the view saw each one exactly once
+    EXPECT_EQ(engine.get_spectrogram_column_count(), expected);
+    EXPECT_EQ(received, expected);
+    EXPECT_TRUE(contiguous);
+    EXPECT_EQ(next_column, expected);
+    EXPECT_EQ(reader_allocations.load(), 0);
+
+    size_t loudest = std::max_element(latest.begin(), latest.end()) - latest.begin();
+    EXPECT_EQ(loudest, 100u);
+    EXPECT_NEAR(latest[loudest], 20.0f * std::log10(0.5f), 0.1f);
+    EXPECT_EQ(engine.get_spectrogram_info().sample_rate, rate);
+}
+
+TEST(VisualizationEngineTest, SlowSpectrogramReaderSkipsOverwrittenColumns) {
+    VisualizationConfig config = make_config();
+    config.fft_size = 256;
+    config.spectrogram_columns = 16;
+    config.spectrogram_overlap = 0.5f;
+    VisualizationEngine engine;
+    ASSERT_EQ(engine.initialize(config), Result::Success);
+    SpectrogramInfo info = engine.get_spectrogram_info();
+    ASSERT_EQ(info.hop_size, 128u);
+
+    auto samples = make_sine(1000.0, 0.5f, 48000, 1, 12800);
+    play(engine, samples, 1, 48000);
+    for (int i = 0; i < 200 && engine.get_spectrogram_column_count() < 100; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(engine.get_spectrogram_column_count(), 100u);
+
+    // Only the newest columns - 1 are still intact; the rest are skipped
+    std::vector<float> columns(64 * static_cast<size_t>(info.bins));
+    uint64_t next_column = 0;
+    EXPECT_EQ(engine.read_spectrogram_columns(next_column, columns.data(), 64), 15u);
+    EXPECT_EQ(next_column, 100u);
+    EXPECT_EQ(engine.read_spectrogram_columns(next_column, columns.data(), 64), 0u);
+
+    // Disabled by default
+    VisualizationEngine plain;
+    ASSERT_EQ(plain.initialize(make_config()), Result::Success);
+    EXPECT_EQ(plain.get_spectrogram_info().columns, 0u);
+    next_column = 0;
+    EXPECT_EQ(plain.read_spectrogram_columns(next_column, columns.data(), 64), 0u);
+}
@@ -0,0 +1,343 @@
+#include "../core/waveform_pyramid.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mp::core;
+
+namespace {
+
+const uint64_t TRACK_FRAMES = 300001;   // Not a multiple of any bucket size
+
+// Stereo Int16 with an envelope that changes over the track; right is half of left
+int16_t left_sample(uint64_t n) {
+    double envelope = 0.1 + 0.8 * (n % 100000) / 100000.0;
+    return static_cast<int16_t>(std::lround(32767.0 * envelope * std::sin(n * 0.01)));
+}
+
+class EnvelopeDecoder : public mp::IDecoder {
+public:
+    EnvelopeDecoder(uint64_t total_frames, int block_delay_ms = 0)
+        : total_(total_frames), block_delay_ms_(block_delay_ms), pos_(0), opens_(0) {}
+
+    int probe_file(const void*, size_t) override { return 100; }
+    const char** get_extensions() const override { return nullptr; }
+
+    mp::Result open_stream(const char*, mp::DecoderHandle* handle) override {
+        handle->internal = this;
+        pos_ = 0;
+        ++opens_;
+        return mp::Result::Success;
+    }
+
+    mp::Result get_stream_info(mp::DecoderHandle, mp::AudioStreamInfo* info) override {
+        info->sample_rate = 44100;
+        info->channels = 2;
+        info->format = mp::SampleFormat::Int16;
+        info->total_samples = total_;
+        info->duration_ms = total_ * 1000 / 44100;
+        info->bitrate = 0;
+        return mp::Result::Success;
+    }
+
+    mp::Result decode_block(mp::DecoderHandle, void* buffer, size_t buffer_size, size_t* samples_decoded) override {
+        if (block_delay_ms_ > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(block_delay_ms_));
+        }
+        // Uneven blocks, so buckets straddle decoder blocks
+        size_t frames = std::min<size_t>(buffer_size / (2 * sizeof(int16_t)), 1000);
+        frames = static_cast<size_t>(std::min<uint64_t>(frames, total_ - pos_));
+        int16_t* out = static_cast<int16_t*>(buffer);
+        for (size_t i = 0; i < frames; ++i) {
+            int16_t value = left_sample(pos_ + i);
+            out[i * 2] = value;
+            out[i * 2 + 1] = static_cast<int16_t>(value / 2);
+        }
+        pos_ += frames;
+        *samples_decoded = frames;
+        return mp::Result::Success;
+    }
+
+    mp::Result seek(mp::DecoderHandle, uint64_t, uint64_t*) override {
+        return mp::Result::NotImplemented;
+    }
+
+    mp::Result get_metadata(mp::DecoderHandle, const mp::MetadataTag**, size_t*) override {
+        return mp::Result::NotImplemented;
+    }
+
+    void close_stream(mp::DecoderHandle) override {}
+
+    int opens() const { return opens_; }
+
+private:
+    uint64_t total_;
+    int block_delay_ms_;
+    uint64_t pos_;
+    std::atomic<int> opens_;
+};
+
+// Exact min, max and RMS of frames [from, to) over both channels
+void direct_stats(uint64_t from, uint64_t to, float& min_value, float& max_value, double& rms) {
+    min_value = 1.0f;
+    max_value = -1.0f;
+    double sum_sq = 0.0;
+    for (uint64_t n = from; n < to; ++n) {
+        int16_t left = left_sample(n);
+        float values[2] = { left / 32768.0f, static_cast<int16_t>(left / 2) / 32768.0f };
+        for (float v : values) {
+            min_value = std::min(min_value, v);
+            max_value = std::max(max_value, v);
+            sum_sq += static_cast<double>(v) * v;
+        }
+    }
+    rms = std::sqrt(sum_sq / (2.0 * (to - from)));
+}
+
+class WaveformPyramidTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir_;
+
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("test_waveform_pyramid_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir_);
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    // The cache keys on the file, so tracks have to exist
+    std::string make_track(const std::string& name, size_t bytes) {
+        std::string path = (dir_ / name).string();
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(bytes, 'x');
+        return path;
+    }
+};
+
+// Blocks until the cache reports a track ready
+class ReadyWaiter {
+public:
+    explicit ReadyWaiter(WaveformPyramidCache& cache) {
+        cache.set_ready_callback([this](const std::string&) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++ready_;
+            cv_.notify_all();
+        });
+    }
+
+    bool wait_for(int count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(10), [&] { return ready_ >= count; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int ready_ = 0;
+};
+
+} // namespace
+
+TEST_F(WaveformPyramidTest, LevelsMatchTheSamples) {
+    EnvelopeDecoder decoder(TRACK_FRAMES);
+    WaveformPyramid pyramid;
+    ASSERT_EQ(pyramid.build(&decoder, "track", nullptr), mp::Result::Success);
+    EXPECT_EQ(pyramid.total_frames(), TRACK_FRAMES);
+    EXPECT_EQ(pyramid.sample_rate(), 44100u);
+    EXPECT_EQ(pyramid.channels(), 2u);
+
+    const float step = 1.0f / 32767.0f;
+    for (size_t level = 0; level < WaveformPyramid::LEVEL_COUNT; ++level) {
+        SCOPED_TRACE("level " + std::to_string(level));
+        const uint64_t frames = WaveformPyramid::bucket_frames(level);
+        const auto& buckets = pyramid.level(level);
+        ASSERT_EQ(buckets.size(), (TRACK_FRAMES + frames - 1) / frames);
+
+        // First, a middle one and the short last one
+        for (size_t index : { size_t(0), buckets.size() / 2, buckets.size() - 1 }) {
+            uint64_t from = index * frames;
+            uint64_t to = std::min(from + frames, TRACK_FRAMES);
+            float min_value, max_value;
+            double rms;
+            direct_stats(from, to, min_value, max_value, rms);
+
+            // Rounded outwards by at most one step
+            EXPECT_LE(buckets[index].min / 32767.0f, min_value);
+            EXPECT_GE(buckets[index].min / 32767.0f, min_value - 2 * step);
+            EXPECT_GE(buckets[index].max / 32767.0f, max_value);
+            EXPECT_LE(buckets[index].max / 32767.0f, max_value + 2 * step);
+            EXPECT_NEAR(buckets[index].rms / 65535.0, rms, 1e-4);
+        }
+    }
+}
+
+TEST_F(WaveformPyramidTest, RenderCoversEveryZoom) {
+    EnvelopeDecoder decoder(TRACK_FRAMES);
+    WaveformPyramid pyramid;
+    ASSERT_EQ(pyramid.build(&decoder, "track", nullptr), mp::Result::Success);
+
+    struct View { uint64_t start, end; uint32_t pixels; };
+    const View views[] = {
+        { 0, TRACK_FRAMES, 300 },              // Whole track
+        { 0, TRACK_FRAMES, 4 },                // Past the top level
+        { 123456, 133456, 500 },               // 20 frames per pixel
+        { 250000, 350000, 100 },               // Runs off the end
+    };
+    WaveformOverviewData data;
+    for (const View& view : views) {
+        SCOPED_TRACE(std::to_string(view.start) + "-" + std::to_string(view.end));
+        pyramid.render(view.start, view.end, view.pixels, data);
+        ASSERT_EQ(data.min_values.size(), view.pixels);
+        ASSERT_EQ(data.max_values.size(), view.pixels);
+        ASSERT_EQ(data.rms_values.size(), view.pixels);
+        EXPECT_EQ(data.total_frames, TRACK_FRAMES);
+
+        const double frames_per_pixel = static_cast<double>(view.end - view.start) / view.pixels;
+        for (uint32_t pixel = 0; pixel < view.pixels; ++pixel) {
+            uint64_t from = view.start + static_cast<uint64_t>(pixel * frames_per_pixel);
+            uint64_t to = std::min(view.start + static_cast<uint64_t>((pixel + 1) * frames_per_pixel),
+                                   TRACK_FRAMES);
+            if (from >= TRACK_FRAMES) {
+                EXPECT_EQ(data.max_values[pixel], 0.0f);
+                EXPECT_EQ(data.rms_values[pixel], 0.0f);
+                continue;
+            }
+            // Buckets may reach past the pixel, never fall short of it
+            float min_value, max_value;
+            double rms;
+            direct_stats(from, to, min_value, max_value, rms);
+            ASSERT_LE(data.min_values[pixel], min_value) << "pixel " << pixel;
+            ASSERT_GE(data.max_values[pixel], max_value) << "pixel " << pixel;
+            ASSERT_GT(data.rms_values[pixel], 0.0f) << "pixel " << pixel;
+        }
+    }
+
+    // The whole track at one pixel per base bucket reads level 0 exactly
+    const uint32_t pixels = static_cast<uint32_t>(pyramid.level(0).size());
+    pyramid.render(0, pixels * uint64_t(WaveformPyramid::BASE_BUCKET_FRAMES), pixels, data);
+    for (uint32_t pixel = 0; pixel < pixels; ++pixel) {
+        ASSERT_EQ(data.max_values[pixel], pyramid.level(0)[pixel].max / 32767.0f);
+    }
+}
+
+TEST_F(WaveformPyramidTest, SidecarRoundTripsAndChecksTheKey) {
+    EnvelopeDecoder decoder(TRACK_FRAMES);
+    WaveformPyramid built;
+    ASSERT_EQ(built.build(&decoder, "track", nullptr), mp::Result::Success);
+
+    WaveformSourceKey key;
+    key.path = "/music/track.flac";
+    key.mtime = 1234567;
+    key.size = 987654;
+    std::string sidecar = (dir_ / "track.mpwf").string();
+    ASSERT_EQ(built.save(sidecar, key), mp::Result::Success);
+    EXPECT_FALSE(std::filesystem::exists(sidecar + ".tmp"));
+
+    // About 6 bytes per 256 frames, plus 1/3 for the upper levels
+    EXPECT_LT(std::filesystem::file_size(sidecar), TRACK_FRAMES / 256 * 6 * 4 / 3 + 256);
+
+    WaveformPyramid loaded;
+    ASSERT_EQ(loaded.load(sidecar, key), mp::Result::Success);
+    EXPECT_EQ(loaded.total_frames(), TRACK_FRAMES);
+    EXPECT_EQ(loaded.sample_rate(), 44100u);
+    for (size_t level = 0; level < WaveformPyramid::LEVEL_COUNT; ++level) {
+        ASSERT_EQ(loaded.level(level).size(), built.level(level).size());
+        for (size_t i = 0; i < built.level(level).size(); ++i) {
+            ASSERT_EQ(loaded.level(level)[i].min, built.level(level)[i].min);
+            ASSERT_EQ(loaded.level(level)[i].max, built.level(level)[i].max);
+            ASSERT_EQ(loaded.level(level)[i].rms, built.level(level)[i].rms);
+        }
+    }
+
+    WaveformSourceKey changed = key;
+    changed.mtime++;
+    EXPECT_EQ(loaded.load(sidecar, changed), mp::Result::InvalidFormat);
+    changed = key;
+    changed.size++;
+    EXPECT_EQ(loaded.load(sidecar, changed), mp::Result::InvalidFormat);
+    changed = key;
+    changed.path = "/music/other.flac";
+    EXPECT_EQ(loaded.load(sidecar, changed), mp::Result::InvalidFormat);
+
+    // A truncated file is rejected and leaves the pyramid as it was
+    std::filesystem::resize_file(sidecar, std::filesystem::file_size(sidecar) - 1);
+    EXPECT_EQ(loaded.load(sidecar, key), mp::Result::InvalidFormat);
+    EXPECT_EQ(loaded.total_frames(), TRACK_FRAMES);
+    EXPECT_EQ(loaded.load((dir_ / "missing.mpwf").string(), key), mp::Result::FileNotFound);
+}
+
+TEST_F(WaveformPyramidTest, CacheBuildsOnceAndReusesTheSidecar) {
+    std::string track = make_track("track.wav", 1000);
+    std::string cache_dir = (dir_ / "cache").string();
+    EnvelopeDecoder decoder(TRACK_FRAMES);
+
+    {
+        WaveformPyramidCache cache;
+        ReadyWaiter waiter(cache);
+        ASSERT_EQ(cache.initialize(cache_dir.c_str()), mp::Result::Success);
+        EXPECT_EQ(cache.request(track, &decoder), nullptr);
+        EXPECT_EQ(cache.request(track, &decoder), nullptr);   // Already queued
+        ASSERT_TRUE(waiter.wait_for(1));
+
+        auto pyramid = cache.request(track, &decoder);
+        ASSERT_NE(pyramid, nullptr);
+        EXPECT_EQ(pyramid->total_frames(), TRACK_FRAMES);
+        EXPECT_EQ(cache.get(track), pyramid);
+        EXPECT_TRUE(std::filesystem::exists(cache.cache_file_path(track)));
+        EXPECT_EQ(decoder.opens(), 1);
+    }
+
+    // A new session loads the sidecar instead of decoding
+    {
+        WaveformPyramidCache cache;
+        ReadyWaiter waiter(cache);
+        ASSERT_EQ(cache.initialize(cache_dir.c_str()), mp::Result::Success);
+        EXPECT_EQ(cache.request(track, &decoder), nullptr);
+        ASSERT_TRUE(waiter.wait_for(1));
+        ASSERT_NE(cache.request(track, &decoder), nullptr);
+        EXPECT_EQ(decoder.opens(), 1);
+
+        // Replacing the file invalidates both the resident copy and the sidecar
+        make_track("track.wav", 2000);
+        EXPECT_EQ(cache.request(track, &decoder), nullptr);
+        ASSERT_TRUE(waiter.wait_for(2));
+        EXPECT_NE(cache.request(track, &decoder), nullptr);
+        EXPECT_EQ(decoder.opens(), 2);
+    }
+}
+
+TEST_F(WaveformPyramidTest, ShutdownCancelsABuild) {
+    std::string track = make_track("long.wav", 1000);
+    // About 45 minutes of audio at 2 ms per 1000-frame block: minutes to build
+    EnvelopeDecoder decoder(120000000, 2);
+
+    WaveformPyramidCache cache;
+    ASSERT_EQ(cache.initialize((dir_ / "cache").string().c_str()), mp::Result::Success);
+    EXPECT_EQ(cache.request(track, &decoder), nullptr);
+    for (int i = 0; i < 200 && decoder.opens() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(decoder.opens(), 1);
+
+    auto start = std::chrono::steady_clock::now();
+    cache.shutdown();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 1000);
+    EXPECT_EQ(cache.get(track), nullptr);
+    EXPECT_FALSE(std::filesystem::exists(cache.cache_file_path(track)));
+}